@@ -5,6 +5,7 @@
 
 #include "constants.h"
 #include "ring_buffer.h"
+#include "simulation_snapshot.h"
 
 #include <cmath>
 
@@ -53,6 +54,32 @@ public:
         return y;
     }
 
+    // Equivalent to calling fast_f() on each sample, but keeps the filter
+    // history in registers for the duration of the block
+    void process(const T_Real *input, T_Real *output, int samples) {
+        T_Real y_prev[4] = { m_y.read(3), m_y.read(2), m_y.read(1), m_y.read(0) };
+        T_Real x_prev[4] = { m_x.read(3), m_x.read(2), m_x.read(1), m_x.read(0) };
+
+        for (int i = 0; i < samples; ++i) {
+            const T_Real sample = input[i];
+            T_Real const n = m_f_4 / m_a[0] * (sample + 4 * x_prev[0] + 6 * x_prev[1] + 4 * x_prev[2] + x_prev[3]);
+            T_Real const d = -m_a[1] * y_prev[0] - m_a[2] * y_prev[1] - m_a[3] * y_prev[2] - m_a[4] * y_prev[3];
+            T_Real const y = n + d;
+
+            x_prev[3] = x_prev[2]; x_prev[2] = x_prev[1]; x_prev[1] = x_prev[0]; x_prev[0] = sample;
+            y_prev[3] = y_prev[2]; y_prev[2] = y_prev[1]; y_prev[1] = y_prev[0]; y_prev[0] = y;
+
+            output[i] = y;
+        }
+
+        m_x.removeBeginning(4);
+        m_y.removeBeginning(4);
+        for (int i = 3; i >= 0; --i) {
+            m_x.write(x_prev[i]);
+            m_y.write(y_prev[i]);
+        }
+    }
+
     inline void setCutoffFrequency(T_Real f_c, T_Real sampleRate) {
         const T_Real f = std::tan(static_cast<T_Real>(constants::pi) * f_c / sampleRate);
         const T_Real f_2 = f * f;
@@ -70,6 +97,16 @@ public:
         m_f_4 = f_4;
     }
 
+    void saveState(SimulationSnapshot *snapshot) const {
+        snapshot->writeRingBuffer(m_x);
+        snapshot->writeRingBuffer(m_y);
+    }
+
+    void loadState(SimulationSnapshot *snapshot) {
+        snapshot->readRingBuffer(&m_x);
+        snapshot->readRingBuffer(&m_y);
+    }
+
 protected:
     RingBuffer<T_Real> m_y;
     RingBuffer<T_Real> m_x;
@@ -36,6 +36,9 @@ class Camshaft : public Part {
         double valveLift(int lobe) const;
         double sampleLobe(double theta) const;
 
+        // Angle passed to sampleLobe() for the given lobe, without wrapping
+        double getLobeAngle(int lobe) const;
+
         void setLobeCenterline(int lobe, double crankAngle) { m_lobeAngles[lobe] = crankAngle / 2; }
         double getLobeCenterline(int lobe) const { return m_lobeAngles[lobe]; }
 
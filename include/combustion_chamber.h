@@ -8,14 +8,17 @@
 #include "cylinder_head.h"
 #include "units.h"
 #include "fuel.h"
+#include "random_stream.h"
 
 class Engine;
+class FlowSchedule;
+class SimulationSnapshot;
 class CombustionChamber : public atg_scs::ForceGenerator {
     public:
         struct Parameters {
-            Piston *Piston;
+            ::Piston *Piston;
             CylinderHead *Head;
-            Fuel *Fuel;
+            ::Fuel *Fuel;
             Function *MeanPistonSpeedToTurbulence;
 
             double StartingPressure;
@@ -43,6 +46,10 @@ class CombustionChamber : public atg_scs::ForceGenerator {
             double viscousFrictionCoefficient = units::force(20, units::N);
         };
 
+        // Below this piston speed friction is scaled down linearly so that it
+        // vanishes at rest
+        static constexpr double FrictionAttenuationSpeed = 1E-3;
+
     public:
         CombustionChamber();
         virtual ~CombustionChamber();
@@ -52,8 +59,27 @@ class CombustionChamber : public atg_scs::ForceGenerator {
         void setEngine(Engine *engine) { m_engine = engine; }
         virtual void apply(atg_scs::SystemState *system);
 
+        // Gas and friction force on the piston along the cylinder axis for a
+        // given piston speed along the same axis
+        double calculatePistonForce(double v_s) const;
+
+        // Linearization of the piston force, for the linearly implicit
+        // integrator. The pressure stiffness is how fast the gas force drops
+        // per unit of piston travel away from the head, assuming adiabatic
+        // compression. The friction damping is the slope of the friction
+        // force with respect to piston speed, clamped at zero where friction
+        // falls off with speed.
+        double calculatePressureStiffness() const;
+        double calculateFrictionDamping(double v_s) const;
+
+        // Damping along the cylinder axis added by apply(), set before each
+        // step by the simulator
+        void setImplicitDamping(double damping) { m_implicitDamping = damping; }
+        double getImplicitDamping() const { return m_implicitDamping; }
+
         CylinderHead *getCylinderHead() const { return m_head; }
         Piston *getPiston() const { return m_piston; }
+        double getCrankcasePressure() const { return m_crankcasePressure; }
 
         double getFrictionForce() const;
         double getVolume() const;
@@ -64,10 +90,33 @@ class CombustionChamber : public atg_scs::ForceGenerator {
         bool isLit() const { return m_lit; }
         bool popLitLastFrame();
 
+        void bindGasSystems(GasSystemStore *store);
+        void unbindGasSystems();
+
+        void seedRandom(uint64_t seed, uint64_t stream);
+
+        // Gas state lives in the store and is saved with it
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
         void ignite();
         void update(double dt);
         void flow(double dt);
 
+        // flow() in three parts, for running the flow edges of several
+        // chambers through one FlowSchedule. startFlow() must be called on
+        // every chamber before the schedule runs and endFlow() after.
+        void startFlow(double dt);
+        void scheduleFlow(FlowSchedule *schedule);
+        void endFlow(double dt);
+
+        // With both valves shut the cylinder exchanges no gas with its
+        // runners in a flow step
+        bool isSealed() const { return m_intakeFlowRate == 0 && m_exhaustFlowRate == 0; }
+
+        // Largest GasSystem::flowStiffness() over this chamber's flow paths
+        double getFlowStiffness(double minPressureDifference);
+
         double lastEventAfr() const;
 
         double getLastIterationExhaustFlow() const { return m_exhaustFlow; }
@@ -78,6 +127,11 @@ class CombustionChamber : public atg_scs::ForceGenerator {
         void resetLastTimestepIntakeFlow() { m_lastTimestepTotalIntakeFlow = 0; }
         double getLastTimestepIntakeFlow() const { return m_lastTimestepTotalIntakeFlow; }
 
+        // Number of flow() calls that took the sealed path with both valves
+        // closed
+        void resetSealedFlowSteps() { m_sealedFlowSteps = 0; }
+        long long getSealedFlowSteps() const { return m_sealedFlowSteps; }
+
         Function *m_meanPistonSpeedToTurbulence;
         GasSystem m_system;
         GasSystem m_intakeRunnerAndManifold;
@@ -105,8 +159,11 @@ class CombustionChamber : public atg_scs::ForceGenerator {
         double m_lastTimestepTotalExhaustFlow;
         double m_lastTimestepTotalIntakeFlow;
         double m_exhaustFlow;
+        double m_intakeFlow;
+        long long m_sealedFlowSteps;
 
         double m_crankcasePressure;
+        double m_implicitDamping;
 
         double *m_pressure;
         double *m_pistonSpeed;
@@ -114,6 +171,11 @@ class CombustionChamber : public atg_scs::ForceGenerator {
 
         bool m_litLastFrame;
 
+        GasSystemStore *m_gasSystemStore;
+        int m_flowEdges;
+
+        RandomStream m_random;
+
         Piston *m_piston;
         CylinderHead *m_head;
         Engine *m_engine;
@@ -3,10 +3,10 @@
 
 namespace constants {
 
-    extern constexpr double pi = 3.14159265359;
-    extern constexpr double R = 8.31446261815324;
-    extern constexpr double root_2 = 1.41421356237309504880168872420969807856967187537694807317667973799;
-    extern constexpr double e = 2.71828182845904523536028747135266249775724709369995;
+    inline constexpr double pi = 3.14159265359;
+    inline constexpr double R = 8.31446261815324;
+    inline constexpr double root_2 = 1.41421356237309504880168872420969807856967187537694807317667973799;
+    inline constexpr double e = 2.71828182845904523536028747135266249775724709369995;
 
 } /* namespace Constants */
 
@@ -0,0 +1,95 @@
+#ifndef ATG_ENGINE_SIM_CONSTRAINT_SOLVER_H
+#define ATG_ENGINE_SIM_CONSTRAINT_SOLVER_H
+
+#include "scs.h"
+
+#include "simulation_snapshot.h"
+
+#include <vector>
+
+// Projected Gauss-Seidel solver for the constraint forces of the rigid body
+// system. Constraint forces in an engine change little from one step to the
+// next, so every solve starts from the multipliers found in the previous step
+// and stops as soon as the largest correction made in a sweep falls below the
+// tolerance.
+class ConstraintSolver : public atg_scs::GaussSeidelSleSolver {
+    public:
+        struct Statistics {
+            long long solves = 0;
+            long long iterations = 0;
+            long long unconverged = 0;
+            int lastIterations = 0;
+            double lastResidual = 0.0;
+            double maxResidual = 0.0;
+        };
+
+    public:
+        ConstraintSolver();
+        virtual ~ConstraintSolver();
+
+        virtual bool solve(
+            atg_scs::SparseMatrix<3> &J,
+            atg_scs::Matrix &W,
+            atg_scs::Matrix &right,
+            atg_scs::Matrix *result,
+            atg_scs::Matrix *previous) override;
+        virtual bool solveWithLimits(
+            atg_scs::SparseMatrix<3> &J,
+            atg_scs::Matrix &W,
+            atg_scs::Matrix &right,
+            atg_scs::Matrix &limits,
+            atg_scs::Matrix *result,
+            atg_scs::Matrix *previous) override;
+
+        // The tolerance is relative to the largest term of the right-hand
+        // side, or absolute when that is smaller than one
+        void setTolerance(double tolerance) { m_tolerance = tolerance; }
+        double getTolerance() const { return m_tolerance; }
+        void setMaxIterations(int iterations) { m_maxIterationCount = iterations; }
+        int getMaxIterations() const { return m_maxIterationCount; }
+
+        // Starting from zero reproduces a solver without warm-starting
+        void setWarmStartEnabled(bool enabled) { m_warmStart = enabled; }
+        bool isWarmStartEnabled() const { return m_warmStart; }
+        void clearWarmStart() { m_lambda.clear(); }
+
+        const Statistics &getStatistics() const { return m_statistics; }
+        void resetStatistics() { m_statistics = Statistics(); }
+
+        // The multipliers carried between steps are part of the simulation
+        // state; restoring a run without them would not reproduce it exactly
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
+    protected:
+        struct Row {
+            int body[2];
+            double J[2][3];
+            double WJ[2][3];
+            double diagonal;
+            double lower;
+            double upper;
+        };
+
+        virtual bool solveProjected(
+            atg_scs::SparseMatrix<3> &J,
+            atg_scs::Matrix &W,
+            atg_scs::Matrix &right,
+            atg_scs::Matrix *limits,
+            atg_scs::Matrix *result);
+
+        void recordSolve(int iterations, double residual, bool converged);
+
+    protected:
+        double m_tolerance;
+        int m_maxIterationCount;
+        bool m_warmStart;
+
+        std::vector<Row> m_rows;
+        std::vector<double> m_lambda;
+        std::vector<double> m_u;
+
+        Statistics m_statistics;
+};
+
+#endif /* ATG_ENGINE_SIM_CONSTRAINT_SOLVER_H */
@@ -0,0 +1,34 @@
+#ifndef ATG_ENGINE_SIM_CONTROL_PROFILE_H
+#define ATG_ENGINE_SIM_CONTROL_PROFILE_H
+
+#include <string>
+#include <vector>
+
+// Throttle and dyno speed keyframes over time, linearly interpolated. Loaded
+// from a text file with one "<time s> <throttle 0-1> [<dyno rpm>]" entry per
+// line; '#' starts a comment. A dyno speed of zero (or none) leaves the dyno
+// disabled for that segment.
+class ControlProfile {
+    public:
+        struct Keyframe {
+            double time;
+            double throttle;
+            double dynoSpeed;
+        };
+
+    public:
+        ControlProfile();
+        ~ControlProfile();
+
+        bool load(const std::string &filename);
+        void addKeyframe(const Keyframe &keyframe);
+
+        bool isEmpty() const { return m_keyframes.empty(); }
+        double getDuration() const;
+        Keyframe sample(double t) const;
+
+    protected:
+        std::vector<Keyframe> m_keyframes;
+};
+
+#endif /* ATG_ENGINE_SIM_CONTROL_PROFILE_H */
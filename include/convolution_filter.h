@@ -3,24 +3,98 @@
 
 #include "filter.h"
 
+#include "fft.h"
+
+class SimulationSnapshot;
 class ConvolutionFilter : public Filter {
+    public:
+        // Impulse responses up to this length are evaluated directly; longer
+        // ones use partitioned FFT convolution
+        static constexpr int DirectConvolutionThreshold = 256;
+        static constexpr int PartitionSize = 128;
+        static constexpr int PartitionBins = PartitionSize + 1;
+
+        // Impulse response together with the spectra of its partitions. A
+        // kernel is read-only, so one copy can be shared by any number of
+        // filters.
+        struct Kernel {
+            const float *impulseResponse = nullptr;
+            const float *partitions_re = nullptr;
+            const float *partitions_im = nullptr;
+            int sampleCount = 0;
+        };
+
+        // Number of frequency-domain partitions used for an impulse response
+        // of the given length (zero if it is convolved directly)
+        static int getPartitionCount(int samples);
+
+        // Computes the partition spectra of an impulse response. Each array
+        // must hold getPartitionCount(samples) * PartitionBins values.
+        static void transformPartitions(
+            const float *impulseResponse,
+            int samples,
+            float *partitions_re,
+            float *partitions_im);
+
     public:
         ConvolutionFilter();
         virtual ~ConvolutionFilter();
 
         void initialize(int samples);
+
+        // Convolves with a shared kernel scaled by the given gain. The kernel
+        // must outlive the filter.
+        void initialize(const Kernel &kernel, float gain);
         virtual float f(float sample) override;
+        void process(const float *input, float *output, int samples);
         virtual void destroy();
 
+        // Saves the input history; the impulse response is not included
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
         int getSampleCount() const { return m_sampleCount; }
-        float *getImpulseResponse() { return m_impulseResponse; }
+        float getGain() const { return m_gain; }
+
+        // Only available if the filter owns its impulse response
+        float *getImpulseResponse() { m_prepared = false; return m_impulseResponse; }
+        bool isPartitioned() const { return m_partitionCount > 0; }
+
+    protected:
+        float directConvolution(float sample);
+        float partitionedConvolution(float sample);
+        void initializeState(int samples);
+        void prepare();
+        void processBlock();
 
     protected:
         float *m_shiftRegister;
         int m_shiftOffset;
 
+        // Taps and partition spectra in use; they point either into the
+        // owned arrays or into a shared kernel
+        const float *m_taps;
+        const float *m_kernel_re, *m_kernel_im;
+        float m_gain;
+
         float *m_impulseResponse;
         int m_sampleCount;
+        bool m_prepared;
+
+        // Partitioned mode. The first PartitionSize taps are applied directly
+        // so that there is no added latency; the remaining taps are split into
+        // partitions which are applied in the frequency domain once per block
+        // (uniformly partitioned overlap-save).
+        Fft m_fft;
+        int m_partitionCount;
+        int m_blockPosition;
+        int m_fdlPosition;
+
+        float *m_window;
+        float *m_tailOutput;
+        float *m_partitions_re, *m_partitions_im;
+        float *m_fdl_re, *m_fdl_im;
+        float *m_scratch_re, *m_scratch_im;
 };
 
 #endif /* ATG_ENGINE_SIM_CONVOLUTION_FILTER_H */
@@ -0,0 +1,104 @@
+#ifndef ATG_ENGINE_SIM_CRANK_SLIDER_LINKAGE_H
+#define ATG_ENGINE_SIM_CRANK_SLIDER_LINKAGE_H
+
+#include "scs.h"
+
+#include <vector>
+
+class Engine;
+class Crankshaft;
+class ConnectingRod;
+class CombustionChamber;
+class Piston;
+class SimulationSnapshot;
+
+// Pistons and connecting rods of an engine expressed in terms of the angle of
+// its output shaft. All crankshafts turn together, so the whole linkage has a
+// single degree of freedom. The inertia of the pistons and rods is folded into
+// the output shaft and the forces on the pistons are mapped onto it through
+// the exact crank-slider Jacobian, which leaves nothing for constraints to
+// hold together.
+class CrankSliderLinkage : public atg_scs::ForceGenerator {
+    public:
+        CrankSliderLinkage();
+        virtual ~CrankSliderLinkage();
+
+        void initialize(Engine *engine);
+        void destroy();
+
+        // Sets the moment of inertia of the output shaft for the next step.
+        // A non-zero timestep linearizes the piston forces over the step, as
+        // the linearly implicit integrator does for the full system.
+        void prepare(double implicitTimestep = 0.0);
+
+        // Moves every crankshaft, piston and rod to match the output shaft
+        void place();
+
+        // Places the linkage after a step of length dt and updates the
+        // cylinder wall forces
+        void update(double dt);
+
+        virtual void apply(atg_scs::SystemState *state) override;
+
+        // The output shaft velocity at the start of the last step, from which
+        // update() finds the angular acceleration
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
+        double getCrankshaftInertia() const { return m_crankshaftInertia; }
+        double getEffectiveInertia() const { return m_effectiveInertia; }
+        double getImplicitInertia() const { return m_implicitInertia; }
+        int getCylinderCount() const { return static_cast<int>(m_cylinders.size()); }
+
+    protected:
+        // A point together with its first and second derivatives with
+        // respect to the crank angle
+        struct Point {
+            double x = 0, y = 0;
+            double dx = 0, dy = 0;
+            double ddx = 0, ddy = 0;
+        };
+
+        struct Cylinder {
+            Piston *piston = nullptr;
+            ConnectingRod *rod = nullptr;
+            CombustionChamber *chamber = nullptr;
+
+            // Cylinder whose rod carries this rod's big end, or -1 if it
+            // rides on the crankshaft
+            int master = -1;
+
+            Point bigEnd;
+            Point wristPin;
+            Point rodCenter;
+            double rodAngle = 0, d_rodAngle = 0, dd_rodAngle = 0;
+
+            // Force on the piston along the cylinder axis during the last
+            // step
+            double pistonForce = 0;
+        };
+
+        void calculate(double theta);
+        void calculateCylinder(Cylinder *cylinder, double theta);
+        double calculateEffectiveInertia() const;
+        double calculateStroke(const Cylinder &cylinder) const;
+
+    protected:
+        Engine *m_engine;
+        Crankshaft *m_outputShaft;
+
+        std::vector<Cylinder> m_cylinders;
+
+        // Master rods come before the rods they carry
+        std::vector<int> m_order;
+
+        double m_crankshaftInertia;
+        double m_effectiveInertia;
+        double m_lastVelocity;
+
+        // Terms added by the linearization of the piston forces
+        double m_implicitInertia;
+        double m_implicitDamping;
+};
+
+#endif /* ATG_ENGINE_SIM_CRANK_SLIDER_LINKAGE_H */
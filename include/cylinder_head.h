@@ -18,7 +18,7 @@ class CylinderHead : public Part {
             Function *ExhaustPortFlow;
             Function *IntakePortFlow;
 
-            Valvetrain *Valvetrain;
+            ::Valvetrain *Valvetrain;
 
             double CombustionChamberVolume;
 
@@ -30,6 +30,13 @@ class CylinderHead : public Part {
             bool FlipDisplay = false;
         };
 
+        // Number of points per camshaft revolution in the port flow tables
+        static constexpr int FlowTableResolution = 4096;
+
+        // Port flow tables kept per side; enough for a valvetrain that
+        // switches between two camshafts
+        static constexpr int FlowTableCacheSize = 2;
+
         struct Cylinder {
             ExhaustSystem *exhaustSystem = nullptr;
             Intake *intake = nullptr;
@@ -76,6 +83,31 @@ class CylinderHead : public Part {
 
         Camshaft *getExhaustCamshaft();
         Camshaft *getIntakeCamshaft();
+        Valvetrain *getValvetrain() const { return m_valvetrain; }
+
+    protected:
+        // Port flow as a function of angle relative to the lobe centerline.
+        // It only depends on the lobe profile and the port flow function, so
+        // the same table serves every cylinder. Tables are built in
+        // initialize() for each camshaft the valvetrain can switch between.
+        struct FlowTable {
+            const Camshaft *camshaft = nullptr;
+            double *flow = nullptr;
+        };
+
+        double flowRate(
+            const FlowTable *tables,
+            const Camshaft *active,
+            const Camshaft *previous,
+            const Function *portFlow,
+            int cylinder) const;
+        void buildFlowTables(FlowTable *tables, const Camshaft *active, const Camshaft *previous, const Function *portFlow);
+        void buildFlowTable(FlowTable *table, const Camshaft *camshaft, const Function *portFlow);
+        double sampleFlow(
+            const FlowTable *tables,
+            const Camshaft *camshaft,
+            const Function *portFlow,
+            int cylinder) const;
 
     protected:
         Cylinder *m_cylinders;
@@ -86,6 +118,9 @@ class CylinderHead : public Part {
         Function *m_exhaustPortFlow;
         Function *m_intakePortFlow;
 
+        FlowTable m_intakeFlowTables[FlowTableCacheSize];
+        FlowTable m_exhaustFlowTables[FlowTableCacheSize];
+
         double m_intakeRunnerVolume;
         double m_intakeRunnerCrossSectionArea;
         double m_exhaustRunnerVolume;
@@ -7,10 +7,14 @@
 
 #include <cmath>
 
+class SimulationSnapshot;
+
 class DelayFilter : public Filter {
 public:
     DelayFilter() {
         m_latencySamples = 0;
+        m_delay = 0;
+        m_sampleRate = 0;
     }
 
     virtual ~DelayFilter() {
@@ -21,10 +25,19 @@ public:
         const int samples = static_cast<int>(std::round(delay * audioFrequency));
         const int capacity = samples + 32;
 
+        m_history.destroy();
         m_history.initialize(capacity);
         m_latencySamples = samples;
+        m_delay = delay;
+        m_sampleRate = audioFrequency;
     }
 
+    // Keeps the delay in seconds when the rate at which samples arrive
+    // changes. Samples already in flight are resampled to the new rate.
+    void setSampleRate(double audioFrequency);
+    double getSampleRate() const { return m_sampleRate; }
+    int getLatencySamples() const { return m_latencySamples; }
+
     virtual float f(float sample) override {
         return static_cast<float>(fast_f(static_cast<double>(sample)));
     }
@@ -43,8 +56,16 @@ public:
         }
     }
 
+    void saveState(SimulationSnapshot *snapshot) const;
+    void loadState(SimulationSnapshot *snapshot);
+
+protected:
+    void restore(const double *samples, int n);
+
 protected:
     int m_latencySamples;
+    double m_delay;
+    double m_sampleRate;
     RingBuffer<double> m_history;
 };
 
@@ -3,12 +3,17 @@
 
 #include "filter.h"
 
+class SimulationSnapshot;
 class DerivativeFilter : public Filter {
     public:
         DerivativeFilter();
         virtual ~DerivativeFilter();
 
         virtual float f(float sample) override;
+        void process(const float *input, float *output, int samples);
+
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
 
         float m_dt;
 
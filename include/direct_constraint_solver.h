@@ -0,0 +1,86 @@
+#ifndef ATG_ENGINE_SIM_DIRECT_CONSTRAINT_SOLVER_H
+#define ATG_ENGINE_SIM_DIRECT_CONSTRAINT_SOLVER_H
+
+#include "constraint_solver.h"
+
+#include <vector>
+
+// Exact solver for the constraint forces, using a sparse LDL^T factorization
+// of J * W * J^T. The sparsity pattern only depends on which bodies each
+// constraint row acts on, which never changes once a simulation is loaded, so
+// the elimination order, the fill-in and the list of updates the numeric
+// factorization performs are worked out on the first solve and reused from
+// then on. A minimum degree ordering eliminates pistons and rods before the
+// crankshaft they hang off, which keeps the cost of a step proportional to
+// the number of rows apart from the rows that share the crankshaft.
+//
+// Limits are handled with an active set: rows found outside their limits are
+// fixed at them and the system is solved again, starting from the set of rows
+// that were at a limit in the previous step. The statistics count the number
+// of factorizations per solve as iterations.
+class DirectConstraintSolver : public ConstraintSolver {
+    public:
+        DirectConstraintSolver();
+        virtual ~DirectConstraintSolver();
+
+        int getFactorNonZeroCount() const { return static_cast<int>(m_factorRows.size()); }
+        int getAnalysisCount() const { return m_analysisCount; }
+
+    protected:
+        virtual bool solveProjected(
+            atg_scs::SparseMatrix<3> &J,
+            atg_scs::Matrix &W,
+            atg_scs::Matrix &right,
+            atg_scs::Matrix *limits,
+            atg_scs::Matrix *result) override;
+
+        bool patternChanged(atg_scs::SparseMatrix<3> &J, int bodyCount) const;
+        void analyze(atg_scs::SparseMatrix<3> &J, int bodyCount);
+        int findEntry(int column, int row) const;
+
+        void assemble(atg_scs::SparseMatrix<3> &J, atg_scs::Matrix &W);
+        void factor();
+        void solveFactored(double *x) const;
+
+    protected:
+        enum class Bound : uint8_t {
+            Free,
+            Lower,
+            Upper
+        };
+
+        // Contribution of one body to an entry of J * W * J^T
+        struct Product {
+            int target;
+            int body;
+            int row0, entry0;
+            int row1, entry1;
+        };
+
+        // Symbolic factorization. Entries are stored column by column in
+        // elimination order; the first n values are the diagonal.
+        int m_rowCount;
+        int m_bodyCount;
+        std::vector<int> m_blocks;
+        std::vector<int> m_order;
+        std::vector<int> m_position;
+        std::vector<int> m_factorStart;
+        std::vector<int> m_factorRows;
+        std::vector<int> m_updates;
+        std::vector<Product> m_products;
+        int m_analysisCount;
+
+        // Numeric factorization
+        std::vector<double> m_matrix;
+        std::vector<double> m_factor;
+        std::vector<double> m_inverseDiagonal;
+
+        std::vector<Bound> m_bounds;
+        std::vector<double> m_lower;
+        std::vector<double> m_upper;
+        std::vector<double> m_right;
+        std::vector<double> m_x;
+        std::vector<double> m_w;
+};
+
+#endif /* ATG_ENGINE_SIM_DIRECT_CONSTRAINT_SOLVER_H */
@@ -18,6 +18,9 @@ public:
     virtual void setSpeedControl(double s);
     virtual void update(double dt, Engine *engine);
 
+    virtual void saveState(SimulationSnapshot *snapshot) const;
+    virtual void loadState(SimulationSnapshot *snapshot);
+
 protected:
     double m_gamma;
     double m_throttlePosition;
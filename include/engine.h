@@ -18,6 +18,7 @@
 #include <string>
 
 class Simulator;
+class SimulationSnapshot;
 class Vehicle;
 class Transmission;
 class Engine : public Part {
@@ -66,6 +67,11 @@ class Engine : public Part {
         virtual double getIntakeFlowRate() const;
         virtual void update(double dt);
 
+        // Rigid bodies and per-part state; gas volumes are saved by the
+        // simulator that owns their store
+        virtual void saveState(SimulationSnapshot *snapshot) const;
+        virtual void loadState(SimulationSnapshot *snapshot);
+
         virtual double getManifoldPressure() const;
         virtual double getIntakeAfr() const;
         virtual double getExhaustO2() const;
@@ -107,7 +113,12 @@ class Engine : public Part {
         double getInitialNoise() const { return m_initialNoise; }
         double getInitialJitter() const { return m_initialJitter; }
 
-        virtual Simulator *createSimulator(Vehicle *vehicle, Transmission *transmission);
+        // Reduced coordinates simulate only the crankshaft; see
+        // Simulator::SystemType::ReducedCoordinate
+        virtual Simulator *createSimulator(
+            Vehicle *vehicle,
+            Transmission *transmission,
+            bool reducedCoordinates = false);
 
     protected:
         std::string m_name;
@@ -22,6 +22,7 @@
 #include "info_cluster.h"
 #include "application_settings.h"
 #include "transmission.h"
+#include "impulse_response_store.h"
 
 #include "delta.h"
 #include "dtv.h"
@@ -135,6 +136,7 @@ class EngineSimApplication {
         Vehicle *m_vehicle;
         Transmission *m_transmission;
         Simulator *m_simulator;
+        ImpulseResponseStore m_impulseResponses;
         double m_dynoSpeed;
         double m_torque;
 
@@ -6,6 +6,7 @@
 #include "gas_system.h"
 #include "impulse_response.h"
 
+class SimulationSnapshot;
 class ExhaustSystem : public Part {
     friend class Engine;
 
@@ -29,6 +30,14 @@ class ExhaustSystem : public Part {
         virtual void destroy();
 
         void process(double dt);
+        double getFlowStiffness(double minPressureDifference) const;
+
+        void bindGasSystems(GasSystemStore *store);
+        void unbindGasSystems();
+
+        // Gas state lives in the store and is saved with it
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
 
         inline int getIndex() const { return m_index; }
         inline double getLength() const { return m_length; }
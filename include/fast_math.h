@@ -0,0 +1,46 @@
+#ifndef ATG_ENGINE_SIM_FAST_MATH_H
+#define ATG_ENGINE_SIM_FAST_MATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Branch-free replacements for std::exp and std::tanh for use in loops that
+// the compiler can vectorize. Both are checked against the standard library
+// in the tests.
+
+// Relative error below 1E-8 for any x. Arguments are clamped to +/-700, so
+// results saturate near the ends of the double range instead of overflowing.
+inline double fastExp(double x) {
+    constexpr double log2_e = 1.44269504088896340736;
+
+    // e^x = 2^n * 2^f, with n the integer nearest to x / ln(2) and
+    // |f| <= 1/2. 2^f is a degree 6 polynomial fitted at Chebyshev nodes and
+    // exact at f = 0.
+    x = std::fmin(std::fmax(x, -700.0), 700.0);
+    const double t = x * log2_e;
+    const double n = std::floor(t + 0.5);
+    const double f = t - n;
+
+    const double p = 1 + f * (0.6931471880293424
+        + f * (0.24022650922342703
+        + f * (0.05550357104253084
+        + f * (0.00961805666990112
+        + f * (0.0013390867351321667
+        + f * 0.00015461447458164912)))));
+
+    // 2^n written directly into the exponent field
+    const int64_t bits = (static_cast<int64_t>(n) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+
+    return p * scale;
+}
+
+// Absolute error below 1E-8 for any x
+inline double fastTanh(double x) {
+    const double e = fastExp(-2 * std::abs(x));
+    return std::copysign((1 - e) / (1 + e), x);
+}
+
+#endif /* ATG_ENGINE_SIM_FAST_MATH_H */
@@ -0,0 +1,30 @@
+#ifndef ATG_ENGINE_SIM_FFT_H
+#define ATG_ENGINE_SIM_FFT_H
+
+// In-place radix-2 complex FFT on split real/imaginary arrays
+class Fft {
+    public:
+        Fft();
+        ~Fft();
+
+        void initialize(int size);
+        void destroy();
+
+        void forward(float *re, float *im) const;
+
+        // Inverse transform, scaled by 1 / size
+        void inverse(float *re, float *im) const;
+
+        int getSize() const { return m_size; }
+
+    protected:
+        void transform(float *re, float *im, float sign) const;
+
+    protected:
+        int *m_bitReverse;
+        float *m_cos;
+        float *m_sin;
+        int m_size;
+};
+
+#endif /* ATG_ENGINE_SIM_FFT_H */
@@ -0,0 +1,69 @@
+#ifndef ATG_ENGINE_SIM_FLOW_SCHEDULE_H
+#define ATG_ENGINE_SIM_FLOW_SCHEDULE_H
+
+#include "gas_system_store.h"
+
+#include <vector>
+
+// Sequence of operations on the gas volumes of a store that would otherwise
+// run one after the other: flow along an edge, or limiting the velocity of a
+// volume to its speed of sound. The operations are grouped into waves in
+// which no two of them touch the same volume, and every operation goes into
+// the wave after the last one that touched any of its volumes. Operations on
+// a volume therefore run in the order in which they were added, and running
+// the schedule gives the same result as running the sequence in order. The
+// flow edges of a wave are evaluated together by GasSystem::flowBatch().
+class FlowSchedule {
+    public:
+        FlowSchedule();
+        ~FlowSchedule();
+
+        void initialize(GasSystemStore *store);
+        void destroy();
+
+        void clear();
+
+        // The flow through the edge, signed as returned by GasSystem::flow(),
+        // is written to result when the schedule runs
+        void addFlow(int edge, double *result = nullptr);
+        void addDissipateExcessVelocity(int system);
+
+        void run(double dt);
+
+        int getOperationCount() const { return static_cast<int>(m_operations.size()); }
+        int getWaveCount() const { return m_waveCount; }
+
+    protected:
+        struct Operation {
+            int edge;
+            int system;
+            double *result;
+        };
+
+        bool isScheduled() const;
+        void assignWaves();
+
+    protected:
+        GasSystemStore *m_store;
+        std::vector<Operation> m_operations;
+        int m_waveCount;
+
+        // Operations that the current waves were assigned for
+        std::vector<Operation> m_scheduledOperations;
+
+        // Last wave that touched each volume of the store, or -1
+        std::vector<int> m_systemWave;
+
+        std::vector<int> m_operationWave;
+        std::vector<int> m_waveStart;
+        std::vector<int> m_order;
+
+        // Flow edges of all waves in wave order, with the result pointer and
+        // the last computed flow of each
+        std::vector<int> m_waveEdgeStart;
+        std::vector<int> m_edges;
+        std::vector<double *> m_results;
+        std::vector<double> m_flows;
+};
+
+#endif /* ATG_ENGINE_SIM_FLOW_SCHEDULE_H */
@@ -3,10 +3,9 @@
 
 #include "gaussian_filter.h"
 
-class Function {
-    protected:
-        static GaussianFilter *DefaultGaussianFilter;
+#include <cmath>
 
+class Function {
     public:
         Function();
         virtual ~Function();
@@ -19,7 +18,20 @@ class Function {
         void setOutputScale(double s) { m_outputScale = s; }
         void addSample(double x, double y);
 
-        double sampleTriangle(double x) const;
+        // Resamples the triangle-filtered function onto a uniform grid so
+        // that sampleTriangle() becomes a single linear interpolation. The
+        // grid is refined until it is within maxError of the exact filter
+        // (relative to the function's range); if that takes more than
+        // maxResolution points the function is left unbaked. Adding samples
+        // discards the baked table.
+        bool bake(double maxError = 1E-4, int maxResolution = 4096);
+        void clearBake();
+        bool isBaked() const { return m_baked != nullptr; }
+        int getBakedResolution() const { return m_bakedResolution; }
+
+        inline double sampleTriangle(double x) const;
+        void sampleTriangle(const double *x, double *y, int n) const;
+        double sampleTriangleExact(double x) const;
         double sampleGaussian(double x) const;
         double triangle(double x) const;
         int closestSample(double x) const;
@@ -29,6 +41,11 @@ class Function {
         void getDomain(double *x0, double *x1);
         void getRange(double *y0, double *y1);
 
+    protected:
+        double triangleFilter(double x) const;
+        double triangleAverage(double x) const;
+        inline double sampleBaked(double x) const;
+
     protected:
         double *m_x;
         double *m_y;
@@ -43,7 +60,34 @@ class Function {
         int m_capacity;
         int m_size;
 
-        GaussianFilter *m_gaussianFilter;
+        const GaussianFilter *m_gaussianFilter;
+
+        double *m_baked;
+        double m_bakedX0;
+        double m_bakedX1;
+        double m_bakedInvSpacing;
+        double m_bakedLast;
+        int m_bakedResolution;
 };
 
+double Function::sampleTriangle(double x) const {
+    return (m_baked != nullptr)
+        ? sampleBaked(x * m_inputScale) * m_outputScale
+        : sampleTriangleExact(x);
+}
+
+double Function::sampleBaked(double x) const {
+    if (x >= m_bakedX1) return m_y[m_size - 1];
+    else if (x <= m_bakedX0) return m_y[0];
+
+    // The table has one padding entry past the end, so rounding up to the
+    // last grid point never reads out of bounds
+    const double s = std::fmin(
+        std::fmax((x - m_bakedX0) * m_bakedInvSpacing, 0.0), m_bakedLast);
+    const int i = static_cast<int>(s);
+    const double f = s - i;
+
+    return m_baked[i] + f * (m_baked[i + 1] - m_baked[i]);
+}
+
 #endif /* ATG_ENGINE_SIM_FUNCTION_H */
@@ -1,6 +1,8 @@
 #ifndef ATG_ENGINE_SIM_GAS_SYSTEM_H
 #define ATG_ENGINE_SIM_GAS_SYSTEM_H
 
+#include "gas_system_store.h"
+
 #include "constants.h"
 #include "units.h"
 
@@ -10,18 +12,11 @@
 class GasSystem {
     public:
         struct Mix {
-            double p_fuel = 0.0;
-            double p_inert = 1.0;
-            double p_o2 = 0.0;
-        };
-
-        struct State {
-            double n_mol = 0.0;
-            double E_k = 0.0;
-            double V = 0.0;
-            double momentum[2] = { 0.0, 0.0 };
+            Mix() : p_fuel(0.0), p_inert(1.0), p_o2(0.0) { /* void */ }
 
-            Mix mix;
+            double p_fuel;
+            double p_inert;
+            double p_o2;
         };
 
         struct FlowParameters {
@@ -33,12 +28,21 @@ class GasSystem {
         };
 
     public:
-        GasSystem() { /* void */ }
+        GasSystem();
+        GasSystem(GasSystemStore *store, int index);
+        GasSystem(const GasSystem &system);
         ~GasSystem() { /* void */ }
 
+        GasSystem &operator=(const GasSystem &system);
+
+        void bind(GasSystemStore *store, int index);
+        void unbind();
+        inline bool isBound() const { return m_state.base() != m_local; }
+        inline int getStoreIndex(const GasSystemStore *store) const { return store->indexOf(m_state.base()); }
+
         void setGeometry(double width, double height, double dx, double dy);
-        void initialize(double P, double V, double T, const Mix &mix = {}, int degreesOfFreedom = 5);
-        void reset(double P, double T, const Mix &mix = {});
+        void initialize(double P, double V, double T, const Mix &mix = Mix(), int degreesOfFreedom = 5);
+        void reset(double P, double T, const Mix &mix = Mix());
 
         void setVolume(double V);
         void setN(double n);
@@ -65,25 +69,47 @@ class GasSystem {
             double chokedFlowLimit,
             double chokedFlowRateCached);
         double loseN(double dn, double E_k_per_mol);
-        double gainN(double dn, double E_k_per_mol, const Mix &mix = {});
+        double gainN(double dn, double E_k_per_mol, const Mix &mix = Mix());
         void dissipateExcessVelocity();
 
         void updateVelocity(double dt, double beta = 1.0);
         void dissipateVelocity(double dt, double timeConstant);
 
         static double flow(const FlowParameters &params);
-        double flow(double k_flow, double dt, double P_env, double T_env, const Mix &mix = {});
+        static double flow(GasSystemStore *store, const GasSystemStore::FlowEdge &edge, double dt);
+
+        // Evaluates several flow edges of a store at once, in lanes of
+        // FlowBatchWidth. No two of the edges may share a gas volume (see
+        // FlowSchedule); each edge then gives the same result as flow() on
+        // its own.
+        static constexpr int FlowBatchWidth = 4;
+        static void flowBatch(
+            GasSystemStore *store,
+            const int *edges,
+            int edgeCount,
+            double dt,
+            double *flows = nullptr);
+
+        double flow(double k_flow, double dt, double P_env, double T_env, const Mix &mix = Mix());
 
         double pressureEquilibriumMaxFlow(const GasSystem *b) const;
         double pressureEquilibriumMaxFlow(double P_env, double T_env) const;
 
+        // Rate (1/s) at which flow through k_flow would close the pressure
+        // difference to another volume or to the environment. An explicit
+        // step longer than the inverse overshoots equilibrium. The flow law
+        // gets arbitrarily stiff as the difference goes to zero, so
+        // differences below minPressureDifference are treated as that.
+        double flowStiffness(double k_flow, const GasSystem *b, double minPressureDifference) const;
+        double flowStiffness(double k_flow, double P_env, double T_env, double minPressureDifference) const;
+
         inline static constexpr double kineticEnergyPerMol(double T, int degreesOfFreedom);
         inline static constexpr double heatCapacityRatio(int degreesOfFreedom);
         inline static double chokedFlowLimit(int degreesOfFreedom);
         inline static double chokedFlowRate(int degreesOfFreedom);
 
         inline double approximateDensity() const;
-        inline int degreesOfFreedom() const { return m_degreesOfFreedom; }
+        inline int degreesOfFreedom() const { return static_cast<int>(m_state.degreesOfFreedom()); }
         inline double n() const;
         inline double n(double V) const;
         inline double kineticEnergy() const;
@@ -104,20 +130,15 @@ class GasSystem {
         inline double n_inert() const;
         inline double n_o2() const;
         inline double heatCapacityRatio() const;
-        inline Mix mix() const { return m_state.mix; }
+        inline Mix mix() const;
 
     protected:
-        State m_state;
-
-        int m_degreesOfFreedom = 5;
+        void copyState(const GasSystemStore::Slot &target) const;
 
-        double m_chokedFlowLimit = 0;
-        double m_chokedFlowFactorCached = 0;
+        // Either points into m_local or into a slot of a GasSystemStore
+        GasSystemStore::Slot m_state;
 
-        double m_width = 0.0;
-        double m_height = 0.0;
-        double m_dx = 0.0;
-        double m_dy = 0.0;
+        double m_local[GasSystemStore::FieldCount];
 };
 
 inline constexpr double GasSystem::kineticEnergyPerMol(double T, int degreesOfFreedom) {
@@ -146,7 +167,7 @@ inline double GasSystem::approximateDensity() const {
 }
 
 inline double GasSystem::n() const {
-    return m_state.n_mol;
+    return m_state.n_mol();
 }
 
 inline double GasSystem::n(double V) const {
@@ -154,7 +175,7 @@ inline double GasSystem::n(double V) const {
 }
 
 inline double GasSystem::kineticEnergy() const {
-    return m_state.E_k;
+    return m_state.E_k();
 }
 
 inline double GasSystem::kineticEnergy(double n) const {
@@ -176,8 +197,8 @@ inline double GasSystem::totalEnergy() const {
     if (n() == 0) return 0;
 
     const double invMass = 1 / mass();
-    const double v_x = m_state.momentum[0] * invMass;
-    const double v_y = m_state.momentum[1] * invMass;
+    const double v_x = m_state.momentum_x() * invMass;
+    const double v_y = m_state.momentum_y() * invMass;
     const double v_squared = v_x * v_x + v_y * v_y;
 
     return kineticEnergy() + 0.5 * mass() * v_squared;
@@ -187,8 +208,8 @@ inline double GasSystem::bulkKineticEnergy() const {
     const double m = mass();
     if (m == 0) return 0;
 
-    const double v_x = m_state.momentum[0] / m;
-    const double v_y = m_state.momentum[1] / m;
+    const double v_x = m_state.momentum_x() / m;
+    const double v_y = m_state.momentum_y() / m;
     const double v_squared = v_x * v_x + v_y * v_y;
     return 0.5 * m * v_squared;
 }
@@ -197,7 +218,7 @@ inline double GasSystem::dynamicPressure(double dx, double dy) const {
     if (n() == 0 || kineticEnergy() == 0) return 0;
 
     const double inverseMass = 1 / this->mass();
-    const double v = inverseMass * (dx * m_state.momentum[0] + dy * m_state.momentum[1]);
+    const double v = inverseMass * (dx * m_state.momentum_x() + dy * m_state.momentum_y());
 
     if (v <= 0) {
         return 0;
@@ -214,7 +235,7 @@ inline double GasSystem::dynamicPressure(double dx, double dy) const {
 
     const double x = 1 + ((hcr - 1) / 2) * machNumber_squared;
     double x_d;
-    switch (m_degreesOfFreedom) {
+    switch (degreesOfFreedom()) {
     case 3:
         x_d = x * x * x * x * x;
         break;
@@ -239,27 +260,27 @@ inline double GasSystem::mass() const {
 inline double GasSystem::pressure() const {
     const double volume = this->volume();
     return (volume != 0)
-        ? kineticEnergy() / (0.5 * m_degreesOfFreedom * volume)
+        ? kineticEnergy() / (0.5 * degreesOfFreedom() * volume)
         : 0;
 }
 
 inline double GasSystem::temperature() const {
     if (n() == 0) return 0;
-    else return kineticEnergy() / (0.5 * m_degreesOfFreedom * n() * constants::R);
+    else return kineticEnergy() / (0.5 * degreesOfFreedom() * n() * constants::R);
 }
 
 inline double GasSystem::velocity_x() const {
     if (n() == 0) return 0;
-    else return m_state.momentum[0] / mass();
+    else return m_state.momentum_x() / mass();
 }
 
 inline double GasSystem::velocity_y() const {
     if (n() == 0) return 0;
-    else return m_state.momentum[1] / mass();
+    else return m_state.momentum_y() / mass();
 }
 
 inline double GasSystem::volume() const {
-    return m_state.V;
+    return m_state.V();
 }
 
 inline double GasSystem::volume(double n) const {
@@ -267,19 +288,28 @@ inline double GasSystem::volume(double n) const {
 }
 
 inline double GasSystem::n_fuel() const {
-    return m_state.mix.p_fuel * n();
+    return m_state.p_fuel() * n();
 }
 
 inline double GasSystem::n_inert() const {
-    return m_state.mix.p_inert * n();
+    return m_state.p_inert() * n();
 }
 
 inline double GasSystem::n_o2() const {
-    return m_state.mix.p_o2 * n();
+    return m_state.p_o2() * n();
+}
+
+inline GasSystem::Mix GasSystem::mix() const {
+    Mix mix;
+    mix.p_fuel = m_state.p_fuel();
+    mix.p_inert = m_state.p_inert();
+    mix.p_o2 = m_state.p_o2();
+
+    return mix;
 }
 
 inline double GasSystem::heatCapacityRatio() const {
-    return heatCapacityRatio(m_degreesOfFreedom);
+    return heatCapacityRatio(degreesOfFreedom());
 }
 
 #endif /* ATG_ENGINE_SIM_GAS_SYSTEM_H */
@@ -0,0 +1,107 @@
+#ifndef ATG_ENGINE_SIM_GAS_SYSTEM_STORE_H
+#define ATG_ENGINE_SIM_GAS_SYSTEM_STORE_H
+
+#include <cstddef>
+
+class SimulationSnapshot;
+class GasSystemStore {
+    public:
+        enum Field {
+            N_mol,
+            KineticEnergy,
+            Volume,
+            Momentum_x,
+            Momentum_y,
+            P_fuel,
+            P_inert,
+            P_o2,
+            DegreesOfFreedom,
+            ChokedFlowLimit,
+            ChokedFlowFactor,
+            Width,
+            Height,
+            Dx,
+            Dy,
+            FieldCount
+        };
+
+        struct FlowEdge {
+            int system_0 = -1;
+            int system_1 = -1;
+            double crossSectionArea_0 = 0.0;
+            double crossSectionArea_1 = 0.0;
+            double direction_x = 1.0;
+            double direction_y = 0.0;
+            double k_flow = 0.0;
+        };
+
+        // Strided reference to the fields of a single gas volume. In the
+        // store each field is one contiguous array, so consecutive fields of
+        // a volume are a whole array apart. With a stride of 1 the fields are
+        // packed together, which is how standalone GasSystem instances store
+        // their state.
+        class Slot {
+            public:
+                Slot() : m_base(nullptr), m_stride(1) { /* void */ }
+                Slot(double *base, int stride) : m_base(base), m_stride(stride) { /* void */ }
+
+                inline double &operator[](int field) const { return m_base[field * m_stride]; }
+
+                inline double &n_mol() const { return (*this)[N_mol]; }
+                inline double &E_k() const { return (*this)[KineticEnergy]; }
+                inline double &V() const { return (*this)[Volume]; }
+                inline double &momentum_x() const { return (*this)[Momentum_x]; }
+                inline double &momentum_y() const { return (*this)[Momentum_y]; }
+                inline double &p_fuel() const { return (*this)[P_fuel]; }
+                inline double &p_inert() const { return (*this)[P_inert]; }
+                inline double &p_o2() const { return (*this)[P_o2]; }
+                inline double &degreesOfFreedom() const { return (*this)[DegreesOfFreedom]; }
+                inline double &chokedFlowLimit() const { return (*this)[ChokedFlowLimit]; }
+                inline double &chokedFlowFactor() const { return (*this)[ChokedFlowFactor]; }
+                inline double &width() const { return (*this)[Width]; }
+                inline double &height() const { return (*this)[Height]; }
+                inline double &dx() const { return (*this)[Dx]; }
+                inline double &dy() const { return (*this)[Dy]; }
+
+                inline double *base() const { return m_base; }
+                inline int stride() const { return m_stride; }
+
+            private:
+                double *m_base;
+                int m_stride;
+        };
+
+    public:
+        GasSystemStore();
+        ~GasSystemStore();
+
+        void initialize(int capacity, int edgeCapacity);
+        void destroy();
+
+        int allocate();
+        int addEdge(const FlowEdge &edge);
+
+        // Every gas volume and flow edge in two contiguous blocks
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
+        inline Slot getSlot(int index) { return Slot(m_data + index, m_capacity); }
+        inline double *getField(Field field) { return m_data + (size_t)field * m_capacity; }
+        inline FlowEdge &getEdge(int index) { return m_edges[index]; }
+        inline int indexOf(const double *base) const { return static_cast<int>(base - m_data); }
+
+        inline int getCapacity() const { return m_capacity; }
+        inline int getSystemCount() const { return m_systemCount; }
+        inline int getEdgeCount() const { return m_edgeCount; }
+
+    protected:
+        double *m_data;
+        int m_capacity;
+        int m_systemCount;
+
+        FlowEdge *m_edges;
+        int m_edgeCapacity;
+        int m_edgeCount;
+};
+
+#endif /* ATG_ENGINE_SIM_GAS_SYSTEM_STORE_H */
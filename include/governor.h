@@ -24,6 +24,9 @@ public:
     virtual void setSpeedControl(double s);
     virtual void update(double dt, Engine *engine);
 
+    virtual void saveState(SimulationSnapshot *snapshot) const;
+    virtual void loadState(SimulationSnapshot *snapshot);
+
 protected:
     double m_minSpeed;
     double m_maxSpeed;
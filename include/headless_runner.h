@@ -0,0 +1,140 @@
+#ifndef ATG_ENGINE_SIM_HEADLESS_RUNNER_H
+#define ATG_ENGINE_SIM_HEADLESS_RUNNER_H
+
+#include "simulator.h"
+#include "control_profile.h"
+#include "impulse_response_store.h"
+#include "wave_writer.h"
+#include "units.h"
+
+#include <string>
+
+class HeadlessRunner {
+    public:
+        struct Parameters {
+            std::string scriptPath = "../assets/main.mr";
+
+            // Compiled script cache; an empty path always compiles the script
+            std::string scriptCachePath = "engine_script.cache";
+
+            // Prepared impulse responses; an empty path prepares them from
+            // the WAV files on every run
+            std::string impulseResponseCachePath = "impulse_response_cache";
+
+            double simulationTime = 10.0;
+            double warmupTime = 2.0;
+            double starterTime = 1.0;
+            double frameRate = 60.0;
+
+            double throttle = 1.0;
+            double dynoSpeed = 0.0;
+            int simulationFrequency = 0;
+            int fluidThreads = 1;
+            unsigned long long seed = 0;
+
+            // Simulate only the crankshaft, with the pistons and rods folded
+            // into it, instead of constraining every part
+            bool reducedCoordinates = false;
+
+            Simulator::IntegrationMethod integrationMethod =
+                Simulator::IntegrationMethod::SemiImplicitEuler;
+
+            // Crank angle (in degrees) covered by each simulation step. When
+            // set, the simulation frequency follows engine speed, bounded by
+            // simulationFrequency and maxSimulationFrequency if given.
+            double crankAnglePerStep = 0.0;
+            int maxSimulationFrequency = 0;
+
+            // Fluid steps per simulation step; adaptive when the minimum and
+            // maximum differ. Zero keeps the engine's default.
+            int minFluidSteps = 0;
+            int maxFluidSteps = 0;
+
+            // Rendering to a WAV file runs offline: no latency control and
+            // the synthesizer runs synchronously on the simulation thread
+            std::string outputPath;
+            std::string profilePath;
+
+            // Loading a snapshot replaces the warmup; saving one captures
+            // the state at the end of the warmup
+            std::string loadSnapshotPath;
+            std::string saveSnapshotPath;
+        };
+
+        struct Report {
+            long long steps = 0;
+            long long frames = 0;
+            double simulatedTime = 0.0;
+            double wallTime = 0.0;
+            double physicsTime = 0.0;
+            double audioTime = 0.0;
+            double stepsPerSecond = 0.0;
+            double realTimeFactor = 0.0;
+            double averageProcessingTime = 0.0;
+            double averageRpm = 0.0;
+            double averageDynoTorque = 0.0;
+            int simulationFrequency = 0;
+            double averageSimulationFrequency = 0.0;
+            bool adaptiveFrequency = false;
+            bool reducedCoordinates = false;
+            bool linearlyImplicit = false;
+            int fluidThreads = 1;
+            int fluidPartitions = 0;
+            double averageFluidSteps = 0.0;
+            bool adaptiveFluidSteps = false;
+            long long sealedChamberSteps = 0;
+            double sealedChamberFraction = 0.0;
+            double averageSolverIterations = 0.0;
+            double maxSolverResidual = 0.0;
+            long long unconvergedSolverSteps = 0;
+            long long audioSamples = 0;
+
+            // Checked after every frame; the run stops at the first frame
+            // that leaves the engine in a state it could not recover from
+            bool stable = true;
+            double maxJointError = 0.0;
+        };
+
+        // Thresholds of the stability check, well beyond anything a stable
+        // simulation reaches
+        static constexpr double MaxStableJointError = 1.0 * units::mm;
+        static constexpr double MaxStableRedlineFraction = 2.0;
+
+    public:
+        HeadlessRunner();
+        ~HeadlessRunner();
+
+        bool initialize(const Parameters &params);
+        bool run(Report *report);
+        void destroy();
+
+        Simulator *getSimulator() const { return m_simulator; }
+
+        static void printReport(const Report &report);
+        void printPhaseBreakdown() const;
+
+    protected:
+        bool loadScript();
+        bool loadImpulseResponses();
+        double runFrame(double *physicsTime, double *audioTime);
+        bool checkStability(Report *report) const;
+        void applyControls(double throttle, double dynoSpeed);
+        void renderOffline();
+
+        Parameters m_parameters;
+
+        Simulator *m_simulator;
+        Engine *m_engine;
+        Vehicle *m_vehicle;
+        Transmission *m_transmission;
+
+        int16_t *m_audioScratch;
+        int m_audioScratchSize;
+
+        ControlProfile m_profile;
+        ImpulseResponseStore m_impulseResponses;
+        WaveWriter m_waveWriter;
+        bool m_recordAudio;
+};
+
+#endif /* ATG_ENGINE_SIM_HEADLESS_RUNNER_H */
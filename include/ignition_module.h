@@ -7,6 +7,7 @@
 #include "function.h"
 #include "units.h"
 
+class SimulationSnapshot;
 class IgnitionModule : public Part {
     public:
         struct Parameters {
@@ -39,6 +40,9 @@ class IgnitionModule : public Part {
 
         double getTimingAdvance();
 
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
         bool m_enabled;
 
     protected:
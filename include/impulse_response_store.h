@@ -0,0 +1,89 @@
+#ifndef ATG_ENGINE_SIM_IMPULSE_RESPONSE_STORE_H
+#define ATG_ENGINE_SIM_IMPULSE_RESPONSE_STORE_H
+
+#include "convolution_filter.h"
+#include "mapped_file.h"
+
+#include <cinttypes>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Loads impulse responses from WAV files and keeps one prepared copy of each,
+// shared by every synthesizer channel that uses it. A response is trimmed,
+// normalized and split into frequency-domain partitions once; if a cache
+// directory is set, the result is written there as a sidecar file so that
+// later runs can map it straight into memory. Asset directories may be
+// read-only, so nothing is ever written next to the WAV.
+class ImpulseResponseStore {
+    public:
+        static constexpr uint32_t SidecarMagic = 0x43524945; // "EIRC"
+        static constexpr uint32_t SidecarVersion = 1;
+
+        // Responses are cut off after the last sample louder than the
+        // threshold and are never longer than MaxSamples
+        static constexpr int MaxSamples = 10000;
+        static constexpr int SilenceThreshold = 100;
+
+    public:
+        ImpulseResponseStore();
+        ~ImpulseResponseStore();
+
+        // Returns the kernel for a 16-bit PCM WAV file, loading it on first
+        // use. Kernels stay valid until the store is destroyed. Returns
+        // nullptr if the file can't be read.
+        const ConvolutionFilter::Kernel *load(const std::string &filename);
+        void destroy();
+
+        // Directory that sidecars are read from and written to; created on
+        // first use. An empty path disables sidecars.
+        void setCacheDirectory(const std::string &directory) { m_cacheDirectory = directory; }
+        const std::string &getCacheDirectory() const { return m_cacheDirectory; }
+
+        int getEntryCount() const;
+
+        // Sidecars are named after the WAV's absolute path, so responses with
+        // the same name in different directories don't collide
+        std::string getSidecarPath(const std::string &filename) const;
+
+    protected:
+        struct Entry {
+            ConvolutionFilter::Kernel kernel;
+
+            // The kernel points into the sidecar if it was mapped and into
+            // the data otherwise
+            MappedFile sidecar;
+            std::vector<float> data;
+        };
+
+        struct SourceStamp {
+            uint64_t size = 0;
+            int64_t time = 0;
+        };
+
+        struct SidecarHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t partitionSize;
+            uint32_t sampleCount;
+            uint32_t partitionCount;
+            uint32_t reserved;
+            uint64_t sourceSize;
+            int64_t sourceTime;
+        };
+
+        static bool getSourceStamp(const std::string &filename, SourceStamp *stamp);
+
+        bool readSidecar(const std::string &filename, const SourceStamp &stamp, Entry *entry);
+        bool writeSidecar(const std::string &filename, const SourceStamp &stamp, const Entry &entry);
+        bool build(const std::string &filename, Entry *entry);
+
+    protected:
+        std::map<std::string, Entry *> m_entries;
+        mutable std::mutex m_lock;
+
+        std::string m_cacheDirectory;
+};
+
+#endif /* ATG_ENGINE_SIM_IMPULSE_RESPONSE_STORE_H */
@@ -5,6 +5,7 @@
 
 #include "gas_system.h"
 
+class SimulationSnapshot;
 class Intake : public Part {
     public:
         struct Parameters {
@@ -44,6 +45,14 @@ class Intake : public Part {
         virtual void destroy();
 
         void process(double dt);
+        double getFlowStiffness(double minPressureDifference) const;
+
+        void bindGasSystems(GasSystemStore *store);
+        void unbindGasSystems();
+
+        // Gas state lives in the store and is saved with it
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
 
         inline double getRunnerFlowRate() const { return m_runnerFlowRate; }
         inline double getThrottlePlatePosition() const { return m_idleThrottlePlatePosition * m_throttle; }
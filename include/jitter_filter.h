@@ -8,6 +8,7 @@
 
 #include <random>
 
+class SimulationSnapshot;
 class JitterFilter : public Filter {
 public:
     JitterFilter();
@@ -18,6 +19,7 @@ public:
         float noiseCutoffFrequency,
         float audioFrequency);
     virtual float f(float sample) override;
+    void process(const float *input, float *output, int samples);
 
     __forceinline float fast_f(float sample, float jitterScale = 1.0f) {
         m_history[m_offset] = sample;
@@ -46,6 +48,11 @@ public:
         return v1 * s_frac + v0 * (1 - s_frac);
     }
 
+    inline void seed(unsigned int seed) { m_generator.seed(seed); }
+
+    void saveState(SimulationSnapshot *snapshot) const;
+    void loadState(SimulationSnapshot *snapshot);
+
     inline void setJitterScale(float jitterScale) { m_jitterScale = jitterScale; }
     inline float getJitterScale() const { return m_jitterScale; }
 
@@ -5,14 +5,19 @@
 
 #include "function.h"
 
+class SimulationSnapshot;
 class LevelingFilter : public Filter {
     public:
         LevelingFilter();
         virtual ~LevelingFilter();
 
         virtual float f(float sample);
+        void process(const float *input, float *output, int samples);
         float getAttenuation() const { return m_attenuation; }
 
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
     protected:
         float m_peak;
         float m_attenuation;
@@ -5,12 +5,14 @@
 
 #include "constants.h"
 
+class SimulationSnapshot;
 class LowPassFilter : public Filter {
     public:
         LowPassFilter();
         virtual ~LowPassFilter();
 
         virtual float f(float sample) override;
+        void process(const float *input, float *output, int samples);
 
         __forceinline float fast_f(float sample) {
             const float alpha = m_dt / (m_rc + m_dt);
@@ -23,6 +25,9 @@ class LowPassFilter : public Filter {
             m_rc = 1.0f / (f * 2.0f * static_cast<float>(constants::pi));
         }
 
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
         float m_dt;
 
     protected:
@@ -0,0 +1,35 @@
+#ifndef ATG_ENGINE_SIM_MAPPED_FILE_H
+#define ATG_ENGINE_SIM_MAPPED_FILE_H
+
+#include <cinttypes>
+#include <cstddef>
+#include <string>
+
+// Read-only view of a file mapped into memory. Pages are loaded by the OS on
+// first access and are shared with every other mapping of the same file.
+class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool open(const std::string &filename);
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+        const uint8_t *getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    protected:
+        const uint8_t *m_data;
+        size_t m_size;
+
+#ifdef _WIN32
+        void *m_file;
+        void *m_mapping;
+#endif /* _WIN32 */
+};
+
+#endif /* ATG_ENGINE_SIM_MAPPED_FILE_H */
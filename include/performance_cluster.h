@@ -35,6 +35,8 @@ class PerformanceCluster : public UiElement {
         LabeledGauge *m_audioLagGauge;
 
     protected:
+        void renderPhaseBreakdown(const Bounds &bounds);
+
         double m_timePerTimestep;
 
         double m_filteredSimulationFrequency;
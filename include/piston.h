@@ -5,6 +5,7 @@
 
 class ConnectingRod;
 class CylinderBank;
+class SimulationSnapshot;
 class Piston : public Part {
     public:
         struct Parameters {
@@ -31,6 +32,13 @@ class Piston : public Part {
         double relativeY() const;
 
         double calculateCylinderWallForce() const;
+
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
+        // Wall force used when the piston is not held by a cylinder
+        // constraint, in which case the simulator computes it
+        inline void setCylinderWallForce(double force) { m_cylinderWallForce = force; }
         inline ConnectingRod *getRod() const { return m_rod; }
         inline CylinderBank *getCylinderBank() const { return m_bank; }
         inline int getCylinderIndex() const { return m_cylinderIndex; }
@@ -44,6 +52,7 @@ class Piston : public Part {
         ConnectingRod *m_rod;
         CylinderBank *m_bank;
         atg_scs::LineConstraint *m_cylinderConstraint;
+        double m_cylinderWallForce;
         int m_cylinderIndex;
         double m_compressionHeight;
         double m_displacement;
@@ -3,6 +3,8 @@
 
 #include "simulator.h"
 
+#include "crank_slider_linkage.h"
+#include "piston_force_generator.h"
 #include "engine.h"
 #include "transmission.h"
 #include "combustion_chamber.h"
@@ -13,10 +15,13 @@
 #include "derivative_filter.h"
 #include "vehicle_drag_constraint.h"
 #include "delay_filter.h"
+#include "worker_pool.h"
+#include "flow_schedule.h"
 
 #include "scs.h"
 
 #include <chrono>
+#include <vector>
 
 class PistonEngineSimulator : public Simulator {
     public:
@@ -26,23 +31,94 @@ class PistonEngineSimulator : public Simulator {
         void loadSimulation(Engine *engine, Vehicle *vehicle, Transmission *transmission);
 
         virtual double getTotalExhaustFlow() const;
+        virtual void startFrame(double dt) override;
         void endFrame();
         virtual void destroy() override;
 
+        virtual void setRandomSeed(uint64_t seed) override;
+
         void setFluidSimulationSteps(int steps) { m_fluidSimulationSteps = steps; }
         int getFluidSimulationSteps() const { return m_fluidSimulationSteps; }
         int getFluidSimulationFrequency() const { return m_fluidSimulationSteps * getSimulationFrequency(); }
 
+        // In adaptive mode the number of fluid steps is chosen every step,
+        // within the given range, so that no flow path moves more than
+        // AdaptiveFluidStepFraction of the way to pressure equilibrium in a
+        // single fluid step. Pressure differences below the tolerance are
+        // not resolved any further.
+        static constexpr double AdaptiveFluidStepFraction = 0.5;
+
+        void setAdaptiveFluidSimulation(bool adaptive) { m_adaptiveFluidSimulation = adaptive; }
+        bool isAdaptiveFluidSimulation() const { return m_adaptiveFluidSimulation; }
+        void setFluidSimulationStepRange(int minSteps, int maxSteps);
+        int getMinFluidSimulationSteps() const { return m_minFluidSimulationSteps; }
+        int getMaxFluidSimulationSteps() const { return m_maxFluidSimulationSteps; }
+        void setFluidPressureTolerance(double tolerance) { m_fluidPressureTolerance = tolerance; }
+        double getFluidPressureTolerance() const { return m_fluidPressureTolerance; }
+
+        // Fluid steps used by the last simulation step and on average since
+        // the statistics were last reset
+        int getLastFluidSimulationSteps() const { return m_lastFluidSimulationSteps; }
+        double getAverageFluidSimulationSteps() const;
+        void resetFluidSimulationStatistics();
+
+        // Number of threads used to run the fluid simulation. Results are
+        // identical for any thread count.
+        void setFluidSimulationThreadCount(int threads);
+        int getFluidSimulationThreadCount() const { return m_fluidWorkers.getThreadCount() + 1; }
+        int getFluidPartitionCount() const { return static_cast<int>(m_fluidPartitions.size()); }
+
+        // With batched flow the chambers of a partition run their flow edges
+        // through a FlowSchedule instead of one chamber at a time. The
+        // schedule keeps the order of operations on every gas volume, so
+        // both give the same result. Off by default: the flow law does not
+        // vectorize, so on its own the batched path is slightly slower than
+        // the per-chamber loop.
+        void setBatchedFlowEnabled(bool enabled) { m_batchedFlow = enabled; }
+        bool isBatchedFlowEnabled() const { return m_batchedFlow; }
+
         virtual double getAverageOutputSignal() const override;
 
+        const CrankSliderLinkage &getCrankSliderLinkage() const { return m_crankSlider; }
+
+        // Largest distance between the two ends of any connecting rod joint.
+        // The constraints only hold the linkage together approximately, so
+        // this stays small in a stable simulation and grows quickly in an
+        // unstable one.
+        double getMaxJointError() const;
+
+        // Baumgarte gains of the constraints holding the engine together,
+        // before any adjustment for the integration method
+        static constexpr double ConstraintStiffness = 5000.0;
+        static constexpr double ConstraintDamping = 10.0;
+
         DerivativeFilter m_derivativeFilter;
 
     protected:
+        virtual void processRigidBodies(double dt) override;
         virtual void simulateStep_() override;
 
+        virtual void saveState(SimulationSnapshot *snapshot) const override;
+        virtual void loadState(SimulationSnapshot *snapshot) override;
+
     protected:
         void placeAndInitialize();
         void placeCylinder(int i);
+
+        void bindGasSystems();
+        void seedChambers();
+        void unbindGasSystems();
+
+        // A timestep of zero gives the semi-implicit behavior
+        void updateConstraintGains(double dt);
+
+        // A timestep of zero restores the nominal piston masses once and is
+        // free after that
+        void linearizePistonForces(double dt);
+
+        void partitionFluidSystems();
+        int chooseFluidSimulationSteps(double dt);
+        void simulateFluidPartition(int partition, double dt, int steps);
         
     protected:
         virtual void writeToSynthesizer() override;
@@ -55,6 +131,8 @@ class PistonEngineSimulator : public Simulator {
         atg_scs::RotationFrictionConstraint *m_crankshaftFrictionConstraints;
         atg_scs::LineConstraint *m_cylinderWallConstraints;
         atg_scs::LinkConstraint *m_linkConstraints;
+        CrankSliderLinkage m_crankSlider;
+        PistonForceGenerator m_pistonForces;
         atg_scs::RigidBody m_vehicleMass;
         VehicleDragConstraint m_vehicleDrag;
 
@@ -67,7 +145,35 @@ class PistonEngineSimulator : public Simulator {
 
         double *m_exhaustFlowStagingBuffer;
 
+        GasSystemStore m_gasSystems;
+
+        // Chambers connected through a shared intake or exhaust system along
+        // with those intakes and exhausts. Partitions exchange no gas with
+        // each other, so they can be simulated on separate threads.
+        struct FluidPartition {
+            std::vector<int> chambers;
+            std::vector<int> intakes;
+            std::vector<int> exhaustSystems;
+            FlowSchedule flowSchedule;
+        };
+
+        std::vector<FluidPartition> m_fluidPartitions;
+        WorkerPool m_fluidWorkers;
+
         int m_fluidSimulationSteps;
+        bool m_batchedFlow;
+
+        double m_constraintGainTimestep;
+        bool m_pistonForcesLinearized;
+
+        bool m_adaptiveFluidSimulation;
+        int m_minFluidSimulationSteps;
+        int m_maxFluidSimulationSteps;
+        double m_fluidPressureTolerance;
+
+        int m_lastFluidSimulationSteps;
+        long long m_totalFluidSimulationSteps;
+        long long m_fluidSimulationStepSamples;
 };
 
 #endif /* ATG_ENGINE_SIM_PISTON_ENGINE_SIMULATOR_H */
@@ -0,0 +1,66 @@
+#ifndef ATG_ENGINE_SIM_PISTON_FORCE_GENERATOR_H
+#define ATG_ENGINE_SIM_PISTON_FORCE_GENERATOR_H
+
+#include "scs.h"
+
+#include <vector>
+
+class Engine;
+
+// Gas pressure and friction forces on every piston of an engine, applied by a
+// single force generator. The model is the one in
+// CombustionChamber::calculatePistonForce(), which remains the reference,
+// evaluated over arrays holding one entry per cylinder. The exponential and
+// hyperbolic tangent of the friction model come from fast_math.h; the
+// friction force differs from the reference by less than 1E-8 of the sum of
+// the breakaway and Coulomb friction forces. The reduced-coordinate system
+// still calls the reference for each chamber, so its friction forces differ
+// from these by the same small amount.
+class PistonForceGenerator : public atg_scs::ForceGenerator {
+    public:
+        PistonForceGenerator();
+        virtual ~PistonForceGenerator();
+
+        // The friction model of each chamber is read once here
+        void initialize(Engine *engine);
+        void destroy();
+
+        // Reads the chamber pressures, cylinder wall forces and implicit
+        // damping, none of which change during a step, and checks that the
+        // pressure forces are finite
+        void prepare();
+
+        virtual void apply(atg_scs::SystemState *state) override;
+
+        // Forces along the cylinder axes for the given piston speeds along
+        // the same axes
+        void calculateForces(const double *v_s, double *F) const;
+
+        int getCylinderCount() const { return m_cylinderCount; }
+
+    protected:
+        Engine *m_engine;
+        int m_cylinderCount;
+
+        std::vector<int> m_bodies;
+        std::vector<double> m_dx;
+        std::vector<double> m_dy;
+        std::vector<double> m_area;
+        std::vector<double> m_crankcasePressure;
+
+        std::vector<double> m_frictionCoeff;
+        std::vector<double> m_breakawayFriction;
+        std::vector<double> m_inverseStribeckVelocity;
+        std::vector<double> m_inverseCoulombVelocity;
+        std::vector<double> m_viscousFriction;
+
+        // Set by prepare()
+        std::vector<double> m_pressure;
+        std::vector<double> m_wallForce;
+        std::vector<double> m_implicitDamping;
+
+        std::vector<double> m_speed;
+        std::vector<double> m_force;
+};
+
+#endif /* ATG_ENGINE_SIM_PISTON_FORCE_GENERATOR_H */
@@ -0,0 +1,60 @@
+#ifndef ATG_ENGINE_SIM_RANDOM_STREAM_H
+#define ATG_ENGINE_SIM_RANDOM_STREAM_H
+
+#include <cstdint>
+
+class SimulationSnapshot;
+
+// Seeded pseudo-random number generator owned by a single object. Runs
+// Lanes independent xoshiro128+ generators side by side so that blocks of
+// numbers can be generated with vector instructions; values are consumed
+// in lane order, so scalar and block use produce the same sequence.
+class RandomStream {
+    public:
+        static constexpr int Lanes = 8;
+
+    public:
+        RandomStream();
+        ~RandomStream();
+
+        // Different stream indices with the same seed give independent sequences
+        void seed(uint64_t seed, uint64_t stream = 0);
+
+        inline uint32_t next() {
+            if (m_index == Lanes) step();
+            return m_output[m_index++];
+        }
+
+        // Uniform in [0, 1)
+        inline double uniform() {
+            return next() * (1.0 / 4294967296.0);
+        }
+
+        // Uniform in [-1, 1)
+        inline float uniformSigned() {
+            return toSigned(next());
+        }
+
+        // Equivalent to calling uniformSigned() n times
+        void fillSigned(float *target, int n);
+
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
+    protected:
+        static inline float toSigned(uint32_t x) {
+            return static_cast<float>(x >> 8) * (2.0f / 16777216.0f) - 1.0f;
+        }
+
+        void step();
+
+    protected:
+        uint32_t m_s0[Lanes];
+        uint32_t m_s1[Lanes];
+        uint32_t m_s2[Lanes];
+        uint32_t m_s3[Lanes];
+        uint32_t m_output[Lanes];
+        int m_index;
+};
+
+#endif /* ATG_ENGINE_SIM_RANDOM_STREAM_H */
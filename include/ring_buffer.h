@@ -4,6 +4,7 @@
 #include "part.h"
 
 #include <cstring>
+#include <atomic>
 
 template <typename T_Data>
 class RingBuffer {
@@ -141,6 +142,18 @@ public:
         return m_start;
     }
 
+    inline size_t capacity() const {
+        return m_capacity;
+    }
+
+    inline T_Data *data() {
+        return m_buffer;
+    }
+
+    inline const T_Data *data() const {
+        return m_buffer;
+    }
+
 private:
     T_Data *m_buffer;
     size_t m_capacity;
@@ -148,4 +161,105 @@ private:
     size_t m_start;
 };
 
+// Single-producer/single-consumer variant that can be shared between two
+// threads without locking. One thread may only write and the other may only
+// read; indices increase monotonically and the capacity is rounded up to a
+// power of two so that they can be masked instead of wrapped.
+template <typename T_Data>
+class SpscRingBuffer {
+public:
+    SpscRingBuffer() {
+        m_buffer = nullptr;
+        m_capacity = 0;
+        m_mask = 0;
+        m_writeIndex = 0;
+        m_readIndex = 0;
+    }
+
+    ~SpscRingBuffer() {
+        destroy();
+    }
+
+    void initialize(size_t capacity) {
+        m_capacity = 1;
+        while (m_capacity < capacity) m_capacity <<= 1;
+
+        m_buffer = new T_Data[m_capacity];
+        m_mask = m_capacity - 1;
+        m_writeIndex = 0;
+        m_readIndex = 0;
+    }
+
+    void destroy() {
+        if (m_buffer != nullptr) {
+            delete[] m_buffer;
+            m_buffer = nullptr;
+        }
+
+        m_capacity = 0;
+        m_mask = 0;
+        m_writeIndex = 0;
+        m_readIndex = 0;
+    }
+
+    // Producer only. Writes as many of the n values as fit and returns the
+    // number written.
+    inline size_t write(const T_Data *data, size_t n) {
+        const size_t w = m_writeIndex.load(std::memory_order_relaxed);
+        const size_t r = m_readIndex.load(std::memory_order_acquire);
+        const size_t free = m_capacity - (w - r);
+        if (n > free) n = free;
+
+        const size_t offset = w & m_mask;
+        const size_t first = (offset + n <= m_capacity) ? n : m_capacity - offset;
+        memcpy(m_buffer + offset, data, first * sizeof(T_Data));
+        memcpy(m_buffer, data + first, (n - first) * sizeof(T_Data));
+
+        m_writeIndex.store(w + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer only. Reads and removes up to n values and returns the number
+    // read.
+    inline size_t read(T_Data *target, size_t n) {
+        const size_t r = m_readIndex.load(std::memory_order_relaxed);
+        const size_t w = m_writeIndex.load(std::memory_order_acquire);
+        const size_t available = w - r;
+        if (n > available) n = available;
+
+        const size_t offset = r & m_mask;
+        const size_t first = (offset + n <= m_capacity) ? n : m_capacity - offset;
+        memcpy(target, m_buffer + offset, first * sizeof(T_Data));
+        memcpy(target + first, m_buffer, (n - first) * sizeof(T_Data));
+
+        m_readIndex.store(r + n, std::memory_order_release);
+        return n;
+    }
+
+    // Exact when called from either end; a snapshot otherwise
+    inline size_t size() const {
+        const size_t r = m_readIndex.load(std::memory_order_acquire);
+        const size_t w = m_writeIndex.load(std::memory_order_acquire);
+        return w - r;
+    }
+
+    inline size_t capacity() const {
+        return m_capacity;
+    }
+
+    // Discards everything in the buffer. Neither end may be in use.
+    inline void clear() {
+        m_readIndex.store(m_writeIndex.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    T_Data *m_buffer;
+    size_t m_capacity;
+    size_t m_mask;
+
+    // Kept on separate cache lines so that the two threads do not contend
+    alignas(64) std::atomic<size_t> m_writeIndex;
+    alignas(64) std::atomic<size_t> m_readIndex;
+};
+
 #endif /* ATG_ENGINE_SIM_RING_BUFFER_H */
@@ -0,0 +1,96 @@
+#ifndef ATG_ENGINE_SIM_SIMULATION_PROFILER_H
+#define ATG_ENGINE_SIM_SIMULATION_PROFILER_H
+
+#include <chrono>
+#include <vector>
+
+class SimulationProfiler {
+    public:
+        enum class Phase {
+            RigidBodySystem,
+            EngineUpdate,
+            Combustion,
+            FluidSimulation,
+            Synthesizer,
+            Count
+        };
+
+        static constexpr int PhaseCount = static_cast<int>(Phase::Count);
+        static constexpr int SampleCapacity = 4096;
+
+        // All times are in nanoseconds per simulation step
+        struct Statistics {
+            double min = 0.0;
+            double mean = 0.0;
+            double p99 = 0.0;
+            double total = 0.0;
+            int samples = 0;
+        };
+
+        class Scope {
+            public:
+                Scope(SimulationProfiler *profiler, Phase phase)
+                    : m_profiler(profiler), m_phase(phase), m_start(std::chrono::steady_clock::now())
+                {
+                    /* void */
+                }
+
+                ~Scope() {
+                    const auto end = std::chrono::steady_clock::now();
+                    m_profiler->record(
+                        m_phase,
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start).count());
+                }
+
+            private:
+                SimulationProfiler *m_profiler;
+                Phase m_phase;
+                std::chrono::steady_clock::time_point m_start;
+        };
+
+    public:
+        SimulationProfiler();
+        ~SimulationProfiler();
+
+        void beginFrame();
+        void endFrame();
+
+        // Steps beyond the capacity in one frame overwrite the oldest
+        // samples, so recording never allocates
+        inline void record(Phase phase, long long ns) {
+            const int i = static_cast<int>(phase);
+            m_samples[i][m_writeIndex[i]] = ns;
+            m_writeIndex[i] = (m_writeIndex[i] + 1) % SampleCapacity;
+            if (m_sampleCount[i] < SampleCapacity) ++m_sampleCount[i];
+        }
+
+        const Statistics &getStatistics(Phase phase) const {
+            return m_statistics[static_cast<int>(phase)];
+        }
+
+        static const char *getPhaseName(Phase phase);
+        static constexpr bool isEnabled();
+
+    protected:
+        std::vector<long long> m_samples[PhaseCount];
+        int m_writeIndex[PhaseCount];
+        int m_sampleCount[PhaseCount];
+        Statistics m_statistics[PhaseCount];
+};
+
+constexpr bool SimulationProfiler::isEnabled() {
+#ifdef ATG_ENGINE_SIM_PROFILING_ENABLED
+    return true;
+#else
+    return false;
+#endif /* ATG_ENGINE_SIM_PROFILING_ENABLED */
+}
+
+#ifdef ATG_ENGINE_SIM_PROFILING_ENABLED
+#define ATG_ENGINE_SIM_PROFILE_SCOPE(profiler, phase) \
+    SimulationProfiler::Scope simulationProfilerScope((profiler), SimulationProfiler::Phase::phase)
+#else
+#define ATG_ENGINE_SIM_PROFILE_SCOPE(profiler, phase)
+#endif /* ATG_ENGINE_SIM_PROFILING_ENABLED */
+
+#endif /* ATG_ENGINE_SIM_SIMULATION_PROFILER_H */
@@ -0,0 +1,81 @@
+#ifndef ATG_ENGINE_SIM_SIMULATION_RUNTIME_H
+#define ATG_ENGINE_SIM_SIMULATION_RUNTIME_H
+
+#include "simulator.h"
+#include "worker_pool.h"
+#include "impulse_response_store.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Owns a set of independent simulations (one per vehicle, sweep point, etc.)
+// and steps them in parallel on a shared worker pool. An instance is only
+// ever touched by one thread at a time and instances share no mutable state,
+// so results do not depend on the thread count. Impulse responses are
+// read-only once loaded and are shared by every instance that uses them.
+class SimulationRuntime {
+    public:
+        struct Parameters {
+            // Threads used to step instances, including the calling thread.
+            // Zero uses one per hardware thread.
+            int threadCount = 0;
+
+            // If set, each instance's audio is rendered synchronously after
+            // every frame and all of it is handed to the sink before the next
+            // frame starts. The sink is called on the thread stepping the
+            // instance, so it may be called for different instances at the
+            // same time.
+            std::function<void(int instance, const int16_t *samples, int sampleCount)> audioSink;
+
+            // Where prepared impulse responses are cached between runs; see
+            // ImpulseResponseStore::setCacheDirectory()
+            std::string impulseResponseCacheDirectory;
+        };
+
+        struct Instance {
+            Simulator *simulator = nullptr;
+            Engine *engine = nullptr;
+            Vehicle *vehicle = nullptr;
+            Transmission *transmission = nullptr;
+        };
+
+    public:
+        SimulationRuntime();
+        ~SimulationRuntime();
+
+        void initialize(const Parameters &params);
+        void destroy();
+
+        // Takes ownership of the engine, vehicle and transmission. Exhausts
+        // whose impulse response can't be loaded are rendered dry, through
+        // a unit impulse.
+        int addInstance(Engine *engine, Vehicle *vehicle, Transmission *transmission);
+
+        int getInstanceCount() const { return static_cast<int>(m_instances.size()); }
+        const Instance &getInstance(int index) const { return m_instances[index]; }
+        Simulator *getSimulator(int index) const { return m_instances[index].simulator; }
+
+        // Advances every instance by the given number of frames. Each
+        // instance runs all of its frames on one thread, so there is no
+        // synchronization between frames.
+        void step(double dt, int frames = 1);
+
+        int getThreadCount() const { return m_workers.getThreadCount() + 1; }
+
+        const ImpulseResponseStore &getImpulseResponses() const { return m_impulseResponses; }
+
+    protected:
+        static constexpr int AudioChunkSamples = 1024;
+
+        void stepInstance(int index, double dt, int frames);
+
+    protected:
+        std::vector<Instance> m_instances;
+        WorkerPool m_workers;
+        ImpulseResponseStore m_impulseResponses;
+        std::function<void(int, const int16_t *, int)> m_audioSink;
+};
+
+#endif /* ATG_ENGINE_SIM_SIMULATION_RUNTIME_H */
@@ -0,0 +1,133 @@
+#ifndef ATG_ENGINE_SIM_SIMULATION_SNAPSHOT_H
+#define ATG_ENGINE_SIM_SIMULATION_SNAPSHOT_H
+
+#include "scs.h"
+#include "ring_buffer.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Flat binary image of a running simulation. Every stateful part appends its
+// raw fields in a fixed order, so restoring is a sequence of memcpys into the
+// same objects. Arrays carry their length, which is what catches a snapshot
+// being loaded into a simulation with a different layout.
+//
+// Reading can be done in a validation pass that walks the snapshot without
+// touching any of the targets, so that a bad snapshot is rejected before the
+// simulation is modified.
+class SimulationSnapshot {
+    public:
+        static constexpr uint32_t Magic = 0x4D495345; // "ESIM"
+        static constexpr uint32_t Version = 6;
+
+    public:
+        SimulationSnapshot();
+        ~SimulationSnapshot();
+
+        void clear();
+        void rewind(bool validateOnly = false);
+
+        void write(const void *data, size_t size);
+        void read(void *data, size_t size);
+
+        template <typename T_Data>
+        inline void write(const T_Data &value) {
+            static_assert(std::is_trivially_copyable<T_Data>::value, "Snapshot fields must be trivially copyable");
+            write(&value, sizeof(T_Data));
+        }
+
+        template <typename T_Data>
+        inline void read(T_Data *value) {
+            static_assert(std::is_trivially_copyable<T_Data>::value, "Snapshot fields must be trivially copyable");
+            read(static_cast<void *>(value), sizeof(T_Data));
+        }
+
+        template <typename T_Data>
+        inline void writeArray(const T_Data *data, size_t n) {
+            static_assert(std::is_trivially_copyable<T_Data>::value, "Snapshot fields must be trivially copyable");
+            writeCount(n);
+            write(data, n * sizeof(T_Data));
+        }
+
+        template <typename T_Data>
+        inline void readArray(T_Data *data, size_t n) {
+            static_assert(std::is_trivially_copyable<T_Data>::value, "Snapshot fields must be trivially copyable");
+            expectCount(n);
+            read(static_cast<void *>(data), n * sizeof(T_Data));
+        }
+
+        template <typename T_Data>
+        inline void writeVector(const std::vector<T_Data> &v) {
+            writeArray(v.data(), v.size());
+        }
+
+        // Unlike arrays, vectors are resized to the length in the snapshot
+        template <typename T_Data>
+        inline void readVector(std::vector<T_Data> *v) {
+            static_assert(std::is_trivially_copyable<T_Data>::value, "Snapshot fields must be trivially copyable");
+            uint64_t n = 0;
+            readCount(&n);
+            if (!m_valid || n > (m_data.size() - m_readOffset) / sizeof(T_Data)) {
+                m_valid = false;
+                return;
+            }
+
+            if (!m_validateOnly) v->resize(static_cast<size_t>(n));
+            read(m_validateOnly ? nullptr : static_cast<void *>(v->data()), static_cast<size_t>(n) * sizeof(T_Data));
+        }
+
+        template <typename T_Data>
+        inline void writeRingBuffer(const RingBuffer<T_Data> &buffer) {
+            writeArray(buffer.data(), buffer.capacity());
+            write(static_cast<uint64_t>(buffer.start()));
+            write(static_cast<uint64_t>(buffer.writeIndex()));
+        }
+
+        template <typename T_Data>
+        inline void readRingBuffer(RingBuffer<T_Data> *buffer) {
+            uint64_t start = 0, writeIndex = 0;
+            readArray(buffer->data(), buffer->capacity());
+            readCount(&start);
+            readCount(&writeIndex);
+
+            if (m_valid && !m_validateOnly) {
+                buffer->setStartIndex(static_cast<size_t>(start));
+                buffer->setWriteIndex(static_cast<size_t>(writeIndex));
+            }
+        }
+
+        void writeHeader();
+        void readHeader();
+
+        // Element counts that the reader checks against its own layout
+        void writeCount(size_t n) { write(static_cast<uint64_t>(n)); }
+        void expectCount(size_t n);
+
+        void writeBody(const atg_scs::RigidBody &body);
+        void readBody(atg_scs::RigidBody *body);
+
+        void invalidate() { m_valid = false; }
+        bool isValid() const { return m_valid; }
+        bool isValidating() const { return m_validateOnly; }
+        bool isAtEnd() const { return m_readOffset == m_data.size(); }
+
+        const uint8_t *getData() const { return m_data.data(); }
+        size_t getSize() const { return m_data.size(); }
+        void setData(const uint8_t *data, size_t size);
+
+        bool saveToFile(const std::string &filename) const;
+        bool loadFromFile(const std::string &filename);
+
+    protected:
+        void readCount(uint64_t *count);
+
+        std::vector<uint8_t> m_data;
+        size_t m_readOffset;
+        bool m_validateOnly;
+        bool m_valid;
+};
+
+#endif /* ATG_ENGINE_SIM_SIMULATION_SNAPSHOT_H */
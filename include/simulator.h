@@ -10,6 +10,10 @@
 #include "derivative_filter.h"
 #include "vehicle_drag_constraint.h"
 #include "delay_filter.h"
+#include "simulation_profiler.h"
+#include "simulation_snapshot.h"
+#include "constraint_solver.h"
+#include "direct_constraint_solver.h"
 #include "engine.h"
 
 #include <chrono>
@@ -18,14 +22,46 @@ class Simulator {
 public:
     enum class SystemType {
         NsvOptimized,
-        Generic
+        Generic,
+
+        // Pistons and rods are not simulated as rigid bodies; they follow
+        // the crankshafts, which are the only engine degrees of freedom
+        ReducedCoordinate
+    };
+
+    enum class SleSolverType {
+        // Gauss-Seidel for the NSV systems, Gaussian elimination for the
+        // generic one
+        Default,
+        GaussSeidel,
+        GaussianElimination,
+
+        // The solver library's own Gauss-Seidel solver, which starts every
+        // solve from zero and keeps no statistics; kept as a reference for
+        // the warm-started one above
+        ScsGaussSeidel,
+
+        // Sparse factorization planned once from the constraint graph
+        Direct
+    };
+
+    enum class IntegrationMethod {
+        SemiImplicitEuler,
+
+        // The stiffest forces on the pistons, the gas spring in each chamber
+        // and the piston friction, are evaluated at the end of the step
+        // through their linearization instead of at the start
+        LinearlyImplicitEuler
     };
 
     struct Parameters {
         SystemType systemType = SystemType::NsvOptimized;
+        SleSolverType sleSolverType = SleSolverType::Default;
+        uint64_t randomSeed = 0;
     };
 
     static constexpr int DynoTorqueSamples = 512;
+    static constexpr int AdaptiveFrequencyResolution = 100;
 
 public:
     Simulator();
@@ -53,12 +89,48 @@ public:
     Transmission *getTransmission() const { return m_transmission; }
     Vehicle *getVehicle() const { return m_vehicle; }
     atg_scs::RigidBodySystem *getSystem() { return m_system; }
+    SystemType getSystemType() const { return m_systemType; }
+    SleSolverType getSleSolverType() const { return m_sleSolverType; }
 
     void setSimulationFrequency(int frequency) { m_simulationFrequency = frequency; }
     int getSimulationFrequency() const { return m_simulationFrequency; }
 
     double getTimestep() const { return 1.0 / m_simulationFrequency; }
 
+    // Can be changed between steps
+    void setIntegrationMethod(IntegrationMethod method) { m_integrationMethod = method; }
+    IntegrationMethod getIntegrationMethod() const { return m_integrationMethod; }
+
+    // With adaptive frequency enabled, the simulation frequency is chosen at
+    // the start of every frame so that each step advances the crankshaft by
+    // roughly the given angle, bounded by the frequency range
+    void setAdaptiveFrequencyEnabled(bool enabled) { m_adaptiveFrequency = enabled; }
+    bool isAdaptiveFrequencyEnabled() const { return m_adaptiveFrequency; }
+    void setCrankAnglePerStep(double angle) { m_crankAnglePerStep = angle; }
+    double getCrankAnglePerStep() const { return m_crankAnglePerStep; }
+    void setSimulationFrequencyRange(int minFrequency, int maxFrequency);
+    int getMinSimulationFrequency() const { return m_minSimulationFrequency; }
+    int getMaxSimulationFrequency() const { return m_maxSimulationFrequency; }
+
+    // Reseeds every random stream owned by the simulation. Must not be called
+    // while the audio rendering thread is running.
+    virtual void setRandomSeed(uint64_t seed);
+    uint64_t getRandomSeed() const { return m_randomSeed; }
+
+    // Captures everything needed to resume the running simulation: rigid
+    // bodies, gas volumes, combustion and control state, and the audio filter
+    // histories. A snapshot can only be loaded into a simulation built from
+    // the same engine, vehicle and transmission; anything else is rejected
+    // before the simulation is touched. Neither may be called while the
+    // audio rendering thread is running.
+    void saveSnapshot(SimulationSnapshot *snapshot) const;
+    bool loadSnapshot(SimulationSnapshot *snapshot);
+
+    // Disabling latency control runs exactly the requested simulated time
+    // each frame, for offline rendering
+    void setLatencyControlEnabled(bool enabled) { m_latencyControlEnabled = enabled; }
+    bool isLatencyControlEnabled() const { return m_latencyControlEnabled; }
+
     void setTargetSynthesizerLatency(double latency) { m_targetSynthesizerLatency = latency; }
     double getTargetSynthesizerLatency() const { return m_targetSynthesizerLatency; }
     double getSynthesizerInputLatency() const { return m_synthesizer.getLatency(); }
@@ -68,6 +140,17 @@ public:
     double getSimulationSpeed() const { return m_simulationSpeed; }
     int getCurrentIteration() const { return m_currentIteration; }
     double getAverageProcessingTime() const { return m_physicsProcessingTime; }
+    const SimulationProfiler &getProfiler() const { return m_profiler; }
+
+    // Iterations and final residual of the constraint solver, per simulation
+    // step. Always zero for the generic system, which solves directly.
+    int getLastSolverIterations() const;
+    double getLastSolverResidual() const;
+    double getAverageSolverIterations() const;
+    double getMaxSolverResidual() const;
+    long long getUnconvergedSolverSteps() const;
+    void resetSolverStatistics();
+    ConstraintSolver *getConstraintSolver() const { return m_constraintSolver; }
 
     int simulationSteps() const { return m_steps; }
 
@@ -81,14 +164,25 @@ public:
     StarterMotor m_starterMotor;
 
 protected:
+    virtual void saveState(SimulationSnapshot *snapshot) const;
+    virtual void loadState(SimulationSnapshot *snapshot);
+
     void initializeSynthesizer();
+    atg_scs::SleSolver *createSleSolver(SleSolverType type);
+    virtual void processRigidBodies(double dt);
     virtual void simulateStep_();
     virtual void writeToSynthesizer() = 0;
 
     atg_scs::RigidBodySystem *m_system;
+    ConstraintSolver *m_constraintSolver;
+    SystemType m_systemType;
+    SleSolverType m_sleSolverType;
+    IntegrationMethod m_integrationMethod;
+    SimulationProfiler m_profiler;
 
 private:
     void updateFilteredEngineSpeed(double dt);
+    int calculateAdaptiveFrequency() const;
 
 private:
     atg_scs::RigidBody m_vehicleMass;
@@ -107,8 +201,15 @@ private:
     double m_physicsProcessingTime;
 
     int m_simulationFrequency;
+    uint64_t m_randomSeed;
+
+    bool m_adaptiveFrequency;
+    double m_crankAnglePerStep;
+    int m_minSimulationFrequency;
+    int m_maxSimulationFrequency;
 
     double m_targetSynthesizerLatency;
+    bool m_latencyControlEnabled;
     double m_simulationSpeed;
 
     double *m_dynoTorqueSamples;
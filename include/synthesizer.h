@@ -7,7 +7,9 @@
 #include "low_pass_filter.h"
 #include "jitter_filter.h"
 #include "ring_buffer.h"
+#include "triple_buffer.h"
 #include "butterworth_low_pass_filter.h"
+#include "random_stream.h"
 
 #include <cinttypes>
 #include <thread>
@@ -17,6 +19,9 @@
 
 class Synthesizer {
     public:
+        static constexpr int RenderBlockSize = 256;
+        static constexpr int AudioBufferTarget = 2000;
+
         struct AudioParameters {
             float volume = 1.0f;
             float convolution = 1.0f;
@@ -36,11 +41,13 @@ class Synthesizer {
             int audioBufferSize = 44100;
             float inputSampleRate = 10000;
             float audioSampleRate = 44100;
+            uint64_t randomSeed = 0;
             AudioParameters initialAudioParameters;
         };
 
         struct InputChannel {
-            RingBuffer<float> data;
+            SpscRingBuffer<float> data;
+            float *stagingBuffer = nullptr;
             float *transferBuffer = nullptr;
             double lastInputSample = 0.0f;
         };
@@ -52,6 +59,19 @@ class Synthesizer {
             ButterworthLowPassFilter<float> airNoiseLowPass;
             LowPassFilter inputDcFilter;
             ButterworthLowPassFilter<double> antialiasing;
+            RandomStream airNoise;
+        };
+
+        // Scratch space for one block of the render pipeline
+        struct RenderBuffers {
+            float *airNoise = nullptr;
+            float *jitter = nullptr;
+            float *dc = nullptr;
+            float *derivative = nullptr;
+            float *input = nullptr;
+            float *convolution = nullptr;
+            float *signal = nullptr;
+            int16_t *output = nullptr;
         };
 
     public:
@@ -64,6 +84,21 @@ class Synthesizer {
             unsigned int samples,
             float volume,
             int index);
+
+        // Uses a kernel shared with other channels or synthesizers; see
+        // ImpulseResponseStore
+        void initializeImpulseResponse(
+            const ConvolutionFilter::Kernel &kernel,
+            float volume,
+            int index);
+        void seed(uint64_t seed);
+
+        // Saves the input resampler and filter histories. Loading discards
+        // any input or output that has not been consumed yet. Neither may be
+        // called while the audio rendering thread is running.
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
         void startAudioRenderingThread();
         void endAudioRenderingThread();
         void destroy();
@@ -73,10 +108,8 @@ class Synthesizer {
         void writeInput(const double *data);
         void endInputBlock();
 
-        void waitProcessed();
-
         void audioRenderingThread();
-        void renderAudio();
+        int renderAudio();
 
         double getLatency() const;
 
@@ -85,26 +118,43 @@ class Synthesizer {
 
         void setInputSampleRate(double sampleRate);
         double getInputSampleRate() const { return m_inputSampleRate; }
+        double getAudioSampleRate() const { return m_audioSampleRate; }
 
-        int16_t renderAudio(int inputOffset);
+        // In offline mode renderAudio() consumes all available input instead
+        // of pacing itself to AudioBufferTarget; the caller must drain the
+        // output between renders
+        void setOfflineMode(bool offline) { m_offline = offline; }
+        bool isOfflineMode() const { return m_offline; }
 
+        void renderBlock(int inputOffset, int samples);
+
+        // Called from the control thread; never blocks the audio thread
         double getLevelerGain();
         AudioParameters getAudioParameters();
         void setAudioParameters(const AudioParameters &params);
 
     //protected:
+        void flushInput();
+
         ButterworthLowPassFilter<float> m_antialiasing;
         LevelingFilter m_levelingFilter;
         InputChannel *m_inputChannels;
-        AudioParameters m_audioParameters;
         int m_inputChannelCount;
         int m_inputBufferSize;
-        int m_inputSamplesRead;
+        int m_stagedInputSamples;
+        int m_inputWriteIndex;
         int m_latency;
         double m_inputWriteOffset;
         double m_lastInputSampleOffset;
 
-        RingBuffer<int16_t> m_audioBuffer;
+        // Written by the control thread, picked up by the audio thread at the
+        // start of each render
+        AudioParameters m_audioParameters;
+        TripleBuffer<AudioParameters> m_audioParameterBuffer;
+        AudioParameters m_renderParameters;
+        std::atomic<float> m_levelerGain;
+
+        SpscRingBuffer<int16_t> m_audioBuffer;
         int m_audioBufferSize;
 
         float m_inputSampleRate;
@@ -112,13 +162,14 @@ class Synthesizer {
 
         std::thread *m_thread;
         std::atomic<bool> m_run;
-        bool m_processed;
+        bool m_offline;
 
-        std::mutex m_inputLock;
-        std::mutex m_lock0;
-        std::condition_variable m_cv0;
+        // Only used to sleep the audio thread when it has nothing to do
+        std::mutex m_wakeLock;
+        std::condition_variable m_wakeCondition;
 
         ProcessingFilters *m_filters;
+        RenderBuffers m_renderBuffers;
 };
 
 #endif /* ATG_ENGINE_SIM_ENGINE_SYNTHESIZER_H */
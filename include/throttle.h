@@ -4,6 +4,7 @@
 #include "part.h"
 
 class Engine;
+class SimulationSnapshot;
 class Throttle {
 public:
     Throttle();
@@ -14,6 +15,9 @@ public:
 
     inline double getSpeedControl() const { return m_speedControl; }
 
+    virtual void saveState(SimulationSnapshot *snapshot) const;
+    virtual void loadState(SimulationSnapshot *snapshot);
+
 protected:
     double m_speedControl;
 };
@@ -5,6 +5,7 @@
 #include "engine.h"
 #include "scs.h"
 
+class SimulationSnapshot;
 class Transmission {
     public:
         struct Parameters {
@@ -29,6 +30,9 @@ class Transmission {
         inline void setClutchPressure(double pressure) { m_clutchPressure = pressure; }
         inline double getClutchPressure() const { return m_clutchPressure; }
 
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
     protected:
         atg_scs::ClutchConstraint m_clutchConstraint;
         atg_scs::RigidBody *m_rotatingMass;
@@ -0,0 +1,57 @@
+#ifndef ATG_ENGINE_SIM_TRIPLE_BUFFER_H
+#define ATG_ENGINE_SIM_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Hands the latest value from one writer thread to one reader thread. The
+// writer fills a back slot and atomically swaps it with the shared middle
+// slot; the reader swaps the middle slot with its front slot when a new value
+// has been published. Neither side ever waits on the other.
+template <typename T_Data>
+class TripleBuffer {
+public:
+    TripleBuffer() {
+        m_front = 0;
+        m_middle = 1;
+        m_back = 2;
+    }
+
+    ~TripleBuffer() {
+        /* void */
+    }
+
+    // Not thread safe; call before either thread starts using the buffer
+    void initialize(const T_Data &value) {
+        m_slots[0] = m_slots[1] = m_slots[2] = value;
+        m_front = 0;
+        m_middle = 1;
+        m_back = 2;
+    }
+
+    // Writer only
+    void write(const T_Data &value) {
+        m_slots[m_back] = value;
+        m_back = m_middle.exchange(m_back | Dirty, std::memory_order_acq_rel) & SlotMask;
+    }
+
+    // Reader only. Returns the most recently published value.
+    const T_Data &read() {
+        if ((m_middle.load(std::memory_order_relaxed) & Dirty) != 0) {
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & SlotMask;
+        }
+
+        return m_slots[m_front];
+    }
+
+private:
+    static constexpr int Dirty = 0x4;
+    static constexpr int SlotMask = 0x3;
+
+    T_Data m_slots[3];
+
+    int m_front;
+    std::atomic<int> m_middle;
+    int m_back;
+};
+
+#endif /* ATG_ENGINE_SIM_TRIPLE_BUFFER_H */
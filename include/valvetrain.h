@@ -2,16 +2,30 @@
 #define ATG_ENGINE_SIM_VALVETRAIN_H
 
 class Camshaft;
+class SimulationSnapshot;
 class Valvetrain {
 public:
     Valvetrain();
     virtual ~Valvetrain();
 
+    // Called once per simulation step; switching decisions belong here so
+    // that lift queries only ever read latched state
+    virtual void update(double dt);
+
     virtual double intakeValveLift(int cylinder) = 0;
     virtual double exhaustValveLift(int cylinder) = 0;
 
     virtual Camshaft *getActiveIntakeCamshaft() = 0;
     virtual Camshaft *getActiveExhaustCamshaft() = 0;
+
+    // While switching between camshafts, lift is blended from the previous
+    // camshaft to the active one by the switch progress (0 to 1)
+    virtual Camshaft *getPreviousIntakeCamshaft() { return getActiveIntakeCamshaft(); }
+    virtual Camshaft *getPreviousExhaustCamshaft() { return getActiveExhaustCamshaft(); }
+    virtual double getSwitchProgress() const { return 1.0; }
+
+    virtual void saveState(SimulationSnapshot *snapshot) const;
+    virtual void loadState(SimulationSnapshot *snapshot);
 };
 
 #endif /* ATG_ENGINE_SIM_VALVETRAIN_H */
@@ -3,6 +3,7 @@
 
 #include "scs.h"
 
+class SimulationSnapshot;
 class Vehicle {
     public:
         struct Parameters {
@@ -32,6 +33,9 @@ class Vehicle {
         inline void resetTravelledDistance() { m_travelledDistance = 0; }
         double linearForceToVirtualTorque(double force) const;
 
+        void saveState(SimulationSnapshot *snapshot) const;
+        void loadState(SimulationSnapshot *snapshot);
+
     protected:
         atg_scs::RigidBody *m_rotatingMass;
 
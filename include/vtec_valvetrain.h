@@ -12,6 +12,15 @@ public:
         double manifoldVacuum;
         double minThrottlePosition;
 
+        // Once engaged, VTEC stays on until a condition falls this far
+        // below its threshold
+        double rpmHysteresis = 0.0;
+        double manifoldVacuumHysteresis = 0.0;
+        double throttlePositionHysteresis = 0.0;
+
+        // Time taken to blend from one lift profile to the other
+        double switchTime = 0.0;
+
         Camshaft *intakeCamshaft;
         Camshaft *exhaustCamshaft;
 
@@ -27,14 +36,25 @@ public:
 
     void initialize(const Parameters &parameters);
 
+    virtual void update(double dt) override;
+
     virtual double intakeValveLift(int cylinder) override;
     virtual double exhaustValveLift(int cylinder) override;
 
     virtual Camshaft *getActiveIntakeCamshaft() override;
     virtual Camshaft *getActiveExhaustCamshaft() override;
+    virtual Camshaft *getPreviousIntakeCamshaft() override;
+    virtual Camshaft *getPreviousExhaustCamshaft() override;
+    virtual double getSwitchProgress() const override { return m_switchProgress; }
+
+    bool isVtecEngaged() const { return m_engaged; }
+
+    virtual void saveState(SimulationSnapshot *snapshot) const override;
+    virtual void loadState(SimulationSnapshot *snapshot) override;
 
 private:
-    bool isVtecEnabled() const;
+    bool shouldEngage() const;
+    bool shouldDisengage() const;
 
     Camshaft *m_intakeCamshaft;
     Camshaft *m_exhaustCamshaft;
@@ -48,6 +68,14 @@ private:
     double m_minSpeed;
     double m_manifoldVacuum;
     double m_minThrottlePosition;
+
+    double m_rpmHysteresis;
+    double m_manifoldVacuumHysteresis;
+    double m_throttlePositionHysteresis;
+    double m_switchTime;
+
+    bool m_engaged;
+    double m_switchProgress;
 };
 
 #endif /* ATG_ENGINE_SIM_VTEC_STANDARD_VALVETRAIN_H */
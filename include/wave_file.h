@@ -0,0 +1,25 @@
+#ifndef ATG_ENGINE_SIM_WAVE_FILE_H
+#define ATG_ENGINE_SIM_WAVE_FILE_H
+
+#include <cinttypes>
+#include <string>
+
+class WaveFile {
+    public:
+        WaveFile();
+        ~WaveFile();
+
+        bool read(const std::string &filename);
+        void destroy();
+
+        const int16_t *getSamples() const { return m_samples; }
+        int getSampleCount() const { return m_sampleCount; }
+        int getSampleRate() const { return m_sampleRate; }
+
+    private:
+        int16_t *m_samples;
+        int m_sampleCount;
+        int m_sampleRate;
+};
+
+#endif /* ATG_ENGINE_SIM_WAVE_FILE_H */
@@ -0,0 +1,50 @@
+#ifndef ATG_ENGINE_SIM_WAVE_WRITER_H
+#define ATG_ENGINE_SIM_WAVE_WRITER_H
+
+#include "ring_buffer.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+// Streams 16-bit mono PCM to a WAV file. Samples are queued by the caller and
+// written to disk by a background thread so that file I/O never stalls the
+// renderer.
+class WaveWriter {
+    public:
+        static constexpr int BufferSize = 1 << 18;
+
+    public:
+        WaveWriter();
+        ~WaveWriter();
+
+        bool open(const std::string &filename, int sampleRate);
+        void write(const int16_t *samples, int n);
+        bool close();
+
+        bool isOpen() const { return m_file != nullptr; }
+        long long getSampleCount() const { return m_sampleCount; }
+
+    protected:
+        void writerThread();
+        void writeHeader(uint32_t dataSize);
+
+        std::FILE *m_file;
+        int m_sampleRate;
+        long long m_sampleCount;
+
+        SpscRingBuffer<int16_t> m_buffer;
+
+        std::thread *m_thread;
+        std::atomic<bool> m_run;
+        std::atomic<bool> m_error;
+
+        std::mutex m_wakeLock;
+        std::condition_variable m_wakeCondition;
+};
+
+#endif /* ATG_ENGINE_SIM_WAVE_WRITER_H */
@@ -0,0 +1,48 @@
+#ifndef ATG_ENGINE_SIM_WORKER_POOL_H
+#define ATG_ENGINE_SIM_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Persistent set of threads that execute batches of independent tasks. The
+// calling thread also participates, so a pool with N threads runs a batch
+// on N + 1 threads.
+class WorkerPool {
+    public:
+        WorkerPool();
+        ~WorkerPool();
+
+        void initialize(int threadCount);
+        void destroy();
+
+        // Runs task(0) ... task(taskCount - 1) and returns once all of them
+        // have completed. Tasks are handed out dynamically, so callers must
+        // not depend on which thread runs a given task.
+        void run(int taskCount, const std::function<void(int)> &task);
+
+        int getThreadCount() const { return m_threadCount; }
+
+    protected:
+        void worker();
+        void executeTasks();
+
+    protected:
+        std::thread *m_threads;
+        int m_threadCount;
+
+        std::mutex m_lock;
+        std::condition_variable m_start;
+        std::condition_variable m_done;
+
+        const std::function<void(int)> *m_task;
+        int m_taskCount;
+        std::atomic<int> m_nextTask;
+        int m_pendingWorkers;
+        unsigned int m_generation;
+        bool m_running;
+};
+
+#endif /* ATG_ENGINE_SIM_WORKER_POOL_H */
@@ -35,6 +35,10 @@ namespace es_script {
             Engine *engine = new Engine;
             engineNode->buildEngine(engine);
             Compiler::output()->engine = engine;
+
+            if (ScriptCache *cache = Compiler::cache()) {
+                cache->setEngine(engineNode);
+            }
         }
 
     protected:
@@ -512,6 +516,10 @@ namespace es_script {
             Transmission *transmission = new Transmission;
             m_transmission->generate(transmission);
             Compiler::output()->transmission = transmission;
+
+            if (ScriptCache *cache = Compiler::cache()) {
+                cache->setTransmission(m_transmission);
+            }
         }
 
     protected:
@@ -536,6 +544,10 @@ namespace es_script {
             Vehicle *vehicle = new Vehicle;
             vehicleNode->generate(vehicle);
             Compiler::output()->vehicle = vehicle;
+
+            if (ScriptCache *cache = Compiler::cache()) {
+                cache->setVehicle(vehicleNode);
+            }
         }
 
     protected:
@@ -39,6 +39,20 @@ namespace es_script {
             m_lobes.push_back(lobeCenterline);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.advance);
+            cache->write(m_parameters.baseRadius);
+            cache->writeNode(m_lobeProfile);
+            cache->writeVector(m_lobes);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.advance);
+            cache->read(&m_parameters.baseRadius);
+            cache->readNode(&m_lobeProfile);
+            cache->readVector(&m_lobes);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("advance", &m_parameters.advance);
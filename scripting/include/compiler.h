@@ -6,10 +6,13 @@
 #include "engine_sim.h"
 #include "piranha.h"
 
+#include <string>
 #include <vector>
 
 namespace es_script {
 
+    class ScriptCache;
+
     class Compiler {
     public:
         struct Output {
@@ -23,15 +26,30 @@ namespace es_script {
         };
 
     private:
-        static Output *s_output;
+        // Output of the compiler whose program is running on this thread;
+        // script nodes write their results through output()
+        static thread_local Output *s_output;
+
+        // Cache that records the nodes the output is generated from; null if
+        // the cache is disabled
+        static thread_local ScriptCache *s_cache;
 
     public:
         Compiler();
         ~Compiler();
 
         static Output *output();
+        static ScriptCache *cache();
 
         void initialize();
+
+        // Enables the compiled-script cache. If the script and everything it
+        // imports are unchanged since the cache was written, compile() builds
+        // the output from the cache and execute() returns it without running
+        // the script. An empty path disables the cache.
+        void setCachePath(const std::string &path) { m_cachePath = path; }
+        bool isCached() const { return m_cached; }
+
         bool compile(const piranha::IrPath &path);
         Output execute();
         void destroy();
@@ -43,6 +61,12 @@ namespace es_script {
         LanguageRules m_rules;
         piranha::Compiler *m_compiler;
         piranha::NodeProgram m_program;
+        Output m_output;
+
+        ScriptCache *m_cache;
+        std::string m_cachePath;
+        uint64_t m_cacheKey;
+        bool m_cached;
     };
 
 } /* namespace es_script */
@@ -53,6 +53,34 @@ namespace es_script {
             }
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.mass);
+            cache->write(m_parameters.momentOfInertia);
+            cache->write(m_parameters.centerOfMass);
+            cache->write(m_parameters.length);
+            cache->write(m_parameters.slaveThrow);
+
+            cache->writeCount(m_rodJournals.size());
+            for (const RodJournalNode *rodJournal : m_rodJournals) {
+                cache->writeNode(rodJournal);
+            }
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.mass);
+            cache->read(&m_parameters.momentOfInertia);
+            cache->read(&m_parameters.centerOfMass);
+            cache->read(&m_parameters.length);
+            cache->read(&m_parameters.slaveThrow);
+
+            const int n = cache->readCount();
+            for (int i = 0; i < n; ++i) {
+                RodJournalNode *rodJournal = nullptr;
+                cache->readNode(&rodJournal);
+                if (rodJournal != nullptr) addRodJournal(rodJournal);
+            }
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("mass", &m_parameters.mass);
@@ -40,6 +40,40 @@ namespace es_script {
             context->addCrankshaft(this, crankshaft);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.crankThrow);
+            cache->write(m_parameters.flywheelMass);
+            cache->write(m_parameters.mass);
+            cache->write(m_parameters.frictionTorque);
+            cache->write(m_parameters.momentOfInertia);
+            cache->write(m_parameters.pos_x);
+            cache->write(m_parameters.pos_y);
+            cache->write(m_parameters.tdc);
+
+            cache->writeCount(m_rodJournals.size());
+            for (const RodJournalNode *rodJournal : m_rodJournals) {
+                cache->writeNode(rodJournal);
+            }
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.crankThrow);
+            cache->read(&m_parameters.flywheelMass);
+            cache->read(&m_parameters.mass);
+            cache->read(&m_parameters.frictionTorque);
+            cache->read(&m_parameters.momentOfInertia);
+            cache->read(&m_parameters.pos_x);
+            cache->read(&m_parameters.pos_y);
+            cache->read(&m_parameters.tdc);
+
+            const int n = cache->readCount();
+            for (int i = 0; i < n; ++i) {
+                RodJournalNode *rodJournal = nullptr;
+                cache->readNode(&rodJournal);
+                if (rodJournal != nullptr) addRodJournal(rodJournal);
+            }
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("throw", &m_parameters.crankThrow);
@@ -24,6 +24,7 @@ namespace es_script {
             RodJournalNode *rodJournal;
             IntakeNode *intake;
             ExhaustSystemNode *exhaust;
+            IgnitionWireNode *wire;
             double soundAttenuation;
             double primaryLength;
         };
@@ -127,6 +128,7 @@ namespace es_script {
                 rodJournal,
                 intake,
                 exhaust,
+                wire,
                 soundAttenuation,
                 primaryLength
             });
@@ -150,6 +152,64 @@ namespace es_script {
             return m_head;
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.angle);
+            cache->write(m_parameters.bore);
+            cache->write(m_parameters.deckHeight);
+            cache->write(m_parameters.positionX);
+            cache->write(m_parameters.positionY);
+            cache->write(m_parameters.displayDepth);
+            cache->writeNode(m_head);
+
+            cache->writeCount(m_cylinders.size());
+            for (const Cylinder &cylinder : m_cylinders) {
+                cache->writeNode(cylinder.piston);
+                cache->writeNode(cylinder.rod);
+                cache->writeNode(cylinder.rodJournal);
+                cache->writeNode(cylinder.intake);
+                cache->writeNode(cylinder.exhaust);
+                cache->writeNode(cylinder.wire);
+                cache->write(cylinder.soundAttenuation);
+                cache->write(cylinder.primaryLength);
+            }
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.angle);
+            cache->read(&m_parameters.bore);
+            cache->read(&m_parameters.deckHeight);
+            cache->read(&m_parameters.positionX);
+            cache->read(&m_parameters.positionY);
+            cache->read(&m_parameters.displayDepth);
+            cache->readNode(&m_head);
+            if (m_head != nullptr) m_head->setBank(this);
+
+            const int n = cache->readCount();
+            for (int i = 0; i < n; ++i) {
+                Cylinder cylinder = { };
+                cache->readNode(&cylinder.piston);
+                cache->readNode(&cylinder.rod);
+                cache->readNode(&cylinder.rodJournal);
+                cache->readNode(&cylinder.intake);
+                cache->readNode(&cylinder.exhaust);
+                cache->readNode(&cylinder.wire);
+                cache->read(&cylinder.soundAttenuation);
+                cache->read(&cylinder.primaryLength);
+
+                if (cylinder.wire != nullptr) {
+                    addCylinder(
+                        cylinder.piston,
+                        cylinder.rod,
+                        cylinder.rodJournal,
+                        cylinder.intake,
+                        cylinder.exhaust,
+                        cylinder.wire,
+                        cylinder.soundAttenuation,
+                        cylinder.primaryLength);
+                }
+            }
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("angle", &m_parameters.angle);
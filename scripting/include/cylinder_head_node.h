@@ -38,6 +38,31 @@ namespace es_script {
         void setBank(CylinderBankNode *bank) { m_bank = bank; }
         CylinderBankNode *getBank() const { return m_bank; }
 
+        // The bank is restored when it sets its head
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->writeNode(m_intakePortFlow);
+            cache->writeNode(m_exhaustPortFlow);
+            cache->writeNode(m_valvetrain);
+            cache->write(m_parameters.CombustionChamberVolume);
+            cache->write(m_parameters.FlipDisplay);
+            cache->write(m_parameters.IntakeRunnerVolume);
+            cache->write(m_parameters.IntakeRunnerCrossSectionArea);
+            cache->write(m_parameters.ExhaustRunnerVolume);
+            cache->write(m_parameters.ExhaustRunnerCrossSectionArea);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->readNode(&m_intakePortFlow);
+            cache->readNode(&m_exhaustPortFlow);
+            cache->readNode(&m_valvetrain);
+            cache->read(&m_parameters.CombustionChamberVolume);
+            cache->read(&m_parameters.FlipDisplay);
+            cache->read(&m_parameters.IntakeRunnerVolume);
+            cache->read(&m_parameters.IntakeRunnerCrossSectionArea);
+            cache->read(&m_parameters.ExhaustRunnerVolume);
+            cache->read(&m_parameters.ExhaustRunnerCrossSectionArea);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput(
@@ -114,6 +114,8 @@ namespace es_script {
                 meanPistonSpeedToTurbulence->addSample(s, s * 0.5);
             }
 
+            meanPistonSpeedToTurbulence->bake();
+
             Fuel *fuel = engine->getFuel();
             m_fuel->generate(fuel, &context);
 
@@ -149,6 +151,66 @@ namespace es_script {
             m_ignitionModule = ignitionModule;
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->writeString(m_parameters.name);
+            cache->write(m_parameters.starterTorque);
+            cache->write(m_parameters.starterSpeed);
+            cache->write(m_parameters.dynoMinSpeed);
+            cache->write(m_parameters.dynoMaxSpeed);
+            cache->write(m_parameters.dynoHoldStep);
+            cache->write(m_parameters.redline);
+            cache->write(m_parameters.initialSimulationFrequency);
+            cache->write(m_parameters.initialHighFrequencyGain);
+            cache->write(m_parameters.initialJitter);
+            cache->write(m_parameters.initialNoise);
+
+            cache->writeNode(m_fuel);
+            cache->writeNode(m_throttle);
+            cache->writeNode(m_ignitionModule);
+
+            cache->writeCount(m_crankshafts.size());
+            for (const CrankshaftNode *crankshaft : m_crankshafts) {
+                cache->writeNode(crankshaft);
+            }
+
+            cache->writeCount(m_cylinderBanks.size());
+            for (const CylinderBankNode *bank : m_cylinderBanks) {
+                cache->writeNode(bank);
+            }
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->readString(&m_parameters.name);
+            cache->read(&m_parameters.starterTorque);
+            cache->read(&m_parameters.starterSpeed);
+            cache->read(&m_parameters.dynoMinSpeed);
+            cache->read(&m_parameters.dynoMaxSpeed);
+            cache->read(&m_parameters.dynoHoldStep);
+            cache->read(&m_parameters.redline);
+            cache->read(&m_parameters.initialSimulationFrequency);
+            cache->read(&m_parameters.initialHighFrequencyGain);
+            cache->read(&m_parameters.initialJitter);
+            cache->read(&m_parameters.initialNoise);
+
+            cache->readNode(&m_fuel);
+            cache->readNode(&m_throttle);
+            cache->readNode(&m_ignitionModule);
+
+            const int crankshaftCount = cache->readCount();
+            for (int i = 0; i < crankshaftCount; ++i) {
+                CrankshaftNode *crankshaft = nullptr;
+                cache->readNode(&crankshaft);
+                if (crankshaft != nullptr) addCrankshaft(crankshaft);
+            }
+
+            const int bankCount = cache->readCount();
+            for (int i = 0; i < bankCount; ++i) {
+                CylinderBankNode *bank = nullptr;
+                cache->readNode(&bank);
+                if (bank != nullptr) addCylinderBank(bank);
+            }
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("name", &m_parameters.name);
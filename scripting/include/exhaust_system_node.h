@@ -25,6 +25,28 @@ namespace es_script {
             return exhaust;
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.length);
+            cache->write(m_parameters.collectorCrossSectionArea);
+            cache->write(m_parameters.outletFlowRate);
+            cache->write(m_parameters.primaryTubeLength);
+            cache->write(m_parameters.primaryFlowRate);
+            cache->write(m_parameters.audioVolume);
+            cache->write(m_parameters.velocityDecay);
+            cache->writeNode(m_impulseResponse);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.length);
+            cache->read(&m_parameters.collectorCrossSectionArea);
+            cache->read(&m_parameters.outletFlowRate);
+            cache->read(&m_parameters.primaryTubeLength);
+            cache->read(&m_parameters.primaryFlowRate);
+            cache->read(&m_parameters.audioVolume);
+            cache->read(&m_parameters.velocityDecay);
+            cache->readNode(&m_impulseResponse);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("length", &m_parameters.length);
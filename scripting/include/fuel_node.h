@@ -26,6 +26,34 @@ namespace es_script {
             fuel->initialize(params);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->writeNode(m_turbulenceToFlameSpeedRatio);
+            cache->writeString(m_parameters.name);
+            cache->write(m_parameters.molecularMass);
+            cache->write(m_parameters.energyDensity);
+            cache->write(m_parameters.density);
+            cache->write(m_parameters.molecularAfr);
+            cache->write(m_parameters.maxBurningEfficiency);
+            cache->write(m_parameters.burningEfficiencyRandomness);
+            cache->write(m_parameters.lowEfficiencyAttenuation);
+            cache->write(m_parameters.maxTurbulenceEffect);
+            cache->write(m_parameters.maxDilutionEffect);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->readNode(&m_turbulenceToFlameSpeedRatio);
+            cache->readString(&m_parameters.name);
+            cache->read(&m_parameters.molecularMass);
+            cache->read(&m_parameters.energyDensity);
+            cache->read(&m_parameters.density);
+            cache->read(&m_parameters.molecularAfr);
+            cache->read(&m_parameters.maxBurningEfficiency);
+            cache->read(&m_parameters.burningEfficiencyRandomness);
+            cache->read(&m_parameters.lowEfficiencyAttenuation);
+            cache->read(&m_parameters.maxTurbulenceEffect);
+            cache->read(&m_parameters.maxDilutionEffect);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput(
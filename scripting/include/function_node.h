@@ -7,6 +7,8 @@
 
 #include "engine_sim.h"
 
+#include <algorithm>
+
 namespace es_script {
 
     class FunctionNode : public ObjectReferenceNode<FunctionNode> {
@@ -33,6 +35,11 @@ namespace es_script {
                 return existingFunction;
             }
             else {
+                // Scripts such as harmonic_cam_lobe add samples out of
+                // order; sorting first lets every insertion be an append
+                std::stable_sort(m_samples.begin(), m_samples.end(),
+                    [](const Sample &a, const Sample &b) { return a.x < b.x; });
+
                 Function *function = new Function;
                 function->initialize((int)m_samples.size(), m_filterRadius);
 
@@ -40,11 +47,23 @@ namespace es_script {
                     function->addSample(sample.x, sample.y);
                 }
 
+                function->bake();
+
                 context->addFunction(this, function);
                 return function;
             }
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_filterRadius);
+            cache->writeVector(m_samples);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_filterRadius);
+            cache->readVector(&m_samples);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("filter_radius", &m_filterRadius);
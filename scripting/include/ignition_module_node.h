@@ -51,6 +51,32 @@ namespace es_script {
             m_posts.push_back({ wire, angle });
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->writeNode(m_timingCurve);
+            cache->write(m_revLimit);
+            cache->write(m_limiterDuration);
+
+            cache->writeCount(m_posts.size());
+            for (const Post &post : m_posts) {
+                cache->writeNode(post.wire);
+                cache->write(post.angle);
+            }
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->readNode(&m_timingCurve);
+            cache->read(&m_revLimit);
+            cache->read(&m_limiterDuration);
+
+            const int n = cache->readCount();
+            for (int i = 0; i < n; ++i) {
+                Post post = { nullptr, 0.0 };
+                cache->readNode(&post.wire);
+                cache->read(&post.angle);
+                if (post.wire != nullptr) m_posts.push_back(post);
+            }
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("timing_curve", &m_timingCurve);
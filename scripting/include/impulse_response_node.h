@@ -25,22 +25,42 @@ namespace es_script {
                 return existingIr;
             }
             else {
-                piranha::Path path = m_filename;
-                piranha::Path parentPath;
-                m_irStructure->getParentUnit()->getPath().getParentPath(&parentPath);
-                if (!path.isAbsolute()) {
-                    path = parentPath.append(path);
-                }
-
                 ImpulseResponse *impulseResponse = new ImpulseResponse;
                 impulseResponse->initialize(
-                    path.toString(),
+                    resolvePath(),
                     m_volume);
 
                 return impulseResponse;
             }
         }
 
+        // Relative filenames are relative to the script that declared the
+        // node. The script isn't available to nodes read back from the
+        // cache, so the resolved path is what gets written.
+        std::string resolvePath() const {
+            if (m_pathResolved) return m_filename;
+
+            piranha::Path path = m_filename;
+            piranha::Path parentPath;
+            m_irStructure->getParentUnit()->getPath().getParentPath(&parentPath);
+            if (!path.isAbsolute()) {
+                path = parentPath.append(path);
+            }
+
+            return path.toString();
+        }
+
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->writeString(resolvePath());
+            cache->write(m_volume);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->readString(&m_filename);
+            cache->read(&m_volume);
+            m_pathResolved = true;
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("filename", &m_filename);
@@ -58,6 +78,7 @@ namespace es_script {
 
         std::string m_filename = "";
         double m_volume = 1.0;
+        bool m_pathResolved = false;
     };
 
 } /* namespace es_script */
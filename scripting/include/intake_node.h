@@ -26,6 +26,30 @@ namespace es_script {
             return intake;
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.volume);
+            cache->write(m_parameters.CrossSectionArea);
+            cache->write(m_parameters.InputFlowK);
+            cache->write(m_parameters.IdleFlowK);
+            cache->write(m_parameters.RunnerFlowRate);
+            cache->write(m_parameters.MolecularAfr);
+            cache->write(m_parameters.IdleThrottlePlatePosition);
+            cache->write(m_parameters.RunnerLength);
+            cache->write(m_parameters.VelocityDecay);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.volume);
+            cache->read(&m_parameters.CrossSectionArea);
+            cache->read(&m_parameters.InputFlowK);
+            cache->read(&m_parameters.IdleFlowK);
+            cache->read(&m_parameters.RunnerFlowRate);
+            cache->read(&m_parameters.MolecularAfr);
+            cache->read(&m_parameters.IdleThrottlePlatePosition);
+            cache->read(&m_parameters.RunnerLength);
+            cache->read(&m_parameters.VelocityDecay);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("plenum_volume", &m_parameters.volume);
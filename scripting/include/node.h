@@ -8,6 +8,8 @@
 
 namespace es_script {
 
+    class ScriptCache;
+
     class Node : public piranha::Node {
     protected:
         struct InputTarget {
@@ -68,6 +70,13 @@ namespace es_script {
             }
         }
 
+        // Writes the inputs the node was evaluated with and the nodes that
+        // were connected to it, so that a node read back from the cache
+        // generates the same objects. Changing what is written requires
+        // bumping ScriptCache::Version.
+        virtual void writeCache(ScriptCache *cache) const { /* void */ }
+        virtual void readCache(ScriptCache *cache) { /* void */ }
+
     private:
         std::map<std::string, InputTarget> m_inputMap;
     };
@@ -4,6 +4,7 @@
 #include "node.h"
 
 #include "object_reference_node_output.h"
+#include "script_cache.h"
 
 namespace es_script {
 
@@ -32,6 +32,22 @@ namespace es_script {
             piston->initialize(params);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.mass);
+            cache->write(m_parameters.BlowbyFlowCoefficient);
+            cache->write(m_parameters.CompressionHeight);
+            cache->write(m_parameters.WristPinPosition);
+            cache->write(m_parameters.Displacement);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.mass);
+            cache->read(&m_parameters.BlowbyFlowCoefficient);
+            cache->read(&m_parameters.CompressionHeight);
+            cache->read(&m_parameters.WristPinPosition);
+            cache->read(&m_parameters.Displacement);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("mass", &m_parameters.mass);
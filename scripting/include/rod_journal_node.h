@@ -31,6 +31,15 @@ namespace es_script {
             return m_rod;
         }
 
+        // The crankshaft and rod are restored when they add the journal
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_angle);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_angle);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("angle", &m_angle);
@@ -0,0 +1,166 @@
+#ifndef ATG_ENGINE_SIM_SCRIPT_CACHE_H
+#define ATG_ENGINE_SIM_SCRIPT_CACHE_H
+
+#include "compiler.h"
+
+#include "../../include/simulation_snapshot.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace es_script {
+
+    class Node;
+    class EngineNode;
+    class VehicleNode;
+    class TransmissionNode;
+    class ThrottleNode;
+    class ValvetrainNode;
+
+    // On-disk copy of the evaluated script. Each node that the output was
+    // generated from writes its inputs and the nodes it's connected to; a
+    // cache hit recreates those nodes and runs the same generate() code on
+    // them, without parsing or evaluating any script. The cache is keyed on
+    // Version and on the contents of the main script and every script it
+    // imports; editing any of them invalidates it.
+    class ScriptCache {
+    public:
+        static constexpr uint32_t Magic = 0x43534545; // "EESC"
+
+        // Must be bumped whenever the layout written by any node's
+        // writeCache()/readCache() changes
+        static constexpr uint32_t Version = 3;
+
+    public:
+        ScriptCache();
+        ~ScriptCache();
+
+        // Directories searched for imports, in addition to the directory
+        // of the importing script
+        void addSearchPath(const std::string &path);
+
+        uint64_t calculateKey(const std::string &scriptPath) const;
+
+        // Nodes that the engine, vehicle and transmission are generated from;
+        // recorded while the script runs
+        void setEngine(EngineNode *engine) { m_engine = engine; }
+        void setVehicle(VehicleNode *vehicle) { m_vehicle = vehicle; }
+        void setTransmission(TransmissionNode *transmission) { m_transmission = transmission; }
+
+        bool read(const std::string &filename, uint64_t key, Compiler::Output *output);
+        bool write(const std::string &filename, uint64_t key, const Compiler::Output &output);
+
+        template <typename T_Data>
+        void write(const T_Data &value) { m_data.write(value); }
+
+        template <typename T_Data>
+        void read(T_Data *value) { m_data.read(value); }
+
+        template <typename T_Data>
+        void writeVector(const std::vector<T_Data> &v) { m_data.writeVector(v); }
+
+        template <typename T_Data>
+        void readVector(std::vector<T_Data> *v) { m_data.readVector(v); }
+
+        void writeString(const std::string &s);
+        void readString(std::string *s);
+
+        void writeCount(size_t n) { m_data.writeCount(n); }
+        int readCount();
+
+        // Nodes are written in full the first time they're referenced and by
+        // index after that, so shared nodes are recreated once
+        template <typename T_Node>
+        void writeNode(const T_Node *node) {
+            if (node == nullptr) {
+                m_data.write(NullNode);
+                return;
+            }
+
+            auto it = m_nodeIndices.find(node);
+            if (it != m_nodeIndices.end()) {
+                m_data.write(it->second);
+                return;
+            }
+
+            const int32_t index = static_cast<int32_t>(m_nodeIndices.size());
+            m_nodeIndices[node] = index;
+            m_data.write(index);
+
+            writeNodeType(node);
+            node->writeCache(this);
+        }
+
+        template <typename T_Node>
+        void readNode(T_Node **node) {
+            int32_t index = NullNode;
+            m_data.read(&index);
+
+            *node = nullptr;
+            if (!m_data.isValid() || index == NullNode) {
+                return;
+            }
+            else if (index >= 0 && index < static_cast<int32_t>(m_nodes.size())) {
+                *node = dynamic_cast<T_Node *>(m_nodes[index]);
+                if (*node == nullptr) m_data.invalidate();
+            }
+            else if (index == static_cast<int32_t>(m_nodes.size())) {
+                T_Node *newNode = createNode(static_cast<T_Node *>(nullptr));
+                if (newNode == nullptr) {
+                    m_data.invalidate();
+                    return;
+                }
+
+                // Registered before its fields are read so that references
+                // back to it resolve
+                m_nodes.push_back(newNode);
+                newNode->readCache(this);
+                *node = newNode;
+            }
+            else {
+                m_data.invalidate();
+            }
+        }
+
+    protected:
+        static constexpr int32_t NullNode = -1;
+
+        void hashScript(
+            const std::string &path,
+            std::set<std::string> *visited,
+            uint64_t *hash) const;
+
+        void writeApplicationSettings(const ApplicationSettings &settings);
+        void readApplicationSettings(ApplicationSettings *settings);
+
+        // Abstract node types are preceded by a tag that selects the
+        // concrete type to recreate
+        template <typename T_Node>
+        void writeNodeType(const T_Node *) { /* void */ }
+        void writeNodeType(const ThrottleNode *node);
+        void writeNodeType(const ValvetrainNode *node);
+
+        template <typename T_Node>
+        T_Node *createNode(T_Node *) { return new T_Node; }
+        ThrottleNode *createNode(ThrottleNode *);
+        ValvetrainNode *createNode(ValvetrainNode *);
+
+        void clearNodes();
+
+    protected:
+        std::vector<std::string> m_searchPaths;
+        SimulationSnapshot m_data;
+
+        EngineNode *m_engine;
+        VehicleNode *m_vehicle;
+        TransmissionNode *m_transmission;
+
+        std::map<const void *, int32_t> m_nodeIndices;
+        std::vector<Node *> m_nodes;
+    };
+
+} /* namespace es_script */
+
+#endif /* ATG_ENGINE_SIM_SCRIPT_CACHE_H */
@@ -35,6 +35,16 @@ namespace es_script {
             return valvetrain;
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->writeNode(m_intakeCamshaft);
+            cache->writeNode(m_exhaustCamshaft);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->readNode(&m_intakeCamshaft);
+            cache->readNode(&m_exhaustCamshaft);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("intake_camshaft", &m_intakeCamshaft, InputTarget::Type::Object);
@@ -33,6 +33,14 @@ namespace es_script {
             return static_cast<Throttle *>(throttle);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.gamma);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.gamma);
+        }
+
     protected:
         virtual void registerInputs() override {
             addInput("gamma", &m_parameters.gamma);
@@ -55,6 +63,26 @@ namespace es_script {
             return static_cast<Throttle *>(throttle);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.minSpeed);
+            cache->write(m_parameters.maxSpeed);
+            cache->write(m_parameters.minVelocity);
+            cache->write(m_parameters.maxVelocity);
+            cache->write(m_parameters.k_s);
+            cache->write(m_parameters.k_d);
+            cache->write(m_parameters.gamma);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.minSpeed);
+            cache->read(&m_parameters.maxSpeed);
+            cache->read(&m_parameters.minVelocity);
+            cache->read(&m_parameters.maxVelocity);
+            cache->read(&m_parameters.k_s);
+            cache->read(&m_parameters.k_d);
+            cache->read(&m_parameters.gamma);
+        }
+
     protected:
         virtual void registerInputs() override {
             addInput("min_speed", &m_parameters.minSpeed);
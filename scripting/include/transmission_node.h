@@ -26,6 +26,16 @@ namespace es_script {
             m_gears.push_back(ratio);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.MaxClutchTorque);
+            cache->writeVector(m_gears);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.MaxClutchTorque);
+            cache->readVector(&m_gears);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("max_clutch_torque", &m_parameters.MaxClutchTorque);
@@ -17,6 +17,24 @@ namespace es_script {
             vehicle->initialize(m_parameters);
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->write(m_parameters.mass);
+            cache->write(m_parameters.dragCoefficient);
+            cache->write(m_parameters.crossSectionArea);
+            cache->write(m_parameters.diffRatio);
+            cache->write(m_parameters.tireRadius);
+            cache->write(m_parameters.rollingResistance);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->read(&m_parameters.mass);
+            cache->read(&m_parameters.dragCoefficient);
+            cache->read(&m_parameters.crossSectionArea);
+            cache->read(&m_parameters.diffRatio);
+            cache->read(&m_parameters.tireRadius);
+            cache->read(&m_parameters.rollingResistance);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("mass", &m_parameters.mass);
@@ -39,12 +39,48 @@ namespace es_script {
             params.minSpeed = m_parameters.minSpeed;
             params.minThrottlePosition = m_parameters.minThrottlePosition;
             params.manifoldVacuum = m_parameters.manifoldVacuum;
+            params.rpmHysteresis = m_parameters.rpmHysteresis;
+            params.manifoldVacuumHysteresis = m_parameters.manifoldVacuumHysteresis;
+            params.throttlePositionHysteresis = m_parameters.throttlePositionHysteresis;
+            params.switchTime = m_parameters.switchTime;
             params.engine = context->getEngine();
             valvetrain->initialize(params);
 
             return valvetrain;
         }
 
+        virtual void writeCache(ScriptCache *cache) const override {
+            cache->writeNode(m_vtecIntakeCamshaft);
+            cache->writeNode(m_vtecExhaustCamshaft);
+            cache->writeNode(m_intakeCamshaft);
+            cache->writeNode(m_exhaustCamshaft);
+
+            cache->write(m_parameters.minRpm);
+            cache->write(m_parameters.minSpeed);
+            cache->write(m_parameters.manifoldVacuum);
+            cache->write(m_parameters.minThrottlePosition);
+            cache->write(m_parameters.rpmHysteresis);
+            cache->write(m_parameters.manifoldVacuumHysteresis);
+            cache->write(m_parameters.throttlePositionHysteresis);
+            cache->write(m_parameters.switchTime);
+        }
+
+        virtual void readCache(ScriptCache *cache) override {
+            cache->readNode(&m_vtecIntakeCamshaft);
+            cache->readNode(&m_vtecExhaustCamshaft);
+            cache->readNode(&m_intakeCamshaft);
+            cache->readNode(&m_exhaustCamshaft);
+
+            cache->read(&m_parameters.minRpm);
+            cache->read(&m_parameters.minSpeed);
+            cache->read(&m_parameters.manifoldVacuum);
+            cache->read(&m_parameters.minThrottlePosition);
+            cache->read(&m_parameters.rpmHysteresis);
+            cache->read(&m_parameters.manifoldVacuumHysteresis);
+            cache->read(&m_parameters.throttlePositionHysteresis);
+            cache->read(&m_parameters.switchTime);
+        }
+
     protected:
         virtual void registerInputs() {
             addInput("vtec_intake_camshaft", &m_vtecIntakeCamshaft, InputTarget::Type::Object);
@@ -56,6 +92,10 @@ namespace es_script {
             addInput("min_speed", &m_parameters.minSpeed);
             addInput("manifold_vacuum", &m_parameters.manifoldVacuum);
             addInput("min_throttle_position", &m_parameters.minThrottlePosition);
+            addInput("rpm_hysteresis", &m_parameters.rpmHysteresis);
+            addInput("manifold_vacuum_hysteresis", &m_parameters.manifoldVacuumHysteresis);
+            addInput("throttle_position_hysteresis", &m_parameters.throttlePositionHysteresis);
+            addInput("switch_time", &m_parameters.switchTime);
 
             ValvetrainNode::registerInputs();
         }
@@ -1,35 +1,67 @@
 #include "../include/compiler.h"
 
-es_script::Compiler::Output *es_script::Compiler::s_output = nullptr;
+#include "../include/script_cache.h"
+
+thread_local es_script::Compiler::Output *es_script::Compiler::s_output = nullptr;
+thread_local es_script::ScriptCache *es_script::Compiler::s_cache = nullptr;
+
+namespace {
+    const char *SearchPaths[] = {
+        "../../es/",
+        "../es/",
+        "es/"
+    };
+}
 
 es_script::Compiler::Compiler() {
     m_compiler = nullptr;
+    m_cache = nullptr;
+    m_cacheKey = 0;
+    m_cached = false;
 }
 
 es_script::Compiler::~Compiler() {
     assert(m_compiler == nullptr);
+    assert(m_cache == nullptr);
 }
 
 es_script::Compiler::Output *es_script::Compiler::output() {
-    if (s_output == nullptr) {
-        s_output = new Output;
-    }
-
+    assert(s_output != nullptr);
     return s_output;
 }
 
+es_script::ScriptCache *es_script::Compiler::cache() {
+    return s_cache;
+}
+
 void es_script::Compiler::initialize() {
     m_compiler = new piranha::Compiler(&m_rules);
     m_compiler->setFileExtension(".mr");
 
-    m_compiler->addSearchPath("../../es/");
-    m_compiler->addSearchPath("../es/");
-    m_compiler->addSearchPath("es/");
+    for (const char *searchPath : SearchPaths) {
+        m_compiler->addSearchPath(searchPath);
+    }
 
     m_rules.initialize();
 }
 
 bool es_script::Compiler::compile(const piranha::IrPath &path) {
+    m_cached = false;
+    if (!m_cachePath.empty()) {
+        if (m_cache == nullptr) {
+            m_cache = new ScriptCache;
+            for (const char *searchPath : SearchPaths) {
+                m_cache->addSearchPath(searchPath);
+            }
+        }
+
+        m_cacheKey = m_cache->calculateKey(path.toString());
+        if (m_cache->read(m_cachePath, m_cacheKey, &m_output)) {
+            m_cached = true;
+            return true;
+        }
+    }
+
     bool successful = false;
 
     std::ofstream file("error_log.log", std::ios::out);
@@ -42,7 +74,10 @@ bool es_script::Compiler::compile(const piranha::IrPath &path) {
         if (errors->getErrorCount() == 0) {
             unit->build(&m_program);
 
+            m_output = Output();
+            s_output = &m_output;
             m_program.initialize();
+            s_output = nullptr;
 
             successful = true;
         }
@@ -59,13 +94,24 @@ bool es_script::Compiler::compile(const piranha::IrPath &path) {
 }
 
 es_script::Compiler::Output es_script::Compiler::execute() {
+    if (m_cached) {
+        return m_output;
+    }
+
+    s_output = &m_output;
+    s_cache = m_cache;
     const bool result = m_program.execute();
+    s_output = nullptr;
+    s_cache = nullptr;
 
     if (!result) {
         // Todo: Runtime error
     }
+    else if (m_cache != nullptr) {
+        m_cache->write(m_cachePath, m_cacheKey, m_output);
+    }
 
-    return *output();
+    return m_output;
 }
 
 void es_script::Compiler::destroy() {
@@ -74,6 +120,9 @@ void es_script::Compiler::destroy() {
 
     delete m_compiler;
     m_compiler = nullptr;
+
+    delete m_cache;
+    m_cache = nullptr;
 }
 
 void es_script::Compiler::printError(
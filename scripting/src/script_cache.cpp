@@ -0,0 +1,346 @@
+#include "../include/script_cache.h"
+
+#include "../include/actions.h"
+#include "../include/standard_valvetrain_node.h"
+#include "../include/vtec_valvetrain_node.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace {
+    constexpr uint64_t HashBasis = 0xCBF29CE484222325ull;
+
+    // FNV-1a
+    uint64_t hashBytes(const void *data, size_t size, uint64_t hash) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ull;
+        }
+
+        return hash;
+    }
+
+    uint64_t hashString(const std::string &s, uint64_t hash) {
+        const uint64_t length = s.size();
+        hash = hashBytes(&length, sizeof(length), hash);
+        return hashBytes(s.data(), s.size(), hash);
+    }
+
+    bool readFile(const std::string &path, std::string *contents) {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) return false;
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        *contents = buffer.str();
+
+        return true;
+    }
+
+    std::string parentPath(const std::string &path) {
+        const size_t separator = path.find_last_of("/\\");
+        return (separator == std::string::npos)
+            ? std::string()
+            : path.substr(0, separator + 1);
+    }
+
+    // Extracts the paths of all import statements. Commented-out imports are
+    // not filtered, which at worst makes the key depend on an extra file.
+    std::vector<std::string> findImports(const std::string &script) {
+        std::vector<std::string> imports;
+
+        std::istringstream lines(script);
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t i = line.find_first_not_of(" \t");
+            if (i == std::string::npos) continue;
+
+            if (line.compare(i, 7, "public ") == 0) i += 7;
+            else if (line.compare(i, 8, "private ") == 0) i += 8;
+
+            i = line.find_first_not_of(" \t", i);
+            if (i == std::string::npos || line.compare(i, 6, "import") != 0) continue;
+
+            const size_t begin = line.find('"', i + 6);
+            if (begin == std::string::npos) continue;
+
+            const size_t end = line.find('"', begin + 1);
+            if (end == std::string::npos) continue;
+
+            imports.push_back(line.substr(begin + 1, end - begin - 1));
+        }
+
+        return imports;
+    }
+}
+
+es_script::ScriptCache::ScriptCache() {
+    m_engine = nullptr;
+    m_vehicle = nullptr;
+    m_transmission = nullptr;
+}
+
+es_script::ScriptCache::~ScriptCache() {
+    clearNodes();
+}
+
+void es_script::ScriptCache::addSearchPath(const std::string &path) {
+    m_searchPaths.push_back(path);
+}
+
+uint64_t es_script::ScriptCache::calculateKey(const std::string &scriptPath) const {
+    uint64_t hash = HashBasis;
+    hash = hashBytes(&Version, sizeof(Version), hash);
+
+    std::set<std::string> visited;
+    hashScript(scriptPath, &visited, &hash);
+
+    return hash;
+}
+
+void es_script::ScriptCache::hashScript(
+    const std::string &path,
+    std::set<std::string> *visited,
+    uint64_t *hash) const
+{
+    if (visited->count(path) > 0) return;
+    visited->insert(path);
+
+    std::string contents;
+    *hash = hashString(path, *hash);
+    if (!readFile(path, &contents)) {
+        // A missing file still contributes its name so that creating it
+        // changes the key
+        *hash = hashString("<missing>", *hash);
+        return;
+    }
+
+    *hash = hashString(contents, *hash);
+
+    // Every location the import could resolve to is included; this is
+    // cheaper than replicating the compiler's lookup order exactly and only
+    // errs on the side of invalidating the cache
+    const std::string directory = parentPath(path);
+    for (const std::string &import : findImports(contents)) {
+        hashScript(directory + import, visited, hash);
+        for (const std::string &searchPath : m_searchPaths) {
+            hashScript(searchPath + import, visited, hash);
+        }
+    }
+}
+
+bool es_script::ScriptCache::read(
+    const std::string &filename,
+    uint64_t key,
+    Compiler::Output *output)
+{
+    SimulationSnapshot file;
+    if (!file.loadFromFile(filename)) return false;
+
+    uint32_t magic = 0, version = 0;
+    uint64_t fileKey = 0, payloadHash = 0;
+    file.read(&magic);
+    file.read(&version);
+    file.read(&fileKey);
+    file.read(&payloadHash);
+
+    if (!file.isValid() || magic != Magic || version != Version || fileKey != key) {
+        return false;
+    }
+
+    // The payload is checked in full before anything is built from it, so a
+    // partially written cache can't produce a half-initialized engine
+    const size_t headerSize = 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+    const uint8_t *payload = file.getData() + headerSize;
+    const size_t payloadSize = file.getSize() - headerSize;
+    if (hashBytes(payload, payloadSize, HashBasis) != payloadHash) {
+        return false;
+    }
+
+    m_data.setData(payload, payloadSize);
+    clearNodes();
+
+    EngineNode *engineNode = nullptr;
+    VehicleNode *vehicleNode = nullptr;
+    TransmissionNode *transmissionNode = nullptr;
+    readNode(&engineNode);
+    readNode(&vehicleNode);
+    readNode(&transmissionNode);
+
+    Compiler::Output cached;
+    m_data.read(&cached.simulatorParameters);
+    readApplicationSettings(&cached.applicationSettings);
+
+    if (!m_data.isValid() || !m_data.isAtEnd()) {
+        clearNodes();
+        return false;
+    }
+
+    if (engineNode != nullptr) {
+        cached.engine = new Engine;
+        engineNode->buildEngine(cached.engine);
+    }
+
+    if (vehicleNode != nullptr) {
+        cached.vehicle = new Vehicle;
+        vehicleNode->generate(cached.vehicle);
+    }
+
+    if (transmissionNode != nullptr) {
+        cached.transmission = new Transmission;
+        transmissionNode->generate(cached.transmission);
+    }
+
+    clearNodes();
+
+    *output = cached;
+    return true;
+}
+
+bool es_script::ScriptCache::write(
+    const std::string &filename,
+    uint64_t key,
+    const Compiler::Output &output)
+{
+    m_data.clear();
+    m_nodeIndices.clear();
+
+    writeNode(m_engine);
+    writeNode(m_vehicle);
+    writeNode(m_transmission);
+    m_data.write(output.simulatorParameters);
+    writeApplicationSettings(output.applicationSettings);
+
+    m_nodeIndices.clear();
+
+    SimulationSnapshot file;
+    file.write(Magic);
+    file.write(Version);
+    file.write(key);
+    file.write(hashBytes(m_data.getData(), m_data.getSize(), HashBasis));
+    file.write(m_data.getData(), m_data.getSize());
+
+    return file.saveToFile(filename);
+}
+
+void es_script::ScriptCache::writeString(const std::string &s) {
+    m_data.writeCount(s.size());
+    m_data.write(s.data(), s.size());
+}
+
+void es_script::ScriptCache::readString(std::string *s) {
+    uint64_t length = 0;
+    m_data.read(&length);
+    if (!m_data.isValid() || length > m_data.getSize()) {
+        m_data.invalidate();
+        return;
+    }
+
+    s->assign(static_cast<size_t>(length), '\0');
+    m_data.read(&(*s)[0], s->size());
+}
+
+int es_script::ScriptCache::readCount() {
+    uint64_t n = 0;
+    m_data.read(&n);
+
+    // Every element takes up at least one byte, so a longer count can only
+    // come from a corrupt cache
+    if (!m_data.isValid() || n > m_data.getSize()) {
+        m_data.invalidate();
+        return 0;
+    }
+
+    return static_cast<int>(n);
+}
+
+void es_script::ScriptCache::writeApplicationSettings(const ApplicationSettings &settings) {
+    m_data.write(settings.startFullscreen);
+    writeString(settings.powerUnits);
+    writeString(settings.torqueUnits);
+    writeString(settings.speedUnits);
+    writeString(settings.pressureUnits);
+    writeString(settings.boostUnits);
+    m_data.write(settings.colorBackground);
+    m_data.write(settings.colorForeground);
+    m_data.write(settings.colorShadow);
+    m_data.write(settings.colorHighlight1);
+    m_data.write(settings.colorHighlight2);
+    m_data.write(settings.colorPink);
+    m_data.write(settings.colorRed);
+    m_data.write(settings.colorOrange);
+    m_data.write(settings.colorYellow);
+    m_data.write(settings.colorBlue);
+    m_data.write(settings.colorGreen);
+}
+
+void es_script::ScriptCache::readApplicationSettings(ApplicationSettings *settings) {
+    m_data.read(&settings->startFullscreen);
+    readString(&settings->powerUnits);
+    readString(&settings->torqueUnits);
+    readString(&settings->speedUnits);
+    readString(&settings->pressureUnits);
+    readString(&settings->boostUnits);
+    m_data.read(&settings->colorBackground);
+    m_data.read(&settings->colorForeground);
+    m_data.read(&settings->colorShadow);
+    m_data.read(&settings->colorHighlight1);
+    m_data.read(&settings->colorHighlight2);
+    m_data.read(&settings->colorPink);
+    m_data.read(&settings->colorRed);
+    m_data.read(&settings->colorOrange);
+    m_data.read(&settings->colorYellow);
+    m_data.read(&settings->colorBlue);
+    m_data.read(&settings->colorGreen);
+}
+
+void es_script::ScriptCache::writeNodeType(const ThrottleNode *node) {
+    if (dynamic_cast<const DirectThrottleLinkageNode *>(node) != nullptr) {
+        m_data.write(static_cast<uint8_t>(0));
+    }
+    else if (dynamic_cast<const GovernorNode *>(node) != nullptr) {
+        m_data.write(static_cast<uint8_t>(1));
+    }
+    else {
+        m_data.write(static_cast<uint8_t>(0xFF));
+    }
+}
+
+void es_script::ScriptCache::writeNodeType(const ValvetrainNode *node) {
+    if (dynamic_cast<const StandardValvetrainNode *>(node) != nullptr) {
+        m_data.write(static_cast<uint8_t>(0));
+    }
+    else if (dynamic_cast<const VtecValvetrainNode *>(node) != nullptr) {
+        m_data.write(static_cast<uint8_t>(1));
+    }
+    else {
+        m_data.write(static_cast<uint8_t>(0xFF));
+    }
+}
+
+es_script::ThrottleNode *es_script::ScriptCache::createNode(ThrottleNode *) {
+    uint8_t type = 0xFF;
+    m_data.read(&type);
+
+    if (type == 0) return new DirectThrottleLinkageNode;
+    else if (type == 1) return new GovernorNode;
+    else return nullptr;
+}
+
+es_script::ValvetrainNode *es_script::ScriptCache::createNode(ValvetrainNode *) {
+    uint8_t type = 0xFF;
+    m_data.read(&type);
+
+    if (type == 0) return new StandardValvetrainNode;
+    else if (type == 1) return new VtecValvetrainNode;
+    else return nullptr;
+}
+
+void es_script::ScriptCache::clearNodes() {
+    for (Node *node : m_nodes) {
+        delete node;
+    }
+
+    m_nodes.clear();
+}
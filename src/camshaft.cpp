@@ -50,6 +50,10 @@ double Camshaft::sampleLobe(double theta) const {
     return m_lobeProfile->sampleTriangle(clampedTheta);
 }
 
+double Camshaft::getLobeAngle(int lobe) const {
+    return (m_crankshaft->getAngle() + m_advance) * 0.5 + m_lobeAngles[lobe];
+}
+
 double Camshaft::getAngle() const {
     const double angle =
         std::fmod((m_crankshaft->getAngle() + m_advance) * 0.5, 2 * constants::pi);
@@ -6,13 +6,16 @@
 #include "../include/connecting_rod.h"
 #include "../include/utilities.h"
 #include "../include/exhaust_system.h"
+#include "../include/flow_schedule.h"
 #include "../include/cylinder_bank.h"
 #include "../include/engine.h"
+#include "../include/simulation_snapshot.h"
 
 #include <cmath>
 
 CombustionChamber::CombustionChamber() {
     m_crankcasePressure = 0.0;
+    m_implicitDamping = 0.0;
     m_piston = nullptr;
     m_head = nullptr;
     m_engine = nullptr;
@@ -33,10 +36,15 @@ CombustionChamber::CombustionChamber() {
     m_lastTimestepTotalExhaustFlow = 0;
     m_lastTimestepTotalIntakeFlow = 0;
     m_exhaustFlow = 0;
+    m_intakeFlow = 0;
+    m_sealedFlowSteps = 0;
     m_exhaustFlowRate = 0;
     m_intakeFlowRate = 0;
 
     m_fuel = nullptr;
+
+    m_gasSystemStore = nullptr;
+    m_flowEdges = -1;
 }
 
 CombustionChamber::~CombustionChamber() {
@@ -117,6 +125,62 @@ void CombustionChamber::destroy() {
     m_pressure = nullptr;
 }
 
+void CombustionChamber::bindGasSystems(GasSystemStore *store) {
+    Intake *intake = m_head->getIntake(m_piston->getCylinderIndex());
+    ExhaustSystem *exhaust = m_head->getExhaustSystem(m_piston->getCylinderIndex());
+
+    m_intakeRunnerAndManifold.bind(store, store->allocate());
+    m_system.bind(store, store->allocate());
+    m_exhaustRunnerAndPrimary.bind(store, store->allocate());
+
+    const int plenum = intake->m_system.getStoreIndex(store);
+    const int intakeRunner = m_intakeRunnerAndManifold.getStoreIndex(store);
+    const int cylinder = m_system.getStoreIndex(store);
+    const int exhaustRunner = m_exhaustRunnerAndPrimary.getStoreIndex(store);
+    const int collector = exhaust->getSystem()->getStoreIndex(store);
+
+    // Edges are stored in the order in which they are evaluated by flow()
+    GasSystemStore::FlowEdge edge;
+    edge.k_flow = m_manifoldToRunnerFlowRate;
+    edge.crossSectionArea_0 = intake->getPlenumCrossSectionArea();
+    edge.crossSectionArea_1 = m_head->getIntakeRunnerCrossSectionArea();
+    edge.system_0 = plenum;
+    edge.system_1 = intakeRunner;
+    m_flowEdges = store->addEdge(edge);
+
+    edge.k_flow = 0.0;
+    edge.crossSectionArea_0 = m_head->getIntakeRunnerCrossSectionArea();
+    edge.crossSectionArea_1 = m_cylinderCrossSectionSurfaceArea;
+    edge.system_0 = intakeRunner;
+    edge.system_1 = cylinder;
+    store->addEdge(edge);
+
+    edge.k_flow = 0.0;
+    edge.crossSectionArea_0 = m_cylinderCrossSectionSurfaceArea;
+    edge.crossSectionArea_1 = m_head->getExhaustRunnerCrossSectionArea();
+    edge.system_0 = cylinder;
+    edge.system_1 = exhaustRunner;
+    store->addEdge(edge);
+
+    edge.k_flow = m_primaryToCollectorFlowRate;
+    edge.crossSectionArea_0 = m_head->getExhaustRunnerCrossSectionArea();
+    edge.crossSectionArea_1 = exhaust->getCollectorCrossSectionArea();
+    edge.system_0 = exhaustRunner;
+    edge.system_1 = collector;
+    store->addEdge(edge);
+
+    m_gasSystemStore = store;
+}
+
+void CombustionChamber::unbindGasSystems() {
+    m_intakeRunnerAndManifold.unbind();
+    m_system.unbind();
+    m_exhaustRunnerAndPrimary.unbind();
+
+    m_gasSystemStore = nullptr;
+    m_flowEdges = -1;
+}
+
 double CombustionChamber::getVolume() const {
     const double combustionPortVolume = m_head->getCombustionChamberVolume();
     const CylinderBank *bank = m_head->getCylinderBank();
@@ -166,6 +230,50 @@ bool CombustionChamber::popLitLastFrame() {
     return lit;
 }
 
+void CombustionChamber::seedRandom(uint64_t seed, uint64_t stream) {
+    m_random.seed(seed, stream);
+}
+
+void CombustionChamber::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_flameEvent);
+    snapshot->write(m_lit);
+    snapshot->write(m_litLastFrame);
+    snapshot->write(m_peakTemperature);
+    snapshot->write(m_nBurntFuel);
+
+    snapshot->write(m_intakeFlowRate);
+    snapshot->write(m_exhaustFlowRate);
+    snapshot->write(m_lastTimestepTotalExhaustFlow);
+    snapshot->write(m_lastTimestepTotalIntakeFlow);
+    snapshot->write(m_exhaustFlow);
+    snapshot->write(m_sealedFlowSteps);
+
+    snapshot->writeArray(m_pressure, StateSamples);
+    snapshot->writeArray(m_pistonSpeed, StateSamples);
+
+    m_random.saveState(snapshot);
+}
+
+void CombustionChamber::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_flameEvent);
+    snapshot->read(&m_lit);
+    snapshot->read(&m_litLastFrame);
+    snapshot->read(&m_peakTemperature);
+    snapshot->read(&m_nBurntFuel);
+
+    snapshot->read(&m_intakeFlowRate);
+    snapshot->read(&m_exhaustFlowRate);
+    snapshot->read(&m_lastTimestepTotalExhaustFlow);
+    snapshot->read(&m_lastTimestepTotalIntakeFlow);
+    snapshot->read(&m_exhaustFlow);
+    snapshot->read(&m_sealedFlowSteps);
+
+    snapshot->readArray(m_pressure, StateSamples);
+    snapshot->readArray(m_pistonSpeed, StateSamples);
+
+    m_random.loadState(snapshot);
+}
+
 void CombustionChamber::ignite() {
     if (!m_lit) {
         if (m_system.mix().p_fuel == 0) return;
@@ -208,7 +316,7 @@ void CombustionChamber::ignite() {
                 * clamp(1 - dilution / maxDilutionEffect));
         const double rand_s =
             lowEfficiencyAttenuation
-            * ((1 - randomness) + randomness * ((double)rand() / RAND_MAX));
+            * ((1 - randomness) + randomness * m_random.uniform());
         const double efficiencyAttenuation =
             (mixingFactor * rand_s + (1 - mixingFactor));
         m_flameEvent.efficiency =
@@ -232,7 +340,89 @@ void CombustionChamber::update(double dt) {
     m_exhaustFlowRate = m_head->exhaustFlowRate(m_piston->getCylinderIndex());
 }
 
+double CombustionChamber::getFlowStiffness(double minPressureDifference) {
+    Intake *intake = m_head->getIntake(m_piston->getCylinderIndex());
+    ExhaustSystem *exhaust = m_head->getExhaustSystem(m_piston->getCylinderIndex());
+
+    double stiffness = m_intakeRunnerAndManifold.flowStiffness(
+        m_manifoldToRunnerFlowRate, &intake->m_system, minPressureDifference);
+    stiffness = std::fmax(stiffness, m_system.flowStiffness(
+        m_intakeFlowRate, &m_intakeRunnerAndManifold, minPressureDifference));
+    stiffness = std::fmax(stiffness, m_system.flowStiffness(
+        m_exhaustFlowRate, &m_exhaustRunnerAndPrimary, minPressureDifference));
+    stiffness = std::fmax(stiffness, m_exhaustRunnerAndPrimary.flowStiffness(
+        m_primaryToCollectorFlowRate, exhaust->getSystem(), minPressureDifference));
+
+    return stiffness;
+}
+
 void CombustionChamber::flow(double dt) {
+    startFlow(dt);
+
+    GasSystemStore::FlowEdge *edges = &m_gasSystemStore->getEdge(m_flowEdges);
+    if (isSealed()) {
+        // Both valves are shut, so the chamber is sealed and each runner only
+        // exchanges with its plenum or collector
+        GasSystem::flow(m_gasSystemStore, edges[0], dt);
+        m_intakeRunnerAndManifold.dissipateExcessVelocity();
+
+        GasSystem::flow(m_gasSystemStore, edges[3], dt);
+        m_exhaustRunnerAndPrimary.dissipateExcessVelocity();
+    }
+    else {
+        GasSystem::flow(m_gasSystemStore, edges[0], dt);
+
+        m_intakeRunnerAndManifold.dissipateExcessVelocity();
+
+        m_intakeFlow = GasSystem::flow(m_gasSystemStore, edges[1], dt);
+
+        m_intakeRunnerAndManifold.dissipateExcessVelocity();
+        m_system.dissipateExcessVelocity();
+
+        m_exhaustFlow = GasSystem::flow(m_gasSystemStore, edges[2], dt);
+
+        m_system.dissipateExcessVelocity();
+        m_exhaustRunnerAndPrimary.dissipateExcessVelocity();
+
+        GasSystem::flow(m_gasSystemStore, edges[3], dt);
+    }
+
+    endFlow(dt);
+}
+
+void CombustionChamber::scheduleFlow(FlowSchedule *schedule) {
+    const int intakeRunner = m_intakeRunnerAndManifold.getStoreIndex(m_gasSystemStore);
+    const int cylinder = m_system.getStoreIndex(m_gasSystemStore);
+    const int exhaustRunner = m_exhaustRunnerAndPrimary.getStoreIndex(m_gasSystemStore);
+
+    // Same operations, in the same order, as flow()
+    if (isSealed()) {
+        schedule->addFlow(m_flowEdges + 0);
+        schedule->addDissipateExcessVelocity(intakeRunner);
+
+        schedule->addFlow(m_flowEdges + 3);
+        schedule->addDissipateExcessVelocity(exhaustRunner);
+    }
+    else {
+        schedule->addFlow(m_flowEdges + 0);
+
+        schedule->addDissipateExcessVelocity(intakeRunner);
+
+        schedule->addFlow(m_flowEdges + 1, &m_intakeFlow);
+
+        schedule->addDissipateExcessVelocity(intakeRunner);
+        schedule->addDissipateExcessVelocity(cylinder);
+
+        schedule->addFlow(m_flowEdges + 2, &m_exhaustFlow);
+
+        schedule->addDissipateExcessVelocity(cylinder);
+        schedule->addDissipateExcessVelocity(exhaustRunner);
+
+        schedule->addFlow(m_flowEdges + 3);
+    }
+}
+
+void CombustionChamber::startFlow(double dt) {
     if (m_system.temperature() > m_peakTemperature) {
         m_peakTemperature = m_system.temperature();
     }
@@ -248,71 +438,38 @@ void CombustionChamber::flow(double dt) {
     m_system.changeEnergy(dT * cylinderSurfaceArea * 100 * dt);
     m_system.flow(m_piston->getBlowbyK(), dt, m_crankcasePressure, units::celcius(25.0));
 
+    m_intakeFlow = 0;
+    m_exhaustFlow = 0;
+    if (!isSealed()) {
+        GasSystemStore::FlowEdge *edges = &m_gasSystemStore->getEdge(m_flowEdges);
+        edges[1].k_flow = m_intakeFlowRate;
+        edges[1].crossSectionArea_1 = volume / cylinderHeight;
+        edges[2].k_flow = m_exhaustFlowRate;
+        edges[2].crossSectionArea_0 = volume / cylinderHeight;
+    }
+}
+
+void CombustionChamber::endFlow(double dt) {
     Intake *intake = m_head->getIntake(m_piston->getCylinderIndex());
     ExhaustSystem *exhaust = m_head->getExhaustSystem(m_piston->getCylinderIndex());
 
-    const double start_n = m_system.n();
-
-    GasSystem::FlowParameters flowParams;
-    flowParams.dt = dt;
-
-    flowParams.k_flow = m_manifoldToRunnerFlowRate;
-    flowParams.crossSectionArea_0 = intake->getPlenumCrossSectionArea();
-    flowParams.crossSectionArea_1 = m_head->getIntakeRunnerCrossSectionArea();
-    flowParams.direction_x = 1.0;
-    flowParams.direction_y = 0.0;
-    flowParams.system_0 = &intake->m_system;
-    flowParams.system_1 = &m_intakeRunnerAndManifold;
-    GasSystem::flow(flowParams);
-
-    m_intakeRunnerAndManifold.dissipateExcessVelocity();
-
-    flowParams.k_flow = m_intakeFlowRate;
-    flowParams.crossSectionArea_0 = m_head->getIntakeRunnerCrossSectionArea();
-    flowParams.crossSectionArea_1 = volume / cylinderHeight;
-    flowParams.direction_x = 1.0;
-    flowParams.direction_y = 0.0;
-    flowParams.system_0 = &m_intakeRunnerAndManifold;
-    flowParams.system_1 = &m_system;
-    const double intakeFlow = GasSystem::flow(flowParams);
-
-    m_intakeRunnerAndManifold.dissipateExcessVelocity();
-    m_system.dissipateExcessVelocity();
-
-    flowParams.k_flow = m_exhaustFlowRate;
-    flowParams.crossSectionArea_0 = volume / cylinderHeight;
-    flowParams.crossSectionArea_1 = m_head->getExhaustRunnerCrossSectionArea();
-    flowParams.direction_x = 1.0;
-    flowParams.direction_y = 0.0;
-    flowParams.system_0 = &m_system;
-    flowParams.system_1 = &m_exhaustRunnerAndPrimary;
-    const double exhaustFlow = GasSystem::flow(flowParams);
-
-    m_system.dissipateExcessVelocity();
-    m_exhaustRunnerAndPrimary.dissipateExcessVelocity();
-
-    flowParams.k_flow = m_primaryToCollectorFlowRate;
-    flowParams.crossSectionArea_0 = m_head->getExhaustRunnerCrossSectionArea();
-    flowParams.crossSectionArea_1 = exhaust->getCollectorCrossSectionArea();
-    flowParams.direction_x = 1.0;
-    flowParams.direction_y = 0.0;
-    flowParams.system_0 = &m_exhaustRunnerAndPrimary;
-    flowParams.system_1 = exhaust->getSystem();
-    GasSystem::flow(flowParams);
-
     m_intakeRunnerAndManifold.updateVelocity(dt, intake->getVelocityDecay());
     m_system.updateVelocity(dt, 0.5);
     m_exhaustRunnerAndPrimary.updateVelocity(dt, exhaust->getVelocityDecay());
 
-    if (std::abs(intakeFlow) > 1E-9 && m_lit) {
+    if (isSealed()) {
+        ++m_sealedFlowSteps;
+    }
+
+    if (std::abs(m_intakeFlow) > 1E-9 && m_lit) {
         m_lit = false;
     }
 
-    m_exhaustFlow = exhaustFlow;
-    m_lastTimestepTotalExhaustFlow += exhaustFlow;
-    m_lastTimestepTotalIntakeFlow += intakeFlow;
+    m_lastTimestepTotalExhaustFlow += m_exhaustFlow;
+    m_lastTimestepTotalIntakeFlow += m_intakeFlow;
 
     if (m_lit) {
+        const double volume = getVolume();
         CylinderBank *bank = m_head->getCylinderBank();
         const double totalTravel_x = bank->getBore() / 2;
         const double totalTravel_y = volume / bank->boreSurfaceArea();
@@ -403,12 +560,24 @@ void CombustionChamber::updateCycleStates() {
 
 void CombustionChamber::apply(atg_scs::SystemState *system) {
     CylinderBank *bank = m_head->getCylinderBank();
-    const double area = (bank->getBore() * bank->getBore() / 4.0) * constants::pi;
     const double v_x = system->v_x[m_piston->m_body.index];
     const double v_y = system->v_y[m_piston->m_body.index];
 
     const double v_s =
         v_x * bank->getDx() + v_y * bank->getDy();
+    const double F = calculatePistonForce(v_s) - m_implicitDamping * v_s;
+
+    system->applyForce(
+        0.0,
+        0.0,
+        F * bank->getDx(),
+        F * bank->getDy(),
+        m_piston->m_body.index);
+}
+
+double CombustionChamber::calculatePistonForce(double v_s) const {
+    CylinderBank *bank = m_head->getCylinderBank();
+    const double area = (bank->getBore() * bank->getBore() / 4.0) * constants::pi;
 
     const double pressureDifferential = m_system.pressure() - m_crankcasePressure;
     const double force = -area * pressureDifferential;
@@ -417,21 +586,52 @@ void CombustionChamber::apply(atg_scs::SystemState *system) {
         assert(false);
     }
 
-    constexpr double limit = 1E-3;
-    const double abs_v_s = std::fmin(std::abs(v_s), limit);
-    const double attenuation = abs_v_s / limit;
+    const double abs_v_s = std::fmin(std::abs(v_s), FrictionAttenuationSpeed);
+    const double attenuation = abs_v_s / FrictionAttenuationSpeed;
 
     const double F = calculateFrictionForce(v_s) * attenuation;
     const double F_fric = (v_s > 0)
         ? -F
         : F;
 
-    system->applyForce(
-        0.0,
-        0.0,
-        (force + F_fric) * bank->getDx(),
-        (force + F_fric) * bank->getDy(),
-        m_piston->m_body.index);
+    return force + F_fric;
+}
+
+double CombustionChamber::calculatePressureStiffness() const {
+    const double volume = m_system.volume();
+    if (volume <= 0) return 0.0;
+
+    const double area = m_head->getCylinderBank()->boreSurfaceArea();
+    const double gamma = GasSystem::heatCapacityRatio(m_system.degreesOfFreedom());
+
+    // dP/dV = -gamma * P / V and the volume shrinks by the bore area for each
+    // unit of travel towards the head
+    return gamma * m_system.pressure() * area * area / volume;
+}
+
+double CombustionChamber::calculateFrictionDamping(double v_s) const {
+    const double cylinderWallForce = m_piston->calculateCylinderWallForce();
+
+    const double F_coul = m_frictionModel.frictionCoeff * cylinderWallForce;
+    const double v_st = m_frictionModel.breakawayFrictionVelocity * constants::root_2;
+    const double v_coul = m_frictionModel.breakawayFrictionVelocity / 10;
+    const double F_brk = m_frictionModel.breakawayFriction;
+    const double v = std::abs(v_s);
+
+    // Derivative of calculateFrictionForce() term by term
+    const double F_0 = constants::root_2 * constants::e * (F_brk - F_coul);
+    const double F_1 = v / v_st;
+    const double tanh_v = std::tanh(v / v_coul);
+    const double dF_2 = std::exp(-F_1 * F_1) * (1 - 2 * F_1 * F_1) / v_st;
+    const double dF_3 = F_coul * (1 - tanh_v * tanh_v) / v_coul;
+    const double dF_4 = m_frictionModel.viscousFrictionCoefficient;
+
+    double damping = F_0 * dF_2 + dF_3 + dF_4;
+    if (v < FrictionAttenuationSpeed) {
+        damping = (damping * v + calculateFrictionForce(v)) / FrictionAttenuationSpeed;
+    }
+
+    return std::fmax(damping, 0.0);
 }
 
 double CombustionChamber::getFrictionForce() const {
@@ -1,4 +1,3 @@
-#include "..\include\connecting_rod.h"
 #include "../include/connecting_rod.h"
 
 #include <cmath>
@@ -0,0 +1,161 @@
+#include "../include/constraint_solver.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+ConstraintSolver::ConstraintSolver() {
+    m_tolerance = 1E-6;
+    m_maxIterationCount = 64;
+    m_warmStart = true;
+}
+
+ConstraintSolver::~ConstraintSolver() {
+    /* void */
+}
+
+bool ConstraintSolver::solve(
+    atg_scs::SparseMatrix<3> &J,
+    atg_scs::Matrix &W,
+    atg_scs::Matrix &right,
+    atg_scs::Matrix *result,
+    atg_scs::Matrix *previous)
+{
+    return solveProjected(J, W, right, nullptr, result);
+}
+
+bool ConstraintSolver::solveWithLimits(
+    atg_scs::SparseMatrix<3> &J,
+    atg_scs::Matrix &W,
+    atg_scs::Matrix &right,
+    atg_scs::Matrix &limits,
+    atg_scs::Matrix *result,
+    atg_scs::Matrix *previous)
+{
+    return solveProjected(J, W, right, &limits, result);
+}
+
+void ConstraintSolver::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->writeVector(m_lambda);
+}
+
+void ConstraintSolver::loadState(SimulationSnapshot *snapshot) {
+    snapshot->readVector(&m_lambda);
+}
+
+bool ConstraintSolver::solveProjected(
+    atg_scs::SparseMatrix<3> &J,
+    atg_scs::Matrix &W,
+    atg_scs::Matrix &right,
+    atg_scs::Matrix *limits,
+    atg_scs::Matrix *result)
+{
+    const int n = J.getHeight();
+    const int bodyCount = W.getHeight() / 3;
+
+    // The constraint set only changes when the simulation is rebuilt, at
+    // which point the old multipliers mean nothing
+    if (!m_warmStart || static_cast<int>(m_lambda.size()) != n) {
+        m_lambda.assign(n, 0.0);
+    }
+
+    m_rows.resize(n);
+    m_u.assign(3 * static_cast<size_t>(bodyCount), 0.0);
+
+    double rightNorm = 0.0;
+    for (int i = 0; i < n; ++i) {
+        Row &row = m_rows[i];
+        row.diagonal = 0.0;
+        row.lower = (limits != nullptr) ? limits->get(0, i) : -DBL_MAX;
+        row.upper = (limits != nullptr) ? limits->get(1, i) : DBL_MAX;
+
+        for (int j = 0; j < 2; ++j) {
+            const int index = static_cast<int>(J.getBlockIndex(i, j));
+            row.body[j] = (index >= 0 && index < bodyCount) ? index : -1;
+
+            for (int k = 0; k < 3; ++k) {
+                const double J_ijk = (row.body[j] != -1) ? J.get(i, j, k) : 0.0;
+                const double W_k = (row.body[j] != -1) ? W.get(0, 3 * index + k) : 0.0;
+
+                row.J[j][k] = J_ijk;
+                row.WJ[j][k] = W_k * J_ijk;
+                row.diagonal += J_ijk * W_k * J_ijk;
+            }
+        }
+
+        rightNorm = std::max(rightNorm, std::abs(right.get(0, i)));
+
+        // Limits can change between steps (e.g. a clutch being engaged), so
+        // the starting point is projected onto the current ones
+        const double lambda = std::min(std::max(m_lambda[i], row.lower), row.upper);
+        m_lambda[i] = lambda;
+
+        // u = W * J^T * lambda is kept up to date so that each row update
+        // only touches the bodies the row refers to
+        for (int j = 0; j < 2; ++j) {
+            if (row.body[j] == -1) continue;
+            for (int k = 0; k < 3; ++k) {
+                m_u[3 * row.body[j] + k] += row.WJ[j][k] * lambda;
+            }
+        }
+    }
+
+    const double threshold = m_tolerance * std::max(rightNorm, 1.0);
+
+    int iterations = 0;
+    double residual = 0.0;
+    bool converged = (n == 0);
+    while (!converged && iterations < m_maxIterationCount) {
+        residual = 0.0;
+        for (int i = 0; i < n; ++i) {
+            const Row &row = m_rows[i];
+            if (row.diagonal <= 0.0) continue;
+
+            double r = right.get(0, i);
+            for (int j = 0; j < 2; ++j) {
+                if (row.body[j] == -1) continue;
+                for (int k = 0; k < 3; ++k) {
+                    r -= row.J[j][k] * m_u[3 * row.body[j] + k];
+                }
+            }
+
+            const double lambda0 = m_lambda[i];
+            const double lambda1 =
+                std::min(std::max(lambda0 + r / row.diagonal, row.lower), row.upper);
+            const double delta = lambda1 - lambda0;
+            if (delta == 0.0) continue;
+
+            m_lambda[i] = lambda1;
+            for (int j = 0; j < 2; ++j) {
+                if (row.body[j] == -1) continue;
+                for (int k = 0; k < 3; ++k) {
+                    m_u[3 * row.body[j] + k] += row.WJ[j][k] * delta;
+                }
+            }
+
+            // Equal to the row residual for rows that are not at a limit
+            residual = std::max(residual, std::abs(delta) * row.diagonal);
+        }
+
+        ++iterations;
+        converged = residual <= threshold;
+    }
+
+    result->resize(1, n);
+    for (int i = 0; i < n; ++i) {
+        result->set(0, i, m_lambda[i]);
+    }
+
+    recordSolve(iterations, residual, converged);
+
+    return converged;
+}
+
+void ConstraintSolver::recordSolve(int iterations, double residual, bool converged) {
+    ++m_statistics.solves;
+    m_statistics.iterations += iterations;
+    m_statistics.lastIterations = iterations;
+    m_statistics.lastResidual = residual;
+    m_statistics.maxResidual = std::max(m_statistics.maxResidual, residual);
+    if (!converged) ++m_statistics.unconverged;
+}
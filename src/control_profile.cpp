@@ -0,0 +1,73 @@
+#include "../include/control_profile.h"
+
+#include <fstream>
+#include <sstream>
+
+ControlProfile::ControlProfile() {
+    /* void */
+}
+
+ControlProfile::~ControlProfile() {
+    /* void */
+}
+
+bool ControlProfile::load(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+
+    m_keyframes.clear();
+
+    std::string line;
+    while (std::getline(file, line)) {
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos) line.resize(comment);
+
+        std::istringstream ss(line);
+        Keyframe keyframe;
+        if (!(ss >> keyframe.time)) continue;
+        if (!(ss >> keyframe.throttle)) return false;
+        if (!(ss >> keyframe.dynoSpeed)) keyframe.dynoSpeed = 0.0;
+
+        addKeyframe(keyframe);
+    }
+
+    return !m_keyframes.empty();
+}
+
+void ControlProfile::addKeyframe(const Keyframe &keyframe) {
+    auto it = m_keyframes.end();
+    while (it != m_keyframes.begin() && (it - 1)->time > keyframe.time) --it;
+
+    m_keyframes.insert(it, keyframe);
+}
+
+double ControlProfile::getDuration() const {
+    return m_keyframes.empty()
+        ? 0.0
+        : m_keyframes.back().time;
+}
+
+ControlProfile::Keyframe ControlProfile::sample(double t) const {
+    if (m_keyframes.empty()) return { t, 0.0, 0.0 };
+    else if (t <= m_keyframes.front().time) return m_keyframes.front();
+    else if (t >= m_keyframes.back().time) return m_keyframes.back();
+
+    size_t i = 1;
+    while (m_keyframes[i].time < t) ++i;
+
+    const Keyframe &k0 = m_keyframes[i - 1];
+    const Keyframe &k1 = m_keyframes[i];
+    const double s = (t - k0.time) / (k1.time - k0.time);
+
+    Keyframe result;
+    result.time = t;
+    result.throttle = k0.throttle + s * (k1.throttle - k0.throttle);
+
+    // Interpolating into or out of a disabled dyno would sweep through
+    // speeds the profile never asked for, so hold the dyno state instead
+    result.dynoSpeed = (k0.dynoSpeed > 0 && k1.dynoSpeed > 0)
+        ? k0.dynoSpeed + s * (k1.dynoSpeed - k0.dynoSpeed)
+        : k0.dynoSpeed;
+
+    return result;
+}
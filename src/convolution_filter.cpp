@@ -1,5 +1,7 @@
 #include "../include/convolution_filter.h"
 
+#include "../include/simulation_snapshot.h"
+
 #include <assert.h>
 #include <string.h>
 
@@ -7,46 +9,305 @@ ConvolutionFilter::ConvolutionFilter() {
     m_shiftRegister = nullptr;
     m_impulseResponse = nullptr;
 
+    m_taps = nullptr;
+    m_kernel_re = m_kernel_im = nullptr;
+    m_gain = 1.0f;
+
     m_shiftOffset = 0;
     m_sampleCount = 0;
+    m_prepared = false;
+
+    m_partitionCount = 0;
+    m_blockPosition = 0;
+    m_fdlPosition = 0;
+
+    m_window = nullptr;
+    m_tailOutput = nullptr;
+    m_partitions_re = m_partitions_im = nullptr;
+    m_fdl_re = m_fdl_im = nullptr;
+    m_scratch_re = m_scratch_im = nullptr;
 }
 
 ConvolutionFilter::~ConvolutionFilter() {
     assert(m_shiftRegister == nullptr);
     assert(m_impulseResponse == nullptr);
+    assert(m_window == nullptr);
+}
+
+int ConvolutionFilter::getPartitionCount(int samples) {
+    return (samples > DirectConvolutionThreshold)
+        ? (samples - 1) / PartitionSize
+        : 0;
+}
+
+void ConvolutionFilter::transformPartitions(
+    const float *impulseResponse,
+    int samples,
+    float *partitions_re,
+    float *partitions_im)
+{
+    constexpr int B = PartitionSize;
+    constexpr int Bins = PartitionBins;
+
+    const int partitionCount = getPartitionCount(samples);
+    if (partitionCount == 0) return;
+
+    Fft fft;
+    fft.initialize(2 * B);
+
+    float re[2 * B], im[2 * B];
+    for (int p = 0; p < partitionCount; ++p) {
+        const int offset = (p + 1) * B;
+        const int taps = (samples - offset < B) ? samples - offset : B;
+
+        for (int i = 0; i < 2 * B; ++i) {
+            re[i] = (i < taps) ? impulseResponse[offset + i] : 0.0f;
+            im[i] = 0.0f;
+        }
+
+        fft.forward(re, im);
+
+        memcpy(partitions_re + p * Bins, re, sizeof(float) * Bins);
+        memcpy(partitions_im + p * Bins, im, sizeof(float) * Bins);
+    }
+
+    fft.destroy();
 }
 
 void ConvolutionFilter::initialize(int samples) {
+    m_impulseResponse = new float[samples];
+    memset(m_impulseResponse, 0, sizeof(float) * samples);
+
+    m_taps = m_impulseResponse;
+    m_gain = 1.0f;
+    m_prepared = false;
+
+    initializeState(samples);
+
+    if (m_partitionCount > 0) {
+        m_partitions_re = new float[m_partitionCount * PartitionBins];
+        m_partitions_im = new float[m_partitionCount * PartitionBins];
+        m_kernel_re = m_partitions_re;
+        m_kernel_im = m_partitions_im;
+    }
+}
+
+void ConvolutionFilter::initialize(const Kernel &kernel, float gain) {
+    m_taps = kernel.impulseResponse;
+    m_kernel_re = kernel.partitions_re;
+    m_kernel_im = kernel.partitions_im;
+    m_gain = gain;
+    m_prepared = true;
+
+    initializeState(kernel.sampleCount);
+}
+
+void ConvolutionFilter::initializeState(int samples) {
     m_sampleCount = samples;
     m_shiftOffset = 0;
-    m_shiftRegister = new float[samples];
-    m_impulseResponse = new float[samples];
 
-    memset(m_shiftRegister, 0, sizeof(float) * samples);
-    memset(m_impulseResponse, 0, sizeof(float) * samples);
+    m_partitionCount = getPartitionCount(samples);
+    m_blockPosition = 0;
+    m_fdlPosition = 0;
+
+    if (m_partitionCount == 0) {
+        m_shiftRegister = new float[samples];
+        memset(m_shiftRegister, 0, sizeof(float) * samples);
+
+        return;
+    }
+
+    constexpr int B = PartitionSize;
+    constexpr int Bins = PartitionBins;
+
+    m_fft.initialize(2 * B);
+
+    m_window = new float[2 * B];
+    m_tailOutput = new float[B];
+    m_fdl_re = new float[m_partitionCount * Bins];
+    m_fdl_im = new float[m_partitionCount * Bins];
+    m_scratch_re = new float[2 * B];
+    m_scratch_im = new float[2 * B];
+
+    memset(m_window, 0, sizeof(float) * 2 * B);
+    memset(m_tailOutput, 0, sizeof(float) * B);
+    memset(m_fdl_re, 0, sizeof(float) * m_partitionCount * Bins);
+    memset(m_fdl_im, 0, sizeof(float) * m_partitionCount * Bins);
 }
 
 void ConvolutionFilter::destroy() {
     delete[] m_shiftRegister;
     delete[] m_impulseResponse;
 
+    delete[] m_window;
+    delete[] m_tailOutput;
+    delete[] m_partitions_re;
+    delete[] m_partitions_im;
+    delete[] m_fdl_re;
+    delete[] m_fdl_im;
+    delete[] m_scratch_re;
+    delete[] m_scratch_im;
+
+    m_fft.destroy();
+
     m_shiftRegister = nullptr;
     m_impulseResponse = nullptr;
+
+    m_taps = nullptr;
+    m_kernel_re = m_kernel_im = nullptr;
+
+    m_window = nullptr;
+    m_tailOutput = nullptr;
+    m_partitions_re = m_partitions_im = nullptr;
+    m_fdl_re = m_fdl_im = nullptr;
+    m_scratch_re = m_scratch_im = nullptr;
+    m_partitionCount = 0;
+}
+
+void ConvolutionFilter::saveState(SimulationSnapshot *snapshot) const {
+    constexpr int B = PartitionSize;
+    constexpr int Bins = B + 1;
+
+    if (m_partitionCount > 0) {
+        snapshot->writeArray(m_window, 2 * B);
+        snapshot->writeArray(m_tailOutput, B);
+        snapshot->writeArray(m_fdl_re, (size_t)m_partitionCount * Bins);
+        snapshot->writeArray(m_fdl_im, (size_t)m_partitionCount * Bins);
+        snapshot->write(m_blockPosition);
+        snapshot->write(m_fdlPosition);
+    }
+    else {
+        snapshot->writeArray(m_shiftRegister, m_sampleCount);
+        snapshot->write(m_shiftOffset);
+    }
+}
+
+void ConvolutionFilter::loadState(SimulationSnapshot *snapshot) {
+    constexpr int B = PartitionSize;
+    constexpr int Bins = B + 1;
+
+    if (m_partitionCount > 0) {
+        snapshot->readArray(m_window, 2 * B);
+        snapshot->readArray(m_tailOutput, B);
+        snapshot->readArray(m_fdl_re, (size_t)m_partitionCount * Bins);
+        snapshot->readArray(m_fdl_im, (size_t)m_partitionCount * Bins);
+        snapshot->read(&m_blockPosition);
+        snapshot->read(&m_fdlPosition);
+    }
+    else {
+        snapshot->readArray(m_shiftRegister, m_sampleCount);
+        snapshot->read(&m_shiftOffset);
+    }
 }
 
 float ConvolutionFilter::f(float sample) {
+    return (m_partitionCount > 0)
+        ? partitionedConvolution(sample)
+        : directConvolution(sample);
+}
+
+void ConvolutionFilter::process(const float *input, float *output, int samples) {
+    if (m_partitionCount > 0) {
+        for (int i = 0; i < samples; ++i) {
+            output[i] = partitionedConvolution(input[i]);
+        }
+    }
+    else {
+        for (int i = 0; i < samples; ++i) {
+            output[i] = directConvolution(input[i]);
+        }
+    }
+}
+
+float ConvolutionFilter::directConvolution(float sample) {
     m_shiftRegister[m_shiftOffset] = sample;
 
     float result = 0;
     for (int i = 0; i < m_sampleCount - m_shiftOffset; ++i) {
-        result += m_impulseResponse[i] * m_shiftRegister[i + m_shiftOffset];
+        result += m_taps[i] * m_shiftRegister[i + m_shiftOffset];
     }
 
     for (int i = m_sampleCount - m_shiftOffset; i < m_sampleCount; ++i) {
-        result += m_impulseResponse[i] * m_shiftRegister[i - (m_sampleCount - m_shiftOffset)];
+        result += m_taps[i] * m_shiftRegister[i - (m_sampleCount - m_shiftOffset)];
     }
 
     m_shiftOffset = (m_shiftOffset - 1 + m_sampleCount) % m_sampleCount;
 
-    return result;
+    return result * m_gain;
+}
+
+float ConvolutionFilter::partitionedConvolution(float sample) {
+    constexpr int B = PartitionSize;
+
+    if (!m_prepared) prepare();
+
+    // The window holds the previous block followed by the current one, so
+    // the head taps can be applied without a separate history buffer
+    const int n = B + m_blockPosition;
+    m_window[n] = sample;
+
+    float result = m_tailOutput[m_blockPosition];
+    for (int i = 0; i < B; ++i) {
+        result += m_taps[i] * m_window[n - i];
+    }
+
+    if (++m_blockPosition == B) {
+        processBlock();
+        m_blockPosition = 0;
+    }
+
+    return result * m_gain;
+}
+
+void ConvolutionFilter::prepare() {
+    transformPartitions(m_impulseResponse, m_sampleCount, m_partitions_re, m_partitions_im);
+    m_prepared = true;
+}
+
+void ConvolutionFilter::processBlock() {
+    constexpr int B = PartitionSize;
+    constexpr int Bins = B + 1;
+
+    // Transform the latest window and add it to the frequency-domain delay
+    // line. Only the non-negative frequencies are kept since the input is real.
+    for (int i = 0; i < 2 * B; ++i) {
+        m_scratch_re[i] = m_window[i];
+        m_scratch_im[i] = 0.0f;
+    }
+
+    m_fft.forward(m_scratch_re, m_scratch_im);
+
+    m_fdlPosition = (m_fdlPosition == 0) ? m_partitionCount - 1 : m_fdlPosition - 1;
+    memcpy(m_fdl_re + m_fdlPosition * Bins, m_scratch_re, sizeof(float) * Bins);
+    memcpy(m_fdl_im + m_fdlPosition * Bins, m_scratch_im, sizeof(float) * Bins);
+
+    memcpy(m_window, m_window + B, sizeof(float) * B);
+
+    // Partition p is applied to the input block p + 1 blocks ago, which makes
+    // its output available for the whole of the next block
+    for (int i = 0; i < Bins; ++i) {
+        m_scratch_re[i] = m_scratch_im[i] = 0.0f;
+    }
+
+    for (int p = 0; p < m_partitionCount; ++p) {
+        const int slot = (m_fdlPosition + p) % m_partitionCount;
+        const float *x_re = m_fdl_re + slot * Bins;
+        const float *x_im = m_fdl_im + slot * Bins;
+        const float *h_re = m_kernel_re + p * Bins;
+        const float *h_im = m_kernel_im + p * Bins;
+
+        for (int i = 0; i < Bins; ++i) {
+            m_scratch_re[i] += x_re[i] * h_re[i] - x_im[i] * h_im[i];
+            m_scratch_im[i] += x_re[i] * h_im[i] + x_im[i] * h_re[i];
+        }
+    }
+
+    for (int i = 1; i < B; ++i) {
+        m_scratch_re[2 * B - i] = m_scratch_re[i];
+        m_scratch_im[2 * B - i] = -m_scratch_im[i];
+    }
+
+    m_fft.inverse(m_scratch_re, m_scratch_im);
+
+    memcpy(m_tailOutput, m_scratch_re + B, sizeof(float) * B);
 }
@@ -0,0 +1,350 @@
+#include "../include/crank_slider_linkage.h"
+
+#include "../include/engine.h"
+#include "../include/constants.h"
+#include "../include/simulation_snapshot.h"
+
+#include <cassert>
+#include <cmath>
+
+CrankSliderLinkage::CrankSliderLinkage() {
+    m_engine = nullptr;
+    m_outputShaft = nullptr;
+
+    m_crankshaftInertia = 0.0;
+    m_effectiveInertia = 0.0;
+    m_lastVelocity = 0.0;
+
+    m_implicitInertia = 0.0;
+    m_implicitDamping = 0.0;
+}
+
+CrankSliderLinkage::~CrankSliderLinkage() {
+    /* void */
+}
+
+void CrankSliderLinkage::initialize(Engine *engine) {
+    m_engine = engine;
+    m_outputShaft = engine->getOutputCrankshaft();
+
+    m_crankshaftInertia = 0.0;
+    for (int i = 0; i < engine->getCrankshaftCount(); ++i) {
+        m_crankshaftInertia += engine->getCrankshaft(i)->getMomentOfInertia();
+    }
+
+    const int cylinderCount = engine->getCylinderCount();
+    m_cylinders.resize(cylinderCount);
+    m_order.clear();
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        Cylinder &cylinder = m_cylinders[i];
+        cylinder.piston = engine->getPiston(i);
+        cylinder.rod = cylinder.piston->getRod();
+        cylinder.chamber = engine->getChamber(i);
+        cylinder.master = -1;
+
+        ConnectingRod *master = cylinder.rod->getMasterRod();
+        for (int j = 0; j < cylinderCount && master != nullptr; ++j) {
+            if (engine->getPiston(j)->getRod() == master) {
+                cylinder.master = j;
+                break;
+            }
+        }
+
+        assert(master == nullptr || cylinder.master != -1);
+        assert(master == nullptr || master->getMasterRod() == nullptr);
+
+        if (cylinder.master == -1) m_order.push_back(i);
+    }
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        if (m_cylinders[i].master != -1) m_order.push_back(i);
+    }
+
+    place();
+    m_lastVelocity = m_outputShaft->m_body.v_theta;
+}
+
+void CrankSliderLinkage::destroy() {
+    m_cylinders.clear();
+    m_order.clear();
+
+    m_engine = nullptr;
+    m_outputShaft = nullptr;
+}
+
+void CrankSliderLinkage::prepare(double implicitTimestep) {
+    const double dt = implicitTimestep;
+    const double omega = m_outputShaft->m_body.v_theta;
+
+    calculate(m_outputShaft->m_body.theta);
+
+    // The stiffness and damping of each piston force are carried onto the
+    // crank angle by the square of the piston's travel per radian
+    m_implicitInertia = 0.0;
+    m_implicitDamping = 0.0;
+    if (dt > 0) {
+        for (const Cylinder &cylinder : m_cylinders) {
+            const double ds = calculateStroke(cylinder);
+            const double k = cylinder.chamber->calculatePressureStiffness() * ds * ds;
+            const double c = cylinder.chamber->calculateFrictionDamping(ds * omega) * ds * ds;
+
+            m_implicitInertia += dt * (c + dt * k);
+            m_implicitDamping += dt * k;
+        }
+    }
+
+    m_effectiveInertia = calculateEffectiveInertia();
+    m_outputShaft->m_body.I = m_crankshaftInertia + m_effectiveInertia + m_implicitInertia;
+    m_lastVelocity = omega;
+}
+
+void CrankSliderLinkage::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_lastVelocity);
+}
+
+void CrankSliderLinkage::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_lastVelocity);
+}
+
+void CrankSliderLinkage::place() {
+    const double theta = m_outputShaft->m_body.theta;
+    const double omega = m_outputShaft->m_body.v_theta;
+
+    calculate(theta);
+
+    for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
+        Crankshaft *crankshaft = m_engine->getCrankshaft(i);
+        crankshaft->m_body.p_x = crankshaft->getPosX();
+        crankshaft->m_body.p_y = crankshaft->getPosY();
+        crankshaft->m_body.v_x = crankshaft->m_body.v_y = 0.0;
+        crankshaft->m_body.theta = theta;
+        crankshaft->m_body.v_theta = omega;
+    }
+
+    for (const Cylinder &cylinder : m_cylinders) {
+        atg_scs::RigidBody &rod = cylinder.rod->m_body;
+        rod.p_x = cylinder.rodCenter.x;
+        rod.p_y = cylinder.rodCenter.y;
+        rod.v_x = cylinder.rodCenter.dx * omega;
+        rod.v_y = cylinder.rodCenter.dy * omega;
+        rod.theta = cylinder.rodAngle;
+        rod.v_theta = cylinder.d_rodAngle * omega;
+
+        // The piston does not rotate and is attached to the rod at its wrist
+        // pin
+        Piston *piston = cylinder.piston;
+        CylinderBank *bank = piston->getCylinderBank();
+        atg_scs::RigidBody &body = piston->m_body;
+        body.theta = bank->getAngle() + constants::pi;
+        body.v_theta = 0.0;
+
+        double pin_x, pin_y;
+        body.p_x = body.p_y = 0.0;
+        body.localToWorld(0.0, piston->getWristPinLocation(), &pin_x, &pin_y);
+        body.p_x = cylinder.wristPin.x - pin_x;
+        body.p_y = cylinder.wristPin.y - pin_y;
+        body.v_x = cylinder.wristPin.dx * omega;
+        body.v_y = cylinder.wristPin.dy * omega;
+    }
+}
+
+void CrankSliderLinkage::update(double dt) {
+    const double omega = m_outputShaft->m_body.v_theta;
+    const double alpha = (dt > 0) ? (omega - m_lastVelocity) / dt : 0.0;
+
+    place();
+
+    // The wall force is whatever is left over once the piston and rod are
+    // given the accelerations implied by the linkage. It feeds the Coulomb
+    // term of the piston friction in the next step, the same way the line
+    // constraint force does in the full system.
+    for (const Cylinder &cylinder : m_cylinders) {
+        Piston *piston = cylinder.piston;
+        ConnectingRod *rod = cylinder.rod;
+        CylinderBank *bank = piston->getCylinderBank();
+
+        const double d_x = bank->getDx(), d_y = bank->getDy();
+        const double n_x = -d_y, n_y = d_x;
+
+        const Point &p = cylinder.bigEnd;
+        const Point &e = cylinder.wristPin;
+        const Point &c = cylinder.rodCenter;
+
+        const double a_e_x = e.ddx * omega * omega + e.dx * alpha;
+        const double a_e_y = e.ddy * omega * omega + e.dy * alpha;
+        const double a_c_x = c.ddx * omega * omega + c.dx * alpha;
+        const double a_c_y = c.ddy * omega * omega + c.dy * alpha;
+        const double a_phi =
+            cylinder.dd_rodAngle * omega * omega + cylinder.d_rodAngle * alpha;
+
+        const double r_x = e.x - p.x, r_y = e.y - p.y;
+        const double q_x = piston->getMass() * a_e_x - cylinder.pistonForce * d_x;
+        const double q_y = piston->getMass() * a_e_y - cylinder.pistonForce * d_y;
+
+        const double numerator =
+            (r_x * q_y - r_y * q_x)
+            - rod->getMass() * ((p.x - c.x) * a_c_y - (p.y - c.y) * a_c_x)
+            + rod->getMomentOfInertia() * a_phi;
+        const double denominator = r_x * n_y - r_y * n_x;
+
+        piston->setCylinderWallForce((denominator != 0)
+            ? std::abs(numerator / denominator)
+            : 0.0);
+    }
+}
+
+void CrankSliderLinkage::apply(atg_scs::SystemState *state) {
+    const int index = m_outputShaft->m_body.index;
+    const double theta = state->theta[index];
+    const double omega = state->v_theta[index];
+
+    calculate(theta);
+
+    // Generalized force on the crank angle: the piston forces through the
+    // Jacobian of the wrist pins, less the velocity-dependent part of the
+    // linkage's inertia, 1/2 * dI/dtheta * omega^2, and any damping from the
+    // linearization. Each piston force comes from the scalar reference in
+    // CombustionChamber rather than PistonForceGenerator, so the friction
+    // differs slightly from the other system types; see fast_math.h.
+    double torque = -m_implicitDamping * omega;
+    for (Cylinder &cylinder : m_cylinders) {
+        const double ds = calculateStroke(cylinder);
+
+        cylinder.pistonForce = cylinder.chamber->calculatePistonForce(ds * omega);
+        torque += cylinder.pistonForce * ds;
+
+        const Point &e = cylinder.wristPin;
+        const Point &c = cylinder.rodCenter;
+        const double coupling =
+            cylinder.piston->getMass() * (e.dx * e.ddx + e.dy * e.ddy)
+            + cylinder.rod->getMass() * (c.dx * c.ddx + c.dy * c.ddy)
+            + cylinder.rod->getMomentOfInertia() * cylinder.d_rodAngle * cylinder.dd_rodAngle;
+        torque -= coupling * omega * omega;
+    }
+
+    state->t[index] += torque;
+}
+
+double CrankSliderLinkage::calculateStroke(const Cylinder &cylinder) const {
+    const CylinderBank *bank = cylinder.piston->getCylinderBank();
+    return cylinder.wristPin.dx * bank->getDx() + cylinder.wristPin.dy * bank->getDy();
+}
+
+void CrankSliderLinkage::calculate(double theta) {
+    for (int i : m_order) {
+        calculateCylinder(&m_cylinders[i], theta);
+    }
+}
+
+void CrankSliderLinkage::calculateCylinder(Cylinder *cylinder, double theta) {
+    ConnectingRod *rod = cylinder->rod;
+    CylinderBank *bank = cylinder->piston->getCylinderBank();
+    Point &p = cylinder->bigEnd;
+
+    // Big end: a journal on the crankshaft or on the master rod, both of
+    // which are rigid bodies whose angle is a known function of theta
+    double j_x, j_y;
+    double center_x, center_y, center_dx, center_dy, center_ddx, center_ddy;
+    double angle, d_angle, dd_angle;
+    if (cylinder->master == -1) {
+        Crankshaft *crankshaft = rod->getCrankshaft();
+        crankshaft->getRodJournalPositionLocal(rod->getJournal(), &j_x, &j_y);
+
+        center_x = crankshaft->getPosX();
+        center_y = crankshaft->getPosY();
+        center_dx = center_dy = center_ddx = center_ddy = 0.0;
+        angle = theta;
+        d_angle = 1.0;
+        dd_angle = 0.0;
+    }
+    else {
+        const Cylinder &master = m_cylinders[cylinder->master];
+        master.rod->getRodJournalPositionLocal(rod->getJournal(), &j_x, &j_y);
+
+        center_x = master.rodCenter.x;
+        center_y = master.rodCenter.y;
+        center_dx = master.rodCenter.dx;
+        center_dy = master.rodCenter.dy;
+        center_ddx = master.rodCenter.ddx;
+        center_ddy = master.rodCenter.ddy;
+        angle = master.rodAngle;
+        d_angle = master.d_rodAngle;
+        dd_angle = master.dd_rodAngle;
+    }
+
+    const double cos_a = std::cos(angle), sin_a = std::sin(angle);
+    const double w_x = cos_a * j_x - sin_a * j_y;
+    const double w_y = sin_a * j_x + cos_a * j_y;
+
+    p.x = center_x + w_x;
+    p.y = center_y + w_y;
+    p.dx = center_dx - d_angle * w_y;
+    p.dy = center_dy + d_angle * w_x;
+    p.ddx = center_ddx - dd_angle * w_y - d_angle * d_angle * w_x;
+    p.ddy = center_ddy + dd_angle * w_x - d_angle * d_angle * w_y;
+
+    // Wrist pin: the point b + d * s on the cylinder axis a rod length away
+    // from the big end. The rod length is the distance between its pins,
+    // which is what the link constraints hold in the full system.
+    const double L = rod->getLittleEndLocal() - rod->getBigEndLocal();
+    const double d_x = bank->getDx(), d_y = bank->getDy();
+    const double o_x = p.x - bank->getX(), o_y = p.y - bank->getY();
+
+    const double a = d_x * d_x + d_y * d_y;
+    const double b = -2 * (d_x * o_x + d_y * o_y);
+    const double c = o_x * o_x + o_y * o_y - L * L;
+    const double det = std::fmax(b * b - 4 * a * c, 0.0);
+    const double s = (-b + std::sqrt(det)) / (2 * a);
+
+    const double r_x = d_x * s - o_x;
+    const double r_y = d_y * s - o_y;
+    const double r_d = r_x * d_x + r_y * d_y;
+    const double r_2 = r_x * r_x + r_y * r_y;
+
+    // Differentiating |r|^2 = L^2 once and twice gives the slide speed and
+    // acceleration per unit crank angle
+    const double ds = (r_x * p.dx + r_y * p.dy) / r_d;
+    const double dr_x = d_x * ds - p.dx;
+    const double dr_y = d_y * ds - p.dy;
+    const double dds = (r_x * p.ddx + r_y * p.ddy - (dr_x * dr_x + dr_y * dr_y)) / r_d;
+    const double ddr_x = d_x * dds - p.ddx;
+    const double ddr_y = d_y * dds - p.ddy;
+
+    Point &e = cylinder->wristPin;
+    e.x = bank->getX() + d_x * s;
+    e.y = bank->getY() + d_y * s;
+    e.dx = d_x * ds;
+    e.dy = d_y * ds;
+    e.ddx = d_x * dds;
+    e.ddy = d_y * dds;
+
+    // The rod's local y axis runs from the big end to the little end
+    cylinder->rodAngle = std::atan2(r_y, r_x) - constants::pi / 2;
+    cylinder->d_rodAngle = (r_x * dr_y - r_y * dr_x) / r_2;
+    cylinder->dd_rodAngle = (r_x * ddr_y - r_y * ddr_x) / r_2;
+
+    const double k = rod->getBigEndLocal() / L;
+    Point &center = cylinder->rodCenter;
+    center.x = p.x - k * r_x;
+    center.y = p.y - k * r_y;
+    center.dx = p.dx - k * dr_x;
+    center.dy = p.dy - k * dr_y;
+    center.ddx = p.ddx - k * ddr_x;
+    center.ddy = p.ddy - k * ddr_y;
+}
+
+double CrankSliderLinkage::calculateEffectiveInertia() const {
+    double inertia = 0.0;
+    for (const Cylinder &cylinder : m_cylinders) {
+        const Point &e = cylinder.wristPin;
+        const Point &c = cylinder.rodCenter;
+
+        inertia +=
+            cylinder.piston->getMass() * (e.dx * e.dx + e.dy * e.dy)
+            + cylinder.rod->getMass() * (c.dx * c.dx + c.dy * c.dy)
+            + cylinder.rod->getMomentOfInertia() * cylinder.d_rodAngle * cylinder.d_rodAngle;
+    }
+
+    return inertia;
+}
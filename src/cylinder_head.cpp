@@ -2,7 +2,10 @@
 
 #include "../include/cylinder_bank.h"
 #include "../include/valvetrain.h"
+#include "../include/constants.h"
 
+#include <algorithm>
+#include <cmath>
 #include <assert.h>
 
 CylinderHead::CylinderHead() {
@@ -41,21 +44,51 @@ void CylinderHead::initialize(const Parameters &params) {
     m_intakeRunnerCrossSectionArea = params.IntakeRunnerCrossSectionArea;
     m_exhaustRunnerVolume = params.ExhaustRunnerVolume;
     m_exhaustRunnerCrossSectionArea = params.ExhaustRunnerCrossSectionArea;
+
+    // Until a switch happens, the previous camshaft of a valvetrain that
+    // can switch is the one it would switch to
+    if (m_valvetrain != nullptr) {
+        buildFlowTables(
+            m_intakeFlowTables,
+            m_valvetrain->getActiveIntakeCamshaft(),
+            m_valvetrain->getPreviousIntakeCamshaft(),
+            m_intakePortFlow);
+        buildFlowTables(
+            m_exhaustFlowTables,
+            m_valvetrain->getActiveExhaustCamshaft(),
+            m_valvetrain->getPreviousExhaustCamshaft(),
+            m_exhaustPortFlow);
+    }
 }
 
 void CylinderHead::destroy() {
     if (m_cylinders != nullptr) delete[] m_cylinders;
     m_cylinders = nullptr;
+
+    for (int i = 0; i < FlowTableCacheSize; ++i) {
+        delete[] m_intakeFlowTables[i].flow;
+        delete[] m_exhaustFlowTables[i].flow;
+        m_intakeFlowTables[i] = FlowTable();
+        m_exhaustFlowTables[i] = FlowTable();
+    }
 }
 
 double CylinderHead::intakeFlowRate(int cylinder) const {
-    return m_intakePortFlow->sampleTriangle(
-            intakeValveLift(cylinder));
+    return flowRate(
+        m_intakeFlowTables,
+        m_valvetrain->getActiveIntakeCamshaft(),
+        m_valvetrain->getPreviousIntakeCamshaft(),
+        m_intakePortFlow,
+        cylinder);
 }
 
 double CylinderHead::exhaustFlowRate(int cylinder) const {
-    return m_exhaustPortFlow->sampleTriangle(
-            exhaustValveLift(cylinder));
+    return flowRate(
+        m_exhaustFlowTables,
+        m_valvetrain->getActiveExhaustCamshaft(),
+        m_valvetrain->getPreviousExhaustCamshaft(),
+        m_exhaustPortFlow,
+        cylinder);
 }
 
 double CylinderHead::intakeValveLift(int cylinder) const {
@@ -100,6 +133,89 @@ void CylinderHead::setHeaderPrimaryLength(int i, double length) {
     m_cylinders[i].headerPrimaryLength = length;
 }
 
+void CylinderHead::buildFlowTable(
+    FlowTable *table,
+    const Camshaft *camshaft,
+    const Function *portFlow)
+{
+    if (table->flow == nullptr) {
+        table->flow = new double[FlowTableResolution + 1];
+    }
+
+    const double spacing = 2 * constants::pi / FlowTableResolution;
+    for (int i = 0; i < FlowTableResolution; ++i) {
+        table->flow[i] = portFlow->sampleTriangle(camshaft->sampleLobe(i * spacing));
+    }
+
+    // Wrap-around entry so that the last interval needs no special case
+    table->flow[FlowTableResolution] = table->flow[0];
+    table->camshaft = camshaft;
+}
+
+void CylinderHead::buildFlowTables(
+    FlowTable *tables,
+    const Camshaft *active,
+    const Camshaft *previous,
+    const Function *portFlow)
+{
+    if (active == nullptr || portFlow == nullptr) return;
+
+    buildFlowTable(&tables[0], active, portFlow);
+    if (previous != nullptr && previous != active) {
+        buildFlowTable(&tables[1], previous, portFlow);
+    }
+}
+
+double CylinderHead::flowRate(
+    const FlowTable *tables,
+    const Camshaft *active,
+    const Camshaft *previous,
+    const Function *portFlow,
+    int cylinder) const
+{
+    const double flow = sampleFlow(tables, active, portFlow, cylinder);
+
+    const double progress = m_valvetrain->getSwitchProgress();
+    if (progress >= 1.0) return flow;
+
+    // Blending flow rather than lift during a camshaft switch is close
+    // enough for the few milliseconds it lasts
+    const double previousFlow = sampleFlow(tables, previous, portFlow, cylinder);
+    return previousFlow + progress * (flow - previousFlow);
+}
+
+double CylinderHead::sampleFlow(
+    const FlowTable *tables,
+    const Camshaft *camshaft,
+    const Function *portFlow,
+    int cylinder) const
+{
+    const FlowTable *table = nullptr;
+    for (int i = 0; i < FlowTableCacheSize; ++i) {
+        if (tables[i].camshaft == camshaft) {
+            table = &tables[i];
+            break;
+        }
+    }
+
+    // A camshaft the valvetrain didn't report at initialization is sampled
+    // exactly rather than built into a table during the simulation
+    if (table == nullptr) {
+        return portFlow->sampleTriangle(camshaft->sampleLobe(camshaft->getLobeAngle(cylinder)));
+    }
+
+    constexpr double Scale = FlowTableResolution / (2 * constants::pi);
+    constexpr double Period = FlowTableResolution;
+
+    const double s = camshaft->getLobeAngle(cylinder) * Scale;
+    const double wrapped =
+        std::fmin(std::fmax(s - Period * std::floor(s / Period), 0.0), Period);
+    const int i = std::min(static_cast<int>(wrapped), FlowTableResolution - 1);
+    const double f = wrapped - i;
+
+    return table->flow[i] + f * (table->flow[i + 1] - table->flow[i]);
+}
+
 Camshaft *CylinderHead::getExhaustCamshaft() {
     return m_valvetrain->getActiveExhaustCamshaft();
 }
@@ -1,2 +1,68 @@
 #include "../include/delay_filter.h"
 
+#include "../include/simulation_snapshot.h"
+
+#include <algorithm>
+#include <vector>
+
+void DelayFilter::setSampleRate(double audioFrequency) {
+    if (audioFrequency == m_sampleRate) return;
+
+    const int n = static_cast<int>(m_history.size());
+    std::vector<double> samples(n);
+    for (int i = 0; i < n; ++i) {
+        samples[i] = m_history.read(i);
+    }
+
+    const double previousRate = m_sampleRate;
+    initialize(m_delay, audioFrequency);
+
+    if (n == 0 || previousRate <= 0) return;
+
+    // Linear interpolation over the same span of time
+    const int resampled = std::min(
+        static_cast<int>(std::round(n * audioFrequency / previousRate)),
+        m_latencySamples);
+    std::vector<double> output(resampled);
+    for (int i = 0; i < resampled; ++i) {
+        const double t = (resampled > 1)
+            ? static_cast<double>(i) * (n - 1) / (resampled - 1)
+            : n - 1;
+        const int i0 = std::min(static_cast<int>(t), n - 1);
+        const int i1 = std::min(i0 + 1, n - 1);
+        const double s = t - i0;
+        output[i] = samples[i0] * (1 - s) + samples[i1] * s;
+    }
+
+    restore(output.data(), resampled);
+}
+
+void DelayFilter::restore(const double *samples, int n) {
+    for (int i = 0; i < n; ++i) {
+        m_history.write(samples[i]);
+    }
+}
+
+void DelayFilter::saveState(SimulationSnapshot *snapshot) const {
+    const int n = static_cast<int>(m_history.size());
+    std::vector<double> samples(n);
+    for (int i = 0; i < n; ++i) {
+        samples[i] = m_history.read(i);
+    }
+
+    snapshot->write(m_sampleRate);
+    snapshot->writeVector(samples);
+}
+
+void DelayFilter::loadState(SimulationSnapshot *snapshot) {
+    double sampleRate = m_sampleRate;
+    std::vector<double> samples;
+    snapshot->read(&sampleRate);
+    snapshot->readVector(&samples);
+
+    if (snapshot->isValidating()) return;
+
+    // The snapshot may have been taken at another simulation frequency
+    initialize(m_delay, sampleRate);
+    restore(samples.data(), std::min(static_cast<int>(samples.size()), m_latencySamples));
+}
@@ -1,5 +1,7 @@
 #include "../include/derivative_filter.h"
 
+#include "../include/simulation_snapshot.h"
+
 DerivativeFilter::DerivativeFilter() {
     m_previous = 0;
     m_dt = 0;
@@ -15,3 +17,23 @@ float DerivativeFilter::f(float sample) {
 
     return (sample - temp) / m_dt;
 }
+
+void DerivativeFilter::process(const float *input, float *output, int samples) {
+    if (samples <= 0) return;
+
+    const float previous = m_previous;
+    m_previous = input[samples - 1];
+
+    output[0] = (input[0] - previous) / m_dt;
+    for (int i = 1; i < samples; ++i) {
+        output[i] = (input[i] - input[i - 1]) / m_dt;
+    }
+}
+
+void DerivativeFilter::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_previous);
+}
+
+void DerivativeFilter::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_previous);
+}
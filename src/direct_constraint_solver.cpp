@@ -0,0 +1,439 @@
+#include "../include/direct_constraint_solver.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <set>
+
+namespace {
+    // Pivots this small relative to the diagonal they started from belong to
+    // redundant rows, whose multipliers are left at zero
+    constexpr double PivotTolerance = 1E-12;
+
+    int getBlock(atg_scs::SparseMatrix<3> &J, int row, int entry, int bodyCount) {
+        const int index = static_cast<int>(J.getBlockIndex(row, entry));
+        return (index >= 0 && index < bodyCount) ? index : -1;
+    }
+}
+
+DirectConstraintSolver::DirectConstraintSolver() {
+    m_rowCount = -1;
+    m_bodyCount = 0;
+    m_analysisCount = 0;
+}
+
+DirectConstraintSolver::~DirectConstraintSolver() {
+    /* void */
+}
+
+bool DirectConstraintSolver::solveProjected(
+    atg_scs::SparseMatrix<3> &J,
+    atg_scs::Matrix &W,
+    atg_scs::Matrix &right,
+    atg_scs::Matrix *limits,
+    atg_scs::Matrix *result)
+{
+    const int n = J.getHeight();
+    const int bodyCount = W.getHeight() / 3;
+
+    if (patternChanged(J, bodyCount)) {
+        analyze(J, bodyCount);
+    }
+
+    assemble(J, W);
+
+    const bool warmStart = m_warmStart && static_cast<int>(m_lambda.size()) == n;
+    m_lambda.resize(n);
+    m_bounds.resize(n);
+    m_lower.resize(n);
+    m_upper.resize(n);
+    m_right.resize(n);
+    m_x.resize(n);
+    m_w.resize(n);
+
+    double rightNorm = 0.0;
+    for (int i = 0; i < n; ++i) {
+        m_lower[i] = (limits != nullptr) ? limits->get(0, i) : -DBL_MAX;
+        m_upper[i] = (limits != nullptr) ? limits->get(1, i) : DBL_MAX;
+        m_right[i] = right.get(0, i);
+        rightNorm = std::max(rightNorm, std::abs(m_right[i]));
+
+        // The active set method needs a feasible starting point, with the
+        // rows at a limit exactly on it
+        if (!warmStart) m_lambda[i] = 0.0;
+        m_lambda[i] = std::min(std::max(m_lambda[i], m_lower[i]), m_upper[i]);
+
+        m_bounds[i] = Bound::Free;
+        if (m_lambda[i] == m_lower[i]) m_bounds[i] = Bound::Lower;
+        else if (m_lambda[i] == m_upper[i]) m_bounds[i] = Bound::Upper;
+    }
+
+    const double threshold = m_tolerance * std::max(rightNorm, 1.0);
+
+    int iterations = 0;
+    int released = -1;
+    double residual = 0.0;
+    bool converged = (n == 0);
+    while (!converged && iterations < m_maxIterationCount) {
+        factor();
+
+        for (int k = 0; k < n; ++k) {
+            const int i = m_order[k];
+            m_x[k] = (m_bounds[i] == Bound::Free)
+                ? m_right[i]
+                : ((m_bounds[i] == Bound::Lower) ? m_lower[i] : m_upper[i]);
+        }
+
+        // Rows fixed at a limit move their contribution over to the
+        // right-hand side of the free rows
+        for (int k = 0; k < n; ++k) {
+            const int i = m_order[k];
+            for (int p = m_factorStart[k]; p < m_factorStart[k + 1]; ++p) {
+                const int r = m_factorRows[p];
+                const int j = m_order[r];
+                const double a = m_matrix[n + p];
+
+                if (m_bounds[i] != Bound::Free && m_bounds[j] == Bound::Free) {
+                    m_x[r] -= a * ((m_bounds[i] == Bound::Lower) ? m_lower[i] : m_upper[i]);
+                }
+                else if (m_bounds[i] == Bound::Free && m_bounds[j] != Bound::Free) {
+                    m_x[k] -= a * ((m_bounds[j] == Bound::Lower) ? m_lower[j] : m_upper[j]);
+                }
+            }
+        }
+
+        solveFactored(m_x.data());
+        ++iterations;
+
+        // Step towards the solution for the current active set, stopping at
+        // the first limit in the way
+        double step = 1.0;
+        int blocking = -1;
+        Bound blockingBound = Bound::Free;
+        for (int k = 0; k < n; ++k) {
+            const int i = m_order[k];
+            if (m_bounds[i] != Bound::Free) continue;
+
+            const double delta = m_x[k] - m_lambda[i];
+            if (m_x[k] < m_lower[i] && delta < 0) {
+                const double s = (m_lower[i] - m_lambda[i]) / delta;
+                if (s < step) {
+                    step = s;
+                    blocking = i;
+                    blockingBound = Bound::Lower;
+                }
+            }
+            else if (m_x[k] > m_upper[i] && delta > 0) {
+                const double s = (m_upper[i] - m_lambda[i]) / delta;
+                if (s < step) {
+                    step = s;
+                    blocking = i;
+                    blockingBound = Bound::Upper;
+                }
+            }
+        }
+
+        for (int k = 0; k < n; ++k) {
+            const int i = m_order[k];
+            if (m_bounds[i] != Bound::Free) continue;
+
+            m_lambda[i] = (blocking == -1)
+                ? m_x[k]
+                : m_lambda[i] + step * (m_x[k] - m_lambda[i]);
+        }
+
+        if (blocking != -1) {
+            m_bounds[blocking] = blockingBound;
+            m_lambda[blocking] = (blockingBound == Bound::Lower)
+                ? m_lower[blocking]
+                : m_upper[blocking];
+
+            // A row that can't move away from the limit it was just released
+            // from is part of a singular set of rows; going on would cycle
+            if (blocking == released && step == 0.0) break;
+
+            continue;
+        }
+
+        // w = A * lambda - b tells whether the rows at a limit are still
+        // being pushed against it
+        for (int k = 0; k < n; ++k) {
+            const int i = m_order[k];
+            m_w[i] = m_matrix[k] * m_lambda[i] - m_right[i];
+        }
+
+        for (int k = 0; k < n; ++k) {
+            const int i = m_order[k];
+            for (int p = m_factorStart[k]; p < m_factorStart[k + 1]; ++p) {
+                const int j = m_order[m_factorRows[p]];
+                const double a = m_matrix[n + p];
+                m_w[i] += a * m_lambda[j];
+                m_w[j] += a * m_lambda[i];
+            }
+        }
+
+        residual = 0.0;
+        int release = -1;
+        double releaseResidual = threshold;
+        for (int i = 0; i < n; ++i) {
+            if (m_bounds[i] == Bound::Free) {
+                residual = std::max(residual, std::abs(m_w[i]));
+                continue;
+            }
+
+            const double w = (m_bounds[i] == Bound::Lower) ? -m_w[i] : m_w[i];
+            residual = std::max(residual, w);
+            if (w > releaseResidual) {
+                release = i;
+                releaseResidual = w;
+            }
+        }
+
+        if (release != -1) {
+            m_bounds[release] = Bound::Free;
+            released = release;
+        }
+        else {
+            converged = true;
+        }
+    }
+
+    result->resize(1, n);
+    for (int i = 0; i < n; ++i) {
+        m_lambda[i] = std::min(std::max(m_lambda[i], m_lower[i]), m_upper[i]);
+        result->set(0, i, m_lambda[i]);
+    }
+
+    recordSolve(iterations, residual, converged);
+
+    return converged;
+}
+
+bool DirectConstraintSolver::patternChanged(atg_scs::SparseMatrix<3> &J, int bodyCount) const {
+    const int n = J.getHeight();
+    if (n != m_rowCount || bodyCount != m_bodyCount) return true;
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            if (getBlock(J, i, j, bodyCount) != m_blocks[2 * i + j]) return true;
+        }
+    }
+
+    return false;
+}
+
+void DirectConstraintSolver::analyze(atg_scs::SparseMatrix<3> &J, int bodyCount) {
+    const int n = J.getHeight();
+    m_rowCount = n;
+    m_bodyCount = bodyCount;
+    ++m_analysisCount;
+
+    std::vector<std::vector<int>> bodyRows(bodyCount);
+    m_blocks.resize(2 * static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            const int body = getBlock(J, i, j, bodyCount);
+            m_blocks[2 * i + j] = body;
+
+            if (body != -1 && (j == 0 || body != m_blocks[2 * i])) {
+                bodyRows[body].push_back(i);
+            }
+        }
+    }
+
+    // Rows are coupled when they act on a common body
+    std::vector<std::set<int>> adjacent(n);
+    for (const std::vector<int> &rows : bodyRows) {
+        for (int a : rows) {
+            for (int b : rows) {
+                if (a != b) adjacent[a].insert(b);
+            }
+        }
+    }
+
+    // Minimum degree ordering. Eliminating a row couples all of its remaining
+    // neighbours, which is exactly the fill-in of its column of the factor.
+    std::vector<std::vector<int>> columns(n);
+    std::vector<bool> eliminated(n, false);
+    m_order.clear();
+    m_position.assign(n, -1);
+    for (int k = 0; k < n; ++k) {
+        int next = -1;
+        for (int i = 0; i < n; ++i) {
+            if (eliminated[i]) continue;
+            if (next == -1 || adjacent[i].size() < adjacent[next].size()) next = i;
+        }
+
+        eliminated[next] = true;
+        m_position[next] = k;
+        m_order.push_back(next);
+
+        columns[next].assign(adjacent[next].begin(), adjacent[next].end());
+        for (int u : adjacent[next]) {
+            adjacent[u].erase(next);
+            for (int v : adjacent[next]) {
+                if (u != v) adjacent[u].insert(v);
+            }
+        }
+
+        adjacent[next].clear();
+    }
+
+    m_factorStart.assign(n + 1, 0);
+    m_factorRows.clear();
+    for (int k = 0; k < n; ++k) {
+        const size_t start = m_factorRows.size();
+        for (int u : columns[m_order[k]]) {
+            m_factorRows.push_back(m_position[u]);
+        }
+
+        std::sort(m_factorRows.begin() + start, m_factorRows.end());
+        m_factorStart[k + 1] = static_cast<int>(m_factorRows.size());
+    }
+
+    // Every update made while eliminating a column, in the order the numeric
+    // factorization makes them
+    m_updates.clear();
+    for (int k = 0; k < n; ++k) {
+        for (int p = m_factorStart[k]; p < m_factorStart[k + 1]; ++p) {
+            for (int q = m_factorStart[k]; q <= p; ++q) {
+                const int row = m_factorRows[p];
+                const int column = m_factorRows[q];
+                m_updates.push_back((p == q)
+                    ? row
+                    : n + findEntry(column, row));
+            }
+        }
+    }
+
+    m_products.clear();
+    for (int body = 0; body < bodyCount; ++body) {
+        std::vector<std::pair<int, int>> slots;
+        for (int row : bodyRows[body]) {
+            for (int j = 0; j < 2; ++j) {
+                if (m_blocks[2 * row + j] == body) slots.push_back({ row, j });
+            }
+        }
+
+        for (const std::pair<int, int> &a : slots) {
+            for (const std::pair<int, int> &b : slots) {
+                if (a.first > b.first) continue;
+
+                Product product;
+                product.body = body;
+                product.row0 = a.first;
+                product.entry0 = a.second;
+                product.row1 = b.first;
+                product.entry1 = b.second;
+
+                const int k0 = m_position[a.first];
+                const int k1 = m_position[b.first];
+                product.target = (a.first == b.first)
+                    ? k0
+                    : n + findEntry(std::min(k0, k1), std::max(k0, k1));
+                m_products.push_back(product);
+            }
+        }
+    }
+
+    m_matrix.assign(n + m_factorRows.size(), 0.0);
+    m_factor.assign(n + m_factorRows.size(), 0.0);
+    m_inverseDiagonal.assign(n, 0.0);
+}
+
+int DirectConstraintSolver::findEntry(int column, int row) const {
+    const auto begin = m_factorRows.begin() + m_factorStart[column];
+    const auto end = m_factorRows.begin() + m_factorStart[column + 1];
+    const auto entry = std::lower_bound(begin, end, row);
+
+    return (entry != end && *entry == row)
+        ? static_cast<int>(entry - m_factorRows.begin())
+        : -1;
+}
+
+void DirectConstraintSolver::assemble(atg_scs::SparseMatrix<3> &J, atg_scs::Matrix &W) {
+    std::fill(m_matrix.begin(), m_matrix.end(), 0.0);
+
+    for (const Product &product : m_products) {
+        double v = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            v += J.get(product.row0, product.entry0, k)
+                * W.get(0, 3 * product.body + k)
+                * J.get(product.row1, product.entry1, k);
+        }
+
+        m_matrix[product.target] += v;
+    }
+}
+
+void DirectConstraintSolver::factor() {
+    const int n = m_rowCount;
+    m_factor = m_matrix;
+
+    // Rows fixed at a limit are replaced by lambda_i = limit
+    for (int k = 0; k < n; ++k) {
+        const bool fixed = m_bounds[m_order[k]] != Bound::Free;
+        if (fixed) m_factor[k] = 1.0;
+
+        for (int p = m_factorStart[k]; p < m_factorStart[k + 1]; ++p) {
+            if (fixed || m_bounds[m_order[m_factorRows[p]]] != Bound::Free) {
+                m_factor[n + p] = 0.0;
+            }
+        }
+    }
+
+    int u = 0;
+    for (int k = 0; k < n; ++k) {
+        const int start = m_factorStart[k];
+        const int end = m_factorStart[k + 1];
+        const double d = m_factor[k];
+        const double scale = (m_bounds[m_order[k]] == Bound::Free)
+            ? m_matrix[k]
+            : 1.0;
+
+        if (d <= PivotTolerance * scale || d <= 0.0) {
+            m_inverseDiagonal[k] = 0.0;
+            for (int p = start; p < end; ++p) {
+                m_factor[n + p] = 0.0;
+            }
+
+            u += (end - start) * (end - start + 1) / 2;
+            continue;
+        }
+
+        const double inv = 1 / d;
+        m_inverseDiagonal[k] = inv;
+        for (int p = start; p < end; ++p) {
+            m_factor[n + p] *= inv;
+        }
+
+        for (int p = start; p < end; ++p) {
+            const double l_d = m_factor[n + p] * d;
+            for (int q = start; q <= p; ++q) {
+                m_factor[m_updates[u++]] -= l_d * m_factor[n + q];
+            }
+        }
+    }
+}
+
+void DirectConstraintSolver::solveFactored(double *x) const {
+    const int n = m_rowCount;
+
+    for (int k = 0; k < n; ++k) {
+        const double x_k = x[k];
+        for (int p = m_factorStart[k]; p < m_factorStart[k + 1]; ++p) {
+            x[m_factorRows[p]] -= m_factor[n + p] * x_k;
+        }
+
+        x[k] = x_k * m_inverseDiagonal[k];
+    }
+
+    for (int k = n - 1; k >= 0; --k) {
+        double x_k = x[k];
+        for (int p = m_factorStart[k]; p < m_factorStart[k + 1]; ++p) {
+            x_k -= m_factor[n + p] * x[m_factorRows[p]];
+        }
+
+        x[k] = x_k;
+    }
+}
@@ -1,6 +1,7 @@
 #include "../include/direct_throttle_linkage.h"
 
 #include "../include/engine.h"
+#include "../include/simulation_snapshot.h"
 
 #include <cmath>
 
@@ -26,3 +27,15 @@ void DirectThrottleLinkage::update(double dt, Engine *engine) {
     Throttle::update(dt, engine);
     engine->setThrottle(m_throttlePosition);
 }
+
+void DirectThrottleLinkage::saveState(SimulationSnapshot *snapshot) const {
+    Throttle::saveState(snapshot);
+
+    snapshot->write(m_throttlePosition);
+}
+
+void DirectThrottleLinkage::loadState(SimulationSnapshot *snapshot) {
+    Throttle::loadState(snapshot);
+
+    snapshot->read(&m_throttlePosition);
+}
@@ -1,10 +1,11 @@
-#include "..\include\engine.h"
 #include "../include/engine.h"
 
 #include "../include/constants.h"
 #include "../include/units.h"
 #include "../include/fuel.h"
 #include "../include/piston_engine_simulator.h"
+#include "../include/valvetrain.h"
+#include "../include/simulation_snapshot.h"
 
 #include <cmath>
 #include <assert.h>
@@ -300,6 +301,76 @@ double Engine::getIntakeFlowRate() const {
 
 void Engine::update(double dt) {
     m_throttle->update(dt, this);
+
+    for (int i = 0; i < m_cylinderBankCount; ++i) {
+        m_heads[i].getValvetrain()->update(dt);
+    }
+}
+
+void Engine::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->writeCount(m_crankshaftCount);
+    for (int i = 0; i < m_crankshaftCount; ++i) {
+        snapshot->writeBody(m_crankshafts[i].m_body);
+    }
+
+    snapshot->writeCount(m_cylinderCount);
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        m_pistons[i].saveState(snapshot);
+        snapshot->writeBody(m_connectingRods[i].m_body);
+        m_combustionChambers[i].saveState(snapshot);
+    }
+
+    snapshot->writeCount(m_cylinderBankCount);
+    for (int i = 0; i < m_cylinderBankCount; ++i) {
+        m_heads[i].getValvetrain()->saveState(snapshot);
+    }
+
+    snapshot->writeCount(m_intakeCount);
+    for (int i = 0; i < m_intakeCount; ++i) {
+        m_intakes[i].saveState(snapshot);
+    }
+
+    snapshot->writeCount(m_exhaustSystemCount);
+    for (int i = 0; i < m_exhaustSystemCount; ++i) {
+        m_exhaustSystems[i].saveState(snapshot);
+    }
+
+    m_ignitionModule.saveState(snapshot);
+    m_throttle->saveState(snapshot);
+    snapshot->write(m_throttleValue);
+}
+
+void Engine::loadState(SimulationSnapshot *snapshot) {
+    snapshot->expectCount(m_crankshaftCount);
+    for (int i = 0; i < m_crankshaftCount; ++i) {
+        snapshot->readBody(&m_crankshafts[i].m_body);
+    }
+
+    snapshot->expectCount(m_cylinderCount);
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        m_pistons[i].loadState(snapshot);
+        snapshot->readBody(&m_connectingRods[i].m_body);
+        m_combustionChambers[i].loadState(snapshot);
+    }
+
+    snapshot->expectCount(m_cylinderBankCount);
+    for (int i = 0; i < m_cylinderBankCount; ++i) {
+        m_heads[i].getValvetrain()->loadState(snapshot);
+    }
+
+    snapshot->expectCount(m_intakeCount);
+    for (int i = 0; i < m_intakeCount; ++i) {
+        m_intakes[i].loadState(snapshot);
+    }
+
+    snapshot->expectCount(m_exhaustSystemCount);
+    for (int i = 0; i < m_exhaustSystemCount; ++i) {
+        m_exhaustSystems[i].loadState(snapshot);
+    }
+
+    m_ignitionModule.loadState(snapshot);
+    m_throttle->loadState(snapshot);
+    snapshot->read(&m_throttleValue);
 }
 
 double Engine::getManifoldPressure() const {
@@ -383,10 +454,16 @@ int Engine::getMaxDepth() const {
     return maxDepth;
 }
 
-Simulator *Engine::createSimulator(Vehicle *vehicle, Transmission *transmission) {
+Simulator *Engine::createSimulator(
+    Vehicle *vehicle,
+    Transmission *transmission,
+    bool reducedCoordinates)
+{
     PistonEngineSimulator *simulator = new PistonEngineSimulator;
     Simulator::Parameters simulatorParams;
-    simulatorParams.systemType = Simulator::SystemType::NsvOptimized;
+    simulatorParams.systemType = reducedCoordinates
+        ? Simulator::SystemType::ReducedCoordinate
+        : Simulator::SystemType::NsvOptimized;
     simulator->initialize(simulatorParams);
 
     simulator->loadSimulation(this, vehicle, transmission);
@@ -52,6 +52,7 @@ EngineSimApplication::EngineSimApplication() {
     m_green = ysColor::srgbiToLinear(0xBDD869);
 
     m_displayHeight = (float)units::distance(2.0, units::foot);
+    m_impulseResponses.setCacheDirectory("impulse_response_cache");
     m_outputAudioBuffer = nullptr;
     m_audioSource = nullptr;
 
@@ -490,20 +491,16 @@ void EngineSimApplication::loadEngine(
     for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
         ImpulseResponse *response = engine->getExhaustSystem(i)->getImpulseResponse();
 
-        ysWindowsAudioWaveFile waveFile;
-        waveFile.OpenFile(response->getFilename().c_str());
-        waveFile.InitializeInternalBuffer(waveFile.GetSampleCount());
-        waveFile.FillBuffer(0);
-        waveFile.CloseFile();
+        // Responses are kept by the store across engine reloads
+        const ConvolutionFilter::Kernel *kernel =
+            m_impulseResponses.load(response->getFilename());
+        if (kernel == nullptr) continue;
 
         m_simulator->synthesizer().initializeImpulseResponse(
-            reinterpret_cast<const int16_t *>(waveFile.GetBuffer()),
-            waveFile.GetSampleCount(),
-            response->getVolume(),
+            *kernel,
+            static_cast<float>(response->getVolume()),
             i
         );
-
-        waveFile.DestroyInternalBuffer();
     }
 
     m_simulator->startAudioRenderingThread();
@@ -623,6 +620,7 @@ void EngineSimApplication::loadScript() {
 #ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
     es_script::Compiler compiler;
     compiler.initialize();
+    compiler.setCachePath("engine_script.cache");
     const bool compiled = compiler.compile("../assets/main.mr");
     if (compiled) {
         const es_script::Compiler::Output output = compiler.execute();
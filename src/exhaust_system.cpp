@@ -1,6 +1,7 @@
 #include "../include/exhaust_system.h"
 
 #include "../include/units.h"
+#include "../include/simulation_snapshot.h"
 
 ExhaustSystem::ExhaustSystem() {
     m_primaryFlowRate = 0;
@@ -57,6 +58,22 @@ void ExhaustSystem::destroy() {
     /* void */
 }
 
+void ExhaustSystem::bindGasSystems(GasSystemStore *store) {
+    m_system.bind(store, store->allocate());
+}
+
+void ExhaustSystem::unbindGasSystems() {
+    m_system.unbind();
+}
+
+double ExhaustSystem::getFlowStiffness(double minPressureDifference) const {
+    return m_system.flowStiffness(
+        m_outletFlowRate,
+        units::pressure(1.0, units::atm),
+        units::celcius(25.0),
+        minPressureDifference);
+}
+
 void ExhaustSystem::process(double dt) {
     GasSystem::Mix airMix;
     airMix.p_fuel = 0;
@@ -79,3 +96,11 @@ void ExhaustSystem::process(double dt) {
     m_system.dissipateExcessVelocity();
     m_system.updateVelocity(dt, m_velocityDecay);
 }
+
+void ExhaustSystem::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_flow);
+}
+
+void ExhaustSystem::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_flow);
+}
@@ -0,0 +1,105 @@
+#include "../include/fft.h"
+
+#include "../include/constants.h"
+
+#include <assert.h>
+#include <cmath>
+
+Fft::Fft() {
+    m_bitReverse = nullptr;
+    m_cos = nullptr;
+    m_sin = nullptr;
+    m_size = 0;
+}
+
+Fft::~Fft() {
+    assert(m_bitReverse == nullptr);
+    assert(m_cos == nullptr);
+    assert(m_sin == nullptr);
+}
+
+void Fft::initialize(int size) {
+    assert(size > 0 && (size & (size - 1)) == 0);
+
+    destroy();
+
+    m_size = size;
+    m_bitReverse = new int[size];
+    m_cos = new float[size / 2];
+    m_sin = new float[size / 2];
+
+    int bits = 0;
+    while ((1 << bits) < size) ++bits;
+
+    for (int i = 0; i < size; ++i) {
+        int r = 0;
+        for (int j = 0; j < bits; ++j) {
+            r |= ((i >> j) & 1) << (bits - 1 - j);
+        }
+
+        m_bitReverse[i] = r;
+    }
+
+    for (int i = 0; i < size / 2; ++i) {
+        const double theta = -2 * constants::pi * i / size;
+        m_cos[i] = static_cast<float>(std::cos(theta));
+        m_sin[i] = static_cast<float>(std::sin(theta));
+    }
+}
+
+void Fft::destroy() {
+    delete[] m_bitReverse;
+    delete[] m_cos;
+    delete[] m_sin;
+
+    m_bitReverse = nullptr;
+    m_cos = nullptr;
+    m_sin = nullptr;
+    m_size = 0;
+}
+
+void Fft::forward(float *re, float *im) const {
+    transform(re, im, 1.0f);
+}
+
+void Fft::inverse(float *re, float *im) const {
+    transform(re, im, -1.0f);
+
+    const float scale = 1.0f / m_size;
+    for (int i = 0; i < m_size; ++i) {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+}
+
+void Fft::transform(float *re, float *im, float sign) const {
+    for (int i = 0; i < m_size; ++i) {
+        const int j = m_bitReverse[i];
+        if (j > i) {
+            const float t_re = re[i], t_im = im[i];
+            re[i] = re[j]; im[i] = im[j];
+            re[j] = t_re; im[j] = t_im;
+        }
+    }
+
+    for (int length = 2; length <= m_size; length <<= 1) {
+        const int half = length / 2;
+        const int stride = m_size / length;
+
+        for (int i = 0; i < m_size; i += length) {
+            for (int j = 0; j < half; ++j) {
+                const float w_re = m_cos[j * stride];
+                const float w_im = sign * m_sin[j * stride];
+
+                const int a = i + j, b = i + j + half;
+                const float v_re = re[b] * w_re - im[b] * w_im;
+                const float v_im = re[b] * w_im + im[b] * w_re;
+
+                re[b] = re[a] - v_re;
+                im[b] = im[a] - v_im;
+                re[a] += v_re;
+                im[a] += v_im;
+            }
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#include "../include/flow_schedule.h"
+
+#include "../include/gas_system.h"
+
+#include <algorithm>
+#include <cassert>
+
+FlowSchedule::FlowSchedule() {
+    m_store = nullptr;
+    m_waveCount = 0;
+}
+
+FlowSchedule::~FlowSchedule() {
+    /* void */
+}
+
+void FlowSchedule::initialize(GasSystemStore *store) {
+    m_store = store;
+    m_systemWave.assign(store->getCapacity(), -1);
+
+    clear();
+}
+
+void FlowSchedule::destroy() {
+    m_store = nullptr;
+    m_operations.clear();
+    m_scheduledOperations.clear();
+    m_systemWave.clear();
+    m_operationWave.clear();
+    m_waveStart.clear();
+    m_order.clear();
+    m_waveEdgeStart.clear();
+    m_edges.clear();
+    m_results.clear();
+    m_flows.clear();
+    m_waveCount = 0;
+}
+
+void FlowSchedule::clear() {
+    m_operations.clear();
+}
+
+void FlowSchedule::addFlow(int edge, double *result) {
+    m_operations.push_back({ edge, -1, result });
+}
+
+void FlowSchedule::addDissipateExcessVelocity(int system) {
+    m_operations.push_back({ -1, system, nullptr });
+}
+
+bool FlowSchedule::isScheduled() const {
+    if (m_operations.size() != m_scheduledOperations.size()) return false;
+
+    for (size_t i = 0; i < m_operations.size(); ++i) {
+        const Operation &a = m_operations[i];
+        const Operation &b = m_scheduledOperations[i];
+        if (a.edge != b.edge || a.system != b.system || a.result != b.result) return false;
+    }
+
+    return true;
+}
+
+void FlowSchedule::assignWaves() {
+    const int operationCount = static_cast<int>(m_operations.size());
+    m_operationWave.resize(operationCount);
+
+    m_waveCount = 0;
+    for (int i = 0; i < operationCount; ++i) {
+        const Operation &operation = m_operations[i];
+
+        int wave;
+        if (operation.edge != -1) {
+            const GasSystemStore::FlowEdge &edge = m_store->getEdge(operation.edge);
+            wave = std::max(m_systemWave[edge.system_0], m_systemWave[edge.system_1]) + 1;
+            m_systemWave[edge.system_0] = m_systemWave[edge.system_1] = wave;
+        }
+        else {
+            wave = m_systemWave[operation.system] + 1;
+            m_systemWave[operation.system] = wave;
+        }
+
+        m_operationWave[i] = wave;
+        m_waveCount = std::max(m_waveCount, wave + 1);
+    }
+
+    // Only the volumes that were touched need to be reset for the next run
+    for (const Operation &operation : m_operations) {
+        if (operation.edge != -1) {
+            const GasSystemStore::FlowEdge &edge = m_store->getEdge(operation.edge);
+            m_systemWave[edge.system_0] = m_systemWave[edge.system_1] = -1;
+        }
+        else {
+            m_systemWave[operation.system] = -1;
+        }
+    }
+
+    // Counting sort by wave; operations keep their relative order within a
+    // wave, so the layout of every batch is deterministic
+    m_waveStart.assign(m_waveCount + 1, 0);
+    for (int i = 0; i < operationCount; ++i) {
+        ++m_waveStart[m_operationWave[i] + 1];
+    }
+
+    for (int i = 0; i < m_waveCount; ++i) {
+        m_waveStart[i + 1] += m_waveStart[i];
+    }
+
+    m_order.resize(operationCount);
+    for (int i = 0; i < operationCount; ++i) {
+        m_order[m_waveStart[m_operationWave[i]]++] = i;
+    }
+
+    for (int i = m_waveCount; i > 0; --i) {
+        m_waveStart[i] = m_waveStart[i - 1];
+    }
+
+    m_waveStart[0] = 0;
+
+    // The edges of each wave are laid out contiguously for flowBatch()
+    m_edges.clear();
+    m_results.clear();
+    m_waveEdgeStart.resize(m_waveCount + 1);
+    for (int wave = 0; wave < m_waveCount; ++wave) {
+        m_waveEdgeStart[wave] = static_cast<int>(m_edges.size());
+        for (int i = m_waveStart[wave]; i < m_waveStart[wave + 1]; ++i) {
+            const Operation &operation = m_operations[m_order[i]];
+            if (operation.edge == -1) continue;
+
+            m_edges.push_back(operation.edge);
+            m_results.push_back(operation.result);
+        }
+    }
+
+    m_waveEdgeStart[m_waveCount] = static_cast<int>(m_edges.size());
+    m_flows.resize(m_edges.size());
+}
+
+void FlowSchedule::run(double dt) {
+    assert(m_store != nullptr);
+
+    // Engines schedule the same operations step after step, so the waves
+    // are only assigned again when the operations change
+    if (!isScheduled()) {
+        assignWaves();
+        m_scheduledOperations = m_operations;
+    }
+
+    for (int wave = 0; wave < m_waveCount; ++wave) {
+        for (int i = m_waveStart[wave]; i < m_waveStart[wave + 1]; ++i) {
+            const Operation &operation = m_operations[m_order[i]];
+            if (operation.edge == -1) {
+                GasSystem system(m_store, operation.system);
+                system.dissipateExcessVelocity();
+            }
+        }
+
+        const int begin = m_waveEdgeStart[wave];
+        const int end = m_waveEdgeStart[wave + 1];
+        if (begin == end) continue;
+
+        GasSystem::flowBatch(m_store, m_edges.data() + begin, end - begin, dt, m_flows.data() + begin);
+
+        for (int i = begin; i < end; ++i) {
+            if (m_results[i] != nullptr) {
+                *m_results[i] = m_flows[i];
+            }
+        }
+    }
+}
@@ -5,7 +5,19 @@
 #include <assert.h>
 #include <cmath>
 
-GaussianFilter *Function::DefaultGaussianFilter = nullptr;
+namespace {
+    // Never modified after construction, so a single instance can be shared
+    // by every function in every simulation
+    const GaussianFilter *defaultGaussianFilter() {
+        static const GaussianFilter *filter = [] {
+            GaussianFilter *f = new GaussianFilter;
+            f->initialize(1.0, 3.0, 1024);
+            return f;
+        }();
+
+        return filter;
+    }
+}
 
 Function::Function() {
     m_x = m_y = nullptr;
@@ -16,27 +28,31 @@ Function::Function() {
     m_inputScale = 1.0;
     m_outputScale = 1.0;
 
-    if (DefaultGaussianFilter == nullptr) {
-        DefaultGaussianFilter = new GaussianFilter;
-        DefaultGaussianFilter->initialize(1.0, 3.0, 1024);
-    }
-
     m_gaussianFilter = nullptr;
+
+    m_baked = nullptr;
+    m_bakedX0 = 0;
+    m_bakedX1 = 0;
+    m_bakedInvSpacing = 0;
+    m_bakedLast = 0;
+    m_bakedResolution = 0;
 }
 
 Function::~Function() {
     assert(m_x == nullptr);
     assert(m_y == nullptr);
+    assert(m_baked == nullptr);
 }
 
 void Function::initialize(int size, double filterRadius, GaussianFilter *filter) {
+    clearBake();
     resize(size);
     m_size = 0;
     m_filterRadius = filterRadius;
 
     m_gaussianFilter = (filter != nullptr)
         ? filter
-        : DefaultGaussianFilter;
+        : defaultGaussianFilter();
 }
 
 void Function::resize(int newCapacity) {
@@ -58,6 +74,8 @@ void Function::resize(int newCapacity) {
 }
 
 void Function::destroy() {
+    clearBake();
+
     delete[] m_x;
     delete[] m_y;
 
@@ -73,9 +91,20 @@ void Function::addSample(double x, double y) {
         resize(m_capacity * 2 + 1);
     }
 
+    clearBake();
+
     m_yMin = std::fmin(m_yMin, y);
     m_yMax = std::fmax(m_yMax, y);
 
+    // Samples are almost always added in order, in which case there is no
+    // need to search or shift anything
+    if (m_size == 0 || x >= m_x[m_size - 1]) {
+        m_x[m_size] = x;
+        m_y[m_size] = y;
+        ++m_size;
+        return;
+    }
+
     const int closest = closestSample(x);
     if (closest == -1) {
         m_size = 1;
@@ -101,13 +130,134 @@ void Function::addSample(double x, double y) {
     m_y[index] = y;
 }
 
-double Function::sampleTriangle(double x) const {
-    x *= m_inputScale;
-    const int closest = closestSample(x);
+bool Function::bake(double maxError, int maxResolution) {
+    clearBake();
+
+    if (m_size == 0) return false;
+
+    const double x0 = m_x[0];
+    const double x1 = m_x[m_size - 1];
+    if (x1 <= x0) {
+        // With every sample at one point there is nothing between the end
+        // samples, which sampleBaked() returns without reading the table
+        m_baked = new double[2];
+        m_baked[0] = m_baked[1] = m_y[0];
+
+        m_bakedX0 = x0;
+        m_bakedX1 = x1;
+        m_bakedInvSpacing = 0;
+        m_bakedLast = 0;
+        m_bakedResolution = 1;
+
+        return true;
+    }
+
+    if (maxResolution < 2) return false;
+
+    const double tolerance = maxError * (m_yMax - m_yMin);
+
+    // Start at a few points per filter radius and refine by halving the
+    // spacing, which keeps every previous grid point
+    const double initialResolution = (m_filterRadius > 0)
+        ? std::ceil(4 * (x1 - x0) / m_filterRadius) + 1
+        : maxResolution;
+    int resolution =
+        static_cast<int>(std::fmax(std::fmin(initialResolution, maxResolution), 2.0));
+
+    while (true) {
+        const double spacing = (x1 - x0) / (resolution - 1);
+
+        // The filter jumps to the end samples at the edges of the domain
+        // whenever it is wider than the sample spacing, so the outer grid
+        // points hold the limits from inside and the clamping is left to
+        // sampleBaked()
+        m_baked = new double[(size_t)resolution + 1];
+        for (int i = 0; i < resolution - 1; ++i) {
+            m_baked[i] = triangleAverage(x0 + i * spacing);
+        }
+
+        m_baked[resolution - 1] = m_baked[resolution] = triangleAverage(x1);
+
+        m_bakedX0 = x0;
+        m_bakedX1 = x1;
+        m_bakedInvSpacing = 1 / spacing;
+        m_bakedLast = resolution - 1.0;
+        m_bakedResolution = resolution;
+
+        // The largest errors are either mid-way between grid points or at
+        // the kinks the triangle filter has at every sample
+        double error = 0;
+        for (int i = 0; i < resolution - 1; ++i) {
+            const double x = x0 + (i + 0.5) * spacing;
+            error = std::fmax(error, std::abs(sampleBaked(x) - triangleFilter(x)));
+        }
+
+        for (int i = 0; i < m_size; ++i) {
+            error = std::fmax(error, std::abs(sampleBaked(m_x[i]) - triangleFilter(m_x[i])));
+        }
+
+        if (error <= tolerance) return true;
+
+        clearBake();
+        if (resolution >= maxResolution) return false;
+
+        resolution = std::min(2 * resolution - 1, maxResolution);
+    }
+}
+
+void Function::clearBake() {
+    delete[] m_baked;
+
+    m_baked = nullptr;
+    m_bakedResolution = 0;
+}
+
+void Function::sampleTriangle(const double *x, double *y, int n) const {
+    if (m_baked == nullptr) {
+        for (int i = 0; i < n; ++i) {
+            y[i] = sampleTriangleExact(x[i]);
+        }
 
+        return;
+    }
+
+    const double inputScale = m_inputScale;
+    const double outputScale = m_outputScale;
+    const double x0 = m_bakedX0;
+    const double x1 = m_bakedX1;
+    const double y0 = m_y[0];
+    const double y1 = m_y[m_size - 1];
+    const double invSpacing = m_bakedInvSpacing;
+    const double last = m_bakedLast;
+    const double *table = m_baked;
+
+    // Kept branch-free so that the compiler can vectorize it
+    for (int i = 0; i < n; ++i) {
+        const double x_i = x[i] * inputScale;
+        const double s =
+            std::fmin(std::fmax((x_i - x0) * invSpacing, 0.0), last);
+        const int j = static_cast<int>(s);
+        const double f = s - j;
+        const double v = table[j] + f * (table[j + 1] - table[j]);
+
+        y[i] = ((x_i >= x1) ? y1 : ((x_i <= x0) ? y0 : v)) * outputScale;
+    }
+}
+
+double Function::sampleTriangleExact(double x) const {
+    return triangleFilter(x * m_inputScale) * m_outputScale;
+}
+
+double Function::triangleFilter(double x) const {
     if (m_size == 0) return 0;
-    else if (x >= m_x[m_size - 1]) return m_y[m_size - 1] * m_outputScale;
-    else if (x <= m_x[0]) return m_y[0] * m_outputScale;
+    else if (x >= m_x[m_size - 1]) return m_y[m_size - 1];
+    else if (x <= m_x[0]) return m_y[0];
+
+    return triangleAverage(x);
+}
+
+double Function::triangleAverage(double x) const {
+    const int closest = closestSample(x);
 
     double sum = 0;
     double totalWeight = 0;
@@ -130,7 +280,7 @@ double Function::sampleTriangle(double x) const {
     }
 
     return (totalWeight != 0)
-        ? sum * m_outputScale / totalWeight
+        ? sum / totalWeight
         : 0;
 }
 
@@ -5,41 +5,87 @@
 
 #include <cmath>
 #include <cassert>
+#include <algorithm>
+
+GasSystem::GasSystem() : m_state(m_local, 1) {
+    for (int i = 0; i < GasSystemStore::FieldCount; ++i) {
+        m_local[i] = 0.0;
+    }
+
+    m_state.p_inert() = 1.0;
+    m_state.degreesOfFreedom() = 5;
+}
+
+GasSystem::GasSystem(GasSystemStore *store, int index) : m_state(store->getSlot(index)) {
+    /* void */
+}
+
+GasSystem::GasSystem(const GasSystem &system) : m_state(m_local, 1) {
+    system.copyState(m_state);
+}
+
+GasSystem &GasSystem::operator=(const GasSystem &system) {
+    if (this != &system) {
+        system.copyState(m_state);
+    }
+
+    return *this;
+}
+
+void GasSystem::bind(GasSystemStore *store, int index) {
+    const GasSystemStore::Slot slot = store->getSlot(index);
+    copyState(slot);
+    m_state = slot;
+}
+
+void GasSystem::unbind() {
+    if (!isBound()) return;
+
+    const GasSystemStore::Slot local(m_local, 1);
+    copyState(local);
+    m_state = local;
+}
+
+void GasSystem::copyState(const GasSystemStore::Slot &target) const {
+    for (int i = 0; i < GasSystemStore::FieldCount; ++i) {
+        target[i] = m_state[i];
+    }
+}
 
 void GasSystem::setGeometry(double width, double height, double dx, double dy) {
-    m_width = width;
-    m_height = height;
-    m_dx = dx;
-    m_dy = dy;
+    m_state.width() = width;
+    m_state.height() = height;
+    m_state.dx() = dx;
+    m_state.dy() = dy;
 }
 
 void GasSystem::initialize(double P, double V, double T, const Mix &mix, int degreesOfFreedom) {
-    m_degreesOfFreedom = degreesOfFreedom;
-    m_state.n_mol = P * V / (constants::R * T);
-    m_state.V = V;
-    m_state.E_k = T * (0.5 * degreesOfFreedom * m_state.n_mol * constants::R);
-    m_state.mix = mix;
-    m_state.momentum[0] = m_state.momentum[1] = 0;
+    m_state.degreesOfFreedom() = degreesOfFreedom;
+    m_state.n_mol() = P * V / (constants::R * T);
+    m_state.V() = V;
+    m_state.E_k() = T * (0.5 * degreesOfFreedom * m_state.n_mol() * constants::R);
+    changeMix(mix);
+    m_state.momentum_x() = m_state.momentum_y() = 0;
 
     const double hcr = heatCapacityRatio();
-    m_chokedFlowLimit = chokedFlowLimit(degreesOfFreedom);
-    m_chokedFlowFactorCached = chokedFlowRate(degreesOfFreedom);
+    m_state.chokedFlowLimit() = chokedFlowLimit(degreesOfFreedom);
+    m_state.chokedFlowFactor() = chokedFlowRate(degreesOfFreedom);
 }
 
 void GasSystem::reset(double P, double T, const Mix &mix) {
-    m_state.n_mol = P * volume() / (constants::R * T);
-    m_state.E_k = T * (0.5 * m_degreesOfFreedom * m_state.n_mol * constants::R);
-    m_state.mix = mix;
-    m_state.momentum[0] = m_state.momentum[1] = 0;
+    m_state.n_mol() = P * volume() / (constants::R * T);
+    m_state.E_k() = T * (0.5 * degreesOfFreedom() * m_state.n_mol() * constants::R);
+    changeMix(mix);
+    m_state.momentum_x() = m_state.momentum_y() = 0;
 }
 
 void GasSystem::setVolume(double V) {
-    return changeVolume(V - m_state.V);
+    return changeVolume(V - m_state.V());
 }
 
 void GasSystem::setN(double n) {
-    m_state.E_k = kineticEnergy(n);
-    m_state.n_mol = n;
+    m_state.E_k() = kineticEnergy(n);
+    m_state.n_mol() = n;
 }
 
 void GasSystem::changeVolume(double dV) {
@@ -49,34 +95,36 @@ void GasSystem::changeVolume(double dV) {
     const double dL = -dV / surfaceArea;
     const double W = dL * pressure() * surfaceArea;
 
-    m_state.V += dV;
-    m_state.E_k += W;
+    m_state.V() += dV;
+    m_state.E_k() += W;
 }
 
 void GasSystem::changePressure(double dP) {
-    m_state.E_k += dP * volume() * m_degreesOfFreedom * 0.5;
+    m_state.E_k() += dP * volume() * degreesOfFreedom() * 0.5;
 }
 
 void GasSystem::changeTemperature(double dT) {
-    m_state.E_k += dT * 0.5 * m_degreesOfFreedom * n() * constants::R;
+    m_state.E_k() += dT * 0.5 * degreesOfFreedom() * n() * constants::R;
 }
 
 void GasSystem::changeEnergy(double dE) {
-    m_state.E_k += dE;
+    m_state.E_k() += dE;
 }
 
 void GasSystem::changeMix(const Mix &mix) {
-    m_state.mix = mix;
+    m_state.p_fuel() = mix.p_fuel;
+    m_state.p_inert() = mix.p_inert;
+    m_state.p_o2() = mix.p_o2;
 }
 
 void GasSystem::injectFuel(double n) {
     const double n_fuel = this->n_fuel() + n;
     const double p_fuel = n_fuel / this->n();
-    m_state.mix.p_fuel = p_fuel;
+    m_state.p_fuel() = p_fuel;
 }
 
 void GasSystem::changeTemperature(double dT, double n) {
-    m_state.E_k += dT * 0.5 * m_degreesOfFreedom * n * constants::R;
+    m_state.E_k() += dT * 0.5 * degreesOfFreedom() * n * constants::R;
 }
 
 double GasSystem::react(double n, const Mix &mix) {
@@ -108,7 +156,7 @@ double GasSystem::react(double n, const Mix &mix) {
     const double products_n = output_input_ratio * reactants_n;
     const double dn = products_n - reactants_n;
 
-    m_state.n_mol += dn;
+    m_state.n_mol() += dn;
 
     // Adjust mix
     const double new_system_n_fuel = system_n_fuel - a_n_fuel;
@@ -117,12 +165,12 @@ double GasSystem::react(double n, const Mix &mix) {
     const double new_system_n = system_n + dn;
 
     if (new_system_n != 0) {
-        m_state.mix.p_fuel = new_system_n_fuel / new_system_n;
-        m_state.mix.p_inert = new_system_n_inert / new_system_n;
-        m_state.mix.p_o2 = new_system_n_o2 / new_system_n;
+        m_state.p_fuel() = new_system_n_fuel / new_system_n;
+        m_state.p_inert() = new_system_n_inert / new_system_n;
+        m_state.p_o2() = new_system_n_o2 / new_system_n;
     }
     else {
-        m_state.mix.p_fuel = m_state.mix.p_inert = m_state.mix.p_o2 = 0;
+        m_state.p_fuel() = m_state.p_inert() = m_state.p_o2() = 0;
     }
 
     return a_n_fuel;
@@ -229,30 +277,30 @@ double GasSystem::flowRate(
 }
 
 double GasSystem::loseN(double dn, double E_k_per_mol) {
-    m_state.E_k -= E_k_per_mol * dn;
-    m_state.n_mol -= dn;
+    m_state.E_k() -= E_k_per_mol * dn;
+    m_state.n_mol() -= dn;
 
-    if (m_state.n_mol < 0) {
-        m_state.n_mol = 0;
+    if (m_state.n_mol() < 0) {
+        m_state.n_mol() = 0;
     }
 
     return dn;
 }
 
 double GasSystem::gainN(double dn, double E_k_per_mol, const Mix &mix) {
-    const double next_n = m_state.n_mol + dn;
-    const double current_n = m_state.n_mol;
+    const double next_n = m_state.n_mol() + dn;
+    const double current_n = m_state.n_mol();
 
-    m_state.E_k += dn * E_k_per_mol;
-    m_state.n_mol = next_n;
+    m_state.E_k() += dn * E_k_per_mol;
+    m_state.n_mol() = next_n;
 
     if (next_n != 0) {
-        m_state.mix.p_fuel = (m_state.mix.p_fuel * current_n + dn * mix.p_fuel) / next_n;
-        m_state.mix.p_inert = (m_state.mix.p_inert * current_n + dn * mix.p_inert) / next_n;
-        m_state.mix.p_o2 = (m_state.mix.p_o2 * current_n + dn * mix.p_o2) / next_n;
+        m_state.p_fuel() = (m_state.p_fuel() * current_n + dn * mix.p_fuel) / next_n;
+        m_state.p_inert() = (m_state.p_inert() * current_n + dn * mix.p_inert) / next_n;
+        m_state.p_o2() = (m_state.p_o2() * current_n + dn * mix.p_o2) / next_n;
     }
     else {
-        m_state.mix.p_fuel = m_state.mix.p_inert = m_state.mix.p_o2 = 0;
+        m_state.p_fuel() = m_state.p_inert() = m_state.p_o2() = 0;
     }
 
     return -dn;
@@ -272,81 +320,81 @@ void GasSystem::dissipateExcessVelocity() {
     const double k_squared = c_squared / v_squared;
     const double k = std::sqrt(k_squared);
 
-    m_state.momentum[0] *= k;
-    m_state.momentum[1] *= k;
+    m_state.momentum_x() *= k;
+    m_state.momentum_y() *= k;
 
-    m_state.E_k += 0.5 * mass() * (v_squared - c_squared);
+    m_state.E_k() += 0.5 * mass() * (v_squared - c_squared);
 
-    if (m_state.E_k < 0) m_state.E_k = 0;
+    if (m_state.E_k() < 0) m_state.E_k() = 0;
 }
 
 void GasSystem::updateVelocity(double dt, double beta) {
     if (n() == 0) return;
 
-    const double depth = volume() / (m_width * m_height);
+    const double depth = volume() / (m_state.width() * m_state.height());
     
     double d_momentum_x = 0;
     double d_momentum_y = 0;
 
-    const double p0 = dynamicPressure(m_dx, m_dy);
-    const double p1 = dynamicPressure(-m_dx, -m_dy);
-    const double p2 = dynamicPressure(m_dy, m_dx);
-    const double p3 = dynamicPressure(-m_dy, -m_dx);
+    const double p0 = dynamicPressure(m_state.dx(), m_state.dy());
+    const double p1 = dynamicPressure(-m_state.dx(), -m_state.dy());
+    const double p2 = dynamicPressure(m_state.dy(), m_state.dx());
+    const double p3 = dynamicPressure(-m_state.dy(), -m_state.dx());
 
-    const double p_sa_0 = p0 * (m_height * depth);
-    const double p_sa_1 = p1 * (m_height * depth);
-    const double p_sa_2 = p2 * (m_width * depth);
-    const double p_sa_3 = p3 * (m_width * depth);
+    const double p_sa_0 = p0 * (m_state.height() * depth);
+    const double p_sa_1 = p1 * (m_state.height() * depth);
+    const double p_sa_2 = p2 * (m_state.width() * depth);
+    const double p_sa_3 = p3 * (m_state.width() * depth);
 
-    d_momentum_x += p_sa_0 * m_dx;
-    d_momentum_y += p_sa_0 * m_dy;
+    d_momentum_x += p_sa_0 * m_state.dx();
+    d_momentum_y += p_sa_0 * m_state.dy();
 
-    d_momentum_x -= p_sa_1 * m_dx;
-    d_momentum_y -= p_sa_1 * m_dy;
+    d_momentum_x -= p_sa_1 * m_state.dx();
+    d_momentum_y -= p_sa_1 * m_state.dy();
 
-    d_momentum_x += p_sa_2 * m_dy;
-    d_momentum_y += p_sa_2 * m_dx;
+    d_momentum_x += p_sa_2 * m_state.dy();
+    d_momentum_y += p_sa_2 * m_state.dx();
 
-    d_momentum_x -= p_sa_3 * m_dy;
-    d_momentum_y -= p_sa_3 * m_dx;
+    d_momentum_x -= p_sa_3 * m_state.dy();
+    d_momentum_y -= p_sa_3 * m_state.dx();
 
     const double m = mass();
     const double inv_m = 1 / m;
-    const double v0_x = m_state.momentum[0] * inv_m;
-    const double v0_y = m_state.momentum[1] * inv_m;
+    const double v0_x = m_state.momentum_x() * inv_m;
+    const double v0_y = m_state.momentum_y() * inv_m;
 
-    m_state.momentum[0] -= d_momentum_x * dt * beta;
-    m_state.momentum[1] -= d_momentum_y * dt * beta;
+    m_state.momentum_x() -= d_momentum_x * dt * beta;
+    m_state.momentum_y() -= d_momentum_y * dt * beta;
 
-    const double v1_x = m_state.momentum[0] * inv_m;
-    const double v1_y = m_state.momentum[1] * inv_m;
+    const double v1_x = m_state.momentum_x() * inv_m;
+    const double v1_y = m_state.momentum_y() * inv_m;
 
-    m_state.E_k -= 0.5 * m * (v1_x * v1_x - v0_x * v0_x);
-    m_state.E_k -= 0.5 * m * (v1_y * v1_y - v0_y * v0_y);
+    m_state.E_k() -= 0.5 * m * (v1_x * v1_x - v0_x * v0_x);
+    m_state.E_k() -= 0.5 * m * (v1_y * v1_y - v0_y * v0_y);
 
-    if (m_state.E_k < 0) m_state.E_k = 0;
+    if (m_state.E_k() < 0) m_state.E_k() = 0;
 }
 
 void GasSystem::dissipateVelocity(double dt, double timeConstant) {
     if (n() == 0) return;
 
     const double invMass = 1.0 / mass();
-    const double velocity_x = m_state.momentum[0] * invMass;
-    const double velocity_y = m_state.momentum[1] * invMass;
+    const double velocity_x = m_state.momentum_x() * invMass;
+    const double velocity_y = m_state.momentum_y() * invMass;
     const double velocity_squared =
         velocity_x * velocity_x + velocity_y * velocity_y;
 
     const double s = dt / (dt + timeConstant);
-    m_state.momentum[0] = m_state.momentum[0] * (1 - s);
-    m_state.momentum[1] = m_state.momentum[1] * (1 - s);
+    m_state.momentum_x() = m_state.momentum_x() * (1 - s);
+    m_state.momentum_y() = m_state.momentum_y() * (1 - s);
 
-    const double newVelocity_x = m_state.momentum[0] * invMass;
-    const double newVelocity_y = m_state.momentum[1] * invMass;
+    const double newVelocity_x = m_state.momentum_x() * invMass;
+    const double newVelocity_y = m_state.momentum_y() * invMass;
     const double newVelocity_squared =
         newVelocity_x * newVelocity_x + newVelocity_y * newVelocity_y;
 
     const double dE_k = 0.5 * mass() * (velocity_squared - newVelocity_squared);
-    m_state.E_k += dE_k;
+    m_state.E_k() += dE_k;
 }
 
 double GasSystem::flow(const FlowParameters &params) {
@@ -393,8 +441,8 @@ double GasSystem::flow(const FlowParameters &params) {
         source->temperature(),
         sink->temperature(),
         source->heatCapacityRatio(),
-        source->m_chokedFlowLimit,
-        source->m_chokedFlowFactorCached);
+        source->m_state.chokedFlowLimit(),
+        source->m_state.chokedFlowFactor());
 
     const double maxFlow = source->pressureEquilibriumMaxFlow(sink);
     flow = clamp(flow, 0.0, 0.9 * source->n());
@@ -419,18 +467,18 @@ double GasSystem::flow(const FlowParameters &params) {
 
         const double s1 = source->totalEnergy() + sink->totalEnergy();
 
-        const double dp_x = source->m_state.momentum[0] * fraction;
-        const double dp_y = source->m_state.momentum[1] * fraction;
-        source->m_state.momentum[0] -= dp_x;
-        source->m_state.momentum[1] -= dp_y;
+        const double dp_x = source->m_state.momentum_x() * fraction;
+        const double dp_y = source->m_state.momentum_y() * fraction;
+        source->m_state.momentum_x() -= dp_x;
+        source->m_state.momentum_y() -= dp_y;
 
-        sink->m_state.momentum[0] += dp_x;
-        sink->m_state.momentum[1] += dp_y;
+        sink->m_state.momentum_x() += dp_x;
+        sink->m_state.momentum_y() += dp_y;
 
         const double E_k_bulk_src1 = source->bulkKineticEnergy();
         const double E_k_bulk_sink1 = sink->bulkKineticEnergy();
 
-        sink->m_state.E_k -= ((E_k_bulk_src1 + E_k_bulk_sink1) - (E_k_bulk_src0 + E_k_bulk_sink0));
+        sink->m_state.E_k() -= ((E_k_bulk_src1 + E_k_bulk_sink1) - (E_k_bulk_src0 + E_k_bulk_sink0));
     }
     
     const double sourceMass = source->mass();
@@ -441,11 +489,11 @@ double GasSystem::flow(const FlowParameters &params) {
     const double c_source = source->c();
     const double c_sink = sink->c();
 
-    const double sourceInitialMomentum_x = source->m_state.momentum[0];
-    const double sourceInitialMomentum_y = source->m_state.momentum[1];
+    const double sourceInitialMomentum_x = source->m_state.momentum_x();
+    const double sourceInitialMomentum_y = source->m_state.momentum_y();
 
-    const double sinkInitialMomentum_x = sink->m_state.momentum[0];
-    const double sinkInitialMomentum_y = sink->m_state.momentum[1];
+    const double sinkInitialMomentum_x = sink->m_state.momentum_x();
+    const double sinkInitialMomentum_y = sink->m_state.momentum_y();
 
     // Momentum in fraction
 
@@ -458,8 +506,8 @@ double GasSystem::flow(const FlowParameters &params) {
         const double sinkFractionMomentum_x = sinkFractionVelocity_x * fractionMass;
         const double sinkFractionMomentum_y = sinkFractionVelocity_y * fractionMass;
 
-        sink->m_state.momentum[0] += sinkFractionMomentum_x;
-        sink->m_state.momentum[1] += sinkFractionMomentum_y;
+        sink->m_state.momentum_x() += sinkFractionMomentum_x;
+        sink->m_state.momentum_y() += sinkFractionMomentum_y;
     }
 
     if (sourceCrossSection != 0 && sourceMass != 0) {
@@ -471,8 +519,8 @@ double GasSystem::flow(const FlowParameters &params) {
         const double sourceFractionMomentum_x = sourceFractionVelocity_x * fractionMass;
         const double sourceFractionMomentum_y = sourceFractionVelocity_y * fractionMass;
 
-        source->m_state.momentum[0] += sourceFractionMomentum_x;
-        source->m_state.momentum[1] += sourceFractionMomentum_y;
+        source->m_state.momentum_x() += sourceFractionMomentum_x;
+        source->m_state.momentum_y() += sourceFractionMomentum_y;
     }
 
     if (sourceMass != 0) {
@@ -480,14 +528,14 @@ double GasSystem::flow(const FlowParameters &params) {
         const double sourceVelocity0_x = sourceInitialMomentum_x * invSourceMass;
         const double sourceVelocity0_y = sourceInitialMomentum_y * invSourceMass;
 
-        const double sourceVelocity1_x = source->m_state.momentum[0] * invSourceMass;
-        const double sourceVelocity1_y = source->m_state.momentum[1] * invSourceMass;
+        const double sourceVelocity1_x = source->m_state.momentum_x() * invSourceMass;
+        const double sourceVelocity1_y = source->m_state.momentum_y() * invSourceMass;
 
-        source->m_state.E_k -=
+        source->m_state.E_k() -=
             0.5 * sourceMass
             * (sourceVelocity1_x * sourceVelocity1_x - sourceVelocity0_x * sourceVelocity0_x);
 
-        source->m_state.E_k -=
+        source->m_state.E_k() -=
             0.5 * sourceMass
             * (sourceVelocity1_y * sourceVelocity1_y - sourceVelocity0_y * sourceVelocity0_y);
     }
@@ -496,29 +544,310 @@ double GasSystem::flow(const FlowParameters &params) {
         const double sinkVelocity0_x = sinkInitialMomentum_x * invSinkMass;
         const double sinkVelocity0_y = sinkInitialMomentum_y * invSinkMass;
 
-        const double sinkVelocity1_x = sink->m_state.momentum[0] * invSinkMass;
-        const double sinkVelocity1_y = sink->m_state.momentum[1] * invSinkMass;
+        const double sinkVelocity1_x = sink->m_state.momentum_x() * invSinkMass;
+        const double sinkVelocity1_y = sink->m_state.momentum_y() * invSinkMass;
 
-        sink->m_state.E_k -=
+        sink->m_state.E_k() -=
             0.5 * sinkMass
             * (sinkVelocity1_x * sinkVelocity1_x - sinkVelocity0_x * sinkVelocity0_x);
 
-        sink->m_state.E_k -=
+        sink->m_state.E_k() -=
             0.5 * sinkMass
             * (sinkVelocity1_y * sinkVelocity1_y - sinkVelocity0_y * sinkVelocity0_y);
     }
 
-    if (sink->m_state.E_k < 0) {
-        sink->m_state.E_k = 0;
+    if (sink->m_state.E_k() < 0) {
+        sink->m_state.E_k() = 0;
     }
 
-    if (source->m_state.E_k < 0) {
-        source->m_state.E_k = 0;
+    if (source->m_state.E_k() < 0) {
+        source->m_state.E_k() = 0;
     }
 
     return flow * direction;
 }
 
+double GasSystem::flow(GasSystemStore *store, const GasSystemStore::FlowEdge &edge, double dt) {
+    GasSystem system_0(store, edge.system_0);
+    GasSystem system_1(store, edge.system_1);
+
+    FlowParameters params;
+    params.k_flow = edge.k_flow;
+    params.dt = dt;
+    params.direction_x = edge.direction_x;
+    params.direction_y = edge.direction_y;
+    params.crossSectionArea_0 = edge.crossSectionArea_0;
+    params.crossSectionArea_1 = edge.crossSectionArea_1;
+    params.system_0 = &system_0;
+    params.system_1 = &system_1;
+
+    return flow(params);
+}
+
+namespace {
+    struct FlowLaneState {
+        double n_mol;
+        double E_k;
+        double V;
+        double momentum_x;
+        double momentum_y;
+        double p_fuel;
+        double p_inert;
+        double p_o2;
+        double degreesOfFreedom;
+        double chokedFlowLimit;
+        double chokedFlowFactor;
+    };
+
+    inline FlowLaneState gather(GasSystemStore *store, int index) {
+        return {
+            store->getField(GasSystemStore::N_mol)[index],
+            store->getField(GasSystemStore::KineticEnergy)[index],
+            store->getField(GasSystemStore::Volume)[index],
+            store->getField(GasSystemStore::Momentum_x)[index],
+            store->getField(GasSystemStore::Momentum_y)[index],
+            store->getField(GasSystemStore::P_fuel)[index],
+            store->getField(GasSystemStore::P_inert)[index],
+            store->getField(GasSystemStore::P_o2)[index],
+            store->getField(GasSystemStore::DegreesOfFreedom)[index],
+            store->getField(GasSystemStore::ChokedFlowLimit)[index],
+            store->getField(GasSystemStore::ChokedFlowFactor)[index] };
+    }
+
+    // Only the fields that flow() changes are written back
+    inline void scatter(GasSystemStore *store, int index, const FlowLaneState &s) {
+        store->getField(GasSystemStore::N_mol)[index] = s.n_mol;
+        store->getField(GasSystemStore::KineticEnergy)[index] = s.E_k;
+        store->getField(GasSystemStore::Momentum_x)[index] = s.momentum_x;
+        store->getField(GasSystemStore::Momentum_y)[index] = s.momentum_y;
+        store->getField(GasSystemStore::P_fuel)[index] = s.p_fuel;
+        store->getField(GasSystemStore::P_inert)[index] = s.p_inert;
+        store->getField(GasSystemStore::P_o2)[index] = s.p_o2;
+    }
+
+    // The functions below mirror the GasSystem accessors used by the scalar
+    // flow(), operation for operation, so that both paths produce the same
+    // results.
+
+    inline double laneMass(const FlowLaneState &s) {
+        return units::AirMolecularMass * s.n_mol;
+    }
+
+    inline double lanePressure(const FlowLaneState &s) {
+        return (s.V != 0)
+            ? s.E_k / (0.5 * s.degreesOfFreedom * s.V)
+            : 0;
+    }
+
+    inline double laneTemperature(const FlowLaneState &s) {
+        return (s.n_mol != 0)
+            ? s.E_k / (0.5 * s.degreesOfFreedom * s.n_mol * constants::R)
+            : 0;
+    }
+
+    inline double laneC(const FlowLaneState &s) {
+        if (s.n_mol == 0 || s.E_k == 0) return 0;
+
+        const double hcr = 1.0 + (2.0 / s.degreesOfFreedom);
+        const double density = laneMass(s) / s.V;
+        return std::sqrt(lanePressure(s) * hcr / density);
+    }
+
+    inline double laneBulkKineticEnergy(const FlowLaneState &s) {
+        const double m = laneMass(s);
+        if (m == 0) return 0;
+
+        const double v_x = s.momentum_x / m;
+        const double v_y = s.momentum_y / m;
+        return 0.5 * m * (v_x * v_x + v_y * v_y);
+    }
+
+    inline double laneDynamicPressure(const FlowLaneState &s, double dx, double dy) {
+        if (s.n_mol == 0 || s.E_k == 0) return 0;
+
+        const double inverseMass = 1 / laneMass(s);
+        const double v = inverseMass * (dx * s.momentum_x + dy * s.momentum_y);
+        if (v <= 0) return 0;
+
+        const double hcr = 1.0 + (2.0 / s.degreesOfFreedom);
+        const double staticPressure = lanePressure(s);
+        const double density = laneMass(s) / s.V;
+        const double c_squared = staticPressure * hcr / density;
+        const double machNumber_squared = v * v / c_squared;
+
+        const double x = 1 + ((hcr - 1) / 2) * machNumber_squared;
+        const double x_3 = x * x * x;
+        const double x_d = (s.degreesOfFreedom == 3)
+            ? x * x * x * x * x
+            : (s.degreesOfFreedom == 5)
+                ? x_3 * x_3 * x
+                : x;
+
+        return staticPressure * (std::sqrt(x_d) - 1);
+    }
+}
+
+void GasSystem::flowBatch(
+    GasSystemStore *store,
+    const int *edges,
+    int edgeCount,
+    double dt,
+    double *flows)
+{
+    FlowLaneState state_0[FlowBatchWidth], state_1[FlowBatchWidth];
+    double k_flow[FlowBatchWidth];
+    double crossSectionArea_0[FlowBatchWidth], crossSectionArea_1[FlowBatchWidth];
+    double direction_x[FlowBatchWidth], direction_y[FlowBatchWidth];
+    double flow[FlowBatchWidth];
+
+    for (int i = 0; i < edgeCount; i += FlowBatchWidth) {
+        const int activeLanes = std::min(FlowBatchWidth, edgeCount - i);
+
+        for (int l = 0; l < activeLanes; ++l) {
+            const GasSystemStore::FlowEdge &edge = store->getEdge(edges[i + l]);
+            state_0[l] = gather(store, edge.system_0);
+            state_1[l] = gather(store, edge.system_1);
+            k_flow[l] = edge.k_flow;
+            crossSectionArea_0[l] = edge.crossSectionArea_0;
+            crossSectionArea_1[l] = edge.crossSectionArea_1;
+            direction_x[l] = edge.direction_x;
+            direction_y[l] = edge.direction_y;
+        }
+
+        // Evaluate. Each lane is independent of the others.
+        for (int l = 0; l < activeLanes; ++l) {
+            const FlowLaneState &s_0 = state_0[l];
+            const FlowLaneState &s_1 = state_1[l];
+
+            const double P_0 =
+                lanePressure(s_0) + laneDynamicPressure(s_0, direction_x[l], direction_y[l]);
+            const double P_1 =
+                lanePressure(s_1) + laneDynamicPressure(s_1, -direction_x[l], -direction_y[l]);
+
+            const bool forward = P_0 > P_1;
+            FlowLaneState &source = forward ? state_0[l] : state_1[l];
+            FlowLaneState &sink = forward ? state_1[l] : state_0[l];
+            const double sourceCrossSection = forward ? crossSectionArea_0[l] : crossSectionArea_1[l];
+            const double sinkCrossSection = forward ? crossSectionArea_1[l] : crossSectionArea_0[l];
+            const double dx = forward ? direction_x[l] : -direction_x[l];
+            const double dy = forward ? direction_y[l] : -direction_y[l];
+            const double direction = forward ? 1.0 : -1.0;
+
+            double laneFlow = dt * flowRate(
+                k_flow[l],
+                forward ? P_0 : P_1,
+                forward ? P_1 : P_0,
+                laneTemperature(source),
+                laneTemperature(sink),
+                1.0 + (2.0 / source.degreesOfFreedom),
+                source.chokedFlowLimit,
+                source.chokedFlowFactor);
+            laneFlow = clamp(laneFlow, 0.0, 0.9 * source.n_mol);
+
+            const double fraction = laneFlow / source.n_mol;
+            const double fractionVolume = fraction * source.V;
+            const double fractionMass = fraction * laneMass(source);
+
+            if (laneFlow != 0) {
+                const double E_k_bulk_src0 = laneBulkKineticEnergy(source);
+                const double E_k_bulk_sink0 = laneBulkKineticEnergy(sink);
+
+                const double E_k_per_mol = source.E_k / source.n_mol;
+                const double current_n = sink.n_mol;
+                const double next_n = sink.n_mol + laneFlow;
+
+                sink.E_k += laneFlow * E_k_per_mol;
+                sink.n_mol = next_n;
+                if (next_n != 0) {
+                    sink.p_fuel = (sink.p_fuel * current_n + laneFlow * source.p_fuel) / next_n;
+                    sink.p_inert = (sink.p_inert * current_n + laneFlow * source.p_inert) / next_n;
+                    sink.p_o2 = (sink.p_o2 * current_n + laneFlow * source.p_o2) / next_n;
+                }
+                else {
+                    sink.p_fuel = sink.p_inert = sink.p_o2 = 0;
+                }
+
+                source.E_k -= E_k_per_mol * laneFlow;
+                source.n_mol -= laneFlow;
+                if (source.n_mol < 0) source.n_mol = 0;
+
+                const double dp_x = source.momentum_x * fraction;
+                const double dp_y = source.momentum_y * fraction;
+                source.momentum_x -= dp_x;
+                source.momentum_y -= dp_y;
+                sink.momentum_x += dp_x;
+                sink.momentum_y += dp_y;
+
+                const double E_k_bulk_src1 = laneBulkKineticEnergy(source);
+                const double E_k_bulk_sink1 = laneBulkKineticEnergy(sink);
+
+                sink.E_k -= ((E_k_bulk_src1 + E_k_bulk_sink1) - (E_k_bulk_src0 + E_k_bulk_sink0));
+            }
+
+            const double sourceMass = laneMass(source);
+            const double invSourceMass = 1 / sourceMass;
+            const double sinkMass = laneMass(sink);
+            const double invSinkMass = 1 / sinkMass;
+
+            const double c_source = laneC(source);
+            const double c_sink = laneC(sink);
+
+            const double sourceInitialMomentum_x = source.momentum_x;
+            const double sourceInitialMomentum_y = source.momentum_y;
+            const double sinkInitialMomentum_x = sink.momentum_x;
+            const double sinkInitialMomentum_y = sink.momentum_y;
+
+            if (sinkCrossSection != 0) {
+                const double sinkFractionVelocity =
+                    clamp((fractionVolume / sinkCrossSection) / dt, 0.0, c_sink);
+                sink.momentum_x += (sinkFractionVelocity * dx) * fractionMass;
+                sink.momentum_y += (sinkFractionVelocity * dy) * fractionMass;
+            }
+
+            if (sourceCrossSection != 0 && sourceMass != 0) {
+                const double sourceFractionVelocity =
+                    clamp((fractionVolume / sourceCrossSection) / dt, 0.0, c_source);
+                source.momentum_x += (sourceFractionVelocity * dx) * fractionMass;
+                source.momentum_y += (sourceFractionVelocity * dy) * fractionMass;
+            }
+
+            if (sourceMass != 0) {
+                const double v0_x = sourceInitialMomentum_x * invSourceMass;
+                const double v0_y = sourceInitialMomentum_y * invSourceMass;
+                const double v1_x = source.momentum_x * invSourceMass;
+                const double v1_y = source.momentum_y * invSourceMass;
+
+                source.E_k -= 0.5 * sourceMass * (v1_x * v1_x - v0_x * v0_x);
+                source.E_k -= 0.5 * sourceMass * (v1_y * v1_y - v0_y * v0_y);
+            }
+
+            if (sinkMass > 0) {
+                const double v0_x = sinkInitialMomentum_x * invSinkMass;
+                const double v0_y = sinkInitialMomentum_y * invSinkMass;
+                const double v1_x = sink.momentum_x * invSinkMass;
+                const double v1_y = sink.momentum_y * invSinkMass;
+
+                sink.E_k -= 0.5 * sinkMass * (v1_x * v1_x - v0_x * v0_x);
+                sink.E_k -= 0.5 * sinkMass * (v1_y * v1_y - v0_y * v0_y);
+            }
+
+            if (sink.E_k < 0) sink.E_k = 0;
+            if (source.E_k < 0) source.E_k = 0;
+
+            flow[l] = laneFlow * direction;
+        }
+
+        // Scatter. The edges share no volume, so the order does not matter.
+        for (int l = 0; l < activeLanes; ++l) {
+            const GasSystemStore::FlowEdge &edge = store->getEdge(edges[i + l]);
+            scatter(store, edge.system_0, state_0[l]);
+            scatter(store, edge.system_1, state_1[l]);
+
+            if (flows != nullptr) flows[i + l] = flow[l];
+        }
+    }
+}
+
 double GasSystem::flow(double k_flow, double dt, double P_env, double T_env, const Mix &mix) {
     const double maxFlow = pressureEquilibriumMaxFlow(P_env, T_env);
     double flow = dt * flowRate(
@@ -528,8 +857,8 @@ double GasSystem::flow(double k_flow, double dt, double P_env, double T_env, con
         temperature(),
         T_env,
         heatCapacityRatio(),
-        m_chokedFlowLimit,
-        m_chokedFlowFactorCached);
+        m_state.chokedFlowLimit(),
+        m_state.chokedFlowFactor());
 
     if (std::abs(flow) > std::abs(maxFlow)) {
         flow = maxFlow;
@@ -537,22 +866,87 @@ double GasSystem::flow(double k_flow, double dt, double P_env, double T_env, con
 
     if (flow < 0) {
         const double bulk_E_k_0 = bulkKineticEnergy();
-        gainN(-flow, kineticEnergyPerMol(T_env, m_degreesOfFreedom), mix);
+        gainN(-flow, kineticEnergyPerMol(T_env, degreesOfFreedom()), mix);
         const double bulk_E_k_1 = bulkKineticEnergy();
 
-        m_state.E_k += (bulk_E_k_1 - bulk_E_k_0);
+        m_state.E_k() += (bulk_E_k_1 - bulk_E_k_0);
     }
     else {
         const double starting_n = n();
         loseN(flow, kineticEnergyPerMol());
 
-        m_state.momentum[0] -= (flow / starting_n) * m_state.momentum[0];
-        m_state.momentum[1] -= (flow / starting_n) * m_state.momentum[1];
+        m_state.momentum_x() -= (flow / starting_n) * m_state.momentum_x();
+        m_state.momentum_y() -= (flow / starting_n) * m_state.momentum_y();
     }
 
     return flow;
 }
 
+double GasSystem::flowStiffness(
+    double k_flow,
+    const GasSystem *b,
+    double minPressureDifference) const
+{
+    if (k_flow == 0) return 0;
+
+    const double P_a = pressure(), P_b = b->pressure();
+    const GasSystem *source = (P_a >= P_b) ? this : b;
+    const double P_0 = std::fmax(P_a, P_b);
+    const double dP = std::fmax(std::abs(P_a - P_b), minPressureDifference);
+    const double T_0 = source->temperature();
+
+    const double rate = std::abs(flowRate(
+        k_flow,
+        P_0,
+        std::fmax(P_0 - dP, 0.0),
+        T_0,
+        T_0,
+        source->heatCapacityRatio(),
+        source->m_state.chokedFlowLimit(),
+        source->m_state.chokedFlowFactor()));
+
+    // Moles that would have to move to equalize the pressures, ignoring the
+    // temperature change
+    const double n_eq =
+        dP / (constants::R * (temperature() / volume() + b->temperature() / b->volume()));
+
+    return (n_eq > 0)
+        ? rate / n_eq
+        : 0;
+}
+
+double GasSystem::flowStiffness(
+    double k_flow,
+    double P_env,
+    double T_env,
+    double minPressureDifference) const
+{
+    if (k_flow == 0) return 0;
+
+    const double P = pressure();
+    const double P_0 = std::fmax(P, P_env);
+    const double dP = std::fmax(std::abs(P - P_env), minPressureDifference);
+    const double T_0 = (P >= P_env) ? temperature() : T_env;
+
+    // The environment is treated as an infinite reservoir; its flow
+    // constants are approximated by this volume's
+    const double rate = std::abs(flowRate(
+        k_flow,
+        P_0,
+        std::fmax(P_0 - dP, 0.0),
+        T_0,
+        T_0,
+        heatCapacityRatio(),
+        m_state.chokedFlowLimit(),
+        m_state.chokedFlowFactor()));
+
+    const double n_eq = dP * volume() / (constants::R * temperature());
+
+    return (n_eq > 0)
+        ? rate / n_eq
+        : 0;
+}
+
 double GasSystem::pressureEquilibriumMaxFlow(const GasSystem *b) const {
     // pressure_a = (kineticEnergy() + n * b->kineticEnergyPerMol()) / (0.5 * degreesOfFreedom * volume())
     // pressure_b = (b->kineticEnergy() - n *  / (0.5 * b->degreesOfFreedom * b->volume())
@@ -583,10 +977,10 @@ double GasSystem::pressureEquilibriumMaxFlow(const GasSystem *b) const {
 
 double GasSystem::pressureEquilibriumMaxFlow(double P_env, double T_env) const {
     if (pressure() > P_env) {
-        return -(P_env * (0.5 * m_degreesOfFreedom * volume()) - kineticEnergy()) / kineticEnergyPerMol();
+        return -(P_env * (0.5 * degreesOfFreedom() * volume()) - kineticEnergy()) / kineticEnergyPerMol();
     }
     else {
-        const double E_k_per_mol_env = 0.5 * T_env * constants::R * m_degreesOfFreedom;
-        return -(P_env * (0.5 * m_degreesOfFreedom * volume()) - kineticEnergy()) / E_k_per_mol_env;
+        const double E_k_per_mol_env = 0.5 * T_env * constants::R * degreesOfFreedom();
+        return -(P_env * (0.5 * degreesOfFreedom() * volume()) - kineticEnergy()) / E_k_per_mol_env;
     }
 }
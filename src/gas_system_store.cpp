@@ -0,0 +1,67 @@
+#include "../include/gas_system_store.h"
+
+#include "../include/simulation_snapshot.h"
+
+#include <cassert>
+
+GasSystemStore::GasSystemStore() {
+    m_data = nullptr;
+    m_capacity = 0;
+    m_systemCount = 0;
+
+    m_edges = nullptr;
+    m_edgeCapacity = 0;
+    m_edgeCount = 0;
+}
+
+GasSystemStore::~GasSystemStore() {
+    assert(m_data == nullptr);
+    assert(m_edges == nullptr);
+}
+
+void GasSystemStore::initialize(int capacity, int edgeCapacity) {
+    destroy();
+
+    m_capacity = capacity;
+    m_data = new double[(size_t)capacity * FieldCount];
+    for (int i = 0; i < capacity * FieldCount; ++i) {
+        m_data[i] = 0.0;
+    }
+
+    m_edgeCapacity = edgeCapacity;
+    m_edges = new FlowEdge[edgeCapacity];
+}
+
+void GasSystemStore::destroy() {
+    if (m_data != nullptr) delete[] m_data;
+    if (m_edges != nullptr) delete[] m_edges;
+
+    m_data = nullptr;
+    m_edges = nullptr;
+    m_capacity = m_systemCount = 0;
+    m_edgeCapacity = m_edgeCount = 0;
+}
+
+int GasSystemStore::allocate() {
+    assert(m_systemCount < m_capacity);
+    return m_systemCount++;
+}
+
+int GasSystemStore::addEdge(const FlowEdge &edge) {
+    assert(m_edgeCount < m_edgeCapacity);
+
+    m_edges[m_edgeCount] = edge;
+    return m_edgeCount++;
+}
+
+void GasSystemStore::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->writeCount(m_systemCount);
+    snapshot->writeArray(m_data, (size_t)m_capacity * FieldCount);
+    snapshot->writeArray(m_edges, m_edgeCount);
+}
+
+void GasSystemStore::loadState(SimulationSnapshot *snapshot) {
+    snapshot->expectCount(m_systemCount);
+    snapshot->readArray(m_data, (size_t)m_capacity * FieldCount);
+    snapshot->readArray(m_edges, m_edgeCount);
+}
@@ -2,6 +2,7 @@
 
 #include "../include/engine.h"
 #include "../include/utilities.h"
+#include "../include/simulation_snapshot.h"
 
 Governor::Governor() {
     m_minSpeed = m_maxSpeed = 0;
@@ -50,3 +51,19 @@ void Governor::update(double dt, Engine *engine) {
 
     engine->setThrottle(1 - std::pow(1 - m_currentThrottle, m_gamma));
 }
+
+void Governor::saveState(SimulationSnapshot *snapshot) const {
+    Throttle::saveState(snapshot);
+
+    snapshot->write(m_targetSpeed);
+    snapshot->write(m_currentThrottle);
+    snapshot->write(m_velocity);
+}
+
+void Governor::loadState(SimulationSnapshot *snapshot) {
+    Throttle::loadState(snapshot);
+
+    snapshot->read(&m_targetSpeed);
+    snapshot->read(&m_currentThrottle);
+    snapshot->read(&m_velocity);
+}
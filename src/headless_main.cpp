@@ -0,0 +1,151 @@
+#include "../include/headless_runner.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    void printUsage(const char *program) {
+        std::printf(
+            "Usage: %s [options]\n"
+            "  --script <path>       Engine script to load (default: ../assets/main.mr)\n"
+            "  --script-cache <path> Compiled script cache (default: engine_script.cache;\n"
+            "                        \"none\" always compiles the script)\n"
+            "  --ir-cache <dir>      Prepared impulse response cache (default: impulse_response_cache;\n"
+            "                        \"none\" prepares them on every run)\n"
+            "  --time <s>            Simulated time to measure (default: 10)\n"
+            "  --warmup <s>          Simulated time to run before measuring (default: 2)\n"
+            "  --throttle <0-1>      Throttle position (default: 1)\n"
+            "  --dyno <rpm>          Hold the engine at a fixed speed with the dyno\n"
+            "  --frequency <hz>|<min>-<max>\n"
+            "                        Override the simulation frequency, or bound it with --step-angle\n"
+            "  --step-angle <deg>    Choose the simulation frequency from engine speed so each\n"
+            "                        step covers about this much crank angle\n"
+            "  --frame-rate <hz>     Frame rate used to drive the simulator (default: 60)\n"
+            "  --system <full|reduced>\n"
+            "                        Constrain every part, or simulate only the crankshaft\n"
+            "                        with the pistons and rods folded into it (default: full)\n"
+            "  --integrator <semi-implicit|implicit>\n"
+            "                        Integrate the piston forces explicitly, or linearize them\n"
+            "                        over the step to stay stable at lower frequencies\n"
+            "                        (default: semi-implicit)\n"
+            "  --threads <n>         Threads used for the fluid simulation (default: 1)\n"
+            "  --fluid-steps <n>|<min>-<max>\n"
+            "                        Fixed or adaptive fluid steps per simulation step\n"
+            "  --seed <n>            Seed for the simulation's random streams (default: 0)\n"
+            "  --output <path>       Render audio offline to a WAV file, as fast as possible\n"
+            "  --save-snapshot <path>\n"
+            "                        Save the simulation state after the warmup\n"
+            "  --load-snapshot <path>\n"
+            "                        Start from a saved simulation state instead of warming up\n"
+            "  --profile <path>      Throttle/dyno keyframes (\"<time> <throttle> [<rpm>]\" per line);\n"
+            "                        runs for the profile's duration unless --time is given\n",
+            program);
+    }
+}
+
+int main(int argc, char **argv) {
+    HeadlessRunner::Parameters params;
+    bool timeSpecified = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if (value == nullptr) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        else if (std::strcmp(arg, "--script") == 0) params.scriptPath = value;
+        else if (std::strcmp(arg, "--script-cache") == 0) {
+            params.scriptCachePath = (std::strcmp(value, "none") == 0)
+                ? ""
+                : value;
+        }
+        else if (std::strcmp(arg, "--ir-cache") == 0) {
+            params.impulseResponseCachePath = (std::strcmp(value, "none") == 0)
+                ? ""
+                : value;
+        }
+        else if (std::strcmp(arg, "--time") == 0) {
+            params.simulationTime = std::atof(value);
+            timeSpecified = true;
+        }
+        else if (std::strcmp(arg, "--warmup") == 0) params.warmupTime = std::atof(value);
+        else if (std::strcmp(arg, "--throttle") == 0) params.throttle = std::atof(value);
+        else if (std::strcmp(arg, "--dyno") == 0) params.dynoSpeed = std::atof(value);
+        else if (std::strcmp(arg, "--frequency") == 0) {
+            const char *separator = std::strchr(value, '-');
+            params.simulationFrequency = std::atoi(value);
+            params.maxSimulationFrequency = (separator != nullptr)
+                ? std::atoi(separator + 1)
+                : 0;
+        }
+        else if (std::strcmp(arg, "--step-angle") == 0) params.crankAnglePerStep = std::atof(value);
+        else if (std::strcmp(arg, "--frame-rate") == 0) params.frameRate = std::atof(value);
+        else if (std::strcmp(arg, "--system") == 0) {
+            if (std::strcmp(value, "reduced") == 0) params.reducedCoordinates = true;
+            else if (std::strcmp(value, "full") == 0) params.reducedCoordinates = false;
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (std::strcmp(arg, "--integrator") == 0) {
+            if (std::strcmp(value, "implicit") == 0) {
+                params.integrationMethod = Simulator::IntegrationMethod::LinearlyImplicitEuler;
+            }
+            else if (std::strcmp(value, "semi-implicit") == 0) {
+                params.integrationMethod = Simulator::IntegrationMethod::SemiImplicitEuler;
+            }
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (std::strcmp(arg, "--threads") == 0) params.fluidThreads = std::atoi(value);
+        else if (std::strcmp(arg, "--fluid-steps") == 0) {
+            const char *separator = std::strchr(value, '-');
+            params.minFluidSteps = std::atoi(value);
+            params.maxFluidSteps = (separator != nullptr)
+                ? std::atoi(separator + 1)
+                : params.minFluidSteps;
+        }
+        else if (std::strcmp(arg, "--seed") == 0) params.seed = std::strtoull(value, nullptr, 10);
+        else if (std::strcmp(arg, "--output") == 0) params.outputPath = value;
+        else if (std::strcmp(arg, "--profile") == 0) params.profilePath = value;
+        else if (std::strcmp(arg, "--save-snapshot") == 0) params.saveSnapshotPath = value;
+        else if (std::strcmp(arg, "--load-snapshot") == 0) params.loadSnapshotPath = value;
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        ++i;
+    }
+
+    if (!params.profilePath.empty() && !timeSpecified) {
+        params.simulationTime = 0.0;
+    }
+
+    HeadlessRunner runner;
+    if (!runner.initialize(params)) {
+        std::fprintf(stderr, "Failed to load engine from %s (see error_log.log)\n",
+            params.scriptPath.c_str());
+        runner.destroy();
+        return 1;
+    }
+
+    HeadlessRunner::Report report;
+    const bool success = runner.run(&report);
+    HeadlessRunner::printReport(report);
+    runner.printPhaseBreakdown();
+
+    runner.destroy();
+
+    return (success && report.stable) ? 0 : 1;
+}
@@ -0,0 +1,495 @@
+#include "../include/headless_runner.h"
+
+#include "../include/piston_engine_simulator.h"
+#include "../include/units.h"
+
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+#include "../scripting/include/compiler.h"
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+HeadlessRunner::HeadlessRunner() {
+    m_simulator = nullptr;
+    m_engine = nullptr;
+    m_vehicle = nullptr;
+    m_transmission = nullptr;
+
+    m_audioScratch = nullptr;
+    m_audioScratchSize = 0;
+
+    m_recordAudio = false;
+}
+
+HeadlessRunner::~HeadlessRunner() {
+    assert(m_simulator == nullptr);
+    assert(m_audioScratch == nullptr);
+}
+
+bool HeadlessRunner::initialize(const Parameters &params) {
+    m_parameters = params;
+    m_impulseResponses.setCacheDirectory(params.impulseResponseCachePath);
+
+    if (!loadScript()) {
+        return false;
+    }
+
+    m_simulator = m_engine->createSimulator(
+        m_vehicle, m_transmission, params.reducedCoordinates);
+    m_engine->calculateDisplacement();
+
+    m_simulator->setIntegrationMethod(params.integrationMethod);
+    m_simulator->setSimulationFrequency((params.simulationFrequency > 0)
+        ? params.simulationFrequency
+        : static_cast<int>(m_engine->getSimulationFrequency()));
+
+    if (params.crankAnglePerStep > 0) {
+        m_simulator->setAdaptiveFrequencyEnabled(true);
+        m_simulator->setCrankAnglePerStep(
+            units::angle(params.crankAnglePerStep, units::deg));
+        m_simulator->setSimulationFrequencyRange(
+            (params.simulationFrequency > 0)
+                ? params.simulationFrequency
+                : m_simulator->getMinSimulationFrequency(),
+            (params.maxSimulationFrequency > 0)
+                ? params.maxSimulationFrequency
+                : m_simulator->getMaxSimulationFrequency());
+    }
+
+    PistonEngineSimulator *pistonSimulator = dynamic_cast<PistonEngineSimulator *>(m_simulator);
+    if (pistonSimulator != nullptr) {
+        pistonSimulator->setFluidSimulationThreadCount(params.fluidThreads);
+
+        if (params.maxFluidSteps > params.minFluidSteps) {
+            pistonSimulator->setAdaptiveFluidSimulation(true);
+            pistonSimulator->setFluidSimulationStepRange(
+                params.minFluidSteps, params.maxFluidSteps);
+        }
+        else if (params.minFluidSteps > 0) {
+            pistonSimulator->setFluidSimulationSteps(params.minFluidSteps);
+        }
+    }
+
+    m_simulator->setRandomSeed(params.seed);
+
+    Synthesizer::AudioParameters audioParams = m_simulator->synthesizer().getAudioParameters();
+    audioParams.inputSampleNoise = static_cast<float>(m_engine->getInitialJitter());
+    audioParams.airNoise = static_cast<float>(m_engine->getInitialNoise());
+    audioParams.dF_F_mix = static_cast<float>(m_engine->getInitialHighFrequencyGain());
+    m_simulator->synthesizer().setAudioParameters(audioParams);
+
+    if (!loadImpulseResponses()) {
+        return false;
+    }
+
+    m_audioScratchSize = 44100;
+    m_audioScratch = new int16_t[m_audioScratchSize];
+
+    if (!params.profilePath.empty() && !m_profile.load(params.profilePath)) {
+        std::fprintf(stderr, "Could not read control profile: %s\n",
+            params.profilePath.c_str());
+        return false;
+    }
+
+    if (m_parameters.simulationTime <= 0) {
+        m_parameters.simulationTime = m_profile.getDuration();
+    }
+
+    if (!params.outputPath.empty()) {
+        Synthesizer &synthesizer = m_simulator->synthesizer();
+        if (!m_waveWriter.open(
+            params.outputPath,
+            static_cast<int>(synthesizer.getAudioSampleRate())))
+        {
+            std::fprintf(stderr, "Could not open output file: %s\n",
+                params.outputPath.c_str());
+            return false;
+        }
+
+        m_simulator->setLatencyControlEnabled(false);
+        synthesizer.setOfflineMode(true);
+    }
+
+    return true;
+}
+
+bool HeadlessRunner::run(Report *report) {
+    *report = Report();
+    report->simulationFrequency = m_simulator->getSimulationFrequency();
+    report->adaptiveFrequency = m_simulator->isAdaptiveFrequencyEnabled();
+    report->reducedCoordinates =
+        m_simulator->getSystemType() == Simulator::SystemType::ReducedCoordinate;
+    report->linearlyImplicit =
+        m_simulator->getIntegrationMethod() == Simulator::IntegrationMethod::LinearlyImplicitEuler;
+
+    PistonEngineSimulator *pistonSimulator = dynamic_cast<PistonEngineSimulator *>(m_simulator);
+    if (pistonSimulator != nullptr) {
+        report->fluidThreads = pistonSimulator->getFluidSimulationThreadCount();
+        report->fluidPartitions = pistonSimulator->getFluidPartitionCount();
+        report->adaptiveFluidSteps = pistonSimulator->isAdaptiveFluidSimulation();
+    }
+
+    const bool warmStart = !m_parameters.loadSnapshotPath.empty();
+    if (warmStart) {
+        SimulationSnapshot snapshot;
+        if (!snapshot.loadFromFile(m_parameters.loadSnapshotPath)
+            || !m_simulator->loadSnapshot(&snapshot))
+        {
+            std::fprintf(stderr, "Failed to load snapshot %s\n",
+                m_parameters.loadSnapshotPath.c_str());
+            return false;
+        }
+    }
+
+    m_engine->getIgnitionModule()->m_enabled = true;
+    if (m_profile.isEmpty()) {
+        applyControls(m_parameters.throttle, m_parameters.dynoSpeed);
+    }
+    else {
+        const ControlProfile::Keyframe controls = m_profile.sample(0.0);
+        applyControls(controls.throttle, controls.dynoSpeed);
+    }
+
+    double warmupElapsed = 0.0;
+    while (!warmStart && warmupElapsed < m_parameters.warmupTime) {
+        m_simulator->m_starterMotor.m_enabled =
+            warmupElapsed < m_parameters.starterTime;
+
+        double physicsTime = 0, audioTime = 0;
+        warmupElapsed += runFrame(&physicsTime, &audioTime);
+
+        if (!checkStability(report)) break;
+    }
+
+    m_simulator->m_starterMotor.m_enabled = false;
+
+    if (!m_parameters.saveSnapshotPath.empty()) {
+        SimulationSnapshot snapshot;
+        m_simulator->saveSnapshot(&snapshot);
+        if (!snapshot.saveToFile(m_parameters.saveSnapshotPath)) {
+            std::fprintf(stderr, "Failed to write snapshot %s\n",
+                m_parameters.saveSnapshotPath.c_str());
+            return false;
+        }
+    }
+
+    m_recordAudio = true;
+
+    if (pistonSimulator != nullptr) {
+        pistonSimulator->resetFluidSimulationStatistics();
+    }
+
+    m_simulator->resetSolverStatistics();
+
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_engine->getChamber(i)->resetSealedFlowSteps();
+    }
+
+    double processingTime = 0.0;
+    double rpm = 0.0, dynoTorque = 0.0;
+    while (report->stable && report->simulatedTime < m_parameters.simulationTime) {
+        if (!m_profile.isEmpty()) {
+            const ControlProfile::Keyframe controls =
+                m_profile.sample(report->simulatedTime);
+            applyControls(controls.throttle, controls.dynoSpeed);
+        }
+
+        const double frameSimulatedTime =
+            runFrame(&report->physicsTime, &report->audioTime);
+
+        report->steps += m_simulator->simulationSteps();
+        report->simulatedTime += frameSimulatedTime;
+        ++report->frames;
+
+        processingTime += m_simulator->getAverageProcessingTime();
+        rpm += m_engine->getRpm();
+        dynoTorque += m_simulator->getFilteredDynoTorque();
+
+        checkStability(report);
+    }
+
+    m_recordAudio = false;
+
+    if (pistonSimulator != nullptr) {
+        report->averageFluidSteps = pistonSimulator->getAverageFluidSimulationSteps();
+    }
+
+    report->averageSolverIterations = m_simulator->getAverageSolverIterations();
+    report->maxSolverResidual = m_simulator->getMaxSolverResidual();
+    report->unconvergedSolverSteps = m_simulator->getUnconvergedSolverSteps();
+
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        report->sealedChamberSteps += m_engine->getChamber(i)->getSealedFlowSteps();
+    }
+
+    const double chamberSteps =
+        report->averageFluidSteps * report->steps * m_engine->getCylinderCount();
+    if (chamberSteps > 0) {
+        report->sealedChamberFraction = report->sealedChamberSteps / chamberSteps;
+    }
+
+    bool success = true;
+    if (m_waveWriter.isOpen()) {
+        report->audioSamples = m_waveWriter.getSampleCount();
+        if (!m_waveWriter.close()) {
+            std::fprintf(stderr, "Failed to write %s\n",
+                m_parameters.outputPath.c_str());
+            success = false;
+        }
+    }
+
+    report->wallTime = report->physicsTime + report->audioTime;
+    if (report->simulatedTime > 0) {
+        report->averageSimulationFrequency = report->steps / report->simulatedTime;
+    }
+
+    if (report->frames > 0) {
+        report->averageProcessingTime = processingTime / report->frames;
+        report->averageRpm = rpm / report->frames;
+        report->averageDynoTorque = dynoTorque / report->frames;
+    }
+
+    if (report->wallTime > 0) {
+        report->stepsPerSecond = report->steps / report->wallTime;
+        report->realTimeFactor = report->simulatedTime / report->wallTime;
+    }
+
+    return success;
+}
+
+void HeadlessRunner::destroy() {
+    if (m_waveWriter.isOpen()) {
+        m_waveWriter.close();
+    }
+
+    if (m_simulator != nullptr) {
+        m_simulator->releaseSimulation();
+        delete m_simulator;
+        m_simulator = nullptr;
+    }
+
+    m_impulseResponses.destroy();
+
+    if (m_engine != nullptr) {
+        m_engine->destroy();
+        delete m_engine;
+        m_engine = nullptr;
+    }
+
+    if (m_vehicle != nullptr) {
+        delete m_vehicle;
+        m_vehicle = nullptr;
+    }
+
+    if (m_transmission != nullptr) {
+        delete m_transmission;
+        m_transmission = nullptr;
+    }
+
+    if (m_audioScratch != nullptr) {
+        delete[] m_audioScratch;
+        m_audioScratch = nullptr;
+    }
+
+    m_audioScratchSize = 0;
+}
+
+void HeadlessRunner::printReport(const Report &report) {
+    if (report.adaptiveFrequency) {
+        std::printf("Simulation frequency:      %.0f Hz avg. (adaptive)\n",
+            report.averageSimulationFrequency);
+    }
+    else {
+        std::printf("Simulation frequency:      %d Hz\n", report.simulationFrequency);
+    }
+
+    std::printf("Rigid body system:         %s\n",
+        report.reducedCoordinates ? "reduced coordinates" : "full");
+    std::printf("Integration:               %s\n",
+        report.linearlyImplicit ? "linearly implicit" : "semi-implicit");
+
+    // The generic system solves its constraints directly
+    if (report.averageSolverIterations > 0) {
+        std::printf("Solver iterations:         %.2f avg. (max. residual %.3g, %lld unconverged)\n",
+            report.averageSolverIterations, report.maxSolverResidual, report.unconvergedSolverSteps);
+    }
+
+    std::printf("Fluid threads:             %d (%d partitions)\n",
+        report.fluidThreads, report.fluidPartitions);
+    std::printf("Fluid steps:               %.2f avg.%s\n",
+        report.averageFluidSteps, report.adaptiveFluidSteps ? " (adaptive)" : "");
+    std::printf("Sealed chamber steps:      %lld (%.1f%%)\n",
+        report.sealedChamberSteps, report.sealedChamberFraction * 100);
+    std::printf("Simulated time:            %.3f s\n", report.simulatedTime);
+    std::printf("Wall time:                 %.3f s (physics %.3f s, audio %.3f s)\n",
+        report.wallTime, report.physicsTime, report.audioTime);
+    std::printf("Frames:                    %lld\n", report.frames);
+    std::printf("Simulation steps:          %lld\n", report.steps);
+    std::printf("Steps/sec:                 %.0f\n", report.stepsPerSecond);
+    std::printf("Real-time factor:          %.2fx\n", report.realTimeFactor);
+    std::printf("Avg. processing time:      %.1f us/frame\n", report.averageProcessingTime);
+    std::printf("Avg. engine speed:         %.0f rpm\n", report.averageRpm);
+    std::printf("Avg. dyno torque:          %.1f ft-lb\n",
+        units::convert(report.averageDynoTorque, units::ft_lb));
+
+    if (report.audioSamples > 0) {
+        std::printf("Audio written:             %lld samples\n", report.audioSamples);
+    }
+
+    std::printf("Stable:                    %s (max. joint error %.3g mm)\n",
+        report.stable ? "yes" : "no", report.maxJointError / units::mm);
+}
+
+void HeadlessRunner::printPhaseBreakdown() const {
+    if (!SimulationProfiler::isEnabled()) return;
+
+    const SimulationProfiler &profiler = m_simulator->getProfiler();
+
+    std::printf("\nLast frame breakdown (us/step):\n");
+    std::printf("  %-12s %10s %10s %10s\n", "Phase", "Min", "Mean", "P99");
+    for (int i = 0; i < SimulationProfiler::PhaseCount; ++i) {
+        const SimulationProfiler::Phase phase = static_cast<SimulationProfiler::Phase>(i);
+        const SimulationProfiler::Statistics &stats = profiler.getStatistics(phase);
+        std::printf("  %-12s %10.2f %10.2f %10.2f\n",
+            SimulationProfiler::getPhaseName(phase),
+            stats.min / 1000.0,
+            stats.mean / 1000.0,
+            stats.p99 / 1000.0);
+    }
+}
+
+bool HeadlessRunner::loadScript() {
+#ifdef ATG_ENGINE_SIM_PIRANHA_ENABLED
+    es_script::Compiler compiler;
+    compiler.initialize();
+    compiler.setCachePath(m_parameters.scriptCachePath);
+    const bool compiled = compiler.compile(m_parameters.scriptPath.c_str());
+    if (compiled) {
+        const es_script::Compiler::Output output = compiler.execute();
+
+        m_engine = output.engine;
+        m_vehicle = output.vehicle;
+        m_transmission = output.transmission;
+    }
+
+    compiler.destroy();
+#endif /* ATG_ENGINE_SIM_PIRANHA_ENABLED */
+
+    return m_engine != nullptr
+        && m_vehicle != nullptr
+        && m_transmission != nullptr;
+}
+
+bool HeadlessRunner::loadImpulseResponses() {
+    for (int i = 0; i < m_engine->getExhaustSystemCount(); ++i) {
+        ImpulseResponse *response = m_engine->getExhaustSystem(i)->getImpulseResponse();
+
+        const ConvolutionFilter::Kernel *kernel =
+            m_impulseResponses.load(response->getFilename());
+        if (kernel == nullptr) {
+            std::fprintf(stderr, "Could not read impulse response: %s\n",
+                response->getFilename().c_str());
+            return false;
+        }
+
+        m_simulator->synthesizer().initializeImpulseResponse(
+            *kernel,
+            static_cast<float>(response->getVolume()),
+            i
+        );
+    }
+
+    return true;
+}
+
+double HeadlessRunner::runFrame(double *physicsTime, double *audioTime) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    m_simulator->startFrame(1.0 / m_parameters.frameRate);
+    while (m_simulator->simulateStep()) {
+        /* void */
+    }
+
+    m_simulator->endFrame();
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    if (m_simulator->synthesizer().isOfflineMode()) {
+        renderOffline();
+
+        auto t2 = std::chrono::steady_clock::now();
+        *physicsTime += std::chrono::duration<double>(t1 - t0).count();
+        *audioTime += std::chrono::duration<double>(t2 - t1).count();
+
+        return m_simulator->simulationSteps() * m_simulator->getTimestep();
+    }
+
+    // Drain the output first so that the synthesizer always has room to
+    // render; without an audio device there is nothing else consuming it.
+    while (m_simulator->readAudioOutput(m_audioScratchSize, m_audioScratch) > 0) {
+        /* void */
+    }
+
+    if (m_simulator->getSynthesizerInputLatency() > 0) {
+        m_simulator->synthesizer().renderAudio();
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+
+    *physicsTime += std::chrono::duration<double>(t1 - t0).count();
+    *audioTime += std::chrono::duration<double>(t2 - t1).count();
+
+    return m_simulator->simulationSteps() * m_simulator->getTimestep();
+}
+
+bool HeadlessRunner::checkStability(Report *report) const {
+    const double speed = m_engine->getSpeed();
+    bool stable = std::isfinite(speed);
+    if (m_engine->getRedline() > 0) {
+        stable = stable && speed <= MaxStableRedlineFraction * m_engine->getRedline();
+    }
+
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        const double pressure = m_engine->getChamber(i)->m_system.pressure();
+        stable = stable && std::isfinite(pressure) && pressure > 0;
+    }
+
+    const PistonEngineSimulator *pistonSimulator =
+        dynamic_cast<const PistonEngineSimulator *>(m_simulator);
+    if (pistonSimulator != nullptr) {
+        const double jointError = pistonSimulator->getMaxJointError();
+        stable = stable && !(jointError > MaxStableJointError);
+        report->maxJointError = std::fmax(report->maxJointError, jointError);
+    }
+
+    report->stable = report->stable && stable;
+    return report->stable;
+}
+
+void HeadlessRunner::applyControls(double throttle, double dynoSpeed) {
+    m_engine->setSpeedControl(throttle);
+
+    m_simulator->m_dyno.m_enabled = dynoSpeed > 0;
+    m_simulator->m_dyno.m_hold = dynoSpeed > 0;
+    if (dynoSpeed > 0) {
+        m_simulator->m_dyno.m_rotationSpeed = units::rpm(dynoSpeed);
+    }
+}
+
+void HeadlessRunner::renderOffline() {
+    Synthesizer &synthesizer = m_simulator->synthesizer();
+
+    // Render everything the frame produced; audio generated during warmup
+    // is discarded
+    while (synthesizer.renderAudio() > 0) {
+        int samples;
+        while ((samples = m_simulator->readAudioOutput(m_audioScratchSize, m_audioScratch)) > 0) {
+            if (m_recordAudio) {
+                m_waveWriter.write(m_audioScratch, samples);
+            }
+        }
+    }
+}
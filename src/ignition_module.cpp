@@ -3,6 +3,7 @@
 #include "../include/utilities.h"
 #include "../include/constants.h"
 #include "../include/units.h"
+#include "../include/simulation_snapshot.h"
 
 #include <cmath>
 
@@ -114,3 +115,17 @@ double IgnitionModule::getTimingAdvance() {
 IgnitionModule::SparkPlug *IgnitionModule::getPlug(int i) {
     return &m_plugs[((i % m_cylinderCount) + m_cylinderCount) % m_cylinderCount];
 }
+
+void IgnitionModule::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->writeArray(m_plugs, m_cylinderCount);
+    snapshot->write(m_lastCrankshaftAngle);
+    snapshot->write(m_revLimitTimer);
+    snapshot->write(m_enabled);
+}
+
+void IgnitionModule::loadState(SimulationSnapshot *snapshot) {
+    snapshot->readArray(m_plugs, m_cylinderCount);
+    snapshot->read(&m_lastCrankshaftAngle);
+    snapshot->read(&m_revLimitTimer);
+    snapshot->read(&m_enabled);
+}
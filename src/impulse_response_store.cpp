@@ -0,0 +1,293 @@
+#include "../include/impulse_response_store.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    uint32_t readU32(const uint8_t *data) {
+        return (uint32_t)data[0]
+            | ((uint32_t)data[1] << 8)
+            | ((uint32_t)data[2] << 16)
+            | ((uint32_t)data[3] << 24);
+    }
+
+    int16_t readS16(const uint8_t *data) {
+        return (int16_t)(uint16_t)(data[0] | (data[1] << 8));
+    }
+
+    // FNV-1a; unlike std::hash the result is the same for every build, so
+    // sidecars written by one build are found by the next
+    uint64_t hashString(const std::string &s) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (const char c : s) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001B3ull;
+        }
+
+        return hash;
+    }
+
+    // Finds the first channel of the sample data in a mapped 16-bit PCM WAV
+    // file without copying it
+    bool findSamples(
+        const uint8_t *data,
+        size_t size,
+        const uint8_t **samples,
+        size_t *stride,
+        size_t *frameCount)
+    {
+        if (size < 12) return false;
+        if (std::memcmp(data, "RIFF", 4) != 0) return false;
+        if (std::memcmp(data + 8, "WAVE", 4) != 0) return false;
+
+        size_t channels = 0;
+        size_t offset = 12;
+        while (size - offset >= 8) {
+            const uint8_t *chunk = data + offset;
+            const size_t chunkSize = std::min<size_t>(readU32(chunk + 4), size - offset - 8);
+
+            if (std::memcmp(chunk, "fmt ", 4) == 0) {
+                if (chunkSize < 16) return false;
+
+                const uint32_t formatTag = readU32(chunk + 8) & 0xFFFF;
+                const uint32_t bitsPerSample = readU32(chunk + 22) & 0xFFFF;
+                channels = readU32(chunk + 10) & 0xFFFF;
+
+                if (formatTag != 1 || bitsPerSample != 16 || channels < 1) return false;
+            }
+            else if (std::memcmp(chunk, "data", 4) == 0) {
+                if (channels == 0) return false;
+
+                *samples = chunk + 8;
+                *stride = 2 * channels;
+                *frameCount = chunkSize / *stride;
+                return true;
+            }
+
+            offset += 8 + chunkSize + (chunkSize & 1);
+        }
+
+        return false;
+    }
+}
+
+ImpulseResponseStore::ImpulseResponseStore() {
+    /* void */
+}
+
+ImpulseResponseStore::~ImpulseResponseStore() {
+    destroy();
+}
+
+const ConvolutionFilter::Kernel *ImpulseResponseStore::load(const std::string &filename) {
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    auto it = m_entries.find(filename);
+    if (it != m_entries.end()) {
+        return &it->second->kernel;
+    }
+
+    SourceStamp stamp;
+    const bool useSidecar = !m_cacheDirectory.empty() && getSourceStamp(filename, &stamp);
+
+    Entry *entry = new Entry;
+    if (!useSidecar || !readSidecar(filename, stamp, entry)) {
+        if (!build(filename, entry)) {
+            delete entry;
+            return nullptr;
+        }
+
+        // Failing to write the sidecar only means the next run has to
+        // build the response again
+        if (useSidecar) {
+            writeSidecar(filename, stamp, *entry);
+        }
+    }
+
+    m_entries[filename] = entry;
+    return &entry->kernel;
+}
+
+void ImpulseResponseStore::destroy() {
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    for (auto &entry : m_entries) {
+        delete entry.second;
+    }
+
+    m_entries.clear();
+}
+
+int ImpulseResponseStore::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(m_lock);
+    return static_cast<int>(m_entries.size());
+}
+
+std::string ImpulseResponseStore::getSidecarPath(const std::string &filename) const {
+    if (m_cacheDirectory.empty()) return std::string();
+
+    std::error_code error;
+    std::filesystem::path source = std::filesystem::absolute(filename, error);
+    if (error) source = filename;
+
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+        static_cast<unsigned long long>(hashString(source.lexically_normal().string())));
+
+    const std::string name = source.stem().string() + "-" + hash + ".irc";
+    return (std::filesystem::path(m_cacheDirectory) / name).string();
+}
+
+bool ImpulseResponseStore::getSourceStamp(const std::string &filename, SourceStamp *stamp) {
+    std::error_code error;
+    const uintmax_t size = std::filesystem::file_size(filename, error);
+    if (error) return false;
+
+    const auto time = std::filesystem::last_write_time(filename, error);
+    if (error) return false;
+
+    stamp->size = static_cast<uint64_t>(size);
+    stamp->time = static_cast<int64_t>(time.time_since_epoch().count());
+
+    return true;
+}
+
+bool ImpulseResponseStore::readSidecar(
+    const std::string &filename,
+    const SourceStamp &stamp,
+    Entry *entry)
+{
+    MappedFile &sidecar = entry->sidecar;
+    if (!sidecar.open(getSidecarPath(filename))) return false;
+
+    SidecarHeader header;
+    if (sidecar.getSize() < sizeof(SidecarHeader)) {
+        sidecar.close();
+        return false;
+    }
+
+    std::memcpy(&header, sidecar.getData(), sizeof(SidecarHeader));
+
+    const size_t partitionFloats = (size_t)header.partitionCount * ConvolutionFilter::PartitionBins;
+    const size_t expectedSize =
+        sizeof(SidecarHeader) + sizeof(float) * ((size_t)header.sampleCount + 2 * partitionFloats);
+
+    if (header.magic != SidecarMagic
+        || header.version != SidecarVersion
+        || header.partitionSize != ConvolutionFilter::PartitionSize
+        || header.sourceSize != stamp.size
+        || header.sourceTime != stamp.time
+        || header.sampleCount == 0
+        || header.sampleCount > (uint32_t)MaxSamples
+        || (int)header.partitionCount != ConvolutionFilter::getPartitionCount(header.sampleCount)
+        || sidecar.getSize() != expectedSize)
+    {
+        sidecar.close();
+        return false;
+    }
+
+    // Mappings are page aligned, so the floats after the header can be used
+    // in place
+    const float *data = reinterpret_cast<const float *>(sidecar.getData() + sizeof(SidecarHeader));
+
+    ConvolutionFilter::Kernel &kernel = entry->kernel;
+    kernel.sampleCount = (int)header.sampleCount;
+    kernel.impulseResponse = data;
+    kernel.partitions_re = data + header.sampleCount;
+    kernel.partitions_im = kernel.partitions_re + partitionFloats;
+
+    return true;
+}
+
+bool ImpulseResponseStore::writeSidecar(
+    const std::string &filename,
+    const SourceStamp &stamp,
+    const Entry &entry)
+{
+    const ConvolutionFilter::Kernel &kernel = entry.kernel;
+
+    SidecarHeader header;
+    header.magic = SidecarMagic;
+    header.version = SidecarVersion;
+    header.partitionSize = ConvolutionFilter::PartitionSize;
+    header.sampleCount = (uint32_t)kernel.sampleCount;
+    header.partitionCount = (uint32_t)ConvolutionFilter::getPartitionCount(kernel.sampleCount);
+    header.reserved = 0;
+    header.sourceSize = stamp.size;
+    header.sourceTime = stamp.time;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_cacheDirectory, error);
+    if (error) return false;
+
+    // Written under a temporary name first so that a partially written
+    // sidecar is never picked up
+    const std::string path = getSidecarPath(filename);
+    const std::string temporaryPath = path + ".tmp";
+
+    std::FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    const bool written =
+        std::fwrite(&header, sizeof(SidecarHeader), 1, file) == 1
+        && std::fwrite(entry.data.data(), sizeof(float), entry.data.size(), file) == entry.data.size();
+    const bool closed = std::fclose(file) == 0;
+
+    if (!written || !closed) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ImpulseResponseStore::build(const std::string &filename, Entry *entry) {
+    MappedFile wave;
+    if (!wave.open(filename)) return false;
+
+    const uint8_t *samples = nullptr;
+    size_t stride = 0, frameCount = 0;
+    if (!findSamples(wave.getData(), wave.getSize(), &samples, &stride, &frameCount)) return false;
+    if (frameCount == 0) return false;
+
+    size_t trimmedLength = 0;
+    for (size_t i = 0; i < frameCount; ++i) {
+        if (std::abs(readS16(samples + i * stride)) > SilenceThreshold) {
+            trimmedLength = i + 1;
+        }
+    }
+
+    // A silent response still gets one tap so that the filter is usable
+    const int sampleCount = (int)std::max<size_t>(1, std::min<size_t>(MaxSamples, trimmedLength));
+    const int partitionCount = ConvolutionFilter::getPartitionCount(sampleCount);
+    const size_t partitionFloats = (size_t)partitionCount * ConvolutionFilter::PartitionBins;
+
+    std::vector<float> &data = entry->data;
+    data.resize((size_t)sampleCount + 2 * partitionFloats);
+
+    float *taps = data.data();
+    for (int i = 0; i < sampleCount; ++i) {
+        taps[i] = (float)readS16(samples + i * stride) / INT16_MAX;
+    }
+
+    float *partitions_re = taps + sampleCount;
+    float *partitions_im = partitions_re + partitionFloats;
+    ConvolutionFilter::transformPartitions(taps, sampleCount, partitions_re, partitions_im);
+
+    ConvolutionFilter::Kernel &kernel = entry->kernel;
+    kernel.sampleCount = sampleCount;
+    kernel.impulseResponse = taps;
+    kernel.partitions_re = partitions_re;
+    kernel.partitions_im = partitions_im;
+
+    return true;
+}
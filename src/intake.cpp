@@ -1,6 +1,7 @@
 #include "../include/intake.h"
 
 #include "../include/units.h"
+#include "../include/simulation_snapshot.h"
 
 #include <cmath>
 
@@ -57,6 +58,23 @@ void Intake::destroy() {
     /* void */
 }
 
+void Intake::bindGasSystems(GasSystemStore *store) {
+    m_system.bind(store, store->allocate());
+}
+
+void Intake::unbindGasSystems() {
+    m_system.unbind();
+}
+
+double Intake::getFlowStiffness(double minPressureDifference) const {
+    const double flowAttenuation = std::cos(getThrottlePlatePosition() * constants::pi / 2);
+    return m_system.flowStiffness(
+        flowAttenuation * m_inputFlowK + m_idleFlowK,
+        units::pressure(1.0, units::atm),
+        units::celcius(25.0),
+        minPressureDifference);
+}
+
 void Intake::process(double dt) {
     const double ideal_afr = 0.8 * m_molecularAfr * 4;
     const double current_afr = (m_system.mix().p_o2 + m_system.mix().p_inert) / m_system.mix().p_fuel;
@@ -107,3 +125,17 @@ void Intake::process(double dt) {
         m_totalFuelInjected += fuelMix.p_fuel * idleCircuitFlow;
     }
 }
+
+void Intake::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_throttle);
+    snapshot->write(m_flow);
+    snapshot->write(m_flowRate);
+    snapshot->write(m_totalFuelInjected);
+}
+
+void Intake::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_throttle);
+    snapshot->read(&m_flow);
+    snapshot->read(&m_flowRate);
+    snapshot->read(&m_totalFuelInjected);
+}
@@ -1,5 +1,7 @@
 #include "../include/jitter_filter.h"
 
+#include "../include/simulation_snapshot.h"
+
 JitterFilter::JitterFilter() {
     m_history = nullptr;
     m_maxJitter = 0;
@@ -28,3 +30,23 @@ void JitterFilter::initialize(
 float JitterFilter::f(float sample) {
     return fast_f(sample);
 }
+
+void JitterFilter::process(const float *input, float *output, int samples) {
+    for (int i = 0; i < samples; ++i) {
+        output[i] = fast_f(input[i]);
+    }
+}
+
+void JitterFilter::saveState(SimulationSnapshot *snapshot) const {
+    m_noiseFilter.saveState(snapshot);
+    snapshot->writeArray(m_history, m_maxJitter);
+    snapshot->write(m_offset);
+    snapshot->write(m_generator);
+}
+
+void JitterFilter::loadState(SimulationSnapshot *snapshot) {
+    m_noiseFilter.loadState(snapshot);
+    snapshot->readArray(m_history, m_maxJitter);
+    snapshot->read(&m_offset);
+    snapshot->read(&m_generator);
+}
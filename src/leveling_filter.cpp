@@ -1,5 +1,7 @@
 #include "../include/leveling_filter.h"
 
+#include "../include/simulation_snapshot.h"
+
 #include <cmath>
 
 LevelingFilter::LevelingFilter() {
@@ -32,3 +34,19 @@ float LevelingFilter::f(float sample) {
 
     return sample * m_attenuation;
 }
+
+void LevelingFilter::process(const float *input, float *output, int samples) {
+    for (int i = 0; i < samples; ++i) {
+        output[i] = LevelingFilter::f(input[i]);
+    }
+}
+
+void LevelingFilter::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_peak);
+    snapshot->write(m_attenuation);
+}
+
+void LevelingFilter::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_peak);
+    snapshot->read(&m_attenuation);
+}
@@ -1,5 +1,7 @@
 #include "../include/low_pass_filter.h"
 
+#include "../include/simulation_snapshot.h"
+
 LowPassFilter::LowPassFilter() {
     m_y = 0;
     m_rc = 0;
@@ -13,3 +15,23 @@ LowPassFilter::~LowPassFilter() {
 float LowPassFilter::f(float sample) {
     return fast_f(sample);
 }
+
+void LowPassFilter::process(const float *input, float *output, int samples) {
+    const float alpha = m_dt / (m_rc + m_dt);
+
+    float y = m_y;
+    for (int i = 0; i < samples; ++i) {
+        y = alpha * input[i] + (1 - alpha) * y;
+        output[i] = y;
+    }
+
+    m_y = y;
+}
+
+void LowPassFilter::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_y);
+}
+
+void LowPassFilter::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_y);
+}
@@ -5,6 +5,7 @@
 #include "../include/constants.h"
 #include "../include/engine_sim_application.h"
 
+#include <iomanip>
 #include <sstream>
 
 PerformanceCluster::PerformanceCluster() {
@@ -189,7 +190,7 @@ void PerformanceCluster::update(float dt) {
 void PerformanceCluster::render() {
     Grid grid;
     grid.h_cells = 3;
-    grid.v_cells = 2;
+    grid.v_cells = SimulationProfiler::isEnabled() ? 3 : 2;
 
     constexpr float shortenAngle = (float)units::angle(1.0, units::deg);
     const double idealTimePerTimestep = (1.0 / m_filteredSimulationFrequency);
@@ -212,9 +213,43 @@ void PerformanceCluster::render() {
     m_simulationFrequencyGauge->m_bounds = grid.get(m_bounds, 2, 1);
     m_simulationFrequencyGauge->m_gauge->m_value = (float)m_simulator->getSimulationFrequency();
 
+    if (SimulationProfiler::isEnabled()) {
+        renderPhaseBreakdown(grid.get(m_bounds, 0, 2, 3, 1));
+    }
+
     UiElement::render();
 }
 
+void PerformanceCluster::renderPhaseBreakdown(const Bounds &bounds) {
+    const SimulationProfiler &profiler = m_simulator->getProfiler();
+
+    Grid grid;
+    grid.h_cells = 4;
+    grid.v_cells = SimulationProfiler::PhaseCount + 1;
+
+    const Bounds inner = bounds.inset(10.0f);
+    const float textHeight = 10.0f;
+
+    drawText("PHASE [US]", grid.get(inner, 0, 0), textHeight, Bounds::lm);
+    drawText("MIN", grid.get(inner, 1, 0), textHeight, Bounds::lm);
+    drawText("MEAN", grid.get(inner, 2, 0), textHeight, Bounds::lm);
+    drawText("P99", grid.get(inner, 3, 0), textHeight, Bounds::lm);
+
+    for (int i = 0; i < SimulationProfiler::PhaseCount; ++i) {
+        const SimulationProfiler::Phase phase = static_cast<SimulationProfiler::Phase>(i);
+        const SimulationProfiler::Statistics &stats = profiler.getStatistics(phase);
+
+        drawText(SimulationProfiler::getPhaseName(phase), grid.get(inner, 0, i + 1), textHeight, Bounds::lm);
+
+        const double values[] = { stats.min, stats.mean, stats.p99 };
+        for (int j = 0; j < 3; ++j) {
+            std::stringstream ss;
+            ss << std::setprecision(2) << std::fixed << values[j] / 1000.0;
+            drawText(ss.str(), grid.get(inner, j + 1, i + 1), textHeight, Bounds::lm);
+        }
+    }
+}
+
 void PerformanceCluster::addTimePerTimestepSample(double sample) {
     const double r = 0.95;
     m_timePerTimestep = r * m_timePerTimestep + (1 - r) * sample;
@@ -3,6 +3,7 @@
 #include "../include/connecting_rod.h"
 #include "../include/crankshaft.h"
 #include "../include/cylinder_bank.h"
+#include "../include/simulation_snapshot.h"
 
 #include <cmath>
 
@@ -10,6 +11,7 @@ Piston::Piston() {
     m_rod = nullptr;
     m_bank = nullptr;
     m_cylinderConstraint = nullptr;
+    m_cylinderWallForce = 0.0;
     m_cylinderIndex = -1;
     m_compressionHeight = 0.0;
     m_displacement = 0.0;
@@ -45,7 +47,19 @@ double Piston::relativeY() const {
     return m_body.p_y - m_bank->getY();
 }
 
+void Piston::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->writeBody(m_body);
+    snapshot->write(m_cylinderWallForce);
+}
+
+void Piston::loadState(SimulationSnapshot *snapshot) {
+    snapshot->readBody(&m_body);
+    snapshot->read(&m_cylinderWallForce);
+}
+
 double Piston::calculateCylinderWallForce() const {
+    if (m_cylinderConstraint == nullptr) return m_cylinderWallForce;
+
     return std::sqrt(
         m_cylinderConstraint->F_x[0][0] * m_cylinderConstraint->F_x[0][0]
         + m_cylinderConstraint->F_y[0][0] * m_cylinderConstraint->F_y[0][0]);
@@ -3,6 +3,7 @@
 #include "../include/constants.h"
 #include "../include/units.h"
 
+#include <algorithm>
 #include <cmath>
 #include <assert.h>
 #include <chrono>
@@ -24,6 +25,18 @@ PistonEngineSimulator::PistonEngineSimulator() {
 
     m_derivativeFilter.m_dt = 1.0;
     m_fluidSimulationSteps = 8;
+    m_batchedFlow = false;
+    m_constraintGainTimestep = -1.0;
+    m_pistonForcesLinearized = true;
+
+    m_adaptiveFluidSimulation = false;
+    m_minFluidSimulationSteps = 2;
+    m_maxFluidSimulationSteps = 16;
+    m_fluidPressureTolerance = units::pressure(0.5, units::kPa);
+
+    m_lastFluidSimulationSteps = 0;
+    m_totalFluidSimulationSteps = 0;
+    m_fluidSimulationStepSamples = 0;
 }
 
 PistonEngineSimulator::~PistonEngineSimulator() {
@@ -33,7 +46,6 @@ PistonEngineSimulator::~PistonEngineSimulator() {
     assert(m_crankshaftFrictionConstraints == nullptr);
     assert(m_exhaustFlowStagingBuffer == nullptr);
     assert(m_delayFilters == nullptr);
-    assert(m_antialiasingFilters == nullptr);
 }
 
 void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Transmission *transmission) {
@@ -56,8 +68,14 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
     m_crankshaftLinks = new atg_scs::ClutchConstraint[crankCount - 1];
     m_delayFilters = new DelayFilter[cylinderCount];
 
-    const double ks = 5000;
-    const double kd = 10;
+    // In reduced coordinates only the output shaft is simulated. The other
+    // crankshafts turn with it, so their inertia and friction are carried by
+    // it as well.
+    const bool reduced = getSystemType() == SystemType::ReducedCoordinate;
+    double totalFrictionTorque = 0.0;
+    for (int i = 0; i < crankCount; ++i) {
+        totalFrictionTorque += m_engine->getCrankshaft(i)->getFrictionTorque();
+    }
 
     for (int i = 0; i < crankCount; ++i) {
         Crankshaft *outputShaft = m_engine->getCrankshaft(0);
@@ -68,8 +86,6 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
             crankshaft->getPosX(),
             crankshaft->getPosY());
         m_crankConstraints[i].setLocalPosition(0.0, 0.0);
-        m_crankConstraints[i].m_kd = kd;
-        m_crankConstraints[i].m_ks = ks;
 
         crankshaft->m_body.p_x = crankshaft->getPosX();
         crankshaft->m_body.p_y = crankshaft->getPosY();
@@ -82,6 +98,18 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
         m_crankshaftFrictionConstraints[i].m_maxTorque = crankshaft->getFrictionTorque();
         m_crankshaftFrictionConstraints[i].setBody(&m_engine->getCrankshaft(i)->m_body);
 
+        if (reduced) {
+            if (crankshaft == outputShaft) {
+                m_crankshaftFrictionConstraints[i].m_minTorque = -totalFrictionTorque;
+                m_crankshaftFrictionConstraints[i].m_maxTorque = totalFrictionTorque;
+
+                m_system->addRigidBody(&crankshaft->m_body);
+                m_system->addConstraint(&m_crankshaftFrictionConstraints[i]);
+            }
+
+            continue;
+        }
+
         m_system->addRigidBody(&m_engine->getCrankshaft(i)->m_body);
         m_system->addConstraint(&m_crankConstraints[i]);
         m_system->addConstraint(&m_crankshaftFrictionConstraints[i]);
@@ -121,8 +149,6 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
         m_cylinderWallConstraints[i].m_local_y = piston->getWristPinLocation();
         m_cylinderWallConstraints[i].m_p0_x = bank->getX();
         m_cylinderWallConstraints[i].m_p0_y = bank->getY();
-        m_cylinderWallConstraints[i].m_ks = ks;
-        m_cylinderWallConstraints[i].m_kd = kd;
 
         piston->setCylinderConstraint(&m_cylinderWallConstraints[i]);
 
@@ -131,8 +157,6 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
         m_linkConstraints[i * 2 + 0]
             .setLocalPosition1(0.0, connectingRod->getLittleEndLocal());
         m_linkConstraints[i * 2 + 0].setLocalPosition2(0.0, piston->getWristPinLocation());
-        m_linkConstraints[i * 2 + 0].m_ks = ks;
-        m_linkConstraints[i * 2 + 0].m_kd = kd;
 
         double journal_x = 0.0, journal_y = 0.0;
         if (connectingRod->getMasterRod() == nullptr) {
@@ -156,8 +180,6 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
             .setLocalPosition1(0.0, connectingRod->getBigEndLocal());
         m_linkConstraints[i * 2 + 1]
             .setLocalPosition2(journal_x, journal_y);
-        m_linkConstraints[i * 2 + 1].m_ks = ks;
-        m_linkConstraints[i * 2 + 0].m_kd = kd;
 
         piston->m_body.m = piston->getMass();
         piston->m_body.I = 1.0;
@@ -165,12 +187,25 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
         connectingRod->m_body.m = connectingRod->getMass();
         connectingRod->m_body.I = connectingRod->getMomentOfInertia();
 
+        if (reduced) {
+            piston->setCylinderConstraint(nullptr);
+            continue;
+        }
+
         m_system->addRigidBody(&piston->m_body);
         m_system->addRigidBody(&connectingRod->m_body);
         m_system->addConstraint(&m_linkConstraints[i * 2 + 0]);
         m_system->addConstraint(&m_linkConstraints[i * 2 + 1]);
         m_system->addConstraint(&m_cylinderWallConstraints[i]);
-        m_system->addForceGenerator(m_engine->getChamber(i));
+    }
+
+    // All piston forces are applied in one pass rather than by each chamber
+    if (reduced) {
+        m_system->addForceGenerator(&m_crankSlider);
+    }
+    else {
+        m_pistonForces.initialize(m_engine);
+        m_system->addForceGenerator(&m_pistonForces);
     }
 
     m_dyno.connectCrankshaft(m_engine->getOutputCrankshaft());
@@ -181,10 +216,219 @@ void PistonEngineSimulator::loadSimulation(Engine *engine, Vehicle *vehicle, Tra
     m_starterMotor.m_rotationSpeed = -m_engine->getStarterSpeed();
     m_system->addConstraint(&m_starterMotor);
 
+    m_constraintGainTimestep = -1.0;
+    updateConstraintGains(0.0);
+    m_pistonForcesLinearized = true;
+
+    bindGasSystems();
+    seedChambers();
+    partitionFluidSystems();
     placeAndInitialize();
     initializeSynthesizer();
 }
 
+void PistonEngineSimulator::bindGasSystems() {
+    const int cylinderCount = m_engine->getCylinderCount();
+    const int intakeCount = m_engine->getIntakeCount();
+    const int exhaustCount = m_engine->getExhaustSystemCount();
+
+    // Shared volumes come first, followed by the runner/cylinder/runner
+    // triplet of each chamber so that a chamber's state is contiguous
+    m_gasSystems.initialize(
+        intakeCount + exhaustCount + 3 * cylinderCount,
+        4 * cylinderCount);
+
+    for (int i = 0; i < intakeCount; ++i) {
+        m_engine->getIntake(i)->bindGasSystems(&m_gasSystems);
+    }
+
+    for (int i = 0; i < exhaustCount; ++i) {
+        m_engine->getExhaustSystem(i)->bindGasSystems(&m_gasSystems);
+    }
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        m_engine->getChamber(i)->bindGasSystems(&m_gasSystems);
+    }
+}
+
+void PistonEngineSimulator::setRandomSeed(uint64_t seed) {
+    Simulator::setRandomSeed(seed);
+
+    if (m_engine != nullptr) {
+        seedChambers();
+    }
+}
+
+void PistonEngineSimulator::seedChambers() {
+    const int cylinderCount = m_engine->getCylinderCount();
+    for (int i = 0; i < cylinderCount; ++i) {
+        m_engine->getChamber(i)->seedRandom(getRandomSeed(), i);
+    }
+}
+
+void PistonEngineSimulator::partitionFluidSystems() {
+    const int cylinderCount = m_engine->getCylinderCount();
+    const int intakeCount = m_engine->getIntakeCount();
+    const int exhaustCount = m_engine->getExhaustSystemCount();
+
+    // Intakes and exhaust systems are nodes of a graph in which each chamber
+    // is an edge joining its intake to its exhaust system
+    std::vector<int> parent(intakeCount + exhaustCount);
+    for (int i = 0; i < intakeCount + exhaustCount; ++i) {
+        parent[i] = i;
+    }
+
+    auto find = [&parent](int node) {
+        while (parent[node] != node) {
+            node = parent[node] = parent[parent[node]];
+        }
+
+        return node;
+    };
+
+    auto intakeNode = [this](int cylinder) {
+        const CombustionChamber *chamber = m_engine->getChamber(cylinder);
+        return static_cast<int>(
+            chamber->getCylinderHead()->getIntake(chamber->getPiston()->getCylinderIndex()) - m_engine->getIntake(0));
+    };
+
+    auto exhaustNode = [this, intakeCount](int cylinder) {
+        const CombustionChamber *chamber = m_engine->getChamber(cylinder);
+        return intakeCount + static_cast<int>(
+            chamber->getCylinderHead()->getExhaustSystem(chamber->getPiston()->getCylinderIndex()) - m_engine->getExhaustSystem(0));
+    };
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        const int a = find(intakeNode(i));
+        const int b = find(exhaustNode(i));
+        if (a < b) parent[b] = a;
+        else if (b < a) parent[a] = b;
+    }
+
+    // Partitions are numbered in order of first appearance and list their
+    // members in ascending order, so the layout does not depend on the
+    // thread count
+    std::vector<int> partitionIndex(intakeCount + exhaustCount, -1);
+    m_fluidPartitions.clear();
+
+    auto partitionOf = [&](int node) -> FluidPartition & {
+        const int root = find(node);
+        if (partitionIndex[root] == -1) {
+            partitionIndex[root] = static_cast<int>(m_fluidPartitions.size());
+            m_fluidPartitions.push_back(FluidPartition());
+        }
+
+        return m_fluidPartitions[partitionIndex[root]];
+    };
+
+    for (int i = 0; i < cylinderCount; ++i) {
+        partitionOf(intakeNode(i)).chambers.push_back(i);
+    }
+
+    for (int i = 0; i < intakeCount; ++i) {
+        partitionOf(i).intakes.push_back(i);
+    }
+
+    for (int i = 0; i < exhaustCount; ++i) {
+        partitionOf(intakeCount + i).exhaustSystems.push_back(i);
+    }
+
+    for (FluidPartition &partition : m_fluidPartitions) {
+        partition.flowSchedule.initialize(&m_gasSystems);
+    }
+}
+
+void PistonEngineSimulator::setFluidSimulationThreadCount(int threads) {
+    m_fluidWorkers.initialize(threads - 1);
+}
+
+void PistonEngineSimulator::setFluidSimulationStepRange(int minSteps, int maxSteps) {
+    m_minFluidSimulationSteps = std::max(minSteps, 1);
+    m_maxFluidSimulationSteps = std::max(maxSteps, m_minFluidSimulationSteps);
+}
+
+double PistonEngineSimulator::getAverageFluidSimulationSteps() const {
+    return (m_fluidSimulationStepSamples > 0)
+        ? static_cast<double>(m_totalFluidSimulationSteps) / m_fluidSimulationStepSamples
+        : 0.0;
+}
+
+void PistonEngineSimulator::resetFluidSimulationStatistics() {
+    m_totalFluidSimulationSteps = 0;
+    m_fluidSimulationStepSamples = 0;
+}
+
+int PistonEngineSimulator::chooseFluidSimulationSteps(double dt) {
+    if (!m_adaptiveFluidSimulation) return m_fluidSimulationSteps;
+
+    double stiffness = 0.0;
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        stiffness = std::fmax(
+            stiffness, m_engine->getChamber(i)->getFlowStiffness(m_fluidPressureTolerance));
+    }
+
+    for (int i = 0; i < m_engine->getIntakeCount(); ++i) {
+        stiffness = std::fmax(
+            stiffness, m_engine->getIntake(i)->getFlowStiffness(m_fluidPressureTolerance));
+    }
+
+    for (int i = 0; i < m_engine->getExhaustSystemCount(); ++i) {
+        stiffness = std::fmax(
+            stiffness, m_engine->getExhaustSystem(i)->getFlowStiffness(m_fluidPressureTolerance));
+    }
+
+    const double steps = std::ceil(dt * stiffness / AdaptiveFluidStepFraction);
+    if (!(steps < m_maxFluidSimulationSteps)) return m_maxFluidSimulationSteps;
+    else return std::max(static_cast<int>(steps), m_minFluidSimulationSteps);
+}
+
+void PistonEngineSimulator::simulateFluidPartition(int partition, double dt, int steps) {
+    FluidPartition &p = m_fluidPartitions[partition];
+    for (int i = 0; i < steps; ++i) {
+        for (int exhaust : p.exhaustSystems) {
+            m_engine->getExhaustSystem(exhaust)->process(dt);
+        }
+
+        for (int intake : p.intakes) {
+            m_engine->getIntake(intake)->process(dt);
+            m_engine->getIntake(intake)->m_flowRate += m_engine->getIntake(intake)->m_flow;
+        }
+
+        if (m_batchedFlow) {
+            p.flowSchedule.clear();
+            for (int chamber : p.chambers) {
+                m_engine->getChamber(chamber)->startFlow(dt);
+                m_engine->getChamber(chamber)->scheduleFlow(&p.flowSchedule);
+            }
+
+            p.flowSchedule.run(dt);
+
+            for (int chamber : p.chambers) {
+                m_engine->getChamber(chamber)->endFlow(dt);
+            }
+        }
+        else {
+            for (int chamber : p.chambers) {
+                m_engine->getChamber(chamber)->flow(dt);
+            }
+        }
+    }
+}
+
+void PistonEngineSimulator::unbindGasSystems() {
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_engine->getChamber(i)->unbindGasSystems();
+    }
+
+    for (int i = 0; i < m_engine->getIntakeCount(); ++i) {
+        m_engine->getIntake(i)->unbindGasSystems();
+    }
+
+    for (int i = 0; i < m_engine->getExhaustSystemCount(); ++i) {
+        m_engine->getExhaustSystem(i)->unbindGasSystems();
+    }
+}
+
 double PistonEngineSimulator::getAverageOutputSignal() const {
     double sum = 0.0;
     for (int i = 0; i < m_engine->getExhaustSystemCount(); ++i) {
@@ -194,18 +438,50 @@ double PistonEngineSimulator::getAverageOutputSignal() const {
     return sum / m_engine->getExhaustSystemCount();
 }
 
+double PistonEngineSimulator::getMaxJointError() const {
+    double maxError = 0.0;
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        const Piston *piston = m_engine->getPiston(i);
+        const ConnectingRod *rod = piston->getRod();
+
+        double pin_x, pin_y, littleEnd_x, littleEnd_y;
+        piston->m_body.localToWorld(0.0, piston->getWristPinLocation(), &pin_x, &pin_y);
+        rod->m_body.localToWorld(0.0, rod->getLittleEndLocal(), &littleEnd_x, &littleEnd_y);
+
+        double journal_x, journal_y, bigEnd_x, bigEnd_y;
+        if (rod->getMasterRod() != nullptr) {
+            rod->getMasterRod()->getRodJournalPositionGlobal(rod->getJournal(), &journal_x, &journal_y);
+        }
+        else {
+            rod->getCrankshaft()->getRodJournalPositionGlobal(rod->getJournal(), &journal_x, &journal_y);
+        }
+
+        rod->m_body.localToWorld(0.0, rod->getBigEndLocal(), &bigEnd_x, &bigEnd_y);
+
+        maxError = std::fmax(maxError, std::hypot(pin_x - littleEnd_x, pin_y - littleEnd_y));
+        maxError = std::fmax(maxError, std::hypot(journal_x - bigEnd_x, journal_y - bigEnd_y));
+    }
+
+    return maxError;
+}
+
 void PistonEngineSimulator::placeAndInitialize() {
     const int cylinderCount = m_engine->getCylinderCount();
-    for (int i = 0; i < cylinderCount; ++i) {
-        ConnectingRod *rod = m_engine->getConnectingRod(i);
+    if (getSystemType() == SystemType::ReducedCoordinate) {
+        m_crankSlider.initialize(m_engine);
+    }
+    else {
+        for (int i = 0; i < cylinderCount; ++i) {
+            ConnectingRod *rod = m_engine->getConnectingRod(i);
 
-        if (rod->getRodJournalCount() != 0) {
-            placeCylinder(i);
+            if (rod->getRodJournalCount() != 0) {
+                placeCylinder(i);
+            }
         }
-    }
 
-    for (int i = 0; i < cylinderCount; ++i) {
-        placeCylinder(i);
+        for (int i = 0; i < cylinderCount; ++i) {
+            placeCylinder(i);
+        }
     }
 
     for (int i = 0; i < cylinderCount; ++i) {
@@ -223,7 +499,7 @@ void PistonEngineSimulator::placeAndInitialize() {
             + exhaust->getLength();
         const double speedOfSound = 343.0 * units::m / units::sec;
         const double delay = exhaustLength / speedOfSound;
-        m_delayFilters[i].initialize(delay, 10000.0);
+        m_delayFilters[i].initialize(delay, 1 / getTimestep());
     }
 
     m_engine->getIgnitionModule()->reset();
@@ -231,6 +507,18 @@ void PistonEngineSimulator::placeAndInitialize() {
     m_exhaustFlowStagingBuffer = new double[m_engine->getExhaustSystemCount()];
 }
 
+void PistonEngineSimulator::startFrame(double dt) {
+    Simulator::startFrame(dt);
+
+    // The delay filters take one sample per simulation step, so they follow
+    // changes to the simulation frequency
+    if (m_engine != nullptr) {
+        for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+            m_delayFilters[i].setSampleRate(1 / getTimestep());
+        }
+    }
+}
+
 void PistonEngineSimulator::placeCylinder(int i) {
     ConnectingRod *rod = m_engine->getConnectingRod(i);
     Piston *piston = m_engine->getPiston(i);
@@ -280,46 +568,153 @@ void PistonEngineSimulator::placeCylinder(int i) {
     piston->m_body.theta = bank->getAngle() + constants::pi;
 }
 
-void PistonEngineSimulator::simulateStep_() {
-    const double timestep = getTimestep();
-    IgnitionModule *im = m_engine->getIgnitionModule();
-    im->update(timestep);
+void PistonEngineSimulator::updateConstraintGains(double dt) {
+    if (dt == m_constraintGainTimestep) return;
+    m_constraintGainTimestep = dt;
+
+    // Evaluating the correcting force at the end of the step turns the
+    // spring and damper into ks / d and (kd + dt * ks) / d
+    const double d = 1 + dt * ConstraintDamping + dt * dt * ConstraintStiffness;
+    const double ks = ConstraintStiffness / d;
+    const double kd = (ConstraintDamping + dt * ConstraintStiffness) / d;
+
+    for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
+        m_crankConstraints[i].m_ks = ks;
+        m_crankConstraints[i].m_kd = kd;
+    }
+
+    for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
+        m_cylinderWallConstraints[i].m_ks = ks;
+        m_cylinderWallConstraints[i].m_kd = kd;
+        m_linkConstraints[i * 2 + 0].m_ks = ks;
+        m_linkConstraints[i * 2 + 0].m_kd = kd;
+
+        // The rod-to-crank link has always kept the solver's default
+        // damping; every engine is tuned against that
+        m_linkConstraints[i * 2 + 1].m_ks = ks;
+    }
+}
+
+void PistonEngineSimulator::linearizePistonForces(double dt) {
+    // With F(s + dt * v') ~ F - k * dt * v' and F(v') ~ F - c * (v' - v), the
+    // end-of-step force is the start-of-step force with extra damping
+    // dt * k, acting on a piston that is heavier by dt * (c + dt * k). The
+    // rigid body has a single mass, so the extra mass also resists the
+    // sideways motion that the cylinder wall constraint allows.
+    if (dt == 0 && !m_pistonForcesLinearized) return;
+    m_pistonForcesLinearized = (dt > 0);
 
     const int cylinderCount = m_engine->getCylinderCount();
     for (int i = 0; i < cylinderCount; ++i) {
-        if (im->getIgnitionEvent(i)) {
-            m_engine->getChamber(i)->ignite();
+        CombustionChamber *chamber = m_engine->getChamber(i);
+        Piston *piston = chamber->getPiston();
+
+        double k = 0.0, c = 0.0;
+        if (dt > 0) {
+            k = chamber->calculatePressureStiffness();
+            c = chamber->calculateFrictionDamping(chamber->pistonSpeed());
         }
 
-        m_engine->getChamber(i)->update(timestep);
+        piston->m_body.m = piston->getMass() + dt * (c + dt * k);
+        chamber->setImplicitDamping(dt * k);
     }
+}
 
-    for (int i = 0; i < cylinderCount; ++i) {
-        m_engine->getChamber(i)->resetLastTimestepExhaustFlow();
-        m_engine->getChamber(i)->resetLastTimestepIntakeFlow();
+void PistonEngineSimulator::processRigidBodies(double dt) {
+    const double implicitTimestep =
+        (getIntegrationMethod() == IntegrationMethod::LinearlyImplicitEuler)
+            ? dt
+            : 0.0;
+
+    if (getSystemType() != SystemType::ReducedCoordinate) {
+        updateConstraintGains(implicitTimestep);
+        linearizePistonForces(implicitTimestep);
+        m_pistonForces.prepare();
+        Simulator::processRigidBodies(dt);
+        return;
     }
 
-    const int exhaustSystemCount = m_engine->getExhaustSystemCount();
-    const int intakeCount = m_engine->getIntakeCount();
-    const double fluidTimestep = timestep / m_fluidSimulationSteps;
-    for (int i = 0; i < m_fluidSimulationSteps; ++i) {
-        for (int j = 0; j < exhaustSystemCount; ++j) {
-            m_engine->getExhaustSystem(j)->process(fluidTimestep);
-        }
+    m_crankSlider.prepare(implicitTimestep);
+    m_system->process(dt, 1);
+    m_crankSlider.update(dt);
+}
+
+void PistonEngineSimulator::simulateStep_() {
+    const double timestep = getTimestep();
+    IgnitionModule *im = m_engine->getIgnitionModule();
+    const int cylinderCount = m_engine->getCylinderCount();
+
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(&m_profiler, Combustion);
+        im->update(timestep);
 
-        for (int j = 0; j < intakeCount; ++j) {
-            m_engine->getIntake(j)->process(fluidTimestep);
-            m_engine->getIntake(j)->m_flowRate += m_engine->getIntake(j)->m_flow;
+        for (int i = 0; i < cylinderCount; ++i) {
+            if (im->getIgnitionEvent(i)) {
+                m_engine->getChamber(i)->ignite();
+            }
+
+            m_engine->getChamber(i)->update(timestep);
         }
 
-        for (int j = 0; j < cylinderCount; ++j) {
-            m_engine->getChamber(j)->flow(fluidTimestep);
+        for (int i = 0; i < cylinderCount; ++i) {
+            m_engine->getChamber(i)->resetLastTimestepExhaustFlow();
+            m_engine->getChamber(i)->resetLastTimestepIntakeFlow();
         }
     }
 
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(&m_profiler, FluidSimulation);
+        const int fluidSteps = chooseFluidSimulationSteps(timestep);
+        const double fluidTimestep = timestep / fluidSteps;
+        m_fluidWorkers.run(
+            getFluidPartitionCount(),
+            [this, fluidTimestep, fluidSteps](int partition) {
+                simulateFluidPartition(partition, fluidTimestep, fluidSteps);
+            });
+
+        m_lastFluidSimulationSteps = fluidSteps;
+        m_totalFluidSimulationSteps += fluidSteps;
+        ++m_fluidSimulationStepSamples;
+    }
+
     im->resetIgnitionEvents();
 }
 
+void PistonEngineSimulator::saveState(SimulationSnapshot *snapshot) const {
+    Simulator::saveState(snapshot);
+
+    snapshot->writeBody(m_vehicleMass);
+    m_gasSystems.saveState(snapshot);
+
+    // Only used in reduced coordinates, but always written so that the
+    // layout doesn't depend on the system type
+    m_crankSlider.saveState(snapshot);
+
+    const int cylinderCount = m_engine->getCylinderCount();
+    snapshot->writeCount(cylinderCount);
+    for (int i = 0; i < cylinderCount; ++i) {
+        m_delayFilters[i].saveState(snapshot);
+    }
+}
+
+void PistonEngineSimulator::loadState(SimulationSnapshot *snapshot) {
+    Simulator::loadState(snapshot);
+
+    snapshot->readBody(&m_vehicleMass);
+    m_gasSystems.loadState(snapshot);
+    m_crankSlider.loadState(snapshot);
+
+    const int cylinderCount = m_engine->getCylinderCount();
+    snapshot->expectCount(cylinderCount);
+    for (int i = 0; i < cylinderCount; ++i) {
+        m_delayFilters[i].loadState(snapshot);
+    }
+
+    // The restored piston masses may include the mass added by a
+    // linearization
+    m_pistonForcesLinearized = true;
+}
+
 double PistonEngineSimulator::getTotalExhaustFlow() const {
     double totalFlow = 0.0;
     for (int i = 0; i < m_engine->getCylinderCount(); ++i) {
@@ -345,11 +740,19 @@ void PistonEngineSimulator::endFrame() {
 
 void PistonEngineSimulator::destroy() {
     if (m_system != nullptr) m_system->reset();
+    if (m_engine != nullptr && m_gasSystems.getCapacity() > 0) unbindGasSystems();
+
+    m_gasSystems.destroy();
+    m_fluidWorkers.destroy();
+    m_fluidPartitions.clear();
+    m_crankSlider.destroy();
+    m_pistonForces.destroy();
 
     if (m_crankConstraints != nullptr) delete[] m_crankConstraints;
     if (m_cylinderWallConstraints != nullptr) delete[] m_cylinderWallConstraints;
     if (m_linkConstraints != nullptr) delete[] m_linkConstraints;
     if (m_crankshaftFrictionConstraints != nullptr) delete[] m_crankshaftFrictionConstraints;
+    if (m_crankshaftLinks != nullptr) delete[] m_crankshaftLinks;
     if (m_exhaustFlowStagingBuffer != nullptr) delete[] m_exhaustFlowStagingBuffer;
     if (m_system != nullptr) delete m_system;
     if (m_delayFilters != nullptr) delete[] m_delayFilters;
@@ -358,6 +761,7 @@ void PistonEngineSimulator::destroy() {
     m_cylinderWallConstraints = nullptr;
     m_linkConstraints = nullptr;
     m_crankshaftFrictionConstraints = nullptr;
+    m_crankshaftLinks = nullptr;
     m_exhaustFlowStagingBuffer = nullptr;
     m_system = nullptr;
 
@@ -365,6 +769,8 @@ void PistonEngineSimulator::destroy() {
     m_transmission = nullptr;
     m_engine = nullptr;
     m_delayFilters = nullptr;
+
+    Simulator::destroy();
 }
 
 void PistonEngineSimulator::writeToSynthesizer() {
@@ -376,8 +782,6 @@ void PistonEngineSimulator::writeToSynthesizer() {
     const double attenuation = std::min(std::abs(filteredEngineSpeed()), 40.0) / 40.0;
     const double attenuation_3 = attenuation * attenuation * attenuation;
 
-    static double lastValveLift[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-
     const double timestep = getTimestep();
     const int cylinderCount = m_engine->getCylinderCount();
     for (int i = 0; i < cylinderCount; ++i) {
@@ -397,8 +801,6 @@ void PistonEngineSimulator::writeToSynthesizer() {
                 + 0.1 * chamber->m_exhaustRunnerAndPrimary.dynamicPressure(1.0, 0.0)
                 + 0.1 * chamber->m_exhaustRunnerAndPrimary.dynamicPressure(-1.0, 0.0));
 
-        lastValveLift[i] = head->exhaustValveLift(piston->getCylinderIndex());
-
         const double delayedExhaustPulse =
             m_delayFilters[i].fast_f(exhaustFlow);
 
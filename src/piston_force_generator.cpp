@@ -0,0 +1,140 @@
+#include "../include/piston_force_generator.h"
+
+#include "../include/engine.h"
+#include "../include/constants.h"
+#include "../include/fast_math.h"
+
+#include <assert.h>
+#include <cmath>
+
+PistonForceGenerator::PistonForceGenerator() {
+    m_engine = nullptr;
+    m_cylinderCount = 0;
+}
+
+PistonForceGenerator::~PistonForceGenerator() {
+    /* void */
+}
+
+void PistonForceGenerator::initialize(Engine *engine) {
+    m_engine = engine;
+    m_cylinderCount = engine->getCylinderCount();
+
+    const int n = m_cylinderCount;
+    m_bodies.assign(n, 0);
+    m_dx.resize(n);
+    m_dy.resize(n);
+    m_area.resize(n);
+    m_crankcasePressure.resize(n);
+    m_frictionCoeff.resize(n);
+    m_breakawayFriction.resize(n);
+    m_inverseStribeckVelocity.resize(n);
+    m_inverseCoulombVelocity.resize(n);
+    m_viscousFriction.resize(n);
+    m_pressure.assign(n, 0.0);
+    m_wallForce.assign(n, 0.0);
+    m_implicitDamping.assign(n, 0.0);
+    m_speed.assign(n, 0.0);
+    m_force.assign(n, 0.0);
+
+    for (int i = 0; i < n; ++i) {
+        const CombustionChamber *chamber = engine->getChamber(i);
+        const CylinderBank *bank = chamber->getCylinderHead()->getCylinderBank();
+        const CombustionChamber::FrictionModelParams &friction = chamber->m_frictionModel;
+
+        m_dx[i] = bank->getDx();
+        m_dy[i] = bank->getDy();
+        m_area[i] = bank->boreSurfaceArea();
+        m_crankcasePressure[i] = chamber->getCrankcasePressure();
+
+        m_frictionCoeff[i] = friction.frictionCoeff;
+        m_breakawayFriction[i] = friction.breakawayFriction;
+        m_inverseStribeckVelocity[i] =
+            1 / (friction.breakawayFrictionVelocity * constants::root_2);
+        m_inverseCoulombVelocity[i] = 10 / friction.breakawayFrictionVelocity;
+        m_viscousFriction[i] = friction.viscousFrictionCoefficient;
+    }
+}
+
+void PistonForceGenerator::destroy() {
+    m_bodies.clear();
+    m_dx.clear();
+    m_dy.clear();
+    m_area.clear();
+    m_crankcasePressure.clear();
+    m_frictionCoeff.clear();
+    m_breakawayFriction.clear();
+    m_inverseStribeckVelocity.clear();
+    m_inverseCoulombVelocity.clear();
+    m_viscousFriction.clear();
+    m_pressure.clear();
+    m_wallForce.clear();
+    m_implicitDamping.clear();
+    m_speed.clear();
+    m_force.clear();
+
+    m_engine = nullptr;
+    m_cylinderCount = 0;
+}
+
+void PistonForceGenerator::prepare() {
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        const CombustionChamber *chamber = m_engine->getChamber(i);
+        const Piston *piston = chamber->getPiston();
+
+        m_bodies[i] = piston->m_body.index;
+        m_pressure[i] = chamber->m_system.pressure();
+        m_wallForce[i] = piston->calculateCylinderWallForce();
+        m_implicitDamping[i] = chamber->getImplicitDamping();
+
+        const double force = -m_area[i] * (m_pressure[i] - m_crankcasePressure[i]);
+        if (std::isnan(force) || std::isinf(force)) {
+            assert(false);
+        }
+    }
+}
+
+void PistonForceGenerator::apply(atg_scs::SystemState *state) {
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        const int body = m_bodies[i];
+        m_speed[i] = state->v_x[body] * m_dx[i] + state->v_y[body] * m_dy[i];
+    }
+
+    calculateForces(m_speed.data(), m_force.data());
+
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        state->applyForce(
+            0.0,
+            0.0,
+            m_force[i] * m_dx[i],
+            m_force[i] * m_dy[i],
+            m_bodies[i]);
+    }
+}
+
+void PistonForceGenerator::calculateForces(const double *v_s, double *F) const {
+    constexpr double F_0_scale = constants::root_2 * constants::e;
+    constexpr double attenuationScale = 1 / CombustionChamber::FrictionAttenuationSpeed;
+
+    // Mirrors CombustionChamber::calculatePistonForce() without branches so
+    // that the loop can be vectorized
+    for (int i = 0; i < m_cylinderCount; ++i) {
+        const double v = std::abs(v_s[i]);
+        const double F_coul = m_frictionCoeff[i] * m_wallForce[i];
+
+        const double F_0 = F_0_scale * (m_breakawayFriction[i] - F_coul);
+        const double F_1 = v * m_inverseStribeckVelocity[i];
+        const double F_2 = fastExp(-F_1 * F_1) * F_1;
+        const double F_3 = F_coul * fastTanh(v * m_inverseCoulombVelocity[i]);
+        const double F_4 = m_viscousFriction[i] * v;
+
+        const double attenuation =
+            std::fmin(v, CombustionChamber::FrictionAttenuationSpeed) * attenuationScale;
+        const double friction = (F_0 * F_2 + F_3 + F_4) * attenuation;
+
+        const double pressureForce = -m_area[i] * (m_pressure[i] - m_crankcasePressure[i]);
+        const double frictionForce = (v_s[i] > 0) ? -friction : friction;
+
+        F[i] = pressureForce + frictionForce - m_implicitDamping[i] * v_s[i];
+    }
+}
@@ -0,0 +1,96 @@
+#include "../include/random_stream.h"
+
+#include "../include/simulation_snapshot.h"
+
+namespace {
+    uint64_t splitMix64(uint64_t *state) {
+        uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    inline uint32_t rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+}
+
+RandomStream::RandomStream() {
+    seed(0);
+}
+
+RandomStream::~RandomStream() {
+    /* void */
+}
+
+void RandomStream::seed(uint64_t seed, uint64_t stream) {
+    uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int i = 0; i < Lanes; ++i) {
+        const uint64_t a = splitMix64(&state);
+        const uint64_t b = splitMix64(&state);
+
+        m_s0[i] = static_cast<uint32_t>(a);
+        m_s1[i] = static_cast<uint32_t>(a >> 32);
+        m_s2[i] = static_cast<uint32_t>(b);
+        m_s3[i] = static_cast<uint32_t>(b >> 32);
+
+        // All-zero state is the one invalid xoshiro state
+        if ((m_s0[i] | m_s1[i] | m_s2[i] | m_s3[i]) == 0) m_s0[i] = 1;
+    }
+
+    m_index = Lanes;
+}
+
+void RandomStream::fillSigned(float *target, int n) {
+    int i = 0;
+    while (i < n && m_index < Lanes) {
+        target[i++] = toSigned(m_output[m_index++]);
+    }
+
+    for (; n - i >= Lanes; i += Lanes) {
+        step();
+        for (int j = 0; j < Lanes; ++j) {
+            target[i + j] = toSigned(m_output[j]);
+        }
+
+        m_index = Lanes;
+    }
+
+    while (i < n) {
+        target[i++] = uniformSigned();
+    }
+}
+
+void RandomStream::step() {
+    for (int i = 0; i < Lanes; ++i) {
+        m_output[i] = m_s0[i] + m_s3[i];
+
+        const uint32_t t = m_s1[i] << 9;
+        m_s2[i] ^= m_s0[i];
+        m_s3[i] ^= m_s1[i];
+        m_s1[i] ^= m_s2[i];
+        m_s0[i] ^= m_s3[i];
+        m_s2[i] ^= t;
+        m_s3[i] = rotl(m_s3[i], 11);
+    }
+
+    m_index = 0;
+}
+
+void RandomStream::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_s0);
+    snapshot->write(m_s1);
+    snapshot->write(m_s2);
+    snapshot->write(m_s3);
+    snapshot->write(m_output);
+    snapshot->write(m_index);
+}
+
+void RandomStream::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_s0);
+    snapshot->read(&m_s1);
+    snapshot->read(&m_s2);
+    snapshot->read(&m_s3);
+    snapshot->read(&m_output);
+    snapshot->read(&m_index);
+}
@@ -0,0 +1,61 @@
+#include "../include/simulation_profiler.h"
+
+#include <algorithm>
+
+SimulationProfiler::SimulationProfiler() {
+    for (int i = 0; i < PhaseCount; ++i) {
+        m_samples[i].resize(SampleCapacity, 0);
+        m_writeIndex[i] = 0;
+        m_sampleCount[i] = 0;
+    }
+}
+
+SimulationProfiler::~SimulationProfiler() {
+    /* void */
+}
+
+void SimulationProfiler::beginFrame() {
+    for (int i = 0; i < PhaseCount; ++i) {
+        m_writeIndex[i] = 0;
+        m_sampleCount[i] = 0;
+    }
+}
+
+void SimulationProfiler::endFrame() {
+    for (int i = 0; i < PhaseCount; ++i) {
+        std::vector<long long> &samples = m_samples[i];
+        const int n = m_sampleCount[i];
+        if (n == 0) {
+            // Keep the previous frame's statistics so that frames without
+            // any steps don't make the readout flicker
+            continue;
+        }
+
+        Statistics &stats = m_statistics[i];
+        long long total = 0, minimum = samples[0];
+        for (int j = 0; j < n; ++j) {
+            total += samples[j];
+            minimum = std::min(minimum, samples[j]);
+        }
+
+        const int p99Index = std::min(n - 1, (n * 99) / 100);
+        std::nth_element(samples.begin(), samples.begin() + p99Index, samples.begin() + n);
+
+        stats.min = static_cast<double>(minimum);
+        stats.mean = static_cast<double>(total) / n;
+        stats.p99 = static_cast<double>(samples[p99Index]);
+        stats.total = static_cast<double>(total);
+        stats.samples = n;
+    }
+}
+
+const char *SimulationProfiler::getPhaseName(Phase phase) {
+    switch (phase) {
+        case Phase::RigidBodySystem: return "RIGID BODY";
+        case Phase::EngineUpdate: return "ENGINE";
+        case Phase::Combustion: return "COMBUSTION";
+        case Phase::FluidSimulation: return "FLUID";
+        case Phase::Synthesizer: return "SYNTH";
+        default: return "";
+    }
+}
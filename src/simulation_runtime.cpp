@@ -0,0 +1,123 @@
+#include "../include/simulation_runtime.h"
+
+#include "../include/engine.h"
+#include "../include/exhaust_system.h"
+#include "../include/impulse_response.h"
+#include "../include/vehicle.h"
+#include "../include/transmission.h"
+
+#include <assert.h>
+#include <thread>
+
+SimulationRuntime::SimulationRuntime() {
+    /* void */
+}
+
+SimulationRuntime::~SimulationRuntime() {
+    assert(m_instances.empty());
+}
+
+void SimulationRuntime::initialize(const Parameters &params) {
+    int threadCount = params.threadCount;
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    }
+
+    // The calling thread also runs tasks
+    m_workers.initialize(threadCount - 1);
+    m_audioSink = params.audioSink;
+    m_impulseResponses.setCacheDirectory(params.impulseResponseCacheDirectory);
+}
+
+void SimulationRuntime::destroy() {
+    for (Instance &instance : m_instances) {
+        instance.simulator->releaseSimulation();
+        delete instance.simulator;
+
+        instance.engine->destroy();
+        delete instance.engine;
+        delete instance.vehicle;
+        delete instance.transmission;
+    }
+
+    m_instances.clear();
+    m_workers.destroy();
+    m_impulseResponses.destroy();
+}
+
+int SimulationRuntime::addInstance(
+    Engine *engine,
+    Vehicle *vehicle,
+    Transmission *transmission)
+{
+    Instance instance;
+    instance.engine = engine;
+    instance.vehicle = vehicle;
+    instance.transmission = transmission;
+    instance.simulator = engine->createSimulator(vehicle, transmission);
+
+    engine->calculateDisplacement();
+
+    Simulator *simulator = instance.simulator;
+    simulator->setSimulationFrequency(
+        static_cast<int>(engine->getSimulationFrequency()));
+
+    // Every frame runs exactly the requested time so that instances are
+    // reproducible regardless of how long they take to compute
+    simulator->setLatencyControlEnabled(false);
+    if (m_audioSink) {
+        simulator->synthesizer().setOfflineMode(true);
+    }
+
+    for (int i = 0; i < engine->getExhaustSystemCount(); ++i) {
+        ImpulseResponse *response = engine->getExhaustSystem(i)->getImpulseResponse();
+        const float volume = static_cast<float>(response->getVolume());
+
+        const ConvolutionFilter::Kernel *kernel =
+            m_impulseResponses.load(response->getFilename());
+        if (kernel != nullptr) {
+            simulator->synthesizer().initializeImpulseResponse(*kernel, volume, i);
+        }
+        else {
+            // Every channel's convolution filter must be initialized
+            const int16_t unitImpulse = INT16_MAX;
+            simulator->synthesizer().initializeImpulseResponse(&unitImpulse, 1, volume, i);
+        }
+    }
+
+    m_instances.push_back(instance);
+
+    return static_cast<int>(m_instances.size()) - 1;
+}
+
+void SimulationRuntime::step(double dt, int frames) {
+    m_workers.run(
+        static_cast<int>(m_instances.size()),
+        [this, dt, frames](int index) {
+            stepInstance(index, dt, frames);
+        });
+}
+
+void SimulationRuntime::stepInstance(int index, double dt, int frames) {
+    Simulator *simulator = m_instances[index].simulator;
+
+    int16_t samples[AudioChunkSamples];
+    for (int i = 0; i < frames; ++i) {
+        simulator->startFrame(dt);
+        while (simulator->simulateStep()) {
+            /* void */
+        }
+
+        simulator->endFrame();
+
+        if (m_audioSink) {
+            // Offline rendering needs the output drained between renders
+            while (simulator->synthesizer().renderAudio() > 0) {
+                int n;
+                while ((n = simulator->readAudioOutput(AudioChunkSamples, samples)) > 0) {
+                    m_audioSink(index, samples, n);
+                }
+            }
+        }
+    }
+}
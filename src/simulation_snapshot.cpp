@@ -0,0 +1,132 @@
+#include "../include/simulation_snapshot.h"
+
+#include <cstdio>
+
+SimulationSnapshot::SimulationSnapshot() {
+    m_readOffset = 0;
+    m_validateOnly = false;
+    m_valid = true;
+}
+
+SimulationSnapshot::~SimulationSnapshot() {
+    /* void */
+}
+
+void SimulationSnapshot::clear() {
+    m_data.clear();
+    m_readOffset = 0;
+    m_validateOnly = false;
+    m_valid = true;
+}
+
+void SimulationSnapshot::rewind(bool validateOnly) {
+    m_readOffset = 0;
+    m_validateOnly = validateOnly;
+    m_valid = true;
+}
+
+void SimulationSnapshot::write(const void *data, size_t size) {
+    const size_t offset = m_data.size();
+    m_data.resize(offset + size);
+    if (size > 0) {
+        memcpy(m_data.data() + offset, data, size);
+    }
+}
+
+void SimulationSnapshot::read(void *data, size_t size) {
+    if (!m_valid || size > m_data.size() - m_readOffset) {
+        m_valid = false;
+        return;
+    }
+
+    if (!m_validateOnly && size > 0) {
+        memcpy(data, m_data.data() + m_readOffset, size);
+    }
+
+    m_readOffset += size;
+}
+
+void SimulationSnapshot::writeHeader() {
+    writeCount(Magic);
+    writeCount(Version);
+}
+
+void SimulationSnapshot::readHeader() {
+    expectCount(Magic);
+    expectCount(Version);
+}
+
+void SimulationSnapshot::readCount(uint64_t *count) {
+    // Counts are needed to check the layout, so they are read even when
+    // validating
+    const bool validateOnly = m_validateOnly;
+    m_validateOnly = false;
+    read(count);
+    m_validateOnly = validateOnly;
+}
+
+void SimulationSnapshot::expectCount(size_t n) {
+    uint64_t count = 0;
+    readCount(&count);
+    if (count != n) {
+        m_valid = false;
+    }
+}
+
+void SimulationSnapshot::writeBody(const atg_scs::RigidBody &body) {
+    write(body.p_x);
+    write(body.p_y);
+    write(body.v_x);
+    write(body.v_y);
+    write(body.theta);
+    write(body.v_theta);
+    write(body.m);
+    write(body.I);
+}
+
+void SimulationSnapshot::readBody(atg_scs::RigidBody *body) {
+    read(&body->p_x);
+    read(&body->p_y);
+    read(&body->v_x);
+    read(&body->v_y);
+    read(&body->theta);
+    read(&body->v_theta);
+    read(&body->m);
+    read(&body->I);
+}
+
+void SimulationSnapshot::setData(const uint8_t *data, size_t size) {
+    m_data.assign(data, data + size);
+    rewind();
+}
+
+bool SimulationSnapshot::saveToFile(const std::string &filename) const {
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    const size_t written = std::fwrite(m_data.data(), 1, m_data.size(), file);
+    const bool closed = std::fclose(file) == 0;
+
+    return written == m_data.size() && closed;
+}
+
+bool SimulationSnapshot::loadFromFile(const std::string &filename) {
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr) return false;
+
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+
+    const bool error = std::ferror(file) != 0;
+    std::fclose(file);
+    if (error) return false;
+
+    m_data.swap(data);
+    rewind();
+
+    return true;
+}
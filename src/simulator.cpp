@@ -1,18 +1,31 @@
 #include "../include/simulator.h"
 
+#include <algorithm>
+
 Simulator::Simulator() {
     m_engine = nullptr;
     m_vehicle = nullptr;
     m_transmission = nullptr;
     m_system = nullptr;
+    m_constraintSolver = nullptr;
+    m_systemType = SystemType::NsvOptimized;
+    m_sleSolverType = SleSolverType::Default;
+    m_integrationMethod = IntegrationMethod::SemiImplicitEuler;
 
     m_physicsProcessingTime = 0;
 
     m_simulationSpeed = 1.0;
     m_targetSynthesizerLatency = 0.1;
+    m_latencyControlEnabled = true;
     m_simulationFrequency = 10000;
+    m_randomSeed = 0;
     m_steps = 0;
 
+    m_adaptiveFrequency = false;
+    m_crankAnglePerStep = units::angle(2.0, units::deg);
+    m_minSimulationFrequency = 5000;
+    m_maxSimulationFrequency = 50000;
+
     m_currentIteration = 0;
 
     m_filteredEngineSpeed = 0.0;
@@ -26,18 +39,31 @@ Simulator::~Simulator() {
 }
 
 void Simulator::initialize(const Parameters &params) {
-    if (params.systemType == SystemType::NsvOptimized) {
+    m_randomSeed = params.randomSeed;
+    m_systemType = params.systemType;
+    m_sleSolverType = params.sleSolverType;
+
+    if (params.systemType == SystemType::NsvOptimized
+        || params.systemType == SystemType::ReducedCoordinate)
+    {
+        if (m_sleSolverType == SleSolverType::Default) {
+            m_sleSolverType = SleSolverType::GaussSeidel;
+        }
+
         atg_scs::OptimizedNsvRigidBodySystem *system =
             new atg_scs::OptimizedNsvRigidBodySystem;
-        system->initialize(
-            new atg_scs::GaussSeidelSleSolver);
+        system->initialize(createSleSolver(m_sleSolverType));
         m_system = system;
     }
     else {
+        if (m_sleSolverType == SleSolverType::Default) {
+            m_sleSolverType = SleSolverType::GaussianElimination;
+        }
+
         atg_scs::GenericRigidBodySystem *system =
             new atg_scs::GenericRigidBodySystem;
         system->initialize(
-            new atg_scs::GaussianEliminationSleSolver,
+            createSleSolver(m_sleSolverType),
             new atg_scs::NsvOdeSolver);
         m_system = system;
     }
@@ -69,19 +95,27 @@ void Simulator::startFrame(double dt) {
 
     m_simulationStart = std::chrono::steady_clock::now();
     m_currentIteration = 0;
+    m_profiler.beginFrame();
+
+    if (m_adaptiveFrequency) {
+        m_simulationFrequency = calculateAdaptiveFrequency();
+    }
+
     m_synthesizer.setInputSampleRate(m_simulationFrequency * m_simulationSpeed);
 
     const double timestep = getTimestep();
     m_steps = (int)std::round((dt * m_simulationSpeed) / timestep);
 
-    const double targetLatency = getSynthesizerInputLatencyTarget();
-    if (m_synthesizer.getLatency() < targetLatency) {
-        m_steps = static_cast<int>((m_steps + 1) * 1.1);
-    }
-    else if (m_synthesizer.getLatency() > targetLatency) {
-        m_steps = static_cast<int>((m_steps - 1) * 0.9);
-        if (m_steps < 0) {
-            m_steps = 0;
+    if (m_latencyControlEnabled) {
+        const double targetLatency = getSynthesizerInputLatencyTarget();
+        if (m_synthesizer.getLatency() < targetLatency) {
+            m_steps = static_cast<int>((m_steps + 1) * 1.1);
+        }
+        else if (m_synthesizer.getLatency() > targetLatency) {
+            m_steps = static_cast<int>((m_steps - 1) * 0.9);
+            if (m_steps < 0) {
+                m_steps = 0;
+            }
         }
     }
 
@@ -99,27 +133,38 @@ bool Simulator::simulateStep() {
         const long long lastFrame =
             std::chrono::duration_cast<std::chrono::microseconds>(s1 - m_simulationStart).count();
         m_physicsProcessingTime = m_physicsProcessingTime * 0.98 + 0.02 * lastFrame;
+        m_profiler.endFrame();
 
         return false;
     }
 
     const double timestep = getTimestep();
-    m_system->process(timestep, 1);
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(&m_profiler, RigidBodySystem);
+        processRigidBodies(timestep);
+    }
 
-    m_engine->update(timestep);
-    m_vehicle->update(timestep);
-    m_transmission->update(timestep);
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(&m_profiler, EngineUpdate);
+        m_engine->update(timestep);
+        m_vehicle->update(timestep);
+        m_transmission->update(timestep);
+    }
 
     updateFilteredEngineSpeed(timestep);
 
     Crankshaft *outputShaft = m_engine->getOutputCrankshaft();
     outputShaft->resetAngle();
 
-    for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
-        Crankshaft *shaft = m_engine->getCrankshaft(i);
+    // Crankshafts share a single angle in reduced coordinates, so there is
+    // no drift to correct
+    if (m_systemType != SystemType::ReducedCoordinate) {
+        for (int i = 0; i < m_engine->getCrankshaftCount(); ++i) {
+            Crankshaft *shaft = m_engine->getCrankshaft(i);
 
-        // Correct drift (temporary hack)
-        shaft->m_body.theta = outputShaft->m_body.theta;
+            // Correct drift (temporary hack)
+            shaft->m_body.theta = outputShaft->m_body.theta;
+        }
     }
 
     const int index =
@@ -146,12 +191,20 @@ bool Simulator::simulateStep() {
 
     simulateStep_();
 
-    writeToSynthesizer();
+    {
+        ATG_ENGINE_SIM_PROFILE_SCOPE(&m_profiler, Synthesizer);
+        writeToSynthesizer();
+    }
 
     ++m_currentIteration;
     return true;
 }
 
+void Simulator::setSimulationFrequencyRange(int minFrequency, int maxFrequency) {
+    m_minSimulationFrequency = std::max(minFrequency, 1);
+    m_maxSimulationFrequency = std::max(maxFrequency, m_minSimulationFrequency);
+}
+
 double Simulator::getTotalExhaustFlow() const {
     return 0.0;
 }
@@ -166,6 +219,9 @@ void Simulator::endFrame() {
 
 void Simulator::destroy() {
     m_synthesizer.destroy();
+
+    if (m_dynoTorqueSamples != nullptr) delete[] m_dynoTorqueSamples;
+    m_dynoTorqueSamples = nullptr;
 }
 
 void Simulator::startAudioRenderingThread() {
@@ -201,6 +257,123 @@ double Simulator::getAverageOutputSignal() const {
     return 0.0;
 }
 
+int Simulator::getLastSolverIterations() const {
+    return (m_constraintSolver != nullptr)
+        ? m_constraintSolver->getStatistics().lastIterations
+        : 0;
+}
+
+double Simulator::getLastSolverResidual() const {
+    return (m_constraintSolver != nullptr)
+        ? m_constraintSolver->getStatistics().lastResidual
+        : 0.0;
+}
+
+double Simulator::getAverageSolverIterations() const {
+    if (m_constraintSolver == nullptr) return 0.0;
+
+    const ConstraintSolver::Statistics &stats = m_constraintSolver->getStatistics();
+    return (stats.solves > 0)
+        ? static_cast<double>(stats.iterations) / stats.solves
+        : 0.0;
+}
+
+double Simulator::getMaxSolverResidual() const {
+    return (m_constraintSolver != nullptr)
+        ? m_constraintSolver->getStatistics().maxResidual
+        : 0.0;
+}
+
+long long Simulator::getUnconvergedSolverSteps() const {
+    return (m_constraintSolver != nullptr)
+        ? m_constraintSolver->getStatistics().unconverged
+        : 0;
+}
+
+void Simulator::resetSolverStatistics() {
+    if (m_constraintSolver != nullptr) {
+        m_constraintSolver->resetStatistics();
+    }
+}
+
+void Simulator::setRandomSeed(uint64_t seed) {
+    m_randomSeed = seed;
+    m_synthesizer.seed(seed);
+}
+
+void Simulator::saveSnapshot(SimulationSnapshot *snapshot) const {
+    snapshot->clear();
+    snapshot->writeHeader();
+    saveState(snapshot);
+}
+
+bool Simulator::loadSnapshot(SimulationSnapshot *snapshot) {
+    if (m_engine == nullptr) return false;
+
+    // Walk the whole snapshot once without writing anything so that a
+    // mismatched or truncated snapshot leaves the simulation untouched
+    snapshot->rewind(true);
+    snapshot->readHeader();
+    loadState(snapshot);
+    if (!snapshot->isValid() || !snapshot->isAtEnd()) {
+        return false;
+    }
+
+    snapshot->rewind();
+    snapshot->readHeader();
+    loadState(snapshot);
+
+    return snapshot->isValid();
+}
+
+void Simulator::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_simulationFrequency);
+    snapshot->writeArray(m_dynoTorqueSamples, DynoTorqueSamples);
+    snapshot->write(m_lastDynoTorqueSample);
+    snapshot->write(m_filteredEngineSpeed);
+
+    snapshot->write(m_dyno.m_rotationSpeed);
+    snapshot->write(m_dyno.m_hold);
+    snapshot->write(m_dyno.m_enabled);
+    snapshot->write(m_starterMotor.m_enabled);
+
+    if (m_constraintSolver != nullptr) {
+        m_constraintSolver->saveState(snapshot);
+    }
+    else {
+        snapshot->writeCount(0);
+    }
+
+    m_engine->saveState(snapshot);
+    m_vehicle->saveState(snapshot);
+    m_transmission->saveState(snapshot);
+    m_synthesizer.saveState(snapshot);
+}
+
+void Simulator::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_simulationFrequency);
+    snapshot->readArray(m_dynoTorqueSamples, DynoTorqueSamples);
+    snapshot->read(&m_lastDynoTorqueSample);
+    snapshot->read(&m_filteredEngineSpeed);
+
+    snapshot->read(&m_dyno.m_rotationSpeed);
+    snapshot->read(&m_dyno.m_hold);
+    snapshot->read(&m_dyno.m_enabled);
+    snapshot->read(&m_starterMotor.m_enabled);
+
+    if (m_constraintSolver != nullptr) {
+        m_constraintSolver->loadState(snapshot);
+    }
+    else {
+        snapshot->expectCount(0);
+    }
+
+    m_engine->loadState(snapshot);
+    m_vehicle->loadState(snapshot);
+    m_transmission->loadState(snapshot);
+    m_synthesizer.loadState(snapshot);
+}
+
 void Simulator::initializeSynthesizer() {
     Synthesizer::Parameters synthParams;
     synthParams.audioBufferSize = 44100;
@@ -208,12 +381,48 @@ void Simulator::initializeSynthesizer() {
     synthParams.inputBufferSize = 44100;
     synthParams.inputChannelCount = m_engine->getExhaustSystemCount();
     synthParams.inputSampleRate = static_cast<float>(getSimulationFrequency());
+    synthParams.randomSeed = m_randomSeed;
     m_synthesizer.initialize(synthParams);
 }
 
+atg_scs::SleSolver *Simulator::createSleSolver(SleSolverType type) {
+    if (type == SleSolverType::GaussianElimination) {
+        m_constraintSolver = nullptr;
+        return new atg_scs::GaussianEliminationSleSolver;
+    }
+    else if (type == SleSolverType::ScsGaussSeidel) {
+        m_constraintSolver = nullptr;
+        return new atg_scs::GaussSeidelSleSolver;
+    }
+    else if (type == SleSolverType::Direct) {
+        m_constraintSolver = new DirectConstraintSolver;
+    }
+    else {
+        m_constraintSolver = new ConstraintSolver;
+    }
+
+    return m_constraintSolver;
+}
+
+void Simulator::processRigidBodies(double dt) {
+    m_system->process(dt, 1);
+}
+
 void Simulator::simulateStep_() {
 }
 
+int Simulator::calculateAdaptiveFrequency() const {
+    // Rounded up to a coarse resolution so that small speed fluctuations
+    // don't change the synthesizer's input rate on every frame
+    const double frequency = std::fmin(
+        m_engine->getSpeed() / m_crankAnglePerStep,
+        m_maxSimulationFrequency);
+    const int quantized = static_cast<int>(
+        std::ceil(frequency / AdaptiveFrequencyResolution)) * AdaptiveFrequencyResolution;
+
+    return std::clamp(quantized, m_minSimulationFrequency, m_maxSimulationFrequency);
+}
+
 void Simulator::updateFilteredEngineSpeed(double dt) {
     const double alpha = dt / (100 + dt);
     m_filteredEngineSpeed = alpha * m_filteredEngineSpeed + (1 - alpha) * m_engine->getRpm();
@@ -0,0 +1,199 @@
+#include "../include/headless_runner.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Finds the lowest simulation frequency at which each engine in a directory
+// stays stable, for each integration method. Frequencies are tried from the
+// highest down and the sweep for an engine stops at the first unstable one.
+
+namespace {
+    const int Frequencies[] = {
+        20000, 16000, 12000, 10000, 8000, 6000, 5000, 4000, 3000, 2500, 2000, 1500, 1000
+    };
+
+    // The number of fluid steps grows as the frequency drops so that the gas
+    // dynamics always run at this rate and only the rigid body step changes
+    constexpr int FluidSimulationFrequency = 80000;
+
+    // Engine scripts only define their main node; the sweep calls it from a
+    // script written next to them so that their imports resolve as usual
+    const char *DriverScript = "stability_sweep_driver.mr";
+
+    struct Integrator {
+        const char *name;
+        Simulator::IntegrationMethod method;
+    };
+
+    const Integrator Integrators[] = {
+        { "Semi-implicit", Simulator::IntegrationMethod::SemiImplicitEuler },
+        { "Linearly implicit", Simulator::IntegrationMethod::LinearlyImplicitEuler }
+    };
+
+    void printUsage(const char *program) {
+        std::printf(
+            "Usage: %s [options]\n"
+            "  --engines <path>      Directory searched for engine scripts (default: ../assets/engines)\n"
+            "  --time <s>            Simulated time that must stay stable (default: 1)\n"
+            "  --warmup <s>          Simulated time to run before that (default: 1)\n"
+            "  --throttle <0-1>      Throttle position (default: 1)\n"
+            "  --dyno <rpm>          Hold the engine at a fixed speed with the dyno\n"
+            "  --system <full|reduced>\n"
+            "                        Rigid body system to test (default: full)\n",
+            program);
+    }
+
+    bool definesMain(const std::filesystem::path &path) {
+        std::ifstream file(path);
+        const std::string contents(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+
+        return contents.find("public node main") != std::string::npos;
+    }
+
+    bool writeDriver(const std::filesystem::path &path, const std::string &engineScript) {
+        std::ofstream file(path);
+        file << "import \"engine_sim.mr\"\n";
+        file << "import \"" << engineScript << "\"\n";
+        file << "\n";
+        file << "main()\n";
+
+        return file.good();
+    }
+
+    // Returns the lowest stable frequency, -1 if even the highest is
+    // unstable, or 0 if the engine could not be loaded
+    int findLowestStableFrequency(HeadlessRunner::Parameters params) {
+        int lowest = -1;
+        for (int frequency : Frequencies) {
+            params.simulationFrequency = frequency;
+            params.minFluidSteps = params.maxFluidSteps =
+                std::max(1, (FluidSimulationFrequency + frequency - 1) / frequency);
+
+            HeadlessRunner runner;
+            if (!runner.initialize(params)) {
+                runner.destroy();
+                return 0;
+            }
+
+            HeadlessRunner::Report report;
+            const bool success = runner.run(&report);
+            runner.destroy();
+
+            if (!success || !report.stable) break;
+            lowest = frequency;
+        }
+
+        return lowest;
+    }
+
+    void printResult(int frequency) {
+        if (frequency > 0) std::printf("%18d Hz", frequency);
+        else if (frequency < 0) std::printf("%21s", "unstable");
+        else std::printf("%21s", "failed to load");
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string engineDirectory = "../assets/engines";
+
+    HeadlessRunner::Parameters params;
+    params.simulationTime = 1.0;
+    params.warmupTime = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if (value == nullptr) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        else if (std::strcmp(arg, "--engines") == 0) engineDirectory = value;
+        else if (std::strcmp(arg, "--time") == 0) params.simulationTime = std::atof(value);
+        else if (std::strcmp(arg, "--warmup") == 0) params.warmupTime = std::atof(value);
+        else if (std::strcmp(arg, "--throttle") == 0) params.throttle = std::atof(value);
+        else if (std::strcmp(arg, "--dyno") == 0) params.dynoSpeed = std::atof(value);
+        else if (std::strcmp(arg, "--system") == 0) {
+            if (std::strcmp(value, "reduced") == 0) params.reducedCoordinates = true;
+            else if (std::strcmp(value, "full") == 0) params.reducedCoordinates = false;
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        ++i;
+    }
+
+    std::error_code error;
+    std::vector<std::filesystem::path> engines;
+    for (auto it = std::filesystem::recursive_directory_iterator(engineDirectory, error);
+        !error && it != std::filesystem::recursive_directory_iterator();
+        it.increment(error))
+    {
+        const std::filesystem::path &path = it->path();
+        if (path.extension() == ".mr" && path.filename() != DriverScript && definesMain(path)) {
+            engines.push_back(path);
+        }
+    }
+
+    if (engines.empty()) {
+        std::fprintf(stderr, "No engine scripts found in %s\n", engineDirectory.c_str());
+        return 1;
+    }
+
+    std::sort(engines.begin(), engines.end());
+
+    std::printf("%-48s", "Engine");
+    for (const Integrator &integrator : Integrators) {
+        std::printf("%21s", integrator.name);
+    }
+
+    std::printf("\n");
+
+    for (const std::filesystem::path &engine : engines) {
+        const std::filesystem::path driver = engine.parent_path() / DriverScript;
+        if (!writeDriver(driver, engine.filename().string())) {
+            std::fprintf(stderr, "Could not write %s\n", driver.string().c_str());
+            return 1;
+        }
+
+        // Every run of an engine compiles the same script, so all but the
+        // first load it from the cache
+        params.scriptPath = driver.string();
+        params.scriptCachePath = "stability_sweep.cache";
+
+        const std::string name =
+            std::filesystem::relative(engine, engineDirectory, error).generic_string();
+        std::printf("%-48s", name.c_str());
+        std::fflush(stdout);
+
+        for (const Integrator &integrator : Integrators) {
+            params.integrationMethod = integrator.method;
+            printResult(findLowestStableFrequency(params));
+            std::fflush(stdout);
+        }
+
+        std::printf("\n");
+        std::filesystem::remove(driver, error);
+    }
+
+    return 0;
+}
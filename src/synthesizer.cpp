@@ -1,20 +1,46 @@
 #include "../include/synthesizer.h"
 
+#include "../include/impulse_response_store.h"
 #include "../include/utilities.h"
-#include "../include/delta.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstring>
+#include <chrono>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#endif
 
 #undef min
 #undef max
 
+namespace {
+    // Flush denormals to zero on the calling thread. Filter tails decay into
+    // the denormal range, where arithmetic is extremely slow on most CPUs.
+    void enableFlushToZero() {
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+        // FTZ (bit 15) and DAZ (bit 6)
+        _mm_setcsr(_mm_getcsr() | 0x8040);
+#elif defined(__aarch64__)
+        unsigned long long fpcr;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+        fpcr |= (1ULL << 24);
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#endif
+    }
+}
+
 Synthesizer::Synthesizer() {
     m_inputChannels = nullptr;
     m_inputChannelCount = 0;
     m_inputBufferSize = 0;
     m_inputWriteOffset = 0.0;
-    m_inputSamplesRead = 0;
+    m_stagedInputSamples = 0;
+    m_inputWriteIndex = 0;
+    m_latency = 0;
+    m_levelerGain = 1.0f;
 
     m_audioBufferSize = 0;
 
@@ -24,6 +50,7 @@ Synthesizer::Synthesizer() {
     m_lastInputSampleOffset = 0.0;
 
     m_run = true;
+    m_offline = false;
     m_thread = nullptr;
     m_filters = nullptr;
 }
@@ -42,15 +69,19 @@ void Synthesizer::initialize(const Parameters &p) {
     m_inputSampleRate = p.inputSampleRate;
     m_audioSampleRate = p.audioSampleRate;
     m_audioParameters = p.initialAudioParameters;
+    m_renderParameters = p.initialAudioParameters;
+    m_audioParameterBuffer.initialize(p.initialAudioParameters);
 
-    m_inputSamplesRead = 0;
+    m_stagedInputSamples = 0;
+    m_inputWriteIndex = 0;
+    m_latency = 0;
 
     m_inputWriteOffset = 0;
-    m_processed = true;
 
     m_audioBuffer.initialize(p.audioBufferSize);
     m_inputChannels = new InputChannel[p.inputChannelCount];
     for (int i = 0; i < p.inputChannelCount; ++i) {
+        m_inputChannels[i].stagingBuffer = new float[p.inputBufferSize];
         m_inputChannels[i].transferBuffer = new float[p.inputBufferSize];
         m_inputChannels[i].data.initialize(p.inputBufferSize);
     }
@@ -73,14 +104,22 @@ void Synthesizer::initialize(const Parameters &p) {
         m_filters[i].antialiasing.setCutoffFrequency(1900.0f, m_audioSampleRate);
     }
 
+    seed(p.randomSeed);
+
+    m_renderBuffers.airNoise = new float[RenderBlockSize * (size_t)p.inputChannelCount];
+    m_renderBuffers.jitter = new float[RenderBlockSize];
+    m_renderBuffers.dc = new float[RenderBlockSize];
+    m_renderBuffers.derivative = new float[RenderBlockSize];
+    m_renderBuffers.input = new float[RenderBlockSize];
+    m_renderBuffers.convolution = new float[RenderBlockSize];
+    m_renderBuffers.signal = new float[RenderBlockSize];
+    m_renderBuffers.output = new int16_t[RenderBlockSize];
+
     m_levelingFilter.p_target = m_audioParameters.levelerTarget;
     m_levelingFilter.p_maxLevel = m_audioParameters.levelerMaxGain;
     m_levelingFilter.p_minLevel = m_audioParameters.levelerMinGain;
     m_antialiasing.setCutoffFrequency(m_audioSampleRate * 0.45f, m_audioSampleRate);
-
-    for (int i = 0; i < m_audioBufferSize; ++i) {
-        m_audioBuffer.write(0);
-    }
+    m_levelerGain = static_cast<float>(m_levelingFilter.getAttenuation());
 }
 
 void Synthesizer::initializeImpulseResponse(
@@ -91,12 +130,13 @@ void Synthesizer::initializeImpulseResponse(
 {
     unsigned int clippedLength = 0;
     for (unsigned int i = 0; i < samples; ++i) {
-        if (std::abs(impulseResponse[i]) > 100) {
+        if (std::abs(impulseResponse[i]) > ImpulseResponseStore::SilenceThreshold) {
             clippedLength = i + 1;
         }
     }
 
-    const unsigned int sampleCount = std::min(10000U, clippedLength);
+    const unsigned int sampleCount =
+        std::min((unsigned int)ImpulseResponseStore::MaxSamples, clippedLength);
     m_filters[index].convolution.initialize(sampleCount);
     for (unsigned int i = 0; i < sampleCount; ++i) {
         m_filters[index].convolution.getImpulseResponse()[i] =
@@ -104,6 +144,91 @@ void Synthesizer::initializeImpulseResponse(
     }
 }
 
+void Synthesizer::initializeImpulseResponse(
+    const ConvolutionFilter::Kernel &kernel,
+    float volume,
+    int index)
+{
+    m_filters[index].convolution.initialize(kernel, volume);
+}
+
+void Synthesizer::seed(uint64_t seed) {
+    // Stream indices are offset so that they do not overlap with the
+    // streams used by the simulation itself
+    constexpr uint64_t StreamBase = 1ULL << 32;
+
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        m_filters[i].airNoise.seed(seed, StreamBase + 2 * i);
+
+        RandomStream jitterSeed;
+        jitterSeed.seed(seed, StreamBase + 2 * i + 1);
+        m_filters[i].jitterFilter.seed(jitterSeed.next());
+    }
+}
+
+void Synthesizer::saveState(SimulationSnapshot *snapshot) const {
+    assert(m_thread == nullptr);
+
+    snapshot->writeCount(m_inputChannelCount);
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        snapshot->write(m_inputChannels[i].lastInputSample);
+
+        ProcessingFilters &filters = m_filters[i];
+        filters.convolution.saveState(snapshot);
+        filters.derivative.saveState(snapshot);
+        filters.jitterFilter.saveState(snapshot);
+        filters.airNoiseLowPass.saveState(snapshot);
+        filters.inputDcFilter.saveState(snapshot);
+        filters.antialiasing.saveState(snapshot);
+        filters.airNoise.saveState(snapshot);
+    }
+
+    m_antialiasing.saveState(snapshot);
+    m_levelingFilter.saveState(snapshot);
+
+    snapshot->write(m_inputWriteIndex);
+    snapshot->write(m_inputWriteOffset);
+    snapshot->write(m_lastInputSampleOffset);
+    snapshot->write(m_inputSampleRate);
+}
+
+void Synthesizer::loadState(SimulationSnapshot *snapshot) {
+    assert(m_thread == nullptr);
+
+    snapshot->expectCount(m_inputChannelCount);
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        snapshot->read(&m_inputChannels[i].lastInputSample);
+
+        ProcessingFilters &filters = m_filters[i];
+        filters.convolution.loadState(snapshot);
+        filters.derivative.loadState(snapshot);
+        filters.jitterFilter.loadState(snapshot);
+        filters.airNoiseLowPass.loadState(snapshot);
+        filters.inputDcFilter.loadState(snapshot);
+        filters.antialiasing.loadState(snapshot);
+        filters.airNoise.loadState(snapshot);
+    }
+
+    m_antialiasing.loadState(snapshot);
+    m_levelingFilter.loadState(snapshot);
+
+    snapshot->read(&m_inputWriteIndex);
+    snapshot->read(&m_inputWriteOffset);
+    snapshot->read(&m_lastInputSampleOffset);
+    snapshot->read(&m_inputSampleRate);
+
+    if (snapshot->isValidating()) return;
+
+    for (int i = 0; i < m_inputChannelCount; ++i) {
+        m_inputChannels[i].data.clear();
+    }
+
+    m_audioBuffer.clear();
+    m_stagedInputSamples = 0;
+    m_latency = 0;
+    m_levelerGain = m_levelingFilter.getAttenuation();
+}
+
 void Synthesizer::startAudioRenderingThread() {
     m_run = true;
     m_thread = new std::thread(&Synthesizer::audioRenderingThread, this);
@@ -112,7 +237,7 @@ void Synthesizer::startAudioRenderingThread() {
 void Synthesizer::endAudioRenderingThread() {
     if (m_thread != nullptr) {
         m_run = false;
-        endInputBlock();
+        m_wakeCondition.notify_one();
 
         m_thread->join();
         delete m_thread;
@@ -126,12 +251,24 @@ void Synthesizer::destroy() {
 
     for (int i = 0; i < m_inputChannelCount; ++i) {
         m_inputChannels[i].data.destroy();
+        delete[] m_inputChannels[i].stagingBuffer;
+        delete[] m_inputChannels[i].transferBuffer;
         m_filters[i].convolution.destroy();
     }
 
     delete[] m_inputChannels;
     delete[] m_filters;
 
+    delete[] m_renderBuffers.airNoise;
+    delete[] m_renderBuffers.jitter;
+    delete[] m_renderBuffers.dc;
+    delete[] m_renderBuffers.derivative;
+    delete[] m_renderBuffers.input;
+    delete[] m_renderBuffers.convolution;
+    delete[] m_renderBuffers.signal;
+    delete[] m_renderBuffers.output;
+    m_renderBuffers = RenderBuffers();
+
     m_inputChannels = nullptr;
     m_filters = nullptr;
 
@@ -139,30 +276,20 @@ void Synthesizer::destroy() {
 }
 
 int Synthesizer::readAudioOutput(int samples, int16_t *buffer) {
-    std::lock_guard<std::mutex> lock(m_lock0);
-
-    const int newDataLength = m_audioBuffer.size();
-    if (newDataLength >= samples) {
-        m_audioBuffer.readAndRemove(samples, buffer);
-    }
-    else {
-        m_audioBuffer.readAndRemove(newDataLength, buffer);
+    const int samplesConsumed =
+        static_cast<int>(m_audioBuffer.read(buffer, samples));
+    if (samplesConsumed < samples) {
         memset(
-            buffer + newDataLength,
+            buffer + samplesConsumed,
             0,
-            sizeof(int16_t) * ((size_t)samples - newDataLength));
+            sizeof(int16_t) * ((size_t)samples - samplesConsumed));
     }
-    
-    const int samplesConsumed = std::min(samples, newDataLength);
 
-    return samplesConsumed;
-}
+    // Reading frees space in the output buffer, which may be what the audio
+    // thread is waiting for
+    m_wakeCondition.notify_one();
 
-void Synthesizer::waitProcessed() {
-    {
-        std::unique_lock<std::mutex> lk(m_lock0);
-        m_cv0.wait(lk, [this] { return m_processed; });
-    }
+    return samplesConsumed;
 }
 
 void Synthesizer::writeInput(const double *data) {
@@ -171,88 +298,116 @@ void Synthesizer::writeInput(const double *data) {
         m_inputWriteOffset -= (double)m_inputBufferSize;
     }
 
+    const double distance =
+        inputDistance(m_inputWriteOffset, m_lastInputSampleOffset);
+    if (m_stagedInputSamples + (int)distance + 2 > m_inputBufferSize) {
+        flushInput();
+    }
+
+    int samplesWritten = 0;
     for (int i = 0; i < m_inputChannelCount; ++i) {
-        RingBuffer<float> &buffer = m_inputChannels[i].data;
-        const double lastInputSample = m_inputChannels[i].lastInputSample;
-        const size_t baseIndex = buffer.writeIndex();
-        const double distance =
-            inputDistance(m_inputWriteOffset, m_lastInputSampleOffset);
+        InputChannel &channel = m_inputChannels[i];
+        float *staging = channel.stagingBuffer + m_stagedInputSamples;
+        const double lastInputSample = channel.lastInputSample;
         double s =
-            inputDistance(baseIndex, m_lastInputSampleOffset);
+            inputDistance(m_inputWriteIndex, m_lastInputSampleOffset);
+
+        samplesWritten = 0;
         for (; s <= distance; s += 1.0) {
             if (s >= m_inputBufferSize) s -= m_inputBufferSize;
 
             const double f = s / distance;
             const double sample = lastInputSample * (1 - f) + data[i] * f;
 
-            buffer.write(m_filters[i].antialiasing.fast_f(static_cast<float>(sample)));
+            staging[samplesWritten++] =
+                m_filters[i].antialiasing.fast_f(static_cast<float>(sample));
         }
 
-        m_inputChannels[i].lastInputSample = data[i];
+        channel.lastInputSample = data[i];
+    }
+
+    m_stagedInputSamples += samplesWritten;
+    m_inputWriteIndex += samplesWritten;
+    if (m_inputWriteIndex >= m_inputBufferSize) {
+        m_inputWriteIndex -= m_inputBufferSize;
     }
 
     m_lastInputSampleOffset = m_inputWriteOffset;
 }
 
-void Synthesizer::endInputBlock() {
-    std::unique_lock<std::mutex> lk(m_inputLock); 
-
+void Synthesizer::flushInput() {
+    // If the audio thread has fallen this far behind the newest samples are
+    // dropped rather than waiting for it
     for (int i = 0; i < m_inputChannelCount; ++i) {
-        m_inputChannels[i].data.removeBeginning(m_inputSamplesRead);
+        m_inputChannels[i].data.write(
+            m_inputChannels[i].stagingBuffer, m_stagedInputSamples);
     }
 
+    m_stagedInputSamples = 0;
+}
+
+void Synthesizer::endInputBlock() {
+    flushInput();
+
     if (m_inputChannelCount != 0) {
-        m_latency = m_inputChannels[0].data.size();
+        m_latency = static_cast<int>(m_inputChannels[0].data.size());
     }
-    
-    m_inputSamplesRead = 0;
-    m_processed = false;
 
-    lk.unlock();
-    m_cv0.notify_one();
+    m_wakeCondition.notify_one();
 }
 
 void Synthesizer::audioRenderingThread() {
+    enableFlushToZero();
+
     while (m_run) {
-        renderAudio();
+        if (renderAudio() > 0) continue;
+
+        // Nothing to do; sleep until new input or output space shows up. The
+        // producers notify without taking the lock, so a missed wakeup only
+        // costs one timeout.
+        std::unique_lock<std::mutex> lk(m_wakeLock);
+        m_wakeCondition.wait_for(lk, std::chrono::milliseconds(1));
     }
 }
 
 #undef max
-void Synthesizer::renderAudio() {
-    std::unique_lock<std::mutex> lk0(m_lock0);
-
-    m_cv0.wait(lk0, [this] {
-        const bool inputAvailable =
-            m_inputChannels[0].data.size() > 0
-            && m_audioBuffer.size() < 2000;
-        return !m_run || (inputAvailable && !m_processed);
-    });
+int Synthesizer::renderAudio() {
+    if (m_inputChannelCount == 0) return 0;
+
+    // Channels are flushed one after another, so only render what every
+    // channel already has
+    size_t inputAvailable = m_inputChannels[0].data.size();
+    for (int i = 1; i < m_inputChannelCount; ++i) {
+        inputAvailable = std::min(inputAvailable, m_inputChannels[i].data.size());
+    }
 
-    const int n = std::min(
-        std::max(0, 2000 - (int)m_audioBuffer.size()),
-        (int)m_inputChannels[0].data.size());
+    const int bufferTarget = m_offline
+        ? (int)m_audioBuffer.capacity()
+        : AudioBufferTarget;
+    const int n = std::min({
+        std::max(0, bufferTarget - (int)m_audioBuffer.size()),
+        (int)inputAvailable,
+        m_inputBufferSize });
+    if (n <= 0) return 0;
 
     for (int i = 0; i < m_inputChannelCount; ++i) {
-        m_inputChannels[i].data.read(n, m_inputChannels[i].transferBuffer);
+        m_inputChannels[i].data.read(m_inputChannels[i].transferBuffer, n);
     }
-    
-    m_inputSamplesRead = n;
-    m_processed = true;
-
-    lk0.unlock();
 
+    m_renderParameters = m_audioParameterBuffer.read();
     for (int i = 0; i < m_inputChannelCount; ++i) {
         m_filters[i].airNoiseLowPass.setCutoffFrequency(
-            static_cast<float>(m_audioParameters.airNoiseFrequencyCutoff), m_audioSampleRate);
-        m_filters[i].jitterFilter.setJitterScale(m_audioParameters.inputSampleNoise);
+            static_cast<float>(m_renderParameters.airNoiseFrequencyCutoff), m_audioSampleRate);
+        m_filters[i].jitterFilter.setJitterScale(m_renderParameters.inputSampleNoise);
     }
 
-    for (int i = 0; i < n; ++i) {
-        m_audioBuffer.write(renderAudio(i));
+    for (int i = 0; i < n; i += RenderBlockSize) {
+        renderBlock(i, std::min(RenderBlockSize, n - i));
     }
 
-    m_cv0.notify_one();
+    m_levelerGain = static_cast<float>(m_levelingFilter.getAttenuation());
+
+    return n;
 }
 
 double Synthesizer::getLatency() const {
@@ -272,75 +427,93 @@ double Synthesizer::inputDistance(double s1, double s0) const {
 }
 
 void Synthesizer::setInputSampleRate(double sampleRate) {
-    if (sampleRate != m_inputSampleRate) {
-        std::lock_guard<std::mutex> lock(m_lock0);
-        m_inputSampleRate = sampleRate;
-    }
+    m_inputSampleRate = static_cast<float>(sampleRate);
 }
 
-int16_t Synthesizer::renderAudio(int inputSample) {
-    const float airNoise = m_audioParameters.airNoise;
-    const float dF_F_mix = m_audioParameters.dF_F_mix;
-    const float convAmount = m_audioParameters.convolution;
-
-    float signal = 0;
-    for (int i = 0; i < m_inputChannelCount; ++i) {
-        const float r_0 = 2.0 * ((double)rand() / RAND_MAX) - 1.0;
-
-        const float jitteredSample =
-            m_filters[i].jitterFilter.fast_f(m_inputChannels[i].transferBuffer[inputSample]);
-
-        const float f_in = jitteredSample;
-        const float f_dc = m_filters[i].inputDcFilter.fast_f(f_in);
-        const float f = f_in - f_dc;
-        const float f_p = m_filters[i].derivative.f(f_in);
-
-        const float noise = 2.0 * ((double)rand() / RAND_MAX) - 1.0;
-        const float r =
-            m_filters->airNoiseLowPass.fast_f(noise);
-        const float r_mixed =
-            airNoise * r + (1 - airNoise);
-
-        float v_in =
-            f_p * dF_F_mix
-            + f * r_mixed * (1 - dF_F_mix);
-        if (fpclassify(v_in) == FP_SUBNORMAL) {
-            v_in = 0;
+void Synthesizer::renderBlock(int inputOffset, int samples) {
+    const float airNoise = m_renderParameters.airNoise;
+    const float dF_F_mix = m_renderParameters.dF_F_mix;
+    const float convAmount = m_renderParameters.convolution;
+    const int channels = m_inputChannelCount;
+
+    float *noise = m_renderBuffers.airNoise;
+    float *jitter = m_renderBuffers.jitter;
+    float *dc = m_renderBuffers.dc;
+    float *derivative = m_renderBuffers.derivative;
+    float *input = m_renderBuffers.input;
+    float *convolution = m_renderBuffers.convolution;
+    float *signal = m_renderBuffers.signal;
+
+    // Air noise for all channels is filtered by the first channel's filter,
+    // which sees the channels' samples interleaved
+    for (int i = 0; i < channels; ++i) {
+        m_filters[i].airNoise.fillSigned(input, samples);
+        for (int j = 0; j < samples; ++j) {
+            noise[j * channels + i] = input[j];
         }
+    }
 
-        const float v =
-            convAmount * m_filters[i].convolution.f(v_in)
-            + (1 - convAmount) * v_in;
+    m_filters[0].airNoiseLowPass.process(noise, noise, samples * channels);
 
-        signal += v;
+    for (int i = 0; i < samples; ++i) {
+        signal[i] = 0;
     }
 
-    signal = m_antialiasing.fast_f(signal);
+    for (int i = 0; i < channels; ++i) {
+        ProcessingFilters &filters = m_filters[i];
 
-    m_levelingFilter.p_target = m_audioParameters.levelerTarget;
-    const float v_leveled = m_levelingFilter.f(signal) * m_audioParameters.volume;
-    int r_int = std::lround(v_leveled);
-    if (r_int > INT16_MAX) {
-        r_int = INT16_MAX;
+        filters.jitterFilter.process(
+            m_inputChannels[i].transferBuffer + inputOffset, jitter, samples);
+        filters.inputDcFilter.process(jitter, dc, samples);
+        filters.derivative.process(jitter, derivative, samples);
+
+        for (int j = 0; j < samples; ++j) {
+            const float r_mixed = airNoise * noise[j * channels + i] + (1 - airNoise);
+            const float f = jitter[j] - dc[j];
+
+            input[j] =
+                derivative[j] * dF_F_mix
+                + f * r_mixed * (1 - dF_F_mix);
+        }
+
+        filters.convolution.process(input, convolution, samples);
+
+        for (int j = 0; j < samples; ++j) {
+            signal[j] += convAmount * convolution[j] + (1 - convAmount) * input[j];
+        }
     }
-    else if (r_int < INT16_MIN) {
-        r_int = INT16_MIN;
+
+    m_antialiasing.process(signal, signal, samples);
+
+    m_levelingFilter.p_target = m_renderParameters.levelerTarget;
+    m_levelingFilter.process(signal, signal, samples);
+
+    int16_t *output = m_renderBuffers.output;
+    const float volume = m_renderParameters.volume;
+    for (int i = 0; i < samples; ++i) {
+        int r_int = std::lround(signal[i] * volume);
+        if (r_int > INT16_MAX) {
+            r_int = INT16_MAX;
+        }
+        else if (r_int < INT16_MIN) {
+            r_int = INT16_MIN;
+        }
+
+        output[i] = static_cast<int16_t>(r_int);
     }
 
-    return static_cast<int16_t>(r_int);
+    m_audioBuffer.write(output, samples);
 }
 
 double Synthesizer::getLevelerGain() {
-    std::lock_guard<std::mutex> lock(m_lock0);
-    return m_levelingFilter.getAttenuation();
+    return m_levelerGain;
 }
 
 Synthesizer::AudioParameters Synthesizer::getAudioParameters() {
-    std::lock_guard<std::mutex> lock(m_lock0);
     return m_audioParameters;
 }
 
 void Synthesizer::setAudioParameters(const AudioParameters &params) {
-    std::lock_guard<std::mutex> lock(m_lock0);
     m_audioParameters = params;
+    m_audioParameterBuffer.write(params);
 }
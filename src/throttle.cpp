@@ -1,5 +1,7 @@
 #include "../include/throttle.h"
 
+#include "../include/simulation_snapshot.h"
+
 Throttle::Throttle() {
     m_speedControl = 0;
 }
@@ -15,3 +17,11 @@ void Throttle::setSpeedControl(double s) {
 void Throttle::update(double dt, Engine *engine) {
     /* void */
 }
+
+void Throttle::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_speedControl);
+}
+
+void Throttle::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_speedControl);
+}
@@ -1,6 +1,7 @@
 #include "../include/transmission.h"
 
 #include "../include/units.h"
+#include "../include/simulation_snapshot.h"
 
 #include <cmath>
 
@@ -80,3 +81,19 @@ void Transmission::changeGear(int newGear) {
 
     m_gear = newGear;
 }
+
+void Transmission::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_gear);
+    snapshot->write(m_newGear);
+    snapshot->write(m_clutchPressure);
+    snapshot->write(m_clutchConstraint.m_minTorque);
+    snapshot->write(m_clutchConstraint.m_maxTorque);
+}
+
+void Transmission::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_gear);
+    snapshot->read(&m_newGear);
+    snapshot->read(&m_clutchPressure);
+    snapshot->read(&m_clutchConstraint.m_minTorque);
+    snapshot->read(&m_clutchConstraint.m_maxTorque);
+}
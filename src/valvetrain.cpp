@@ -1,5 +1,7 @@
 #include "../include/valvetrain.h"
 
+#include "../include/simulation_snapshot.h"
+
 Valvetrain::Valvetrain() {
     /* void */
 }
@@ -7,3 +9,15 @@ Valvetrain::Valvetrain() {
 Valvetrain::~Valvetrain() {
     /* void */
 }
+
+void Valvetrain::update(double dt) {
+    /* void */
+}
+
+void Valvetrain::saveState(SimulationSnapshot *snapshot) const {
+    /* void */
+}
+
+void Valvetrain::loadState(SimulationSnapshot *snapshot) {
+    /* void */
+}
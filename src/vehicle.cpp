@@ -1,5 +1,7 @@
 #include "../include/vehicle.h"
 
+#include "../include/simulation_snapshot.h"
+
 #include <cmath>
 
 Vehicle::Vehicle() {
@@ -49,3 +51,11 @@ double Vehicle::linearForceToVirtualTorque(double force) const {
         std::sqrt(m_rotatingMass->I / m_mass);
     return rotationToKineticRatio * force;
 }
+
+void Vehicle::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_travelledDistance);
+}
+
+void Vehicle::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_travelledDistance);
+}
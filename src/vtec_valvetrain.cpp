@@ -1,6 +1,10 @@
 #include "../include/vtec_valvetrain.h"
 
 #include "../include/engine.h"
+#include "../include/camshaft.h"
+#include "../include/simulation_snapshot.h"
+
+#include <cmath>
 
 VtecValvetrain::VtecValvetrain() {
     m_intakeCamshaft = nullptr;
@@ -15,6 +19,14 @@ VtecValvetrain::VtecValvetrain() {
     m_minSpeed = 0.0;
     m_minThrottlePosition = 0.0;
     m_manifoldVacuum = 0.0;
+
+    m_rpmHysteresis = 0.0;
+    m_manifoldVacuumHysteresis = 0.0;
+    m_throttlePositionHysteresis = 0.0;
+    m_switchTime = 0.0;
+
+    m_engaged = false;
+    m_switchProgress = 1.0;
 }
 
 VtecValvetrain::~VtecValvetrain() {
@@ -32,35 +44,95 @@ void VtecValvetrain::initialize(const Parameters &parameters) {
     m_minThrottlePosition = parameters.minThrottlePosition;
     m_manifoldVacuum = parameters.manifoldVacuum;
     m_engine = parameters.engine;
+
+    m_rpmHysteresis = parameters.rpmHysteresis;
+    m_manifoldVacuumHysteresis = parameters.manifoldVacuumHysteresis;
+    m_throttlePositionHysteresis = parameters.throttlePositionHysteresis;
+    m_switchTime = parameters.switchTime;
+
+    m_engaged = false;
+    m_switchProgress = 1.0;
+}
+
+void VtecValvetrain::update(double dt) {
+    const bool engaged = m_engaged
+        ? !shouldDisengage()
+        : shouldEngage();
+
+    if (engaged != m_engaged) {
+        // Reversing part way through a switch continues from the current
+        // blend rather than jumping
+        m_engaged = engaged;
+        m_switchProgress = 1.0 - m_switchProgress;
+    }
+
+    if (m_switchProgress < 1.0) {
+        m_switchProgress = (m_switchTime > 0)
+            ? std::fmin(m_switchProgress + dt / m_switchTime, 1.0)
+            : 1.0;
+    }
 }
 
 double VtecValvetrain::intakeValveLift(int cylinder) {
-    return isVtecEnabled()
-        ? m_vtecIntakeCamshaft->valveLift(cylinder)
-        : m_intakeCamshaft->valveLift(cylinder);
+    const double lift = getActiveIntakeCamshaft()->valveLift(cylinder);
+    if (m_switchProgress >= 1.0) return lift;
+
+    const double previousLift = getPreviousIntakeCamshaft()->valveLift(cylinder);
+    return previousLift + m_switchProgress * (lift - previousLift);
 }
 
 double VtecValvetrain::exhaustValveLift(int cylinder) {
-    return isVtecEnabled()
-        ? m_vtecExhaustCamshaft->valveLift(cylinder)
-        : m_exhaustCamshaft->valveLift(cylinder);
+    const double lift = getActiveExhaustCamshaft()->valveLift(cylinder);
+    if (m_switchProgress >= 1.0) return lift;
+
+    const double previousLift = getPreviousExhaustCamshaft()->valveLift(cylinder);
+    return previousLift + m_switchProgress * (lift - previousLift);
 }
 
 Camshaft *VtecValvetrain::getActiveIntakeCamshaft() {
-    return isVtecEnabled()
+    return m_engaged
         ? m_vtecIntakeCamshaft
         : m_intakeCamshaft;
 }
 
 Camshaft *VtecValvetrain::getActiveExhaustCamshaft() {
-    return isVtecEnabled()
+    return m_engaged
         ? m_vtecExhaustCamshaft
         : m_exhaustCamshaft;
 }
 
-bool VtecValvetrain::isVtecEnabled() const {
+Camshaft *VtecValvetrain::getPreviousIntakeCamshaft() {
+    return m_engaged
+        ? m_intakeCamshaft
+        : m_vtecIntakeCamshaft;
+}
+
+Camshaft *VtecValvetrain::getPreviousExhaustCamshaft() {
+    return m_engaged
+        ? m_exhaustCamshaft
+        : m_vtecExhaustCamshaft;
+}
+
+bool VtecValvetrain::shouldEngage() const {
     return
         m_engine->getManifoldPressure() > m_manifoldVacuum
         && m_engine->getSpeed() > m_minRpm
         && (1 - m_engine->getThrottle()) > m_minThrottlePosition;
 }
+
+bool VtecValvetrain::shouldDisengage() const {
+    return
+        m_engine->getManifoldPressure() < m_manifoldVacuum - m_manifoldVacuumHysteresis
+        || m_engine->getSpeed() < m_minRpm - m_rpmHysteresis
+        || (1 - m_engine->getThrottle()) < m_minThrottlePosition - m_throttlePositionHysteresis;
+}
+
+void VtecValvetrain::saveState(SimulationSnapshot *snapshot) const {
+    snapshot->write(m_engaged);
+    snapshot->write(m_switchProgress);
+}
+
+void VtecValvetrain::loadState(SimulationSnapshot *snapshot) {
+    snapshot->read(&m_engaged);
+    snapshot->read(&m_switchProgress);
+}
@@ -0,0 +1,97 @@
+#include "../include/wave_file.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    uint32_t readU32(const unsigned char *data) {
+        return (uint32_t)data[0]
+            | ((uint32_t)data[1] << 8)
+            | ((uint32_t)data[2] << 16)
+            | ((uint32_t)data[3] << 24);
+    }
+
+    uint16_t readU16(const unsigned char *data) {
+        return (uint16_t)(data[0] | (data[1] << 8));
+    }
+}
+
+WaveFile::WaveFile() {
+    m_samples = nullptr;
+    m_sampleCount = 0;
+    m_sampleRate = 0;
+}
+
+WaveFile::~WaveFile() {
+    assert(m_samples == nullptr);
+}
+
+bool WaveFile::read(const std::string &filename) {
+    destroy();
+
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    unsigned char header[12];
+    if (!file.read(reinterpret_cast<char *>(header), 12)) return false;
+    if (std::memcmp(header, "RIFF", 4) != 0) return false;
+    if (std::memcmp(header + 8, "WAVE", 4) != 0) return false;
+
+    int channels = 0, bitsPerSample = 0;
+    unsigned char chunkHeader[8];
+    while (file.read(reinterpret_cast<char *>(chunkHeader), 8)) {
+        const uint32_t chunkSize = readU32(chunkHeader + 4);
+
+        if (std::memcmp(chunkHeader, "fmt ", 4) == 0) {
+            unsigned char format[16];
+            if (chunkSize < 16) return false;
+            if (!file.read(reinterpret_cast<char *>(format), 16)) return false;
+
+            const uint16_t formatTag = readU16(format);
+            channels = readU16(format + 2);
+            m_sampleRate = (int)readU32(format + 4);
+            bitsPerSample = readU16(format + 14);
+
+            if (formatTag != 1 || bitsPerSample != 16 || channels < 1) return false;
+
+            file.seekg(chunkSize - 16 + (chunkSize & 1), std::ios::cur);
+        }
+        else if (std::memcmp(chunkHeader, "data", 4) == 0) {
+            if (channels == 0) return false;
+
+            const int frameCount = (int)(chunkSize / (2 * channels));
+            int16_t *interleaved = new int16_t[(size_t)frameCount * channels];
+            if (!file.read(reinterpret_cast<char *>(interleaved), (std::streamsize)frameCount * channels * 2)) {
+                delete[] interleaved;
+                return false;
+            }
+
+            // Only the first channel is used
+            m_sampleCount = frameCount;
+            m_samples = new int16_t[frameCount];
+            for (int i = 0; i < frameCount; ++i) {
+                const unsigned char *s =
+                    reinterpret_cast<const unsigned char *>(interleaved + (size_t)i * channels);
+                m_samples[i] = (int16_t)readU16(s);
+            }
+
+            delete[] interleaved;
+            return true;
+        }
+        else {
+            file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+        }
+    }
+
+    return false;
+}
+
+void WaveFile::destroy() {
+    if (m_samples != nullptr) {
+        delete[] m_samples;
+    }
+
+    m_samples = nullptr;
+    m_sampleCount = 0;
+}
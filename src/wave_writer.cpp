@@ -0,0 +1,141 @@
+#include "../include/wave_writer.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    void writeU32(unsigned char *data, uint32_t v) {
+        data[0] = (unsigned char)(v & 0xFF);
+        data[1] = (unsigned char)((v >> 8) & 0xFF);
+        data[2] = (unsigned char)((v >> 16) & 0xFF);
+        data[3] = (unsigned char)((v >> 24) & 0xFF);
+    }
+
+    void writeU16(unsigned char *data, uint16_t v) {
+        data[0] = (unsigned char)(v & 0xFF);
+        data[1] = (unsigned char)((v >> 8) & 0xFF);
+    }
+}
+
+WaveWriter::WaveWriter() {
+    m_file = nullptr;
+    m_sampleRate = 0;
+    m_sampleCount = 0;
+
+    m_thread = nullptr;
+    m_run = false;
+    m_error = false;
+}
+
+WaveWriter::~WaveWriter() {
+    assert(m_file == nullptr);
+    assert(m_thread == nullptr);
+}
+
+bool WaveWriter::open(const std::string &filename, int sampleRate) {
+    assert(m_file == nullptr);
+
+    m_file = std::fopen(filename.c_str(), "wb");
+    if (m_file == nullptr) return false;
+
+    m_sampleRate = sampleRate;
+    m_sampleCount = 0;
+    m_error = false;
+
+    // Sizes are patched in once the stream is closed
+    writeHeader(0);
+
+    m_buffer.initialize(BufferSize);
+    m_run = true;
+    m_thread = new std::thread(&WaveWriter::writerThread, this);
+
+    return true;
+}
+
+void WaveWriter::write(const int16_t *samples, int n) {
+    m_sampleCount += n;
+
+    while (n > 0) {
+        const int written = static_cast<int>(m_buffer.write(samples, n));
+        samples += written;
+        n -= written;
+
+        m_wakeCondition.notify_one();
+        if (n > 0) {
+            // The disk can't keep up; let the writer catch up rather than
+            // dropping samples
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool WaveWriter::close() {
+    if (m_file == nullptr) return false;
+
+    if (m_thread != nullptr) {
+        m_run = false;
+        m_wakeCondition.notify_one();
+
+        m_thread->join();
+        delete m_thread;
+
+        m_thread = nullptr;
+    }
+
+    const long long dataSize = m_sampleCount * (long long)sizeof(int16_t);
+    std::fseek(m_file, 0, SEEK_SET);
+    writeHeader(static_cast<uint32_t>(dataSize));
+
+    const bool success = !m_error && std::fclose(m_file) == 0;
+    m_file = nullptr;
+
+    m_buffer.destroy();
+
+    return success;
+}
+
+void WaveWriter::writerThread() {
+    int16_t chunk[4096];
+
+    while (true) {
+        // Read the run flag before draining so that samples queued before
+        // close() are never left behind
+        const bool run = m_run;
+
+        size_t n;
+        while ((n = m_buffer.read(chunk, 4096)) > 0) {
+            if (std::fwrite(chunk, sizeof(int16_t), n, m_file) != n) {
+                m_error = true;
+            }
+        }
+
+        if (!run) break;
+
+        std::unique_lock<std::mutex> lk(m_wakeLock);
+        m_wakeCondition.wait_for(lk, std::chrono::milliseconds(10));
+    }
+}
+
+void WaveWriter::writeHeader(uint32_t dataSize) {
+    unsigned char header[44];
+    std::memcpy(header, "RIFF", 4);
+    writeU32(header + 4, 36 + dataSize);
+    std::memcpy(header + 8, "WAVE", 4);
+
+    std::memcpy(header + 12, "fmt ", 4);
+    writeU32(header + 16, 16);
+    writeU16(header + 20, 1);
+    writeU16(header + 22, 1);
+    writeU32(header + 24, (uint32_t)m_sampleRate);
+    writeU32(header + 28, (uint32_t)m_sampleRate * 2);
+    writeU16(header + 32, 2);
+    writeU16(header + 34, 16);
+
+    std::memcpy(header + 36, "data", 4);
+    writeU32(header + 40, dataSize);
+
+    if (std::fwrite(header, 1, 44, m_file) != 44) {
+        m_error = true;
+    }
+}
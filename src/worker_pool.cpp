@@ -0,0 +1,106 @@
+#include "../include/worker_pool.h"
+
+#include <assert.h>
+
+WorkerPool::WorkerPool() {
+    m_threads = nullptr;
+    m_threadCount = 0;
+
+    m_task = nullptr;
+    m_taskCount = 0;
+    m_nextTask = 0;
+    m_pendingWorkers = 0;
+    m_generation = 0;
+    m_running = false;
+}
+
+WorkerPool::~WorkerPool() {
+    assert(m_threads == nullptr);
+}
+
+void WorkerPool::initialize(int threadCount) {
+    destroy();
+
+    if (threadCount <= 0) return;
+
+    m_running = true;
+    m_threadCount = threadCount;
+    m_threads = new std::thread[threadCount];
+    for (int i = 0; i < threadCount; ++i) {
+        m_threads[i] = std::thread(&WorkerPool::worker, this);
+    }
+}
+
+void WorkerPool::destroy() {
+    if (m_threads == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_running = false;
+    }
+
+    m_start.notify_all();
+
+    for (int i = 0; i < m_threadCount; ++i) {
+        m_threads[i].join();
+    }
+
+    delete[] m_threads;
+    m_threads = nullptr;
+    m_threadCount = 0;
+}
+
+void WorkerPool::run(int taskCount, const std::function<void(int)> &task) {
+    if (m_threadCount == 0 || taskCount <= 1) {
+        for (int i = 0; i < taskCount; ++i) {
+            task(i);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_nextTask = 0;
+        m_pendingWorkers = m_threadCount;
+        ++m_generation;
+    }
+
+    m_start.notify_all();
+    executeTasks();
+
+    std::unique_lock<std::mutex> lk(m_lock);
+    m_done.wait(lk, [this] { return m_pendingWorkers == 0; });
+    m_task = nullptr;
+}
+
+void WorkerPool::worker() {
+    unsigned int generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(m_lock);
+            m_start.wait(lk, [&] { return !m_running || m_generation != generation; });
+
+            if (!m_running) return;
+            generation = m_generation;
+        }
+
+        executeTasks();
+
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            done = (--m_pendingWorkers == 0);
+        }
+
+        if (done) m_done.notify_one();
+    }
+}
+
+void WorkerPool::executeTasks() {
+    for (int i = m_nextTask++; i < m_taskCount; i = m_nextTask++) {
+        (*m_task)(i);
+    }
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include "test_engine.h"
+
+#include "../include/piston_engine_simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    class ChamberTest : public ::testing::Test {
+        protected:
+            virtual void SetUp() override {
+                builder.build(&engine, &vehicle, &transmission);
+
+                // Reduced coordinates leave the cylinder wall force up to the
+                // test
+                Simulator::Parameters params;
+                params.systemType = Simulator::SystemType::ReducedCoordinate;
+                simulator.initialize(params);
+                simulator.loadSimulation(engine, vehicle, transmission);
+
+                chamber = engine->getChamber(0);
+                chamber->getPiston()->setCylinderWallForce(500.0);
+            }
+
+            virtual void TearDown() override {
+                simulator.releaseSimulation();
+
+                engine->destroy();
+                delete engine;
+                delete vehicle;
+                delete transmission;
+            }
+
+            TestEngine builder;
+            Engine *engine;
+            Vehicle *vehicle;
+            Transmission *transmission;
+            PistonEngineSimulator simulator;
+            CombustionChamber *chamber;
+    };
+}
+
+TEST_F(ChamberTest, FrictionDampingMatchesForce) {
+    const double speeds[] = { 2E-4, 8E-4, 0.01, 0.05, 0.2, 1.0, 10.0 };
+    for (double v : speeds) {
+        const double dv = v * 1E-4;
+        const double slope =
+            (chamber->calculatePistonForce(v + dv) - chamber->calculatePistonForce(v - dv)) / (2 * dv);
+        const double expected = std::max(-slope, 0.0);
+
+        EXPECT_NEAR(chamber->calculateFrictionDamping(v), expected, 1E-4 * std::abs(slope) + 1E-6);
+        EXPECT_EQ(chamber->calculateFrictionDamping(-v), chamber->calculateFrictionDamping(v));
+    }
+}
+
+TEST_F(ChamberTest, PressureStiffnessMatchesCompression) {
+    chamber->m_system.changePressure(units::pressure(20.0, units::atm));
+    chamber->update(0.0);
+
+    Piston *piston = chamber->getPiston();
+    CylinderBank *bank = piston->getCylinderBank();
+    const double k = chamber->calculatePressureStiffness();
+    const double F0 = chamber->calculatePistonForce(0.0);
+    EXPECT_GT(k, 0.0);
+
+    // Moving the piston towards the head compresses the gas
+    constexpr double ds = 1E-7;
+    piston->m_body.p_x += ds * bank->getDx();
+    piston->m_body.p_y += ds * bank->getDy();
+    chamber->update(0.0);
+
+    const double F1 = chamber->calculatePistonForce(0.0);
+    EXPECT_NEAR((F1 - F0) / ds, -k, 1E-3 * k);
+}
+
+TEST(CombustionChamberTests, BatchedFlowMatchesChamberFlow) {
+    TestEngine builders[2];
+    Engine *engines[2];
+    Vehicle *vehicles[2];
+    Transmission *transmissions[2];
+    PistonEngineSimulator simulators[2];
+
+    for (int i = 0; i < 2; ++i) {
+        builders[i].build(&engines[i], &vehicles[i], &transmissions[i]);
+
+        simulators[i].initialize(Simulator::Parameters());
+        simulators[i].loadSimulation(engines[i], vehicles[i], transmissions[i]);
+        simulators[i].setBatchedFlowEnabled(i == 1);
+        simulators[i].m_starterMotor.m_enabled = true;
+
+        engines[i]->getIgnitionModule()->m_enabled = true;
+        engines[i]->setSpeedControl(1.0);
+    }
+
+    for (int frame = 0; frame < 10; ++frame) {
+        for (int i = 0; i < 2; ++i) {
+            simulators[i].startFrame(1 / 60.0);
+            while (simulators[i].simulateStep()) {
+                /* void */
+            }
+
+            simulators[i].endFrame();
+        }
+    }
+
+    // The schedule only regroups the operations of the chamber loop, so the
+    // two can only differ by floating point contraction
+    for (int i = 0; i < engines[0]->getCylinderCount(); ++i) {
+        const double p0 = engines[0]->getChamber(i)->m_system.pressure();
+        const double p1 = engines[1]->getChamber(i)->m_system.pressure();
+        EXPECT_NEAR(p1, p0, 1E-6 * p0);
+    }
+
+    EXPECT_NEAR(
+        engines[1]->getCrankshaft(0)->getAngle(),
+        engines[0]->getCrankshaft(0)->getAngle(),
+        1E-6);
+
+    for (int i = 0; i < 2; ++i) {
+        simulators[i].releaseSimulation();
+
+        engines[i]->destroy();
+        delete engines[i];
+        delete vehicles[i];
+        delete transmissions[i];
+    }
+}
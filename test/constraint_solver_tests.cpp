@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+
+#include "../include/constraint_solver.h"
+#include "../include/direct_constraint_solver.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace {
+    constexpr int BodyCount = 3;
+    constexpr int RowCount = 5;
+
+    // Chain of three bodies pinned together, with the first one held to a
+    // line
+    void buildSystem(
+        atg_scs::SparseMatrix<3> *J,
+        atg_scs::Matrix *W,
+        atg_scs::Matrix *right,
+        double load)
+    {
+        J->initialize(3 * BodyCount, RowCount);
+        W->initialize(1, 3 * BodyCount);
+        right->initialize(1, RowCount);
+
+        for (int i = 0; i < BodyCount; ++i) {
+            W->set(0, 3 * i + 0, 1 / (1.0 + i));
+            W->set(0, 3 * i + 1, 1 / (1.0 + i));
+            W->set(0, 3 * i + 2, 1 / (0.1 + 0.05 * i));
+        }
+
+        for (int link = 0; link < 2; ++link) {
+            for (int axis = 0; axis < 2; ++axis) {
+                const int row = 2 * link + axis;
+                J->setBlock(row, 0, link);
+                J->setBlock(row, 1, link + 1);
+                J->set(row, 0, axis, 1.0);
+                J->set(row, 0, 2, (axis == 0) ? -0.2 : 0.3);
+                J->set(row, 1, axis, -1.0);
+                J->set(row, 1, 2, (axis == 0) ? 0.1 : -0.25);
+                right->set(0, row, load * (row + 1) * ((row % 2 == 0) ? 1 : -1));
+            }
+        }
+
+        J->setBlock(4, 0, 0);
+        J->setBlock(4, 1, 0);
+        J->set(4, 0, 1, 1.0);
+        right->set(0, 4, -2.0 * load);
+    }
+
+    double residual(
+        atg_scs::SparseMatrix<3> &J,
+        atg_scs::Matrix &W,
+        atg_scs::Matrix &right,
+        atg_scs::Matrix &lambda)
+    {
+        double u[3 * BodyCount] = {};
+        for (int i = 0; i < RowCount; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                const int body = J.getBlockIndex(i, j);
+                for (int k = 0; k < 3; ++k) {
+                    u[3 * body + k] += W.get(0, 3 * body + k) * J.get(i, j, k) * lambda.get(0, i);
+                }
+            }
+        }
+
+        double maxResidual = 0;
+        for (int i = 0; i < RowCount; ++i) {
+            double r = right.get(0, i);
+            for (int j = 0; j < 2; ++j) {
+                const int body = J.getBlockIndex(i, j);
+                for (int k = 0; k < 3; ++k) {
+                    r -= J.get(i, j, k) * u[3 * body + k];
+                }
+            }
+
+            maxResidual = std::fmax(maxResidual, std::abs(r));
+        }
+
+        return maxResidual;
+    }
+}
+
+TEST(ConstraintSolverTests, SolvesSystem) {
+    atg_scs::SparseMatrix<3> J;
+    atg_scs::Matrix W, right, lambda;
+    buildSystem(&J, &W, &right, 10.0);
+
+    ConstraintSolver solver;
+    solver.setMaxIterations(10000);
+    EXPECT_TRUE(solver.solve(J, W, right, &lambda, nullptr));
+
+    EXPECT_EQ(lambda.getHeight(), RowCount);
+    EXPECT_LT(residual(J, W, right, lambda), 1E-3);
+    EXPECT_EQ(solver.getStatistics().solves, 1);
+    EXPECT_GT(solver.getStatistics().lastIterations, 1);
+    EXPECT_LE(solver.getStatistics().lastResidual, solver.getTolerance() * 50.0);
+}
+
+TEST(ConstraintSolverTests, WarmStartReducesIterations) {
+    atg_scs::SparseMatrix<3> J;
+    atg_scs::Matrix W, right, lambda;
+
+    ConstraintSolver cold, warm;
+    cold.setWarmStartEnabled(false);
+    cold.setMaxIterations(10000);
+    warm.setMaxIterations(10000);
+
+    // Loads that change slightly from one step to the next
+    for (int step = 0; step < 10; ++step) {
+        buildSystem(&J, &W, &right, 10.0 + 0.01 * step);
+        cold.solve(J, W, right, &lambda, nullptr);
+        warm.solve(J, W, right, &lambda, nullptr);
+        EXPECT_LT(residual(J, W, right, lambda), 1E-3);
+    }
+
+    EXPECT_EQ(cold.getStatistics().unconverged, 0);
+    EXPECT_EQ(warm.getStatistics().unconverged, 0);
+    EXPECT_LT(warm.getStatistics().iterations, cold.getStatistics().iterations);
+    EXPECT_LT(warm.getStatistics().lastIterations, cold.getStatistics().lastIterations);
+}
+
+TEST(ConstraintSolverTests, RespectsLimits) {
+    atg_scs::SparseMatrix<3> J;
+    atg_scs::Matrix W, right, limits, lambda;
+    buildSystem(&J, &W, &right, 10.0);
+
+    limits.initialize(2, RowCount);
+    for (int i = 0; i < RowCount; ++i) {
+        limits.set(0, i, -1.0);
+        limits.set(1, i, 1.0);
+    }
+
+    ConstraintSolver solver;
+    solver.setMaxIterations(10000);
+    solver.solveWithLimits(J, W, right, limits, &lambda, nullptr);
+
+    for (int i = 0; i < RowCount; ++i) {
+        EXPECT_GE(lambda.get(0, i), -1.0);
+        EXPECT_LE(lambda.get(0, i), 1.0);
+    }
+}
+
+TEST(ConstraintSolverTests, StopsAtIterationLimit) {
+    atg_scs::SparseMatrix<3> J;
+    atg_scs::Matrix W, right, lambda;
+    buildSystem(&J, &W, &right, 10.0);
+
+    ConstraintSolver solver;
+    solver.setMaxIterations(1);
+    EXPECT_FALSE(solver.solve(J, W, right, &lambda, nullptr));
+    EXPECT_EQ(solver.getStatistics().lastIterations, 1);
+    EXPECT_EQ(solver.getStatistics().unconverged, 1);
+    EXPECT_GT(solver.getStatistics().lastResidual, 0.0);
+
+    solver.resetStatistics();
+    EXPECT_EQ(solver.getStatistics().solves, 0);
+}
+
+TEST(ConstraintSolverTests, DirectMatchesIterative) {
+    atg_scs::SparseMatrix<3> J;
+    atg_scs::Matrix W, right, limits, iterative, direct;
+    buildSystem(&J, &W, &right, 10.0);
+
+    limits.initialize(2, RowCount);
+    for (int i = 0; i < RowCount; ++i) {
+        limits.set(0, i, -DBL_MAX);
+        limits.set(1, i, DBL_MAX);
+    }
+
+    // One row held against a limit
+    limits.set(0, 1, -5.0);
+    limits.set(1, 1, 5.0);
+
+    ConstraintSolver gaussSeidel;
+    gaussSeidel.setTolerance(1E-12);
+    gaussSeidel.setMaxIterations(100000);
+    gaussSeidel.solveWithLimits(J, W, right, limits, &iterative, nullptr);
+
+    DirectConstraintSolver solver;
+    EXPECT_TRUE(solver.solveWithLimits(J, W, right, limits, &direct, nullptr));
+    EXPECT_LE(solver.getStatistics().lastIterations, 3);
+
+    for (int i = 0; i < RowCount; ++i) {
+        EXPECT_NEAR(direct.get(0, i), iterative.get(0, i), 1E-6);
+    }
+
+    EXPECT_EQ(std::abs(direct.get(0, 1)), 5.0);
+}
+
+TEST(ConstraintSolverTests, DirectReusesAnalysis) {
+    atg_scs::SparseMatrix<3> J;
+    atg_scs::Matrix W, right, lambda;
+
+    DirectConstraintSolver solver;
+    for (int step = 0; step < 10; ++step) {
+        buildSystem(&J, &W, &right, 10.0 + step);
+        EXPECT_TRUE(solver.solve(J, W, right, &lambda, nullptr));
+        EXPECT_LT(residual(J, W, right, lambda), 1E-9);
+        EXPECT_EQ(solver.getStatistics().lastIterations, 1);
+    }
+
+    EXPECT_EQ(solver.getAnalysisCount(), 1);
+    EXPECT_GT(solver.getFactorNonZeroCount(), 0);
+}
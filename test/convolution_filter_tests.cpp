@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include "../include/convolution_filter.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    void fillImpulseResponse(ConvolutionFilter &filter, std::mt19937 &rng) {
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        const int n = filter.getSampleCount();
+        float *h = filter.getImpulseResponse();
+        for (int i = 0; i < n; ++i) {
+            h[i] = dist(rng) * std::exp(-4.0f * i / n) / std::sqrt(static_cast<float>(n));
+        }
+    }
+
+    void compareWithDirectConvolution(int taps, int samples, double tolerance) {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        ConvolutionFilter filter;
+        filter.initialize(taps);
+        fillImpulseResponse(filter, rng);
+
+        const float *h = filter.getImpulseResponse();
+        std::vector<float> input(samples);
+        for (int i = 0; i < samples; ++i) {
+            input[i] = dist(rng);
+        }
+
+        for (int i = 0; i < samples; ++i) {
+            double reference = 0;
+            for (int j = 0; j < taps && j <= i; ++j) {
+                reference += static_cast<double>(h[j]) * input[i - j];
+            }
+
+            EXPECT_NEAR(filter.f(input[i]), reference, tolerance);
+        }
+
+        filter.destroy();
+    }
+}
+
+TEST(ConvolutionFilterTests, DirectMatchesReference) {
+    compareWithDirectConvolution(ConvolutionFilter::DirectConvolutionThreshold, 1000, 1E-5);
+}
+
+TEST(ConvolutionFilterTests, PartitionedMatchesReference) {
+    compareWithDirectConvolution(ConvolutionFilter::DirectConvolutionThreshold + 1, 1000, 1E-5);
+    compareWithDirectConvolution(1000, 3000, 1E-5);
+    compareWithDirectConvolution(10000, 12000, 1E-4);
+}
+
+TEST(ConvolutionFilterTests, BlockProcessingMatchesPerSample) {
+    constexpr int Taps = 2000;
+    constexpr int Samples = 1000;
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    ConvolutionFilter a, b;
+    a.initialize(Taps);
+    b.initialize(Taps);
+    fillImpulseResponse(a, rng);
+    for (int i = 0; i < Taps; ++i) {
+        b.getImpulseResponse()[i] = a.getImpulseResponse()[i];
+    }
+
+    EXPECT_TRUE(a.isPartitioned());
+
+    std::vector<float> input(Samples), output(Samples);
+    for (int i = 0; i < Samples; ++i) {
+        input[i] = dist(rng);
+    }
+
+    // Uneven block sizes that do not line up with the partition size
+    for (int i = 0; i < Samples; i += 77) {
+        b.process(input.data() + i, output.data() + i, std::min(77, Samples - i));
+    }
+
+    for (int i = 0; i < Samples; ++i) {
+        EXPECT_EQ(a.f(input[i]), output[i]);
+    }
+
+    a.destroy();
+    b.destroy();
+}
+
+TEST(ConvolutionFilterTests, SharedKernelMatchesOwned) {
+    constexpr int Taps = 2000;
+    constexpr int Samples = 1000;
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    ConvolutionFilter owned;
+    owned.initialize(Taps);
+    fillImpulseResponse(owned, rng);
+
+    const int partitionFloats =
+        ConvolutionFilter::getPartitionCount(Taps) * ConvolutionFilter::PartitionBins;
+    std::vector<float> partitions_re(partitionFloats), partitions_im(partitionFloats);
+    ConvolutionFilter::transformPartitions(
+        owned.getImpulseResponse(), Taps, partitions_re.data(), partitions_im.data());
+
+    ConvolutionFilter::Kernel kernel;
+    kernel.impulseResponse = owned.getImpulseResponse();
+    kernel.partitions_re = partitions_re.data();
+    kernel.partitions_im = partitions_im.data();
+    kernel.sampleCount = Taps;
+
+    ConvolutionFilter shared, scaled;
+    shared.initialize(kernel, 1.0f);
+    scaled.initialize(kernel, 0.5f);
+
+    EXPECT_TRUE(shared.isPartitioned());
+    EXPECT_EQ(shared.getSampleCount(), Taps);
+
+    for (int i = 0; i < Samples; ++i) {
+        const float x = dist(rng);
+        const float y = owned.f(x);
+        EXPECT_EQ(shared.f(x), y);
+        EXPECT_EQ(scaled.f(x), 0.5f * y);
+    }
+
+    owned.destroy();
+    shared.destroy();
+    scaled.destroy();
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include "test_engine.h"
+
+#include "../include/crank_slider_linkage.h"
+
+#include <cmath>
+
+TEST(CrankSliderLinkageTests, PlacementSatisfiesConstraints) {
+    TestEngine builder;
+    Engine *engine;
+    Vehicle *vehicle;
+    Transmission *transmission;
+    builder.build(&engine, &vehicle, &transmission);
+
+    CrankSliderLinkage linkage;
+    linkage.initialize(engine);
+
+    Crankshaft *crankshaft = engine->getOutputCrankshaft();
+    Piston *piston = engine->getPiston(0);
+    ConnectingRod *rod = piston->getRod();
+    CylinderBank *bank = piston->getCylinderBank();
+
+    double previousPin_x = 0, previousPin_y = 0;
+    constexpr double dtheta = 1E-6;
+
+    for (int i = 0; i < 64; ++i) {
+        const double theta = i * 0.1;
+        crankshaft->m_body.theta = theta;
+        crankshaft->m_body.v_theta = 1.0;
+        linkage.place();
+
+        // Big end on the crank journal
+        double journal_x, journal_y, bigEnd_x, bigEnd_y;
+        crankshaft->getRodJournalPositionLocal(rod->getJournal(), &journal_x, &journal_y);
+        crankshaft->m_body.localToWorld(journal_x, journal_y, &journal_x, &journal_y);
+        rod->m_body.localToWorld(0.0, rod->getBigEndLocal(), &bigEnd_x, &bigEnd_y);
+        EXPECT_NEAR(bigEnd_x, journal_x, 1E-9);
+        EXPECT_NEAR(bigEnd_y, journal_y, 1E-9);
+
+        // Little end on the wrist pin, which lies on the cylinder axis
+        double littleEnd_x, littleEnd_y, pin_x, pin_y;
+        rod->m_body.localToWorld(0.0, rod->getLittleEndLocal(), &littleEnd_x, &littleEnd_y);
+        piston->m_body.localToWorld(0.0, piston->getWristPinLocation(), &pin_x, &pin_y);
+        EXPECT_NEAR(littleEnd_x, pin_x, 1E-9);
+        EXPECT_NEAR(littleEnd_y, pin_y, 1E-9);
+        EXPECT_NEAR((pin_x - bank->getX()) * bank->getDy() - (pin_y - bank->getY()) * bank->getDx(), 0.0, 1E-9);
+
+        // Velocities follow the crank angle
+        crankshaft->m_body.theta = theta - dtheta;
+        linkage.place();
+        piston->m_body.localToWorld(0.0, piston->getWristPinLocation(), &previousPin_x, &previousPin_y);
+
+        crankshaft->m_body.theta = theta;
+        linkage.place();
+        EXPECT_NEAR(piston->m_body.v_x, (pin_x - previousPin_x) / dtheta, 1E-5);
+        EXPECT_NEAR(piston->m_body.v_y, (pin_y - previousPin_y) / dtheta, 1E-5);
+
+        linkage.prepare();
+        EXPECT_GT(linkage.getEffectiveInertia(), 0.0);
+        EXPECT_EQ(
+            crankshaft->m_body.I,
+            linkage.getCrankshaftInertia() + linkage.getEffectiveInertia());
+    }
+
+    linkage.destroy();
+
+    engine->destroy();
+    delete engine;
+    delete vehicle;
+    delete transmission;
+}
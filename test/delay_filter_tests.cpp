@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "../include/delay_filter.h"
+
+namespace {
+    // Number of samples until the impulse comes out of the filter
+    int measureDelay(DelayFilter &filter, int maxSamples) {
+        for (int i = 0; i < maxSamples; ++i) {
+            if (filter.fast_f(0.0) > 0.5) return i + 1;
+        }
+
+        return -1;
+    }
+}
+
+TEST(DelayFilterTests, DelayFollowsSampleRate) {
+    DelayFilter filter;
+    filter.initialize(0.001, 10000.0);
+    EXPECT_EQ(filter.getLatencySamples(), 10);
+
+    filter.setSampleRate(20000.0);
+    EXPECT_EQ(filter.getLatencySamples(), 20);
+
+    EXPECT_EQ(filter.fast_f(1.0), 0.0);
+    EXPECT_EQ(measureDelay(filter, 100), 20);
+}
+
+TEST(DelayFilterTests, ResamplesSamplesInFlight) {
+    DelayFilter filter;
+    filter.initialize(0.001, 10000.0);
+
+    // Half of the delay passes at the original rate and the other half at
+    // twice the rate
+    filter.fast_f(1.0);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(filter.fast_f(0.0), 0.0);
+    }
+
+    filter.setSampleRate(20000.0);
+    EXPECT_NEAR(measureDelay(filter, 100), 10, 1);
+}
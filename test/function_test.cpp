@@ -78,3 +78,59 @@ TEST(FunctionTests, FunctionGaussianTest) {
 
     f.destroy();
 }
+
+TEST(FunctionTests, FunctionBakeTest) {
+    Function f;
+    f.initialize(0, 0.5);
+    for (int i = 20; i >= -20; --i) {
+        const double x = i * 0.25;
+        f.addSample(x, std::sin(x) * 10);
+    }
+
+    EXPECT_TRUE(f.isOrdered());
+    EXPECT_TRUE(f.bake(1E-4));
+    EXPECT_TRUE(f.isBaked());
+
+    f.setInputScale(2.0);
+    f.setOutputScale(3.0);
+
+    double x[256], y[256];
+    for (int i = 0; i < 256; ++i) {
+        x[i] = -3.0 + i * (6.0 / 255);
+    }
+
+    f.sampleTriangle(x, y, 256);
+
+    const double tolerance = 1E-4 * 20 * 3.0;
+    for (int i = 0; i < 256; ++i) {
+        const double exact = f.sampleTriangleExact(x[i]);
+        EXPECT_NEAR(f.sampleTriangle(x[i]), exact, tolerance);
+        EXPECT_DOUBLE_EQ(y[i], f.sampleTriangle(x[i]));
+    }
+
+    f.addSample(10.0, 0.0);
+    EXPECT_FALSE(f.isBaked());
+
+    f.destroy();
+}
+
+TEST(FunctionTests, FunctionBakeConstantTest) {
+    Function f;
+    f.initialize(0, 0.5);
+    f.addSample(1.0, 7.0);
+
+    EXPECT_TRUE(f.bake());
+    EXPECT_TRUE(f.isBaked());
+
+    f.setOutputScale(2.0);
+
+    double x[4] = { -100.0, 0.0, 1.0, 100.0 }, y[4];
+    f.sampleTriangle(x, y, 4);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_DOUBLE_EQ(f.sampleTriangle(x[i]), f.sampleTriangleExact(x[i]));
+        EXPECT_DOUBLE_EQ(y[i], 14.0);
+    }
+
+    f.destroy();
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "../include/gas_system.h"
+#include "../include/flow_schedule.h"
 #include "../include/units.h"
 #include "../include/csv_io.h"
 
@@ -811,3 +812,459 @@ TEST(GasSystemTests, GasVelocityStabilizesInClosedSystem) {
     csv.writeCsv("gas_system_test_output.csv", nullptr, '\t');
     csv.destroy();
 }
+
+namespace {
+    struct BatchedFlowScenario {
+        GasSystem system_0;
+        GasSystem system_1;
+        GasSystem::FlowParameters params;
+        int steps = 100;
+        bool updateVelocity = false;
+    };
+
+    void expectRelativeNear(double a, double b, double tolerance) {
+        EXPECT_NEAR(a, b, tolerance * std::fmax(std::abs(b), 1.0));
+    }
+
+    void expectSameState(const GasSystem &a, const GasSystem &b) {
+        expectRelativeNear(a.n(), b.n(), 1E-9);
+        expectRelativeNear(a.kineticEnergy(), b.kineticEnergy(), 1E-9);
+        expectRelativeNear(a.velocity_x(), b.velocity_x(), 1E-9);
+        expectRelativeNear(a.velocity_y(), b.velocity_y(), 1E-9);
+        expectRelativeNear(a.mix().p_fuel, b.mix().p_fuel, 1E-9);
+        expectRelativeNear(a.mix().p_o2, b.mix().p_o2, 1E-9);
+    }
+
+    // Runs several copies of a scenario (with different flow constants) as
+    // one batch and compares each copy against the scalar implementation.
+    void compareBatchedFlow(const BatchedFlowScenario &scenario) {
+        constexpr int Copies = 5;
+
+        GasSystemStore store;
+        store.initialize(2 * Copies, Copies);
+
+        GasSystem scalar_0[Copies], scalar_1[Copies];
+        GasSystem batched_0[Copies], batched_1[Copies];
+        GasSystem::FlowParameters params[Copies];
+        int edges[Copies];
+
+        for (int i = 0; i < Copies; ++i) {
+            scalar_0[i] = batched_0[i] = scenario.system_0;
+            scalar_1[i] = batched_1[i] = scenario.system_1;
+            batched_0[i].bind(&store, store.allocate());
+            batched_1[i].bind(&store, store.allocate());
+
+            params[i] = scenario.params;
+            params[i].k_flow *= 1.0 + 0.25 * i;
+            params[i].system_0 = &scalar_0[i];
+            params[i].system_1 = &scalar_1[i];
+
+            GasSystemStore::FlowEdge edge;
+            edge.system_0 = batched_0[i].getStoreIndex(&store);
+            edge.system_1 = batched_1[i].getStoreIndex(&store);
+            edge.crossSectionArea_0 = params[i].crossSectionArea_0;
+            edge.crossSectionArea_1 = params[i].crossSectionArea_1;
+            edge.direction_x = params[i].direction_x;
+            edge.direction_y = params[i].direction_y;
+            edge.k_flow = params[i].k_flow;
+            edges[i] = store.addEdge(edge);
+        }
+
+        const double dt = scenario.params.dt;
+        double flows[Copies];
+        for (int step = 0; step < scenario.steps; ++step) {
+            GasSystem::flowBatch(&store, edges, Copies, dt, flows);
+
+            for (int i = 0; i < Copies; ++i) {
+                const double flow = GasSystem::flow(params[i]);
+                expectRelativeNear(flows[i], flow, 1E-9);
+
+                if (scenario.updateVelocity) {
+                    scalar_0[i].updateVelocity(dt);
+                    scalar_1[i].updateVelocity(dt);
+                    batched_0[i].updateVelocity(dt);
+                    batched_1[i].updateVelocity(dt);
+                }
+            }
+        }
+
+        for (int i = 0; i < Copies; ++i) {
+            expectSameState(batched_0[i], scalar_0[i]);
+            expectSameState(batched_1[i], scalar_1[i]);
+
+            batched_0[i].unbind();
+            batched_1[i].unbind();
+        }
+
+        store.destroy();
+    }
+}
+
+TEST(GasSystemTests, BatchedFlowMatchesScalarPressureEqualization) {
+    BatchedFlowScenario scenario;
+    scenario.system_0.initialize(
+        units::pressure(1.0, units::atm),
+        units::volume(1000.0, units::cc),
+        units::celcius(25.0)
+    );
+    scenario.system_1.initialize(
+        units::pressure(2.0, units::atm),
+        units::volume(1000.0, units::cc),
+        units::celcius(25.0)
+    );
+
+    scenario.params.k_flow = 0.000001;
+    scenario.params.crossSectionArea_0 = 1.0;
+    scenario.params.crossSectionArea_1 = 1.0;
+    scenario.params.direction_x = 1.0;
+    scenario.params.direction_y = 0.0;
+    scenario.params.dt = 1.0;
+
+    compareBatchedFlow(scenario);
+}
+
+TEST(GasSystemTests, BatchedFlowMatchesScalarIntakeStroke) {
+    BatchedFlowScenario scenario;
+    scenario.system_0.initialize(
+        units::pressure(1.0, units::atm),
+        units::volume(1000.0, units::m3),
+        units::celcius(25.0)
+    );
+    scenario.system_1.initialize(
+        units::pressure(1.0, units::atm),
+        units::volume(1.0, units::m3),
+        units::celcius(25.0)
+    );
+    scenario.system_1.changeVolume(units::volume(4.0, units::m3));
+
+    scenario.params.k_flow = GasSystem::k_carb(100000.0);
+    scenario.params.crossSectionArea_0 = 1.0;
+    scenario.params.crossSectionArea_1 = 1.0;
+    scenario.params.direction_x = 1.0;
+    scenario.params.direction_y = 0.0;
+    scenario.params.dt = 0.01;
+
+    compareBatchedFlow(scenario);
+}
+
+TEST(GasSystemTests, BatchedFlowMatchesScalarScavenging) {
+    constexpr double cylinderArea =
+        constants::pi * units::distance(2.0, units::inch) * units::distance(2.0, units::inch);
+    constexpr double tubeArea =
+        constants::pi * units::distance(1.75 / 2, units::inch) * units::distance(1.75 / 2, units::inch);
+
+    BatchedFlowScenario scenario;
+    scenario.system_0.initialize(
+        units::pressure(1000, units::psi),
+        units::volume(1000, units::cc),
+        units::celcius(1000.0)
+    );
+    scenario.system_0.setGeometry(
+        units::distance(10.0, units::cm),
+        units::distance(1.0, units::cm),
+        1.0,
+        0.0);
+
+    scenario.system_1.initialize(
+        units::pressure(15, units::psi),
+        tubeArea * units::distance(50.0, units::inch),
+        units::celcius(25.0)
+    );
+    scenario.system_1.setGeometry(
+        units::distance(50.0, units::inch),
+        std::sqrt(tubeArea),
+        1.0,
+        0.0);
+
+    scenario.params.k_flow = GasSystem::k_28inH2O(230.0);
+    scenario.params.crossSectionArea_0 = cylinderArea;
+    scenario.params.crossSectionArea_1 = tubeArea;
+    scenario.params.direction_x = 1.0;
+    scenario.params.direction_y = 0.0;
+    scenario.params.dt = 1 / (16 * 4000.0);
+    scenario.steps = 1000;
+    scenario.updateVelocity = true;
+
+    compareBatchedFlow(scenario);
+}
+
+TEST(GasSystemTests, BatchedFlowMatchesScalarReverseChokedFlow) {
+    BatchedFlowScenario scenario;
+    scenario.system_0.initialize(
+        units::pressure(1.0, units::atm),
+        units::volume(1.0, units::m3),
+        units::celcius(25.0)
+    );
+    scenario.system_1.initialize(
+        units::pressure(2.5, units::atm),
+        units::volume(1.0, units::m3),
+        units::celcius(2000.0)
+    );
+
+    scenario.params.k_flow = GasSystem::flowConstant(
+        units::flow(400, units::scfm),
+        units::pressure(2.5, units::atm),
+        units::pressure(1.5, units::atm),
+        units::celcius(2000.0),
+        GasSystem::heatCapacityRatio(5)
+    );
+    scenario.params.crossSectionArea_0 = 1.0;
+    scenario.params.crossSectionArea_1 = 1.0;
+    scenario.params.direction_x = 1.0;
+    scenario.params.direction_y = 0.0;
+    scenario.params.dt = 1 / 10000.0;
+
+    compareBatchedFlow(scenario);
+}
+
+
+namespace {
+    // Intake plenum and exhaust collector shared by several cylinders, each
+    // with its own intake and exhaust runner, like the volumes of an engine
+    struct FlowManifold {
+        static constexpr int Cylinders = 6;
+
+        GasSystemStore store;
+        GasSystem plenum, collector;
+        GasSystem intakeRunners[Cylinders], cylinders[Cylinders], exhaustRunners[Cylinders];
+        int edges[Cylinders][4];
+        double intakeFlow[Cylinders];
+        double exhaustFlow[Cylinders];
+
+        void initialize() {
+            store.initialize(2 + 3 * Cylinders, 4 * Cylinders);
+
+            plenum.initialize(
+                units::pressure(0.8, units::atm),
+                units::volume(2.0, units::L),
+                units::celcius(25.0));
+            plenum.setGeometry(0.2, 0.1, 1.0, 0.0);
+            plenum.bind(&store, store.allocate());
+
+            collector.initialize(
+                units::pressure(1.2, units::atm),
+                units::volume(3.0, units::L),
+                units::celcius(600.0));
+            collector.setGeometry(0.2, 0.1, 1.0, 0.0);
+            collector.bind(&store, store.allocate());
+
+            for (int i = 0; i < Cylinders; ++i) {
+                intakeRunners[i].initialize(
+                    units::pressure(0.9, units::atm),
+                    units::volume(100.0, units::cc),
+                    units::celcius(25.0));
+                intakeRunners[i].setGeometry(0.3, 0.02, 1.0, 0.0);
+                intakeRunners[i].bind(&store, store.allocate());
+
+                cylinders[i].initialize(
+                    units::pressure(0.5 + 1.5 * i, units::atm),
+                    units::volume(500.0, units::cc),
+                    units::celcius(300.0 + 200.0 * i));
+                cylinders[i].setGeometry(0.08, 0.08, 0.0, 1.0);
+                cylinders[i].bind(&store, store.allocate());
+
+                exhaustRunners[i].initialize(
+                    units::pressure(1.1, units::atm),
+                    units::volume(150.0, units::cc),
+                    units::celcius(700.0));
+                exhaustRunners[i].setGeometry(0.4, 0.02, 1.0, 0.0);
+                exhaustRunners[i].bind(&store, store.allocate());
+
+                const GasSystem *path[5] = {
+                    &plenum, &intakeRunners[i], &cylinders[i], &exhaustRunners[i], &collector };
+                for (int j = 0; j < 4; ++j) {
+                    GasSystemStore::FlowEdge edge;
+                    edge.system_0 = path[j]->getStoreIndex(&store);
+                    edge.system_1 = path[j + 1]->getStoreIndex(&store);
+                    edge.crossSectionArea_0 = 0.0004;
+                    edge.crossSectionArea_1 = 0.0004;
+                    edge.direction_x = 1.0;
+                    edge.direction_y = 0.0;
+                    edge.k_flow = GasSystem::k_28inH2O(100.0 + 20.0 * j + 5.0 * i);
+                    edges[i][j] = store.addEdge(edge);
+                }
+            }
+        }
+
+        void destroy() {
+            plenum.unbind();
+            collector.unbind();
+            for (int i = 0; i < Cylinders; ++i) {
+                intakeRunners[i].unbind();
+                cylinders[i].unbind();
+                exhaustRunners[i].unbind();
+            }
+
+            store.destroy();
+        }
+
+        // Same sequence of operations as CombustionChamber::flow()
+        void flow(double dt) {
+            for (int i = 0; i < Cylinders; ++i) {
+                GasSystem::flow(&store, store.getEdge(edges[i][0]), dt);
+                intakeRunners[i].dissipateExcessVelocity();
+                intakeFlow[i] = GasSystem::flow(&store, store.getEdge(edges[i][1]), dt);
+                intakeRunners[i].dissipateExcessVelocity();
+                cylinders[i].dissipateExcessVelocity();
+                exhaustFlow[i] = GasSystem::flow(&store, store.getEdge(edges[i][2]), dt);
+                cylinders[i].dissipateExcessVelocity();
+                exhaustRunners[i].dissipateExcessVelocity();
+                GasSystem::flow(&store, store.getEdge(edges[i][3]), dt);
+            }
+        }
+
+        void scheduleFlow(FlowSchedule *schedule) {
+            for (int i = 0; i < Cylinders; ++i) {
+                schedule->addFlow(edges[i][0]);
+                schedule->addDissipateExcessVelocity(intakeRunners[i].getStoreIndex(&store));
+                schedule->addFlow(edges[i][1], &intakeFlow[i]);
+                schedule->addDissipateExcessVelocity(intakeRunners[i].getStoreIndex(&store));
+                schedule->addDissipateExcessVelocity(cylinders[i].getStoreIndex(&store));
+                schedule->addFlow(edges[i][2], &exhaustFlow[i]);
+                schedule->addDissipateExcessVelocity(cylinders[i].getStoreIndex(&store));
+                schedule->addDissipateExcessVelocity(exhaustRunners[i].getStoreIndex(&store));
+                schedule->addFlow(edges[i][3]);
+            }
+        }
+
+        void updateVelocity(double dt) {
+            plenum.updateVelocity(dt);
+            collector.updateVelocity(dt);
+            for (int i = 0; i < Cylinders; ++i) {
+                intakeRunners[i].updateVelocity(dt);
+                cylinders[i].updateVelocity(dt, 0.5);
+                exhaustRunners[i].updateVelocity(dt);
+            }
+        }
+    };
+}
+
+TEST(GasSystemTests, FlowScheduleMatchesSequentialFlow) {
+    constexpr double dt = 1 / (16 * 4000.0);
+
+    FlowManifold sequential, scheduled;
+    sequential.initialize();
+    scheduled.initialize();
+
+    FlowSchedule schedule;
+    schedule.initialize(&scheduled.store);
+
+    for (int step = 0; step < 500; ++step) {
+        sequential.flow(dt);
+        sequential.updateVelocity(dt);
+
+        schedule.clear();
+        scheduled.scheduleFlow(&schedule);
+        schedule.run(dt);
+        scheduled.updateVelocity(dt);
+
+        // Every chamber chains through the shared plenum and collector, so
+        // the waves overlap from one chamber to the next
+        EXPECT_EQ(schedule.getOperationCount(), 9 * FlowManifold::Cylinders);
+        EXPECT_LT(schedule.getWaveCount(), schedule.getOperationCount() / 2);
+
+        for (int i = 0; i < FlowManifold::Cylinders; ++i) {
+            expectRelativeNear(scheduled.intakeFlow[i], sequential.intakeFlow[i], 1E-9);
+            expectRelativeNear(scheduled.exhaustFlow[i], sequential.exhaustFlow[i], 1E-9);
+        }
+    }
+
+    expectSameState(scheduled.plenum, sequential.plenum);
+    expectSameState(scheduled.collector, sequential.collector);
+    for (int i = 0; i < FlowManifold::Cylinders; ++i) {
+        expectSameState(scheduled.intakeRunners[i], sequential.intakeRunners[i]);
+        expectSameState(scheduled.cylinders[i], sequential.cylinders[i]);
+        expectSameState(scheduled.exhaustRunners[i], sequential.exhaustRunners[i]);
+    }
+
+    schedule.destroy();
+    sequential.destroy();
+    scheduled.destroy();
+}
+
+TEST(GasSystemTests, FlowScheduleIsDeterministic) {
+    constexpr double dt = 1 / 10000.0;
+
+    double n[2], E_k[2];
+    for (int run = 0; run < 2; ++run) {
+        FlowManifold manifold;
+        manifold.initialize();
+
+        FlowSchedule schedule;
+        schedule.initialize(&manifold.store);
+
+        double initialMolecules = manifold.plenum.n() + manifold.collector.n();
+        for (int i = 0; i < FlowManifold::Cylinders; ++i) {
+            initialMolecules += manifold.intakeRunners[i].n()
+                + manifold.cylinders[i].n()
+                + manifold.exhaustRunners[i].n();
+        }
+
+        for (int step = 0; step < 100; ++step) {
+            schedule.clear();
+            manifold.scheduleFlow(&schedule);
+            schedule.run(dt);
+        }
+
+        double finalMolecules = manifold.plenum.n() + manifold.collector.n();
+        for (int i = 0; i < FlowManifold::Cylinders; ++i) {
+            finalMolecules += manifold.intakeRunners[i].n()
+                + manifold.cylinders[i].n()
+                + manifold.exhaustRunners[i].n();
+        }
+
+        EXPECT_NEAR(finalMolecules, initialMolecules, 1E-9 * initialMolecules);
+
+        n[run] = manifold.collector.n();
+        E_k[run] = manifold.collector.kineticEnergy();
+
+        schedule.destroy();
+        manifold.destroy();
+    }
+
+    EXPECT_EQ(n[0], n[1]);
+    EXPECT_EQ(E_k[0], E_k[1]);
+}
+
+TEST(GasSystemTests, FlowStiffnessBoundsOvershoot) {
+    auto initialize = [](GasSystem *a, GasSystem *b) {
+        a->initialize(
+            units::pressure(2.0, units::atm),
+            units::volume(500.0, units::cc),
+            units::celcius(25.0));
+        b->initialize(
+            units::pressure(1.0, units::atm),
+            units::volume(300.0, units::cc),
+            units::celcius(25.0));
+    };
+
+    const double k_flow = GasSystem::k_28inH2O(200.0);
+    const double tolerance = units::pressure(0.5, units::kPa);
+
+    GasSystem a, b;
+    initialize(&a, &b);
+
+    const double stiffness = a.flowStiffness(k_flow, &b, tolerance);
+    ASSERT_GT(stiffness, 0.0);
+    EXPECT_DOUBLE_EQ(stiffness, b.flowStiffness(k_flow, &a, tolerance));
+
+    GasSystem::FlowParameters params;
+    params.k_flow = k_flow;
+    params.crossSectionArea_0 = 1.0;
+    params.crossSectionArea_1 = 1.0;
+    params.direction_x = 1.0;
+    params.direction_y = 0.0;
+    params.system_0 = &a;
+    params.system_1 = &b;
+
+    // A step within the bound must not overshoot equilibrium, while
+    // several times the bound does
+    params.dt = 0.5 / stiffness;
+    GasSystem::flow(params);
+    EXPECT_GT(a.pressure(), b.pressure());
+
+    initialize(&a, &b);
+    params.dt = 4.0 / stiffness;
+    GasSystem::flow(params);
+    EXPECT_LT(a.pressure(), b.pressure());
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include "../include/impulse_response_store.h"
+#include "../include/wave_writer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string writeTestResponse(const char *name, int samples, int silence) {
+        const std::string filename = ::testing::TempDir() + name;
+
+        std::vector<int16_t> data(samples + silence, 0);
+        for (int i = 0; i < samples; ++i) {
+            data[i] = (int16_t)(20000 * std::exp(-4.0 * i / samples) * ((i % 2) ? 1 : -1));
+        }
+
+        WaveWriter writer;
+        writer.open(filename, 44100);
+        writer.write(data.data(), (int)data.size());
+        writer.close();
+
+        // Left behind by older builds that wrote sidecars next to the WAV
+        std::remove((filename + ".irc").c_str());
+
+        return filename;
+    }
+
+    bool fileExists(const std::string &filename) {
+        std::FILE *file = std::fopen(filename.c_str(), "rb");
+        if (file == nullptr) return false;
+
+        std::fclose(file);
+        return true;
+    }
+}
+
+TEST(ImpulseResponseStoreTests, SharesAndCachesResponses) {
+    const std::string filename = writeTestResponse("ir_store_test.wav", 2000, 500);
+
+    const std::string cacheDirectory = ::testing::TempDir() + "ir_store_cache";
+
+    ImpulseResponseStore store;
+    store.setCacheDirectory(cacheDirectory);
+    std::remove(store.getSidecarPath(filename).c_str());
+
+    const ConvolutionFilter::Kernel *a = store.load(filename);
+    const ConvolutionFilter::Kernel *b = store.load(filename);
+
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(store.getEntryCount(), 1);
+
+    // The silent tail is trimmed and samples are normalized
+    EXPECT_LE(a->sampleCount, 2000);
+    EXPECT_GT(a->sampleCount, 1000);
+    EXPECT_FLOAT_EQ(a->impulseResponse[0], -20000.0f / INT16_MAX);
+
+    // A second store maps the sidecar written by the first, which is in the
+    // cache directory and not next to the WAV
+    EXPECT_EQ(store.getSidecarPath(filename).rfind(cacheDirectory, 0), 0u);
+    EXPECT_TRUE(fileExists(store.getSidecarPath(filename)));
+    EXPECT_FALSE(fileExists(filename + ".irc"));
+
+    ImpulseResponseStore cached;
+    cached.setCacheDirectory(cacheDirectory);
+    const ConvolutionFilter::Kernel *c = cached.load(filename);
+    ASSERT_NE(c, nullptr);
+    ASSERT_EQ(c->sampleCount, a->sampleCount);
+
+    const int partitionFloats =
+        ConvolutionFilter::getPartitionCount(a->sampleCount) * ConvolutionFilter::PartitionBins;
+    for (int i = 0; i < a->sampleCount; ++i) {
+        EXPECT_EQ(c->impulseResponse[i], a->impulseResponse[i]);
+    }
+
+    for (int i = 0; i < partitionFloats; ++i) {
+        EXPECT_EQ(c->partitions_re[i], a->partitions_re[i]);
+        EXPECT_EQ(c->partitions_im[i], a->partitions_im[i]);
+    }
+
+    EXPECT_EQ(store.load(::testing::TempDir() + "missing.wav"), nullptr);
+
+    store.destroy();
+    cached.destroy();
+}
+
+TEST(ImpulseResponseStoreTests, NoSidecarWithoutCacheDirectory) {
+    const std::string filename = writeTestResponse("ir_store_uncached.wav", 1000, 0);
+
+    ImpulseResponseStore store;
+    EXPECT_TRUE(store.getSidecarPath(filename).empty());
+    ASSERT_NE(store.load(filename), nullptr);
+    EXPECT_FALSE(fileExists(filename + ".irc"));
+
+    store.destroy();
+}
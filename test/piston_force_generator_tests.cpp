@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "test_engine.h"
+
+#include "../include/piston_engine_simulator.h"
+#include "../include/piston_force_generator.h"
+#include "../include/fast_math.h"
+
+#include <cmath>
+
+namespace {
+    class PistonForceTest : public ::testing::Test {
+        protected:
+            virtual void SetUp() override {
+                builder.build(&engine, &vehicle, &transmission);
+
+                Simulator::Parameters params;
+                simulator.initialize(params);
+                simulator.loadSimulation(engine, vehicle, transmission);
+
+                for (int i = 0; i < engine->getCylinderCount(); ++i) {
+                    CombustionChamber *chamber = engine->getChamber(i);
+                    chamber->m_system.changePressure(units::pressure(1.0 + 5.0 * i, units::atm));
+                    chamber->getPiston()->setCylinderWallForce(100.0 * (i + 1));
+                    chamber->setImplicitDamping(3.0 * i);
+                }
+
+                forces.initialize(engine);
+                forces.prepare();
+            }
+
+            virtual void TearDown() override {
+                forces.destroy();
+                simulator.releaseSimulation();
+
+                engine->destroy();
+                delete engine;
+                delete vehicle;
+                delete transmission;
+            }
+
+            TestEngine builder;
+            Engine *engine;
+            Vehicle *vehicle;
+            Transmission *transmission;
+            PistonEngineSimulator simulator;
+            PistonForceGenerator forces;
+    };
+}
+
+TEST(FastMathTests, ExpRelativeError) {
+    for (double x = -700.0; x <= 700.0; x += 0.0137) {
+        const double expected = std::exp(x);
+        EXPECT_LE(std::abs(fastExp(x) - expected), 1E-8 * expected) << "x = " << x;
+    }
+}
+
+TEST(FastMathTests, TanhAbsoluteError) {
+    for (double x = -25.0; x <= 25.0; x += 0.00131) {
+        EXPECT_LE(std::abs(fastTanh(x) - std::tanh(x)), 1E-8) << "x = " << x;
+    }
+
+    EXPECT_EQ(fastTanh(0.0), 0.0);
+}
+
+TEST_F(PistonForceTest, MatchesChamberForce) {
+    const int n = forces.getCylinderCount();
+    ASSERT_EQ(n, engine->getCylinderCount());
+
+    const double speeds[] = { 0.0, 1E-4, -5E-4, 2E-3, -0.01, 0.05, -0.2, 1.0, -10.0 };
+    for (double v : speeds) {
+        std::vector<double> v_s(n), F(n);
+        for (int i = 0; i < n; ++i) v_s[i] = v * (1 + 0.1 * i);
+
+        forces.calculateForces(v_s.data(), F.data());
+
+        for (int i = 0; i < n; ++i) {
+            const CombustionChamber *chamber = engine->getChamber(i);
+            const CombustionChamber::FrictionModelParams &friction = chamber->m_frictionModel;
+            const double F_coul =
+                friction.frictionCoeff * chamber->getPiston()->calculateCylinderWallForce();
+            const double tolerance =
+                1E-8 * (std::abs(friction.breakawayFriction - F_coul) + std::abs(F_coul))
+                + 1E-12 * std::abs(F[i]);
+
+            const double expected =
+                chamber->calculatePistonForce(v_s[i]) - chamber->getImplicitDamping() * v_s[i];
+            EXPECT_NEAR(F[i], expected, tolerance) << "cylinder " << i << ", v = " << v_s[i];
+        }
+    }
+}
@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+
+#include "test_engine.h"
+
+#include "../include/simulation_runtime.h"
+#include "../include/simulation_snapshot.h"
+#include "../include/wave_writer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+    void runFrames(Simulator *simulator, int frames) {
+        for (int i = 0; i < frames; ++i) {
+            simulator->startFrame(1 / 60.0);
+            while (simulator->simulateStep()) {
+                /* void */
+            }
+
+            simulator->endFrame();
+        }
+    }
+
+    std::vector<float> readInput(Synthesizer &synthesizer) {
+        std::vector<float> input(synthesizer.m_inputChannels[0].data.capacity());
+        input.resize(synthesizer.m_inputChannels[0].data.read(input.data(), input.size()));
+
+        return input;
+    }
+
+    std::string writeImpulseResponse(const char *name) {
+        const std::string filename = ::testing::TempDir() + name;
+
+        std::vector<int16_t> data(1000, 0);
+        data[0] = 20000;
+
+        WaveWriter writer;
+        writer.open(filename, 44100);
+        writer.write(data.data(), (int)data.size());
+        writer.close();
+
+        return filename;
+    }
+}
+
+TEST(SimulationRuntimeTests, IdenticalInstancesMatch) {
+    TestEngine builders[2];
+
+    SimulationRuntime::Parameters params;
+    params.threadCount = 2;
+
+    SimulationRuntime runtime;
+    runtime.initialize(params);
+
+    for (int i = 0; i < 2; ++i) {
+        Engine *engine;
+        Vehicle *vehicle;
+        Transmission *transmission;
+        builders[i].build(&engine, &vehicle, &transmission);
+
+        runtime.addInstance(engine, vehicle, transmission);
+
+        engine->getIgnitionModule()->m_enabled = true;
+        engine->setSpeedControl(1.0);
+        runtime.getSimulator(i)->m_starterMotor.m_enabled = true;
+    }
+
+    EXPECT_EQ(runtime.getInstanceCount(), 2);
+    EXPECT_EQ(runtime.getThreadCount(), 2);
+
+    runtime.step(1 / 60.0, 30);
+
+    const SimulationRuntime::Instance &a = runtime.getInstance(0);
+    const SimulationRuntime::Instance &b = runtime.getInstance(1);
+
+    // Instances share no state, so running them concurrently must give
+    // bit-identical results
+    EXPECT_EQ(a.simulator->simulationSteps(), b.simulator->simulationSteps());
+    EXPECT_EQ(a.engine->getCrankshaft(0)->getAngle(), b.engine->getCrankshaft(0)->getAngle());
+    EXPECT_EQ(a.engine->getCrankshaft(0)->m_body.v_theta, b.engine->getCrankshaft(0)->m_body.v_theta);
+    EXPECT_EQ(
+        a.engine->getChamber(0)->m_system.pressure(),
+        b.engine->getChamber(0)->m_system.pressure());
+    EXPECT_NE(a.engine->getCrankshaft(0)->m_body.v_theta, 0.0);
+    EXPECT_GT(a.engine->getChamber(0)->getSealedFlowSteps(), 0);
+    EXPECT_EQ(
+        a.engine->getChamber(0)->getSealedFlowSteps(),
+        b.engine->getChamber(0)->getSealedFlowSteps());
+
+    Synthesizer &synthA = a.simulator->synthesizer();
+    Synthesizer &synthB = b.simulator->synthesizer();
+    std::vector<float> audioA(synthA.m_inputChannels[0].data.capacity());
+    std::vector<float> audioB(synthB.m_inputChannels[0].data.capacity());
+
+    const size_t samplesA = synthA.m_inputChannels[0].data.read(audioA.data(), audioA.size());
+    const size_t samplesB = synthB.m_inputChannels[0].data.read(audioB.data(), audioB.size());
+
+    EXPECT_GT(samplesA, 0u);
+    ASSERT_EQ(samplesA, samplesB);
+    for (size_t i = 0; i < samplesA; ++i) {
+        EXPECT_EQ(audioA[i], audioB[i]);
+    }
+
+    runtime.destroy();
+}
+
+TEST(SimulationRuntimeTests, SnapshotRestoresState) {
+    TestEngine builders[2];
+
+    SimulationRuntime::Parameters params;
+    params.threadCount = 1;
+
+    SimulationRuntime runtime;
+    runtime.initialize(params);
+
+    for (int i = 0; i < 2; ++i) {
+        Engine *engine;
+        Vehicle *vehicle;
+        Transmission *transmission;
+        builders[i].build(&engine, &vehicle, &transmission);
+
+        runtime.addInstance(engine, vehicle, transmission);
+    }
+
+    Simulator *a = runtime.getSimulator(0);
+    Simulator *b = runtime.getSimulator(1);
+    a->getEngine()->getIgnitionModule()->m_enabled = true;
+    a->getEngine()->setSpeedControl(1.0);
+    a->m_starterMotor.m_enabled = true;
+
+    runFrames(a, 30);
+    readInput(a->synthesizer());
+
+    SimulationSnapshot snapshot;
+    a->saveSnapshot(&snapshot);
+    EXPECT_GT(snapshot.getSize(), 0u);
+
+    runFrames(a, 30);
+
+    // A truncated snapshot must be rejected without modifying the target
+    SimulationSnapshot truncated;
+    truncated.setData(snapshot.getData(), snapshot.getSize() / 2);
+    const double angle = b->getEngine()->getCrankshaft(0)->getAngle();
+    EXPECT_FALSE(b->loadSnapshot(&truncated));
+    EXPECT_EQ(b->getEngine()->getCrankshaft(0)->getAngle(), angle);
+
+    ASSERT_TRUE(b->loadSnapshot(&snapshot));
+    runFrames(b, 30);
+
+    Engine *engineA = a->getEngine();
+    Engine *engineB = b->getEngine();
+    EXPECT_NE(engineA->getCrankshaft(0)->m_body.v_theta, 0.0);
+    EXPECT_EQ(engineA->getCrankshaft(0)->getAngle(), engineB->getCrankshaft(0)->getAngle());
+    EXPECT_EQ(engineA->getCrankshaft(0)->m_body.v_theta, engineB->getCrankshaft(0)->m_body.v_theta);
+    for (int i = 0; i < engineA->getCylinderCount(); ++i) {
+        EXPECT_EQ(
+            engineA->getChamber(i)->m_system.pressure(),
+            engineB->getChamber(i)->m_system.pressure());
+    }
+
+    const std::vector<float> inputA = readInput(a->synthesizer());
+    const std::vector<float> inputB = readInput(b->synthesizer());
+    EXPECT_GT(inputA.size(), 0u);
+    EXPECT_EQ(inputA, inputB);
+
+    runtime.destroy();
+}
+
+TEST(SimulationRuntimeTests, SnapshotRestoresReducedCoordinateState) {
+    TestEngine builders[2];
+    Engine *engines[2];
+    Vehicle *vehicles[2];
+    Transmission *transmissions[2];
+    Simulator *simulators[2];
+
+    for (int i = 0; i < 2; ++i) {
+        builders[i].build(&engines[i], &vehicles[i], &transmissions[i]);
+        engines[i]->calculateDisplacement();
+
+        simulators[i] = engines[i]->createSimulator(vehicles[i], transmissions[i], true);
+        simulators[i]->setSimulationFrequency(engines[i]->getSimulationFrequency());
+        simulators[i]->setLatencyControlEnabled(false);
+    }
+
+    Simulator *a = simulators[0];
+    Simulator *b = simulators[1];
+    engines[0]->getIgnitionModule()->m_enabled = true;
+    engines[0]->setSpeedControl(1.0);
+    a->m_starterMotor.m_enabled = true;
+
+    runFrames(a, 30);
+
+    SimulationSnapshot snapshot;
+    a->saveSnapshot(&snapshot);
+    ASSERT_TRUE(b->loadSnapshot(&snapshot));
+
+    // The wall force and the crank-slider velocity carry over from one
+    // step to the next, so a restored run diverges immediately if either
+    // is left at its initial value
+    runFrames(a, 30);
+    runFrames(b, 30);
+
+    Engine *engineA = a->getEngine();
+    Engine *engineB = b->getEngine();
+    EXPECT_NE(engineA->getCrankshaft(0)->m_body.v_theta, 0.0);
+    EXPECT_EQ(engineA->getCrankshaft(0)->getAngle(), engineB->getCrankshaft(0)->getAngle());
+    EXPECT_EQ(engineA->getCrankshaft(0)->m_body.v_theta, engineB->getCrankshaft(0)->m_body.v_theta);
+    for (int i = 0; i < engineA->getCylinderCount(); ++i) {
+        EXPECT_EQ(
+            engineA->getChamber(i)->m_system.pressure(),
+            engineB->getChamber(i)->m_system.pressure());
+        EXPECT_EQ(
+            engineA->getPiston(i)->calculateCylinderWallForce(),
+            engineB->getPiston(i)->calculateCylinderWallForce());
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        simulators[i]->releaseSimulation();
+        delete simulators[i];
+
+        engines[i]->destroy();
+        delete engines[i];
+        delete vehicles[i];
+        delete transmissions[i];
+    }
+}
+
+TEST(SimulationRuntimeTests, InstancesShareImpulseResponses) {
+    const std::string filename = writeImpulseResponse("runtime_ir_test.wav");
+    TestEngine builders[2];
+
+    SimulationRuntime::Parameters params;
+    params.threadCount = 1;
+
+    SimulationRuntime runtime;
+    runtime.initialize(params);
+
+    for (int i = 0; i < 2; ++i) {
+        Engine *engine;
+        Vehicle *vehicle;
+        Transmission *transmission;
+        builders[i].build(&engine, &vehicle, &transmission);
+        engine->getExhaustSystem(0)->getImpulseResponse()->initialize(filename, 1.0);
+
+        runtime.addInstance(engine, vehicle, transmission);
+    }
+
+    // Both instances use the same file, so it's only loaded once
+    EXPECT_EQ(runtime.getImpulseResponses().getEntryCount(), 1);
+
+    runtime.destroy();
+}
+
+TEST(SimulationRuntimeTests, AudioIsHandedToSinkEveryFrame) {
+    TestEngine builder;
+
+    int sinkCalls = 0;
+    size_t totalSamples = 0;
+
+    SimulationRuntime::Parameters params;
+    params.threadCount = 1;
+    params.audioSink = [&](int instance, const int16_t *samples, int sampleCount) {
+        EXPECT_EQ(instance, 0);
+        EXPECT_NE(samples, nullptr);
+        ++sinkCalls;
+        totalSamples += sampleCount;
+    };
+
+    SimulationRuntime runtime;
+    runtime.initialize(params);
+
+    Engine *engine;
+    Vehicle *vehicle;
+    Transmission *transmission;
+    builder.build(&engine, &vehicle, &transmission);
+    ASSERT_EQ(runtime.addInstance(engine, vehicle, transmission), 0);
+
+    Simulator *simulator = runtime.getSimulator(0);
+    engine->getIgnitionModule()->m_enabled = true;
+    engine->setSpeedControl(1.0);
+    simulator->m_starterMotor.m_enabled = true;
+
+    // Nothing is left behind in the synthesizer between frames, so long
+    // runs neither pile up output nor drop input
+    const double sampleRate = simulator->synthesizer().getAudioSampleRate();
+    for (int frame = 1; frame <= 120; ++frame) {
+        runtime.step(1 / 60.0);
+
+        int16_t sample;
+        EXPECT_EQ(simulator->readAudioOutput(1, &sample), 0);
+        // Frames are rounded to whole simulation steps
+        EXPECT_LE(static_cast<double>(totalSamples), 1.02 * sampleRate * frame / 60.0);
+    }
+
+    EXPECT_GT(sinkCalls, 0);
+    EXPECT_GT(static_cast<double>(totalSamples), 0.5 * sampleRate * 120 / 60.0);
+
+    runtime.destroy();
+}
@@ -0,0 +1,130 @@
+#include "test_engine.h"
+
+#include "../include/piston_engine_simulator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Compares the constraint solvers on engines of increasing size. Every engine
+// runs at full throttle, held at a fixed speed by the dynamometer, and only
+// the time spent in the rigid body system is measured. "scs gauss-seidel" is
+// the solver the NSV system used before ConstraintSolver replaced it, and
+// reports no iteration counts.
+//
+// Usage: engine-sim-solver-benchmark [simulated seconds per run]
+
+namespace {
+    class TimedSimulator : public PistonEngineSimulator {
+        public:
+            double m_rigidBodyTime = 0.0;
+            long long m_rigidBodySteps = 0;
+
+        protected:
+            virtual void processRigidBodies(double dt) override {
+                const auto start = std::chrono::steady_clock::now();
+                PistonEngineSimulator::processRigidBodies(dt);
+                const auto end = std::chrono::steady_clock::now();
+
+                m_rigidBodyTime += std::chrono::duration<double>(end - start).count();
+                ++m_rigidBodySteps;
+            }
+    };
+
+    struct Configuration {
+        const char *name;
+        Simulator::SystemType systemType;
+        Simulator::SleSolverType solverType;
+    };
+
+    const Configuration Configurations[] = {
+        { "generic / gaussian elimination", Simulator::SystemType::Generic, Simulator::SleSolverType::GaussianElimination },
+        { "generic / direct", Simulator::SystemType::Generic, Simulator::SleSolverType::Direct },
+        { "nsv / scs gauss-seidel", Simulator::SystemType::NsvOptimized, Simulator::SleSolverType::ScsGaussSeidel },
+        { "nsv / warm-started gauss-seidel", Simulator::SystemType::NsvOptimized, Simulator::SleSolverType::GaussSeidel },
+        { "nsv / direct", Simulator::SystemType::NsvOptimized, Simulator::SleSolverType::Direct }
+    };
+
+    const int CylinderCounts[] = { 1, 4, 8, 12, 18 };
+
+    constexpr double FrameTime = 1 / 60.0;
+    constexpr double WarmupTime = 0.2;
+
+    void runFrame(Simulator *simulator) {
+        simulator->startFrame(FrameTime);
+        while (simulator->simulateStep()) {
+            /* void */
+        }
+
+        simulator->endFrame();
+    }
+}
+
+int main(int argc, char **argv) {
+    const double simulationTime = (argc > 1) ? std::atof(argv[1]) : 1.0;
+
+    std::printf("%-10s%-34s%14s%14s%14s\n",
+        "Cylinders", "System / solver", "us/step", "Iterations", "Max. residual");
+
+    for (int cylinders : CylinderCounts) {
+        for (const Configuration &configuration : Configurations) {
+            TestEngine builder;
+            Engine *engine;
+            Vehicle *vehicle;
+            Transmission *transmission;
+            builder.build(&engine, &vehicle, &transmission, cylinders);
+
+            Simulator::Parameters params;
+            params.systemType = configuration.systemType;
+            params.sleSolverType = configuration.solverType;
+
+            TimedSimulator simulator;
+            simulator.initialize(params);
+            simulator.loadSimulation(engine, vehicle, transmission);
+            engine->calculateDisplacement();
+            simulator.setFluidSimulationSteps(8);
+            simulator.setSimulationFrequency(10000);
+            simulator.setLatencyControlEnabled(false);
+
+            engine->getIgnitionModule()->m_enabled = true;
+            engine->setSpeedControl(1.0);
+            simulator.m_dyno.m_enabled = true;
+            simulator.m_dyno.m_hold = true;
+            simulator.m_dyno.m_rotationSpeed = units::rpm(3000);
+
+            for (double t = 0; t < WarmupTime; t += FrameTime) {
+                runFrame(&simulator);
+            }
+
+            simulator.m_rigidBodyTime = 0.0;
+            simulator.m_rigidBodySteps = 0;
+            simulator.resetSolverStatistics();
+
+            for (double t = 0; t < simulationTime; t += FrameTime) {
+                runFrame(&simulator);
+            }
+
+            const double timePerStep = (simulator.m_rigidBodySteps > 0)
+                ? simulator.m_rigidBodyTime / simulator.m_rigidBodySteps
+                : 0.0;
+
+            std::printf("%-10d%-34s%14.2f", cylinders, configuration.name, timePerStep * 1E6);
+            if (simulator.getConstraintSolver() != nullptr) {
+                std::printf("%14.2f%14.3g\n",
+                    simulator.getAverageSolverIterations(), simulator.getMaxSolverResidual());
+            }
+            else {
+                std::printf("%14s%14s\n", "-", "-");
+            }
+
+            simulator.releaseSimulation();
+
+            engine->destroy();
+            delete engine;
+            delete vehicle;
+            delete transmission;
+        }
+    }
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include "../include/synthesizer.h"
 
 #include <chrono>
+#include <thread>
 
 using namespace std::chrono_literals;
 
@@ -170,9 +171,16 @@ TEST(SynthesizerTests, SynthesizerSystemTest) {
     }
 
     synth.endInputBlock();
-    synth.waitProcessed();
 
-    const int rem = synth.readAudioOutput(outputSamples - totalSamples, output + totalSamples);
+    // The rest of the output arrives once the audio thread gets to it
+    const auto deadline = std::chrono::steady_clock::now() + 5s;
+    int rem = 0;
+    while (totalSamples + rem < outputSamples && std::chrono::steady_clock::now() < deadline) {
+        rem += synth.readAudioOutput(
+            outputSamples - totalSamples - rem, output + totalSamples + rem);
+        std::this_thread::yield();
+    }
+
     EXPECT_EQ(rem, outputSamples - totalSamples);
 
     for (int i = 0; i < 16; ++i) {
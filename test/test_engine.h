@@ -0,0 +1,351 @@
+#ifndef ATG_ENGINE_SIM_TEST_ENGINE_H
+#define ATG_ENGINE_SIM_TEST_ENGINE_H
+
+#include "../include/engine.h"
+#include "../include/vehicle.h"
+#include "../include/transmission.h"
+#include "../include/direct_throttle_linkage.h"
+#include "../include/standard_valvetrain.h"
+#include "../include/impulse_response.h"
+#include "../include/function.h"
+#include "../include/gas_system.h"
+#include "../include/constants.h"
+#include "../include/units.h"
+
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Builds a single-cylinder engine (modelled on assets/engines/kohler) directly
+// in C++ so that tests can run the full simulator without the scripting
+// front end. Objects the engine only references (functions, camshafts and so
+// on) are owned by the TestEngine and must outlive the engine.
+//
+// Larger engines repeat the same cylinder, up to six to a bank, with the
+// banks splayed around the crankshaft and the cylinders firing evenly in
+// order. They exist to scale the simulation, not to sound like anything.
+class TestEngine {
+    public:
+        TestEngine() { /* void */ }
+        ~TestEngine() { destroy(); }
+
+        void build(
+            Engine **engine,
+            Vehicle **vehicle,
+            Transmission **transmission,
+            int cylinderCount = 1)
+        {
+            const int bankCount = (cylinderCount + 5) / 6;
+            const int bankCylinders = cylinderCount / bankCount;
+            assert(bankCylinders * bankCount == cylinderCount);
+
+            Engine *e = new Engine;
+
+            DirectThrottleLinkage::Parameters throttleParams;
+            throttleParams.gamma = 1.0;
+            DirectThrottleLinkage *throttle = new DirectThrottleLinkage;
+            throttle->initialize(throttleParams);
+
+            Engine::Parameters engineParams;
+            engineParams.name = (cylinderCount == 1)
+                ? "Test Single"
+                : "Test " + std::to_string(cylinderCount);
+            engineParams.cylinderBanks = bankCount;
+            engineParams.cylinderCount = cylinderCount;
+            engineParams.crankshaftCount = 1;
+            engineParams.exhaustSystemCount = 1;
+            engineParams.intakeCount = 1;
+            engineParams.starterTorque = units::torque(50.0, units::ft_lb);
+            engineParams.starterSpeed = units::rpm(500);
+            engineParams.redline = units::rpm(3600);
+            engineParams.throttle = throttle;
+            engineParams.initialSimulationFrequency = 10000;
+            engineParams.initialHighFrequencyGain = 0.01;
+            engineParams.initialNoise = 1.0;
+            engineParams.initialJitter = 0.5;
+            e->initialize(engineParams);
+
+            Crankshaft::Parameters crankParams;
+            crankParams.mass = units::mass(5, units::lb);
+            crankParams.flywheelMass = units::mass(5, units::lb);
+            crankParams.momentOfInertia = 0.22986844776863666 * 0.5;
+            crankParams.crankThrow = units::distance(69, units::mm) / 2;
+            crankParams.tdc = constants::pi / 2;
+            crankParams.frictionTorque = units::torque(10.0, units::ft_lb);
+            crankParams.rodJournals = bankCylinders;
+            Crankshaft *crankshaft = e->getCrankshaft(0);
+            crankshaft->initialize(crankParams);
+            for (int i = 0; i < bankCylinders; ++i) {
+                crankshaft->setRodJournalAngle(i, 2 * constants::pi * i / bankCylinders);
+            }
+
+            Function *lobe = createHarmonicCamLobe(
+                160 * units::deg, 1.1, units::distance(200, units::thou), 100);
+
+            static const double IntakeFlow[] = {
+                0, 25, 75, 100, 130, 180, 190, 220, 240, 250, 260, 260, 260, 255, 250 };
+            static const double ExhaustFlow[] = {
+                0, 25, 50, 75, 100, 125, 160, 175, 180, 190, 200, 205, 210, 210, 210 };
+            Function *intakePortFlow = createFlowFunction(IntakeFlow, 15);
+            Function *exhaustPortFlow = createFlowFunction(ExhaustFlow, 15);
+
+            for (int b = 0; b < bankCount; ++b) {
+                CylinderBank::Parameters bankParams;
+                bankParams.crankshaft = crankshaft;
+                bankParams.positionX = 0.0;
+                bankParams.positionY = 0.0;
+                bankParams.angle = (b - (bankCount - 1) / 2.0) * constants::pi / 3;
+                bankParams.bore = units::distance(83, units::mm);
+                bankParams.deckHeight =
+                    units::distance(5.0, units::inch) + units::distance(69, units::mm) / 2;
+                bankParams.displayDepth = 0.5;
+                bankParams.cylinderCount = bankCylinders;
+                bankParams.index = b;
+                CylinderBank *bank = e->getCylinderBank(b);
+                bank->initialize(bankParams);
+
+                Camshaft *intakeCam = new Camshaft;
+                Camshaft *exhaustCam = new Camshaft;
+                m_camshafts.push_back(intakeCam);
+                m_camshafts.push_back(exhaustCam);
+
+                Camshaft::Parameters camParams;
+                camParams.lobes = bankCylinders;
+                camParams.crankshaft = crankshaft;
+                camParams.lobeProfile = lobe;
+                camParams.baseRadius = units::distance(500, units::thou);
+                intakeCam->initialize(camParams);
+                exhaustCam->initialize(camParams);
+
+                for (int i = 0; i < bankCylinders; ++i) {
+                    const int cylinder = b * bankCylinders + i;
+                    const double firingAngle = getFiringAngle(cylinder, cylinderCount);
+
+                    Piston::Parameters pistonParams;
+                    pistonParams.Rod = e->getConnectingRod(cylinder);
+                    pistonParams.Bank = bank;
+                    pistonParams.CylinderIndex = i;
+                    pistonParams.BlowbyFlowCoefficient = GasSystem::k_28inH2O(0.1);
+                    pistonParams.CompressionHeight = units::distance(1.0, units::inch);
+                    pistonParams.WristPinPosition = 0.0;
+                    pistonParams.Displacement = 0.0;
+                    pistonParams.mass = units::mass(400, units::g);
+                    e->getPiston(cylinder)->initialize(pistonParams);
+
+                    ConnectingRod::Parameters rodParams;
+                    rodParams.mass = units::mass(300.0, units::g);
+                    rodParams.momentOfInertia = 0.0015884918028487504;
+                    rodParams.centerOfMass = 0.0;
+                    rodParams.length = units::distance(4.0, units::inch);
+                    rodParams.piston = e->getPiston(cylinder);
+                    rodParams.crankshaft = crankshaft;
+                    rodParams.journal = i;
+                    e->getConnectingRod(cylinder)->initialize(rodParams);
+
+                    intakeCam->setLobeCenterline(i, (360 + 114) * units::deg + firingAngle);
+                    exhaustCam->setLobeCenterline(i, (360 - 114) * units::deg + firingAngle);
+                }
+
+                StandardValvetrain::Parameters valvetrainParams;
+                valvetrainParams.intakeCamshaft = intakeCam;
+                valvetrainParams.exhaustCamshaft = exhaustCam;
+                StandardValvetrain *valvetrain = new StandardValvetrain;
+                valvetrain->initialize(valvetrainParams);
+                m_valvetrains.push_back(valvetrain);
+
+                CylinderHead::Parameters headParams;
+                headParams.Bank = bank;
+                headParams.IntakePortFlow = intakePortFlow;
+                headParams.ExhaustPortFlow = exhaustPortFlow;
+                headParams.Valvetrain = valvetrain;
+                headParams.CombustionChamberVolume = units::volume(50, units::cc);
+                headParams.IntakeRunnerVolume = units::volume(100, units::cc);
+                headParams.IntakeRunnerCrossSectionArea = units::area(30, units::cm2);
+                headParams.ExhaustRunnerVolume = units::volume(100, units::cc);
+                headParams.ExhaustRunnerCrossSectionArea = units::area(30, units::cm2);
+                e->getHead(b)->initialize(headParams);
+            }
+
+            Intake::Parameters intakeParams;
+            intakeParams.volume = units::volume(1.0, units::L);
+            intakeParams.CrossSectionArea = units::area(10.0, units::cm2);
+            intakeParams.InputFlowK = GasSystem::k_carb(50.0);
+            intakeParams.IdleFlowK = GasSystem::k_carb(0.0);
+            intakeParams.RunnerFlowRate = GasSystem::k_carb(200.0);
+            intakeParams.IdleThrottlePlatePosition = 0.96;
+            intakeParams.VelocityDecay = 0.25;
+            Intake *intake = e->getIntake(0);
+            intake->initialize(intakeParams);
+
+            ImpulseResponse *impulseResponse = new ImpulseResponse;
+            impulseResponse->initialize("", 1.0);
+            m_impulseResponses.push_back(impulseResponse);
+
+            const double collectorArea =
+                constants::pi * units::distance(2.0, units::inch) * units::distance(2.0, units::inch);
+            ExhaustSystem::Parameters exhaustParams;
+            exhaustParams.length = units::volume(20.0, units::L) / collectorArea;
+            exhaustParams.collectorCrossSectionArea = collectorArea;
+            exhaustParams.outletFlowRate = GasSystem::k_carb(300.0);
+            exhaustParams.primaryTubeLength = units::distance(10.0, units::inch);
+            exhaustParams.primaryFlowRate = GasSystem::k_carb(200.0);
+            exhaustParams.velocityDecay = 1.0;
+            exhaustParams.audioVolume = 1.0;
+            exhaustParams.impulseResponse = impulseResponse;
+            ExhaustSystem *exhaust = e->getExhaustSystem(0);
+            exhaust->initialize(exhaustParams);
+
+            for (int b = 0; b < bankCount; ++b) {
+                CylinderHead *head = e->getHead(b);
+                for (int i = 0; i < bankCylinders; ++i) {
+                    head->setIntake(i, intake);
+                    head->setExhaustSystem(i, exhaust);
+                    head->setSoundAttenuation(i, 1.0);
+                    head->setHeaderPrimaryLength(i, units::distance(10.0, units::inch));
+                }
+            }
+
+            Function *timingCurve = createFunction(units::rpm(1000));
+            for (int i = 0; i <= 4; ++i) {
+                timingCurve->addSample(units::rpm(1000.0 * i), 50 * units::deg);
+            }
+
+            IgnitionModule::Parameters ignitionParams;
+            ignitionParams.cylinderCount = cylinderCount;
+            ignitionParams.crankshaft = crankshaft;
+            ignitionParams.timingCurve = timingCurve;
+            ignitionParams.revLimit = units::rpm(5000);
+            e->getIgnitionModule()->initialize(ignitionParams);
+            for (int i = 0; i < cylinderCount; ++i) {
+                e->getIgnitionModule()->setFiringOrder(i, getFiringAngle(i, cylinderCount));
+            }
+
+            Function *flameSpeed = createFunction(5.0);
+            flameSpeed->addSample(0.0, 3.0);
+            for (int i = 1; i < 10; ++i) {
+                flameSpeed->addSample(5.0 * i, 1.5 * 5.0 * i);
+            }
+
+            Fuel::Parameters fuelParams;
+            fuelParams.maxDilutionEffect = 10.0;
+            fuelParams.turbulenceToFlameSpeedRatio = flameSpeed;
+            e->getFuel()->initialize(fuelParams);
+
+            Function *turbulence = createFunction(1.0);
+            for (int i = 0; i < 30; ++i) {
+                turbulence->addSample((double)i, i * 0.5);
+            }
+
+            for (int i = 0; i < cylinderCount; ++i) {
+                CombustionChamber::Parameters chamberParams;
+                chamberParams.Piston = e->getPiston(i);
+                chamberParams.Head = e->getHead(i / bankCylinders);
+                chamberParams.Fuel = e->getFuel();
+                chamberParams.MeanPistonSpeedToTurbulence = turbulence;
+                chamberParams.StartingPressure = units::pressure(1.0, units::atm);
+                chamberParams.StartingTemperature = units::celcius(25.0);
+                chamberParams.CrankcasePressure = units::pressure(1.0, units::atm);
+                e->getChamber(i)->initialize(chamberParams);
+            }
+
+            Vehicle::Parameters vehicleParams;
+            vehicleParams.mass = units::mass(1000, units::kg);
+            vehicleParams.dragCoefficient = 0.25;
+            vehicleParams.crossSectionArea =
+                units::distance(72, units::inch) * units::distance(72, units::inch);
+            vehicleParams.diffRatio = 3.42;
+            vehicleParams.tireRadius = units::distance(10, units::inch);
+            vehicleParams.rollingResistance = 2000;
+            Vehicle *v = new Vehicle;
+            v->initialize(vehicleParams);
+
+            static const double GearRatios[] = { 2.97, 2.07, 1.43, 1.00, 0.84, 0.56 };
+            Transmission::Parameters transmissionParams;
+            transmissionParams.GearCount = 6;
+            transmissionParams.GearRatios = GearRatios;
+            transmissionParams.MaxClutchTorque = units::torque(1000.0, units::ft_lb);
+            Transmission *t = new Transmission;
+            t->initialize(transmissionParams);
+
+            *engine = e;
+            *vehicle = v;
+            *transmission = t;
+        }
+
+        void destroy() {
+            for (Function *function : m_functions) {
+                function->destroy();
+                delete function;
+            }
+
+            for (Camshaft *camshaft : m_camshafts) {
+                camshaft->destroy();
+                delete camshaft;
+            }
+
+            for (Valvetrain *valvetrain : m_valvetrains) delete valvetrain;
+            for (ImpulseResponse *response : m_impulseResponses) delete response;
+
+            m_functions.clear();
+            m_camshafts.clear();
+            m_valvetrains.clear();
+            m_impulseResponses.clear();
+        }
+
+    protected:
+        static double getFiringAngle(int cylinder, int cylinderCount) {
+            return 4 * constants::pi * cylinder / cylinderCount;
+        }
+
+        Function *createFunction(double filterRadius) {
+            Function *function = new Function;
+            function->initialize(1, filterRadius);
+            m_functions.push_back(function);
+
+            return function;
+        }
+
+        Function *createFlowFunction(const double *flow, int samples) {
+            Function *function = createFunction(units::distance(50, units::thou));
+            for (int i = 0; i < samples; ++i) {
+                function->addSample(
+                    units::distance(50.0 * i, units::thou),
+                    GasSystem::k_28inH2O(flow[i]));
+            }
+
+            return function;
+        }
+
+        // Same construction as the harmonic_cam_lobe script node
+        Function *createHarmonicCamLobe(
+            double durationAt50Thou, double gamma, double lift, int steps)
+        {
+            Function *function = createFunction(1.0);
+
+            const double angle = durationAt50Thou / 4;
+            const double s = std::pow(2 * units::distance(50, units::thou) / lift, 1 / gamma) - 1;
+            const double k = std::acos(s) / angle;
+            const double extents = constants::pi / k;
+            const double step = extents / (steps - 5.0);
+
+            function->addSample(0.0, lift);
+            for (int i = 1; i < steps; ++i) {
+                const double x = i * step;
+                const double y = (x >= extents)
+                    ? 0.0
+                    : lift * std::pow(0.5 + 0.5 * std::cos(k * x), gamma);
+                function->addSample(x, y);
+                function->addSample(-x, y);
+            }
+
+            return function;
+        }
+
+        std::vector<Function *> m_functions;
+        std::vector<Camshaft *> m_camshafts;
+        std::vector<Valvetrain *> m_valvetrains;
+        std::vector<ImpulseResponse *> m_impulseResponses;
+};
+
+#endif /* ATG_ENGINE_SIM_TEST_ENGINE_H */